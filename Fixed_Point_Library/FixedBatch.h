@@ -0,0 +1,951 @@
+/*
+ *  @file    FixedBatch.h
+ *
+ *  @brief Batch arithmetic over contiguous buffers of Fixed numbers
+ *
+ *  DESCRIPTION
+ *
+ * The scalar operators in FixedPoint.h work on one number at a time. The
+ * functions in this file take a destination buffer, one or two source
+ * buffers, and an element count, and apply the same operation to every
+ * element. Buffers may overlap exactly (dst == L is fine for in-place math).
+ *
+ *     Fixed_batchAdd(dst, L, R, count)   dst[i] = L[i] + R[i]
+ *     Fixed_batchSub(dst, L, R, count)   dst[i] = L[i] - R[i]
+ *     Fixed_batchMul(dst, L, R, count)   dst[i] = L[i] * R[i]
+ *     Fixed_batchDiv(dst, L, R, count)   dst[i] = L[i] / R[i]
+ *     Fixed_batchMac(dst, L, R, count)   dst[i] += L[i] * R[i]
+ *     Fixed_batchRound<MODE>(dst, src, count[, noise])
+ *                                        dst[i] = src[i].round<MODE>()
+ *
+ * The same operations are available on the raw integer buffers through
+ * FixedBatch<INT, FRAC, SIGN, OVER>, which is what FixedVector uses.
+ *
+ * Every result is bit-exact with the scalar operators, including the
+ * MULT_ROUND rounding of multiplication and the FixedOverflow policy.
+ * Wrapping buffers wrap on overflow, FIXED_SATURATE buffers clamp, and
+ * FIXED_TRAP buffers run the scalar operators so the trap is not missed.
+ *
+ *
+ *  MODIFICATIONS
+ *
+ * The SIMD kernels are chosen at compile time from the size of fixSize.
+ * SSE2 kernels are used when the compiler targets SSE2 (__SSE2__), and the
+ * wider AVX2 kernels are used first when it targets AVX2 (-mavx2 or
+ * -march=native). Set ENABLE_SIMD_BATCH to 0 to force the scalar loops.
+ *
+ *   fixSize   Add/Sub/Mac-add   Mul/Mac-mul           Div
+ *    8 bit      SIMD              SIMD (16 bit lanes)   Scalar
+ *   16 bit      SIMD              SIMD (32 bit lanes)   Scalar
+ *   32 bit      SIMD              SIMD (64 bit lanes)   Scalar
+ *   64 bit      SIMD              Scalar                Scalar
+ *
+ * Rounding is an add and an and-not for every FixedRounding mode and every
+ * size, so it always has a SIMD kernel. FIXED_ROUND_STOCHASTIC reads one
+ * random raw number per element from the noise buffer.
+ *
+ * Saturating add and sub use the saturating instructions for 8 and 16 bit
+ * lanes, and a sign bit test for 32 and 64 bit lanes. Saturating multiply
+ * packs the wide products with saturation, so only 8 and 16 bit numbers
+ * have a SIMD kernel. The rest use the scalar loop.
+ *
+ * Formats over 64 bits do not build here, use the scalar operators on them.
+ */
+
+
+
+
+#ifndef FIXEDBATCH_H
+#define FIXEDBATCH_H
+
+#define ENABLE_SIMD_BATCH 1 // 1 for enable, 0 for scalar loops only
+
+#include "FixedPoint.h"
+#include <cassert>
+#include <cstddef>
+
+#if ENABLE_SIMD_BATCH == 1 && defined(__SSE2__)
+    #include <emmintrin.h>
+    #define FIXED_BATCH_SSE2 1
+#else
+    #define FIXED_BATCH_SSE2 0
+#endif // __SSE2__
+
+#if ENABLE_SIMD_BATCH == 1 && defined(__AVX2__)
+    #include <immintrin.h>
+    #define FIXED_BATCH_AVX2 1
+#else
+    #define FIXED_BATCH_AVX2 0
+#endif // __AVX2__
+
+static_assert(ENABLE_SIMD_BATCH == 0 || ENABLE_SIMD_BATCH == 1,
+              "Invalid value for ENABLE_SIMD_BATCH");
+
+
+
+#if FIXED_BATCH_SSE2 == 1
+
+// **************************************************************
+//                    SSE2 Lanes (128 bit vectors)
+// **************************************************************
+template<std::size_t BYTES, bool SIGN> struct FixedLanes128;
+
+// Saturating add and sub for lanes without the instructions. The overflow
+// is found from the sign bits of the inputs and the wrapped result.
+template<class LANES> struct FixedSaturate128;
+
+template<template<std::size_t, bool> class LANES, std::size_t BYTES, bool SIGN>
+struct FixedSaturate128<LANES<BYTES, SIGN> >{
+    typedef __m128i vec;
+    typedef LANES<BYTES, SIGN> lanes;
+
+    static vec adds(vec L, vec R, vec sum){
+        if(SIGN){
+            // Both inputs have the same sign, and the sum does not
+            const vec over = lanes::signMask(_mm_andnot_si128(
+                                 _mm_xor_si128(L, R), _mm_xor_si128(L, sum)));
+            return select(over, limit(L), sum);
+        }
+        // Carry out of the top bit
+        const vec carry = lanes::signMask(_mm_or_si128(_mm_and_si128(L, R),
+                              _mm_andnot_si128(sum, _mm_or_si128(L, R))));
+        return _mm_or_si128(sum, carry);
+    }
+
+    static vec subs(vec L, vec R, vec diff){
+        if(SIGN){
+            // The inputs have different signs, and the result has R's sign
+            const vec over = lanes::signMask(_mm_and_si128(
+                                 _mm_xor_si128(L, R), _mm_xor_si128(L, diff)));
+            return select(over, limit(L), diff);
+        }
+        // Borrow out of the top bit
+        const vec borrow = lanes::signMask(_mm_or_si128(
+                               _mm_andnot_si128(L, R),
+                               _mm_andnot_si128(_mm_xor_si128(L, R), diff)));
+        return _mm_andnot_si128(borrow, diff);
+    }
+
+private:
+    // Max value if L is positive, min value if negative
+    static vec limit(vec L){ return _mm_xor_si128(lanes::signMask(L),
+                                                  lanes::maxValue());}
+
+    static vec select(vec mask, vec L, vec R){
+        return _mm_or_si128(_mm_and_si128(mask, L), _mm_andnot_si128(mask, R));
+    }
+};
+
+template<bool SIGN> struct FixedLanes128<1, SIGN>{
+    typedef __m128i vec;
+    static const bool HAS_MUL = true;
+    static const bool HAS_MULS = true;
+
+    static vec add(vec L, vec R){ return _mm_add_epi8(L, R);}
+    static vec sub(vec L, vec R){ return _mm_sub_epi8(L, R);}
+
+    // There is no 8 bit shift, so 16 bit lanes are shifted and the bits
+    // that crossed into the next lane are cleared
+    static vec signMask(vec x){ return _mm_cmpgt_epi8(_mm_setzero_si128(), x);}
+    static vec set1(fastu64 x){ return _mm_set1_epi8(CAST<char>(x));}
+    static vec srl(vec x, fastu16 n){
+        return _mm_and_si128(_mm_srl_epi16(x, _mm_cvtsi32_si128(n)),
+                             _mm_set1_epi8(CAST<char>(0xFF >> n)));
+    }
+
+    static vec adds(vec L, vec R){
+        return (SIGN) ? _mm_adds_epi8(L, R) : _mm_adds_epu8(L, R);
+    }
+    static vec subs(vec L, vec R){
+        return (SIGN) ? _mm_subs_epi8(L, R) : _mm_subs_epu8(L, R);
+    }
+
+    static vec round(fastu16 frac){ return _mm_set1_epi16(1 << (frac - 1));}
+
+    static vec mul(vec L, vec R, vec round, vec shift){
+        vec lo, hi;
+        widenMul(L, R, round, shift, lo, hi);
+
+        // Keep the low byte of each lane, same as the scalar narrowing cast
+        const vec mask = _mm_set1_epi16(0x00FF);
+        return _mm_packus_epi16(_mm_and_si128(lo, mask),
+                                _mm_and_si128(hi, mask));
+    }
+
+    // Unsigned products are never over 0x7FFF after the shift, so the
+    // signed to unsigned pack clamps them correctly
+    static vec muls(vec L, vec R, vec round, vec shift){
+        vec lo, hi;
+        widenMul(L, R, round, shift, lo, hi);
+        return (SIGN) ? _mm_packs_epi16(lo, hi) : _mm_packus_epi16(lo, hi);
+    }
+
+private:
+    static void widenMul(vec L, vec R, vec round, vec shift, vec &lo, vec &hi){
+        const vec zero = _mm_setzero_si128();
+
+        // Widen to 16 bit lanes, the products always fit
+        const vec LLo = (SIGN) ? _mm_srai_epi16(_mm_unpacklo_epi8(L, L), 8)
+                               : _mm_unpacklo_epi8(L, zero);
+        const vec LHi = (SIGN) ? _mm_srai_epi16(_mm_unpackhi_epi8(L, L), 8)
+                               : _mm_unpackhi_epi8(L, zero);
+        const vec RLo = (SIGN) ? _mm_srai_epi16(_mm_unpacklo_epi8(R, R), 8)
+                               : _mm_unpacklo_epi8(R, zero);
+        const vec RHi = (SIGN) ? _mm_srai_epi16(_mm_unpackhi_epi8(R, R), 8)
+                               : _mm_unpackhi_epi8(R, zero);
+
+        lo = _mm_add_epi16(_mm_mullo_epi16(LLo, RLo), round);
+        hi = _mm_add_epi16(_mm_mullo_epi16(LHi, RHi), round);
+        lo = (SIGN) ? _mm_sra_epi16(lo, shift) : _mm_srl_epi16(lo, shift);
+        hi = (SIGN) ? _mm_sra_epi16(hi, shift) : _mm_srl_epi16(hi, shift);
+    }
+};
+
+template<bool SIGN> struct FixedLanes128<2, SIGN>{
+    typedef __m128i vec;
+    static const bool HAS_MUL = true;
+    static const bool HAS_MULS = true;
+
+    static vec add(vec L, vec R){ return _mm_add_epi16(L, R);}
+    static vec sub(vec L, vec R){ return _mm_sub_epi16(L, R);}
+
+    static vec signMask(vec x){ return _mm_srai_epi16(x, 15);}
+    static vec set1(fastu64 x){ return _mm_set1_epi16(CAST<short>(x));}
+    static vec srl(vec x, fastu16 n){
+        return _mm_srl_epi16(x, _mm_cvtsi32_si128(n));
+    }
+
+    static vec adds(vec L, vec R){
+        return (SIGN) ? _mm_adds_epi16(L, R) : _mm_adds_epu16(L, R);
+    }
+    static vec subs(vec L, vec R){
+        return (SIGN) ? _mm_subs_epi16(L, R) : _mm_subs_epu16(L, R);
+    }
+
+    static vec round(fastu16 frac){ return _mm_set1_epi32(1 << (frac - 1));}
+
+    static vec mul(vec L, vec R, vec round, vec shift){
+        vec lo, hi;
+        widenMul(L, R, round, shift, lo, hi);
+
+        // Sign extend the low half so the saturating pack keeps the bits
+        lo = _mm_srai_epi32(_mm_slli_epi32(lo, 16), 16);
+        hi = _mm_srai_epi32(_mm_slli_epi32(hi, 16), 16);
+        return _mm_packs_epi32(lo, hi);
+    }
+
+    static vec muls(vec L, vec R, vec round, vec shift){
+        vec lo, hi;
+        widenMul(L, R, round, shift, lo, hi);
+        if(SIGN) return _mm_packs_epi32(lo, hi);
+
+        // SSE2 has no unsigned 32 bit pack. The products are never negative,
+        // so move them down by 0x8000 for the signed pack and back after.
+        const vec bias = _mm_set1_epi32(0x8000);
+        return _mm_xor_si128(_mm_packs_epi32(_mm_sub_epi32(lo, bias),
+                                             _mm_sub_epi32(hi, bias)),
+                             _mm_set1_epi16(-0x8000));
+    }
+
+private:
+    static void widenMul(vec L, vec R, vec round, vec shift, vec &lo, vec &hi){
+        const vec pLo = _mm_mullo_epi16(L, R);
+        const vec pHi = (SIGN) ? _mm_mulhi_epi16(L, R) : _mm_mulhi_epu16(L, R);
+
+        lo = _mm_add_epi32(_mm_unpacklo_epi16(pLo, pHi), round);
+        hi = _mm_add_epi32(_mm_unpackhi_epi16(pLo, pHi), round);
+        lo = (SIGN) ? _mm_sra_epi32(lo, shift) : _mm_srl_epi32(lo, shift);
+        hi = (SIGN) ? _mm_sra_epi32(hi, shift) : _mm_srl_epi32(hi, shift);
+    }
+};
+
+template<bool SIGN> struct FixedLanes128<4, SIGN>{
+    typedef __m128i vec;
+    static const bool HAS_MUL = true;
+    static const bool HAS_MULS = false;
+
+    static vec add(vec L, vec R){ return _mm_add_epi32(L, R);}
+    static vec sub(vec L, vec R){ return _mm_sub_epi32(L, R);}
+
+    static vec set1(fastu64 x){ return _mm_set1_epi32(CAST<int>(x));}
+    static vec srl(vec x, fastu16 n){
+        return _mm_srl_epi32(x, _mm_cvtsi32_si128(n));
+    }
+
+    static vec signMask(vec x){ return _mm_srai_epi32(x, 31);}
+    static vec maxValue(){ return _mm_set1_epi32(0x7FFFFFFF);}
+
+    static vec adds(vec L, vec R){
+        return FixedSaturate128<FixedLanes128>::adds(L, R, add(L, R));
+    }
+    static vec subs(vec L, vec R){
+        return FixedSaturate128<FixedLanes128>::subs(L, R, sub(L, R));
+    }
+
+    static vec round(fastu16 frac){
+        return _mm_set1_epi64x(CAST<fast64>(1) << (frac - 1));
+    }
+
+    static vec mul(vec L, vec R, vec round, vec shift){
+        const vec lowMask = _mm_set_epi32(0, -1, 0, -1);
+
+        // SSE2 only has an unsigned 32x32->64 multiply on the even lanes
+        vec even = _mm_mul_epu32(L, R);
+        vec odd  = _mm_mul_epu32(_mm_srli_epi64(L, 32), _mm_srli_epi64(R, 32));
+
+        if(SIGN){
+            // a*b = ua*ub - ((a < 0 ? ub : 0) + (b < 0 ? ua : 0)) << 32
+            const vec fix = _mm_add_epi32(
+                                _mm_and_si128(_mm_srai_epi32(L, 31), R),
+                                _mm_and_si128(_mm_srai_epi32(R, 31), L));
+            even = _mm_sub_epi64(even, _mm_slli_epi64(fix, 32));
+            odd  = _mm_sub_epi64(odd, _mm_andnot_si128(lowMask, fix));
+        }
+
+        // FRAC + 32 <= 63, so a logical shift leaves the kept bits alone
+        even = _mm_srl_epi64(_mm_add_epi64(even, round), shift);
+        odd  = _mm_srl_epi64(_mm_add_epi64(odd, round), shift);
+
+        return _mm_or_si128(_mm_and_si128(even, lowMask),
+                            _mm_slli_epi64(odd, 32));
+    }
+};
+
+template<bool SIGN> struct FixedLanes128<8, SIGN>{
+    typedef __m128i vec;
+    static const bool HAS_MUL = false;
+    static const bool HAS_MULS = false;
+
+    static vec add(vec L, vec R){ return _mm_add_epi64(L, R);}
+    static vec sub(vec L, vec R){ return _mm_sub_epi64(L, R);}
+
+    static vec set1(fastu64 x){ return _mm_set1_epi64x(CAST<long long>(x));}
+    static vec srl(vec x, fastu16 n){
+        return _mm_srl_epi64(x, _mm_cvtsi32_si128(n));
+    }
+
+    // There is no 64 bit arithmetic shift, copy the high half's sign down
+    static vec signMask(vec x){
+        return _mm_shuffle_epi32(_mm_srai_epi32(x, 31),
+                                 _MM_SHUFFLE(3, 3, 1, 1));
+    }
+    static vec maxValue(){ return _mm_set1_epi64x(0x7FFFFFFFFFFFFFFFLL);}
+
+    static vec adds(vec L, vec R){
+        return FixedSaturate128<FixedLanes128>::adds(L, R, add(L, R));
+    }
+    static vec subs(vec L, vec R){
+        return FixedSaturate128<FixedLanes128>::subs(L, R, sub(L, R));
+    }
+};
+
+#endif // FIXED_BATCH_SSE2
+
+
+
+#if FIXED_BATCH_AVX2 == 1
+
+// **************************************************************
+//                    AVX2 Lanes (256 bit vectors)
+// **************************************************************
+template<std::size_t BYTES, bool SIGN> struct FixedLanes256;
+
+// Same sign bit tests as FixedSaturate128
+template<class LANES> struct FixedSaturate256;
+
+template<template<std::size_t, bool> class LANES, std::size_t BYTES, bool SIGN>
+struct FixedSaturate256<LANES<BYTES, SIGN> >{
+    typedef __m256i vec;
+    typedef LANES<BYTES, SIGN> lanes;
+
+    static vec adds(vec L, vec R, vec sum){
+        if(SIGN){
+            const vec over = lanes::signMask(_mm256_andnot_si256(
+                                 _mm256_xor_si256(L, R),
+                                 _mm256_xor_si256(L, sum)));
+            return _mm256_blendv_epi8(sum, limit(L), over);
+        }
+        const vec carry = lanes::signMask(_mm256_or_si256(
+                              _mm256_and_si256(L, R),
+                              _mm256_andnot_si256(sum, _mm256_or_si256(L, R))));
+        return _mm256_or_si256(sum, carry);
+    }
+
+    static vec subs(vec L, vec R, vec diff){
+        if(SIGN){
+            const vec over = lanes::signMask(_mm256_and_si256(
+                                 _mm256_xor_si256(L, R),
+                                 _mm256_xor_si256(L, diff)));
+            return _mm256_blendv_epi8(diff, limit(L), over);
+        }
+        const vec borrow = lanes::signMask(_mm256_or_si256(
+                               _mm256_andnot_si256(L, R),
+                               _mm256_andnot_si256(_mm256_xor_si256(L, R),
+                                                   diff)));
+        return _mm256_andnot_si256(borrow, diff);
+    }
+
+private:
+    static vec limit(vec L){ return _mm256_xor_si256(lanes::signMask(L),
+                                                     lanes::maxValue());}
+};
+
+template<bool SIGN> struct FixedLanes256<1, SIGN>{
+    typedef __m256i vec;
+    static const bool HAS_MUL = true;
+    static const bool HAS_MULS = true;
+
+    static vec add(vec L, vec R){ return _mm256_add_epi8(L, R);}
+    static vec sub(vec L, vec R){ return _mm256_sub_epi8(L, R);}
+
+    // There is no 8 bit shift, so 16 bit lanes are shifted and the bits
+    // that crossed into the next lane are cleared
+    static vec signMask(vec x){
+        return _mm256_cmpgt_epi8(_mm256_setzero_si256(), x);
+    }
+    static vec set1(fastu64 x){ return _mm256_set1_epi8(CAST<char>(x));}
+    static vec srl(vec x, fastu16 n){
+        return _mm256_and_si256(_mm256_srl_epi16(x, _mm_cvtsi32_si128(n)),
+                                _mm256_set1_epi8(CAST<char>(0xFF >> n)));
+    }
+
+    static vec adds(vec L, vec R){
+        return (SIGN) ? _mm256_adds_epi8(L, R) : _mm256_adds_epu8(L, R);
+    }
+    static vec subs(vec L, vec R){
+        return (SIGN) ? _mm256_subs_epi8(L, R) : _mm256_subs_epu8(L, R);
+    }
+
+    static vec round(fastu16 frac){ return _mm256_set1_epi16(1 << (frac - 1));}
+
+    static vec mul(vec L, vec R, vec round, __m128i shift){
+        vec lo, hi;
+        widenMul(L, R, round, shift, lo, hi);
+
+        const vec mask = _mm256_set1_epi16(0x00FF);
+        return _mm256_packus_epi16(_mm256_and_si256(lo, mask),
+                                   _mm256_and_si256(hi, mask));
+    }
+
+    static vec muls(vec L, vec R, vec round, __m128i shift){
+        vec lo, hi;
+        widenMul(L, R, round, shift, lo, hi);
+        return (SIGN) ? _mm256_packs_epi16(lo, hi)
+                      : _mm256_packus_epi16(lo, hi);
+    }
+
+private:
+    static void widenMul(vec L, vec R, vec round, __m128i shift,
+                         vec &lo, vec &hi){
+        const vec zero = _mm256_setzero_si256();
+
+        // Unpack and pack both work per 128 bit lane, so the order is kept
+        const vec LLo = (SIGN) ? _mm256_srai_epi16(_mm256_unpacklo_epi8(L, L), 8)
+                               : _mm256_unpacklo_epi8(L, zero);
+        const vec LHi = (SIGN) ? _mm256_srai_epi16(_mm256_unpackhi_epi8(L, L), 8)
+                               : _mm256_unpackhi_epi8(L, zero);
+        const vec RLo = (SIGN) ? _mm256_srai_epi16(_mm256_unpacklo_epi8(R, R), 8)
+                               : _mm256_unpacklo_epi8(R, zero);
+        const vec RHi = (SIGN) ? _mm256_srai_epi16(_mm256_unpackhi_epi8(R, R), 8)
+                               : _mm256_unpackhi_epi8(R, zero);
+
+        lo = _mm256_add_epi16(_mm256_mullo_epi16(LLo, RLo), round);
+        hi = _mm256_add_epi16(_mm256_mullo_epi16(LHi, RHi), round);
+        lo = (SIGN) ? _mm256_sra_epi16(lo, shift) : _mm256_srl_epi16(lo, shift);
+        hi = (SIGN) ? _mm256_sra_epi16(hi, shift) : _mm256_srl_epi16(hi, shift);
+    }
+};
+
+template<bool SIGN> struct FixedLanes256<2, SIGN>{
+    typedef __m256i vec;
+    static const bool HAS_MUL = true;
+    static const bool HAS_MULS = true;
+
+    static vec add(vec L, vec R){ return _mm256_add_epi16(L, R);}
+    static vec sub(vec L, vec R){ return _mm256_sub_epi16(L, R);}
+
+    static vec signMask(vec x){ return _mm256_srai_epi16(x, 15);}
+    static vec set1(fastu64 x){ return _mm256_set1_epi16(CAST<short>(x));}
+    static vec srl(vec x, fastu16 n){
+        return _mm256_srl_epi16(x, _mm_cvtsi32_si128(n));
+    }
+
+    static vec adds(vec L, vec R){
+        return (SIGN) ? _mm256_adds_epi16(L, R) : _mm256_adds_epu16(L, R);
+    }
+    static vec subs(vec L, vec R){
+        return (SIGN) ? _mm256_subs_epi16(L, R) : _mm256_subs_epu16(L, R);
+    }
+
+    static vec round(fastu16 frac){ return _mm256_set1_epi32(1 << (frac - 1));}
+
+    static vec mul(vec L, vec R, vec round, __m128i shift){
+        vec lo, hi;
+        widenMul(L, R, round, shift, lo, hi);
+
+        lo = _mm256_srai_epi32(_mm256_slli_epi32(lo, 16), 16);
+        hi = _mm256_srai_epi32(_mm256_slli_epi32(hi, 16), 16);
+        return _mm256_packs_epi32(lo, hi);
+    }
+
+    static vec muls(vec L, vec R, vec round, __m128i shift){
+        vec lo, hi;
+        widenMul(L, R, round, shift, lo, hi);
+        return (SIGN) ? _mm256_packs_epi32(lo, hi)
+                      : _mm256_packus_epi32(lo, hi);
+    }
+
+private:
+    static void widenMul(vec L, vec R, vec round, __m128i shift,
+                         vec &lo, vec &hi){
+        const vec pLo = _mm256_mullo_epi16(L, R);
+        const vec pHi = (SIGN) ? _mm256_mulhi_epi16(L, R)
+                               : _mm256_mulhi_epu16(L, R);
+
+        lo = _mm256_add_epi32(_mm256_unpacklo_epi16(pLo, pHi), round);
+        hi = _mm256_add_epi32(_mm256_unpackhi_epi16(pLo, pHi), round);
+        lo = (SIGN) ? _mm256_sra_epi32(lo, shift) : _mm256_srl_epi32(lo, shift);
+        hi = (SIGN) ? _mm256_sra_epi32(hi, shift) : _mm256_srl_epi32(hi, shift);
+    }
+};
+
+template<bool SIGN> struct FixedLanes256<4, SIGN>{
+    typedef __m256i vec;
+    static const bool HAS_MUL = true;
+    static const bool HAS_MULS = false;
+
+    static vec add(vec L, vec R){ return _mm256_add_epi32(L, R);}
+    static vec sub(vec L, vec R){ return _mm256_sub_epi32(L, R);}
+
+    static vec set1(fastu64 x){ return _mm256_set1_epi32(CAST<int>(x));}
+    static vec srl(vec x, fastu16 n){
+        return _mm256_srl_epi32(x, _mm_cvtsi32_si128(n));
+    }
+
+    static vec signMask(vec x){ return _mm256_srai_epi32(x, 31);}
+    static vec maxValue(){ return _mm256_set1_epi32(0x7FFFFFFF);}
+
+    static vec adds(vec L, vec R){
+        return FixedSaturate256<FixedLanes256>::adds(L, R, add(L, R));
+    }
+    static vec subs(vec L, vec R){
+        return FixedSaturate256<FixedLanes256>::subs(L, R, sub(L, R));
+    }
+
+    static vec round(fastu16 frac){
+        return _mm256_set1_epi64x(CAST<fast64>(1) << (frac - 1));
+    }
+
+    static vec mul(vec L, vec R, vec round, __m128i shift){
+        const vec lowMask = _mm256_set1_epi64x(0xFFFFFFFFLL);
+        const vec LOdd = _mm256_srli_epi64(L, 32);
+        const vec ROdd = _mm256_srli_epi64(R, 32);
+
+        vec even = (SIGN) ? _mm256_mul_epi32(L, R) : _mm256_mul_epu32(L, R);
+        vec odd  = (SIGN) ? _mm256_mul_epi32(LOdd, ROdd)
+                          : _mm256_mul_epu32(LOdd, ROdd);
+
+        even = _mm256_srl_epi64(_mm256_add_epi64(even, round), shift);
+        odd  = _mm256_srl_epi64(_mm256_add_epi64(odd, round), shift);
+
+        return _mm256_or_si256(_mm256_and_si256(even, lowMask),
+                               _mm256_slli_epi64(odd, 32));
+    }
+};
+
+template<bool SIGN> struct FixedLanes256<8, SIGN>{
+    typedef __m256i vec;
+    static const bool HAS_MUL = false;
+    static const bool HAS_MULS = false;
+
+    static vec add(vec L, vec R){ return _mm256_add_epi64(L, R);}
+    static vec sub(vec L, vec R){ return _mm256_sub_epi64(L, R);}
+
+    static vec set1(fastu64 x){ return _mm256_set1_epi64x(CAST<long long>(x));}
+    static vec srl(vec x, fastu16 n){
+        return _mm256_srl_epi64(x, _mm_cvtsi32_si128(n));
+    }
+
+    static vec signMask(vec x){
+        return _mm256_shuffle_epi32(_mm256_srai_epi32(x, 31),
+                                    _MM_SHUFFLE(3, 3, 1, 1));
+    }
+    static vec maxValue(){ return _mm256_set1_epi64x(0x7FFFFFFFFFFFFFFFLL);}
+
+    static vec adds(vec L, vec R){
+        return FixedSaturate256<FixedLanes256>::adds(L, R, add(L, R));
+    }
+    static vec subs(vec L, vec R){
+        return FixedSaturate256<FixedLanes256>::subs(L, R, sub(L, R));
+    }
+};
+
+#endif // FIXED_BATCH_AVX2
+
+
+
+// **************************************************************
+//                     Vector Loop Templates
+// **************************************************************
+// Each loop starts at element i, runs over as many whole vectors as fit before
+// count, and returns where it stopped so the caller can finish the tail.
+#if FIXED_BATCH_SSE2 == 1 || FIXED_BATCH_AVX2 == 1
+
+template<class LANES, class T> struct FixedSimd{
+    typedef typename LANES::vec vec;
+    static const std::size_t STEP = sizeof(vec) / sizeof(T);
+
+    static vec load(const T *p){ return loadVec(p, vec());}
+    static void store(T *p, vec v){ storeVec(p, v);}
+
+    static std::size_t add(T *dst, const T *L, const T *R,
+                           std::size_t i, std::size_t count){
+        for(; i + STEP <= count; i += STEP)
+            store(dst + i, LANES::add(load(L + i), load(R + i)));
+        return i;
+    }
+
+    static std::size_t sub(T *dst, const T *L, const T *R,
+                           std::size_t i, std::size_t count){
+        for(; i + STEP <= count; i += STEP)
+            store(dst + i, LANES::sub(load(L + i), load(R + i)));
+        return i;
+    }
+
+    static std::size_t adds(T *dst, const T *L, const T *R,
+                            std::size_t i, std::size_t count){
+        for(; i + STEP <= count; i += STEP)
+            store(dst + i, LANES::adds(load(L + i), load(R + i)));
+        return i;
+    }
+
+    static std::size_t subs(T *dst, const T *L, const T *R,
+                            std::size_t i, std::size_t count){
+        for(; i + STEP <= count; i += STEP)
+            store(dst + i, LANES::subs(load(L + i), load(R + i)));
+        return i;
+    }
+
+    // SAT picks the saturating multiply, and the saturating add for mac
+    template<bool SAT>
+    static std::size_t mul(T *dst, const T *L, const T *R,
+                           std::size_t i, std::size_t count, fastu16 frac){
+        return mul(dst, L, R, i, count, frac,
+                   std::integral_constant<bool, SAT>(),
+                   std::integral_constant<bool, (SAT) ? LANES::HAS_MULS
+                                                      : LANES::HAS_MUL>());
+    }
+
+    template<bool SAT>
+    static std::size_t mac(T *dst, const T *L, const T *R,
+                           std::size_t i, std::size_t count, fastu16 frac){
+        return mac(dst, L, R, i, count, frac,
+                   std::integral_constant<bool, SAT>(),
+                   std::integral_constant<bool, (SAT) ? LANES::HAS_MULS
+                                                      : LANES::HAS_MUL>());
+    }
+
+    // Same adds as Fixed::round<MODE>(), with the lanes taken as signed
+    // for FIXED_ROUND_TO_ZERO
+    template<FixedRounding MODE>
+    static std::size_t round(T *dst, const T *src, const T *noise,
+                             std::size_t i, std::size_t count, fastu16 frac){
+        const fastu64 one = CAST<fastu64>(1) << frac;
+        const vec mask = LANES::set1(one - 1);
+        const vec half = LANES::set1(one >> 1);
+        const vec even = LANES::set1((one >> 1) - 1);
+        const vec low = LANES::set1(1);
+        const vec zero = LANES::set1(0);
+
+        for(; i + STEP <= count; i += STEP){
+            const vec x = load(src + i);
+            const vec add =
+                (MODE == FIXED_ROUND_CEIL)      ? mask :
+                (MODE == FIXED_ROUND_HALF_UP)   ? half :
+                (MODE == FIXED_ROUND_HALF_EVEN) ?
+                    LANES::add(even, andVec(LANES::srl(x, frac), low)) :
+                (MODE == FIXED_ROUND_TO_ZERO)   ?
+                    andVec(mask, LANES::signMask(x)) :
+                (MODE == FIXED_ROUND_STOCHASTIC) ?
+                    andVec(load(noise + i), mask) : zero;
+            store(dst + i, andNotVec(mask, LANES::add(x, add)));
+        }
+        return i;
+    }
+
+private:
+#if FIXED_BATCH_SSE2 == 1
+    static __m128i loadVec(const T *p, __m128i){
+        return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    }
+    static void storeVec(T *p, __m128i v){
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v);
+    }
+    static __m128i andVec(__m128i L, __m128i R){ return _mm_and_si128(L, R);}
+    static __m128i andNotVec(__m128i L, __m128i R){
+        return _mm_andnot_si128(L, R);
+    }
+#endif // FIXED_BATCH_SSE2
+#if FIXED_BATCH_AVX2 == 1
+    static __m256i loadVec(const T *p, __m256i){
+        return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    }
+    static void storeVec(T *p, __m256i v){
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v);
+    }
+    static __m256i andVec(__m256i L, __m256i R){
+        return _mm256_and_si256(L, R);
+    }
+    static __m256i andNotVec(__m256i L, __m256i R){
+        return _mm256_andnot_si256(L, R);
+    }
+#endif // FIXED_BATCH_AVX2
+
+    template<class SAT>
+    static std::size_t mul(T *dst, const T *L, const T *R, std::size_t i,
+                           std::size_t count, fastu16 frac, SAT sat,
+                           std::true_type){
+        const vec round = LANES::round(frac);
+        const __m128i shift = _mm_cvtsi32_si128(frac);
+
+        for(; i + STEP <= count; i += STEP)
+            store(dst + i, mulVec(load(L + i), load(R + i), round, shift, sat));
+        return i;
+    }
+    template<class SAT>
+    static std::size_t mul(T*, const T*, const T*, std::size_t i, std::size_t,
+                           fastu16, SAT, std::false_type){
+        return i;
+    }
+
+    template<class SAT>
+    static std::size_t mac(T *dst, const T *L, const T *R, std::size_t i,
+                           std::size_t count, fastu16 frac, SAT sat,
+                           std::true_type){
+        const vec round = LANES::round(frac);
+        const __m128i shift = _mm_cvtsi32_si128(frac);
+
+        for(; i + STEP <= count; i += STEP)
+            store(dst + i, addVec(load(dst + i),
+                   mulVec(load(L + i), load(R + i), round, shift, sat), sat));
+        return i;
+    }
+    template<class SAT>
+    static std::size_t mac(T*, const T*, const T*, std::size_t i, std::size_t,
+                           fastu16, SAT, std::false_type){
+        return i;
+    }
+
+    static vec mulVec(vec L, vec R, vec round, __m128i shift, std::false_type){
+        return LANES::mul(L, R, round, shift);
+    }
+    static vec mulVec(vec L, vec R, vec round, __m128i shift, std::true_type){
+        return LANES::muls(L, R, round, shift);
+    }
+    static vec addVec(vec L, vec R, std::false_type){ return LANES::add(L, R);}
+    static vec addVec(vec L, vec R, std::true_type){ return LANES::adds(L, R);}
+};
+
+#endif // FIXED_BATCH_SSE2 || FIXED_BATCH_AVX2
+
+
+
+// **************************************************************
+//                    Raw Buffer Batch Operations
+// **************************************************************
+template<fastu16 _INT, fastu16 _FRAC, bool _SIGN = SIGNED,
+         FixedOverflow _OVER = FIXED_WRAP> class FixedBatch{
+public:
+    typedef Fixed<_INT, _FRAC, _SIGN, _OVER> fixed;
+    typedef typename fixed::fixSize fixSize;
+    typedef typename fixed::ufixSize ufixSize;
+
+    // Wider formats keep a FixedInt128, which the kernels and the scalar
+    // loops do not handle
+    static_assert(_INT + _FRAC + _SIGN <= 64,
+                  "FixedBatch.h: only formats up to 64 bits have batch ops");
+    static_assert(sizeof(fixed) == sizeof(fixSize) &&
+                  std::is_standard_layout<fixed>::value,
+                  "FixedBatch.h: Fixed needs the same layout as its fixSize");
+
+    // The vector loops are skipped for FIXED_TRAP, and the scalar operators
+    // finish whatever the vectors did not
+    static void add(fixSize *dst, const fixSize *L, const fixSize *R,
+                    std::size_t count){
+        std::size_t i = 0;
+#if FIXED_BATCH_AVX2 == 1
+        if(_OVER == FIXED_WRAP) i = simd256::add(dst, L, R, i, count);
+        if(SAT)                 i = simd256::adds(dst, L, R, i, count);
+#endif
+#if FIXED_BATCH_SSE2 == 1
+        if(_OVER == FIXED_WRAP) i = simd128::add(dst, L, R, i, count);
+        if(SAT)                 i = simd128::adds(dst, L, R, i, count);
+#endif
+        for(; i < count; i++)
+            dst[i] = (toFixed(L[i]) + toFixed(R[i])).getRawNumber();
+    }
+
+    static void sub(fixSize *dst, const fixSize *L, const fixSize *R,
+                    std::size_t count){
+        std::size_t i = 0;
+#if FIXED_BATCH_AVX2 == 1
+        if(_OVER == FIXED_WRAP) i = simd256::sub(dst, L, R, i, count);
+        if(SAT)                 i = simd256::subs(dst, L, R, i, count);
+#endif
+#if FIXED_BATCH_SSE2 == 1
+        if(_OVER == FIXED_WRAP) i = simd128::sub(dst, L, R, i, count);
+        if(SAT)                 i = simd128::subs(dst, L, R, i, count);
+#endif
+        for(; i < count; i++)
+            dst[i] = (toFixed(L[i]) - toFixed(R[i])).getRawNumber();
+    }
+
+    static void mul(fixSize *dst, const fixSize *L, const fixSize *R,
+                    std::size_t count){
+        std::size_t i = 0;
+#if FIXED_BATCH_AVX2 == 1
+        if(_OVER != FIXED_TRAP)
+            i = simd256::template mul<SAT>(dst, L, R, i, count, _FRAC);
+#endif
+#if FIXED_BATCH_SSE2 == 1
+        if(_OVER != FIXED_TRAP)
+            i = simd128::template mul<SAT>(dst, L, R, i, count, _FRAC);
+#endif
+        for(; i < count; i++)
+            dst[i] = (toFixed(L[i]) * toFixed(R[i])).getRawNumber();
+    }
+
+    static void div(fixSize *dst, const fixSize *L, const fixSize *R,
+                    std::size_t count){
+        // There is no integer divide instruction in SSE2 or AVX2
+        for(std::size_t i = 0; i < count; i++)
+            dst[i] = (toFixed(L[i]) / toFixed(R[i])).getRawNumber();
+    }
+
+    static void mac(fixSize *dst, const fixSize *L, const fixSize *R,
+                    std::size_t count){
+        std::size_t i = 0;
+#if FIXED_BATCH_AVX2 == 1
+        if(_OVER != FIXED_TRAP)
+            i = simd256::template mac<SAT>(dst, L, R, i, count, _FRAC);
+#endif
+#if FIXED_BATCH_SSE2 == 1
+        if(_OVER != FIXED_TRAP)
+            i = simd128::template mac<SAT>(dst, L, R, i, count, _FRAC);
+#endif
+        for(; i < count; i++)
+            dst[i] = (toFixed(dst[i]) +
+                      toFixed(L[i]) * toFixed(R[i])).getRawNumber();
+    }
+
+    // noise is only read by FIXED_ROUND_STOCHASTIC. Rounding ignores the
+    // overflow policy, so every policy takes the vector loops.
+    template<FixedRounding MODE>
+    static void round(fixSize *dst, const fixSize *src, const fixSize *noise,
+                      std::size_t count){
+        // Unsigned numbers round toward zero by rounding down
+        const FixedRounding LANE_MODE =
+            (!_SIGN && MODE == FIXED_ROUND_TO_ZERO) ? FIXED_ROUND_FLOOR : MODE;
+        std::size_t i = 0;
+#if FIXED_BATCH_AVX2 == 1
+        i = simd256::template round<LANE_MODE>(dst, src, noise, i, count,
+                                               _FRAC);
+#endif
+#if FIXED_BATCH_SSE2 == 1
+        i = simd128::template round<LANE_MODE>(dst, src, noise, i, count,
+                                               _FRAC);
+#endif
+        for(; i < count; i++){
+            const ufixSize random = (MODE == FIXED_ROUND_STOCHASTIC) ?
+                                    CAST<ufixSize>(noise[i]) : 0;
+            dst[i] = toFixed(src[i]).template round<MODE>(random)
+                         .getRawNumber();
+        }
+    }
+
+    // Fixed buffers share the layout of their raw numbers
+    static fixSize* raw(fixed *buf){
+        return reinterpret_cast<fixSize*>(buf);
+    }
+    static const fixSize* raw(const fixed *buf){
+        return reinterpret_cast<const fixSize*>(buf);
+    }
+
+private:
+    const static bool SAT = _OVER == FIXED_SATURATE;
+
+    static fixed toFixed(fixSize num){
+        fixed ret;
+        ret.setRawNumber(num);
+        return ret;
+    }
+
+#if FIXED_BATCH_SSE2 == 1
+    typedef FixedSimd<FixedLanes128<sizeof(fixSize), _SIGN>, fixSize> simd128;
+#endif
+#if FIXED_BATCH_AVX2 == 1
+    typedef FixedSimd<FixedLanes256<sizeof(fixSize), _SIGN>, fixSize> simd256;
+#endif
+};
+
+
+
+// **************************************************************
+//                    Fixed Buffer Batch Functions
+// **************************************************************
+template<fastu16 INT, fastu16 FRAC, bool SIGN, FixedOverflow OVER>
+void Fixed_batchAdd(Fixed<INT, FRAC, SIGN, OVER> *dst,
+                    const Fixed<INT, FRAC, SIGN, OVER> *L,
+                    const Fixed<INT, FRAC, SIGN, OVER> *R, std::size_t count){
+    typedef FixedBatch<INT, FRAC, SIGN, OVER> batch;
+    batch::add(batch::raw(dst), batch::raw(L), batch::raw(R), count);
+}
+
+template<fastu16 INT, fastu16 FRAC, bool SIGN, FixedOverflow OVER>
+void Fixed_batchSub(Fixed<INT, FRAC, SIGN, OVER> *dst,
+                    const Fixed<INT, FRAC, SIGN, OVER> *L,
+                    const Fixed<INT, FRAC, SIGN, OVER> *R, std::size_t count){
+    typedef FixedBatch<INT, FRAC, SIGN, OVER> batch;
+    batch::sub(batch::raw(dst), batch::raw(L), batch::raw(R), count);
+}
+
+template<fastu16 INT, fastu16 FRAC, bool SIGN, FixedOverflow OVER>
+void Fixed_batchMul(Fixed<INT, FRAC, SIGN, OVER> *dst,
+                    const Fixed<INT, FRAC, SIGN, OVER> *L,
+                    const Fixed<INT, FRAC, SIGN, OVER> *R, std::size_t count){
+    typedef FixedBatch<INT, FRAC, SIGN, OVER> batch;
+    batch::mul(batch::raw(dst), batch::raw(L), batch::raw(R), count);
+}
+
+template<fastu16 INT, fastu16 FRAC, bool SIGN, FixedOverflow OVER>
+void Fixed_batchDiv(Fixed<INT, FRAC, SIGN, OVER> *dst,
+                    const Fixed<INT, FRAC, SIGN, OVER> *L,
+                    const Fixed<INT, FRAC, SIGN, OVER> *R, std::size_t count){
+    typedef FixedBatch<INT, FRAC, SIGN, OVER> batch;
+    batch::div(batch::raw(dst), batch::raw(L), batch::raw(R), count);
+}
+
+template<fastu16 INT, fastu16 FRAC, bool SIGN, FixedOverflow OVER>
+void Fixed_batchMac(Fixed<INT, FRAC, SIGN, OVER> *dst,
+                    const Fixed<INT, FRAC, SIGN, OVER> *L,
+                    const Fixed<INT, FRAC, SIGN, OVER> *R, std::size_t count){
+    typedef FixedBatch<INT, FRAC, SIGN, OVER> batch;
+    batch::mac(batch::raw(dst), batch::raw(L), batch::raw(R), count);
+}
+
+// dst[i] = src[i].round<MODE>(), dst may be the same buffer as src. noise
+// has one random raw number per element for FIXED_ROUND_STOCHASTIC, from
+// FixedRandom::fillBits() for one, and is not read by the other modes.
+template<FixedRounding MODE, fastu16 INT, fastu16 FRAC, bool SIGN,
+         FixedOverflow OVER>
+void Fixed_batchRound(Fixed<INT, FRAC, SIGN, OVER> *dst,
+                      const Fixed<INT, FRAC, SIGN, OVER> *src,
+                      std::size_t count,
+                      const Fixed<INT, FRAC, SIGN, OVER> *noise = nullptr){
+    typedef FixedBatch<INT, FRAC, SIGN, OVER> batch;
+    assert(MODE != FIXED_ROUND_STOCHASTIC || noise != nullptr);
+    batch::template round<MODE>(batch::raw(dst), batch::raw(src),
+                                batch::raw(noise), count);
+}
+
+#endif // FIXEDBATCH_H
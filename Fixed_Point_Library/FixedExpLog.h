@@ -0,0 +1,748 @@
+/*
+ *  @file    FixedExpLog.h
+ *
+ *  @brief Table and polynomial exp2, exp, log2 and ln, and rounded sqrt and
+ *         rsqrt
+ *
+ *  DESCRIPTION
+ *
+ * Fixed_exp2Table, Fixed_expTable, Fixed_log2Table, Fixed_lnTable,
+ * Fixed_sqrt and Fixed_rsqrt work for every Fixed format up to 64 bits,
+ * signed or unsigned, and take about the same number of steps for any input.
+ *
+ *     Fixed<16, 15> gain = Fixed_exp2Table(Fixed<16, 15>(-1.5));  // 0.3535
+ *     Fixed<8, 23> level = Fixed_log2Table(Fixed<8, 23>(1000));   // 9.9657
+ *
+ * exp2, exp, log2 and ln split the input into a power of two and a mantissa
+ * in [1, 2). The top FIXED_EXPLOG_BITS bits of the mantissa pick a table
+ * entry, and a polynomial covers what is left, which is under 2^-8:
+ *
+ *   Up to 32 bits: Q31 and Q32 tables and cubic polynomials, within an LSB
+ *   or so. exp2 with 8 or fewer FRAC bits has an entry for every fraction
+ *   and skips the polynomial.
+ *
+ *   Over 32 bits: Q62 tables built with integer math. Formats with up to
+ *   38 FRAC bits finish in double math when the result is under 2^44
+ *   LSBs, which is every log2 and ln. The rest use polynomials to 2^-65
+ *   in Q62. Within a few LSBs where a result uses every bit of the format,
+ *   and log2 and ln keep at least 56 fraction bits.
+ *
+ * sqrt and rsqrt have no table. sqrt takes the <cmath> double square root
+ * of raw * 2^FRAC and fixes it up against the exact integer square, so it
+ * is rounded to the nearest LSB where the double round trip truncates.
+ * Once raw * 2^FRAC is over 48 bits the check makes it two to three times
+ * slower than the round trip. rsqrt is one double square root and divide,
+ * within an LSB, and redoes results past 2^51 LSBs with the integer root
+ * and a divide, at about the speed of the round trip.
+ *
+ * Against toDouble(), the <cmath> function and back (FxPtBench.h), formats
+ * up to 32 bits run exp2, exp, log2 and ln at about the same speed or
+ * faster, except exp, which is about a quarter slower. Formats over 32 bits
+ * with up to 38 FRAC bits run them at about the same speed or faster
+ * (Fixed<30, 33>). With more FRAC bits they stay in Q62 and run at about
+ * half to two thirds of the speed (Fixed<7, 56>), but are more accurate,
+ * since those results need more than the 53 bits of a double. Formats
+ * over 64 bits are rejected at compile time. The tables are built at
+ * compile time: 1.5KB, 1KB more for exp2 with 8 FRAC bits, and 5KB more for
+ * formats over 32 bits.
+ *
+ * Results that do not fit the format follow its overflow policy. Inputs
+ * with no answer give the closest one: log2 and ln of x <= 0 give
+ * getMinValue(), sqrt of x < 0 gives 0, and rsqrt of x <= 0 gives
+ * getMaxValue().
+ *
+ * Fixed_batchExp2(dst, src, count) and the other batch functions run the
+ * same code over a buffer. There is no loop carried dependency, so the
+ * lookups and multiplies of neighbouring elements overlap.
+ */
+
+
+
+
+#ifndef FIXEDEXPLOG_H
+#define FIXEDEXPLOG_H
+
+#include "FixedTrig.h"
+#include <cmath>
+#include <cstddef>
+
+// Mantissa bits used to index the tables, 7 keeps the polynomials cubic
+#define FIXED_EXPLOG_BITS 7
+
+#define FIXED_LN2_Q32   0xB17217F8ULL            // ln(2) * 2^32
+#define FIXED_LN2_Q64   0xB17217F7D1CF79ACULL    // ln(2) * 2^64
+#define FIXED_LOG2E_Q31 0xB8AA3B29ULL            // log2(e) * 2^31
+#define FIXED_LOG2E_Q62 0x5C551D94AE0BF85EULL    // log2(e) * 2^62
+
+
+
+// **************************************************************
+//                  Compile Time Table Helpers
+// **************************************************************
+// ln(x) for x > 0 from the atanh series, only run by the compiler
+constexpr double Fixed_constLn(double x){
+    double scale = 0;
+    while(x > 1.5){ x /= 2; scale += 1;}
+    while(x < 0.75){ x *= 2; scale -= 1;}
+
+    const double z = (x - 1) / (x + 1);
+    double term = z, sum = 0;
+    for(fast32 n = 0; n < 30; n++){
+        sum += term / (2 * n + 1);
+        term *= z * z;
+    }
+    return 2 * sum + scale * 0.693147180559945309417;
+}
+
+// e^x for small x from the Taylor series
+constexpr double Fixed_constExp(double x){
+    double term = 1, sum = 1;
+    for(fast32 n = 1; n < 25; n++){
+        term *= x / n;
+        sum += term;
+    }
+    return sum;
+}
+
+constexpr fastu32 Fixed_constRoundU32(double x){
+    return CAST<fastu32>(CAST<fastu64>(x + 0.5));
+}
+
+// (a * b) >> 62 rounded, the product of two Q62 numbers
+constexpr fastu64 Fixed_mulQ62(fastu64 a, fastu64 b){
+    fastu64 hi = 0, lo = 0;
+    FixedLimb::mul(a, b, hi, lo);
+    return ((hi << 2) | (lo >> 62)) + ((lo >> 61) & 1);
+}
+
+// Entry i covers mantissas in [1 + i / 2^BITS, 1 + (i + 1) / 2^BITS)
+template<fastu16 BITS> struct FixedExpLogTable{
+    // 2^32 / (1 + (i + 0.5) / 2^BITS), mantissa * recip is within 2^-8 of 1
+    fastu32 recip[1 << BITS];
+    // log2(2^32 / recip), Q32
+    fastu32 log2[1 << BITS];
+
+    constexpr FixedExpLogTable(): recip(), log2(){
+        const double LOG2E = 1.44269504088896340736;
+        for(fast32 i = 0; i < (1 << BITS); i++){
+            recip[i] = Fixed_constRoundU32(
+                4294967296.0 / (1 + (i + 0.5) / (1 << BITS)));
+
+            const double mant = 4294967296.0 / recip[i];
+            log2[i] = Fixed_constRoundU32(
+                Fixed_constLn(mant) * LOG2E * 4294967296.0);
+        }
+    }
+};
+
+// 2^(i / 2^BITS), Q31
+template<fastu16 BITS> struct FixedExp2Table{
+    fastu32 exp2[1 << BITS];
+
+    constexpr FixedExp2Table(): exp2(){
+        for(fast32 i = 0; i < (1 << BITS); i++){
+            exp2[i] = Fixed_constRoundU32(
+                Fixed_constExp(i * 0.693147180559945309417 / (1 << BITS)) *
+                2147483648.0);
+        }
+    }
+};
+
+// The same entries in Q62 for formats over 32 bits. A double only has 53
+// bits, so these are built with integer math.
+template<fastu16 BITS> struct FixedExpLogWideTable{
+    // 2^(i / 2^BITS), Q62
+    fastu64 exp2[1 << BITS];
+    // log2(2^32 / recip), Q62, with recip from FixedExpLogTable
+    fastu64 log2[1 << BITS];
+
+    constexpr FixedExpLogWideTable(): exp2(), log2(){
+        const fastu64 ONE = CAST<fastu64>(1) << 62;
+        const FixedExpLogTable<BITS> narrow{};
+        for(fast32 i = 0; i < (1 << BITS); i++){
+            // e^z from the Taylor series, z = i * ln(2) / 2^BITS. Every
+            // term after the first is under 1, so they are summed in Q64
+            // with each step rounded.
+            fastu64 hi = 0, lo = 0;
+            FixedLimb::mul(CAST<fastu64>(i), FIXED_LN2_Q64, hi, lo);
+            const fastu64 z = (hi << (64 - BITS)) | (lo >> BITS);
+            fastu64 term = z, sum = z;
+            for(fastu64 n = 2; n < 25; n++){
+                FixedLimb::mul(term, z, hi, lo);
+                term = (hi + (lo >> 63) + n / 2) / n;
+                sum += term;
+            }
+            exp2[i] = ONE + (sum >> 2) + ((sum >> 1) & 1);
+
+            // log2 of m = 2^32 / recip in Q63, one bit at a time. Squaring
+            // m doubles log2(m), which moves its next bit to the ones place.
+            fastu64 rem = 0;
+            fastu64 m = FixedLimb::divide(CAST<fastu64>(1) << 31, 0,
+                                          narrow.recip[i], rem);
+            fastu64 bits = 0;
+            for(fast32 bit = 61; bit >= 0; bit--){
+                FixedLimb::mul(m, m, hi, lo);
+                if((hi >> 63) != 0){
+                    m = hi;
+                    bits |= CAST<fastu64>(1) << bit;
+                }
+                else m = (hi << 1) | (lo >> 63);
+            }
+            log2[i] = bits;
+        }
+    }
+};
+
+// The wide entries rounded to doubles, for formats over 32 bits where a
+// result fits a double with bits to spare
+template<fastu16 BITS> struct FixedExpLogDoubleTable{
+    // 2^(i / 2^BITS)
+    double exp2[1 << BITS];
+    // recip from FixedExpLogTable / 2^32
+    double recip[1 << BITS];
+    // log2(2^32 / recip)
+    double log2[1 << BITS];
+
+    constexpr FixedExpLogDoubleTable(): exp2(), recip(), log2(){
+        const double Q62 = 4611686018427387904.0;    // 2^62
+        const FixedExpLogTable<BITS> narrow{};
+        const FixedExpLogWideTable<BITS> wide{};
+        for(fast32 i = 0; i < (1 << BITS); i++){
+            exp2[i] = CAST<double>(wide.exp2[i]) / Q62;
+            recip[i] = narrow.recip[i] / 4294967296.0;
+            log2[i] = CAST<double>(wide.log2[i]) / Q62;
+        }
+    }
+};
+
+// Holds one copy of each table, shared by every format that uses it
+template<fastu16 BITS> struct FixedExpLogTables{
+    static constexpr FixedExpLogTable<BITS> table{};
+    static constexpr FixedExp2Table<BITS> exp2Table{};
+    static constexpr FixedExpLogWideTable<BITS> wide{};
+    static constexpr FixedExpLogDoubleTable<BITS> doubles{};
+};
+template<fastu16 BITS>
+constexpr FixedExpLogTable<BITS> FixedExpLogTables<BITS>::table;
+template<fastu16 BITS>
+constexpr FixedExp2Table<BITS> FixedExpLogTables<BITS>::exp2Table;
+template<fastu16 BITS>
+constexpr FixedExpLogWideTable<BITS> FixedExpLogTables<BITS>::wide;
+template<fastu16 BITS>
+constexpr FixedExpLogDoubleTable<BITS> FixedExpLogTables<BITS>::doubles;
+
+
+
+// **************************************************************
+//                          Engine
+// **************************************************************
+template<fastu16 INT, fastu16 FRAC, bool SIGN, FixedOverflow OVER>
+class FixedExpLog{
+public:
+    typedef Fixed<INT, FRAC, SIGN, OVER> fixed;
+    typedef typename fixed::fixSize fixSize;
+    typedef typename fixed::ufixSize ufixSize;
+
+    // Over 64 bits the raw number is a FixedInt128, which the steps below
+    // do not handle
+    static_assert(INT + FRAC + SIGN <= 64,
+                  "FixedExpLog.h: only formats up to 64 bits are supported");
+
+    static fixed exp2(const fixed &x){
+        if(WIDE) return expWide(x, CAST<fastu64>(1) << 62);
+        if(FRAC <= 8) return exp2Byte(x);
+        return exp2Q32(toExponent2(x));
+    }
+
+    static fixed exp(const fixed &x){
+        if(WIDE) return expWide(x, FIXED_LOG2E_Q62);
+        return exp2Q32(toExponent(x, FIXED_LOG2E_Q62));
+    }
+
+    static fixed log2(const fixed &x){
+        if(x.getRawNumber() <= 0) return x.getMinValue();
+        if(WIDE && USE_DOUBLE){
+            const fastu64 raw = CAST<fastu64>(x.getRawNumber());
+            return roundDouble(log2Double(raw));
+        }
+        if(WIDE){
+            const fast64 ret = log2Wide(CAST<fastu64>(x.getRawNumber()));
+            return scale(absolute(ret), ret < 0, FRAC - LOG_Q);
+        }
+        const fast64 ret = log2Q32(CAST<fastu64>(x.getRawNumber()));
+        return scale(absolute(ret), ret < 0, FRAC - 32);
+    }
+
+    static fixed ln(const fixed &x){
+        if(x.getRawNumber() <= 0) return x.getMinValue();
+        if(WIDE && USE_DOUBLE){
+            const double LN2 = 0.693147180559945309417;
+            const fastu64 raw = CAST<fastu64>(x.getRawNumber());
+            return roundDouble(log2Double(raw) * LN2);
+        }
+        if(WIDE){
+            const fast64 ret = log2Wide(CAST<fastu64>(x.getRawNumber()));
+            fastu64 hi = 0, lo = 0;
+            FixedLimb::mul(absolute(ret), FIXED_LN2_Q64, hi, lo);
+            return scale(hi, ret < 0, FRAC - LOG_Q);
+        }
+        const fast64 ret = log2Q32(CAST<fastu64>(x.getRawNumber()));
+        const fastu64 mag = FixedWideMul<fastu64>::mulShift(
+            absolute(ret), FIXED_LN2_Q32, 32);
+        return scale(mag, ret < 0, FRAC - 32);
+    }
+
+    // Rounded to the nearest LSB: the double square root of raw * 2^FRAC,
+    // then checked against the exact square
+    static fixed sqrt(const fixed &x){
+        if(x.getRawNumber() <= 0) return fixed(0);
+        const fastu64 raw = CAST<fastu64>(x.getRawNumber());
+
+        // Under 2^48 the double root is never close enough to a half to
+        // round the wrong way, so it needs no check
+        if(fixed::BITSUM + FRAC <= 48){
+            const fastu64 num = raw << FRAC;
+            return scale(CAST<fastu64>(std::sqrt(CAST<double>(num)) + 0.5),
+                         false, 0);
+        }
+
+        // raw * 2^FRAC and its root's square fit one word
+        if(fixed::BITSUM + FRAC <= 62){
+            const fastu64 num = raw << FRAC;
+            fastu64 root = CAST<fastu64>(std::sqrt(CAST<double>(num)) + 0.5);
+            const fast64 rem = CAST<fast64>(num - root * root);
+            if(rem > CAST<fast64>(root)) root++;
+            else if(rem <= -CAST<fast64>(root)) root--;
+            return scale(root, false, 0);
+        }
+
+        const fastu64 hi = (FRAC < 64) ? raw >> ((64 - FRAC) % 64) : raw;
+        const fastu64 lo = raw << (FRAC % 64);
+        return scale(roundedRoot(hi, lo), false, 0);
+    }
+
+    // 2^(1.5 FRAC) / sqrt(raw) in double, within an LSB. Formats over 51
+    // bits redo results of 2^51 LSBs and up, past what a double holds.
+    static fixed rsqrt(const fixed &x){
+        if(x.getRawNumber() <= 0) return x.getMaxValue();
+        const fastu64 raw = CAST<fastu64>(x.getRawNumber());
+
+        const double ONE = CAST<double>(CAST<fastu64>(1) << FRAC);
+        const double HALF = CAST<double>(CAST<fastu64>(1) << (FRAC / 2)) *
+                            ((FRAC % 2 == 1) ? 1.41421356237309504880 : 1.0);
+        const double LARGE = 2251799813685248.0;    // 2^51
+        const double ret = ONE * HALF / std::sqrt(CAST<double>(raw));
+        if(ret >= LARGE){
+            return (fixed::BITSUM > 51) ? rsqrtWide(raw)
+                                        : scale(~CAST<fastu64>(0), false, 0);
+        }
+        return scale(CAST<fastu64>(CAST<fast64>(ret + 0.5)), false, 0);
+    }
+
+private:
+    static const fastu16 BITS = FIXED_EXPLOG_BITS;
+
+    // Formats over 32 bits use the Q62 tables and longer polynomials, to
+    // get every bit of a 64 bit format
+    static const bool WIDE = fixed::BITSUM > 32;
+
+    // Fraction bits of the wide log2. A power of two up to 63 leaves 56,
+    // formats with fewer INT bits clamp it to their range and keep more.
+    static const fastu16 LOG_Q = (INT >= 5) ? 56 : 61 - INT;
+
+    // Wide results up to 2^DOUBLE_BITS LSBs are worked out in doubles, which
+    // leaves 8 bits for the rounding errors. Every log2 and ln result is
+    // under 2^(FRAC + 6) LSBs, so those formats use them for every input,
+    // and exp2 and exp for the results that small. Formats with more FRAC
+    // bits stay in integer math, so their results do not depend on how
+    // the compiler fuses multiply-adds. FixedRandom relies on that.
+    static const fastu16 DOUBLE_BITS = 44;
+    static const bool USE_DOUBLE = FRAC + 6 <= DOUBLE_BITS;
+
+    static const FixedExpLogTable<BITS>& table(){
+        return FixedExpLogTables<BITS>::table;
+    }
+
+    static const FixedExpLogWideTable<BITS>& wide(){
+        return FixedExpLogTables<BITS>::wide;
+    }
+
+    static const FixedExpLogDoubleTable<BITS>& doubles(){
+        return FixedExpLogTables<BITS>::doubles;
+    }
+
+    static fastu16 leadingZeros(fastu64 num){
+#if defined(__GNUC__)
+        return __builtin_clzll(num);
+#else
+        fastu16 lead = 0;
+        for(fastu16 step = 32; step > 0; step /= 2){
+            if((num >> (64 - step)) == 0){
+                num <<= step;
+                lead += step;
+            }
+        }
+        return lead;
+#endif // __GNUC__
+    }
+
+    static fastu64 absolute(fast64 num){
+        return (num < 0) ? 0 - CAST<fastu64>(num) : CAST<fastu64>(num);
+    }
+
+    // (a * b) >> 64, the product of two Q64 numbers
+    static fastu64 mulHigh(fastu64 a, fastu64 b){
+        fastu64 hi = 0, lo = 0;
+        FixedLimb::mul(a, b, hi, lo);
+        return hi;
+    }
+
+    // Signed (a * b) >> 62, the unsigned product with the top word
+    // corrected for negative inputs
+    static fast64 mulQ62(fast64 a, fast64 b){
+        fastu64 hi = 0, lo = 0;
+        FixedLimb::mul(CAST<fastu64>(a), CAST<fastu64>(b), hi, lo);
+        hi -= (a < 0) ? CAST<fastu64>(b) : 0;
+        hi -= (b < 0) ? CAST<fastu64>(a) : 0;
+        return CAST<fast64>((hi << 2) | (lo >> 62));
+    }
+
+    // (hi:lo) >> shift, shift < 128, the low word
+    static fastu64 shiftDown(fastu64 hi, fastu64 lo, fastu16 shift){
+        return (shift >= 64) ? hi >> (shift - 64) :
+               (shift == 0)  ? lo : (hi << (64 - shift)) | (lo >> shift);
+    }
+
+    // The same for a signed hi:lo, rounded down
+    static fast64 signedShiftDown(fastu64 hi, fastu64 lo, fastu16 shift){
+        return (shift >= 64) ? CAST<fast64>(hi) >> (shift - 64)
+                             : CAST<fast64>(shiftDown(hi, lo, shift));
+    }
+
+    // Past 2^10 every format over or underflows, so the input is clamped
+    // there to keep the exponent in range
+    static fastu64 clampedMagnitude(const fixed &x){
+        const fastu64 LIMIT = (FRAC + 10 < 64) ?
+            CAST<fastu64>(1) << (FRAC + 10) : ~CAST<fastu64>(0);
+        const fastu64 mag = fixed::magnitude(x.getRawNumber());
+        return (mag > LIMIT) ? LIMIT : mag;
+    }
+
+    // x clamped to the same limit as a signed raw number
+    static fast64 clampedRaw(const fixed &x){
+        const fast64 LIMIT = (FRAC + 10 < 63) ?
+            CAST<fast64>(1) << (FRAC + 10) : ~(CAST<fastu64>(1) << 63);
+        if(!SIGN){
+            const fastu64 raw = CAST<fastu64>(x.getRawNumber());
+            return (raw > CAST<fastu64>(LIMIT)) ? LIMIT : CAST<fast64>(raw);
+        }
+        const fast64 raw = CAST<fast64>(x.getRawNumber());
+        return (raw > LIMIT) ? LIMIT : (raw < -LIMIT) ? -LIMIT : raw;
+    }
+
+    // x * c as a Q32 power of two, where c is log2(e) in Q62
+    static fast64 toExponent(const fixed &x, fastu64 c){
+        const fast64 ret = CAST<fast64>(FixedWideMul<fastu64>::mulShift(
+            clampedMagnitude(x), c, FRAC + 30));
+        return (x.isNegative()) ? -ret : ret;
+    }
+
+    // x as a Q32 power of two, only a shift
+    static fast64 toExponent2(const fixed &x){
+        const fastu64 mag = clampedMagnitude(x);
+        const fast64 ret = CAST<fast64>((FRAC <= 32) ? mag << (32 - FRAC)
+                                                     : mag >> (FRAC - 32));
+        return (x.isNegative()) ? -ret : ret;
+    }
+
+    // 2^x with 8 or fewer FRAC bits, which has a table entry for every
+    // fraction and needs no polynomial
+    static fixed exp2Byte(const fixed &x){
+        const fastu16 BYTE = (FRAC <= 8) ? FRAC : 8;
+        const fast64 raw = CAST<fast64>(x.getRawNumber());
+        fast64 k = raw >> BYTE;
+        if(k > 100) k = 100;
+        else if(k < -100) k = -100;
+        const fastu16 f = CAST<fastu16>(raw & ((1 << BYTE) - 1));
+        return scale(FixedExpLogTables<BYTE>::exp2Table.exp2[f], false,
+                     CAST<fast32>(k) + BYTE - 31);
+    }
+
+    // 2^e for a Q32 e, 2^k * 2^(i / 2^BITS) * 2^r with r under 2^-BITS
+    static fixed exp2Q32(fast64 e){
+        const fast32 k = CAST<fast32>(e >> 32);
+        const fastu32 f = CAST<fastu32>(e);
+        const fastu32 mult = FixedExpLogTables<BITS>::exp2Table.exp2[
+            f >> (32 - BITS)];
+
+        // 2^r - 1 = y + y^2/2 + y^3/6, with y = r * ln(2)
+        const fastu64 r = f & ((CAST<fastu32>(1) << (32 - BITS)) - 1);
+        const fastu64 y = (r * FIXED_LN2_Q32) >> 32;
+        const fastu64 y2 = (y * y) >> 32, y3 = (y2 * y) >> 32;
+        const fastu64 poly = y + y2 / 2 + y3 / 6;
+
+        const fastu64 mant = mult + ((mult * poly) >> 32);
+        return scale(mant, false, k + FRAC - 31);
+    }
+
+    // 2^(x * c) for c = 1 or log2(e) in Q62. The exponent keeps 62
+    // fraction bits, and e^y = 1 + y + ... + y^6/720 covers what is
+    // left after the table, where y^7/5040 is under 2^-65.
+    static fixed expWide(const fixed &x, fastu64 c){
+        const fastu64 ONE = CAST<fastu64>(1) << 62;
+        const fast64 raw = clampedRaw(x);
+        fastu64 hi = 0, lo = 0;
+        FixedLimb::mul(CAST<fastu64>(raw), c, hi, lo);
+        hi -= (raw < 0) ? c : 0;
+
+        // x * c = k + f, k rounded down and f in Q62, so negative inputs
+        // need no branch of their own
+        const fast32 k = CAST<fast32>(signedShiftDown(hi, lo, FRAC + 62));
+        const fastu64 f = shiftDown(hi, lo, FRAC) & (ONE - 1);
+        if(USE_DOUBLE && k + FRAC <= DOUBLE_BITS) return exp2Double(k, f);
+
+        const fastu64 r = f & ((CAST<fastu64>(1) << (62 - BITS)) - 1);
+        FixedLimb::mul(r, FIXED_LN2_Q64, hi, lo);
+
+        // y + y^2 (1/2 + y/6) + y^4 (1/24 + y/120 + y^2/720) in Q64, in
+        // pairs so the multiplies do not wait on each other, and rounded
+        // once to Q62 at the end
+        const fastu64 y = (hi << 2) | (lo >> 62);
+        const fastu64 y2 = mulHigh(y, y), y4 = mulHigh(y2, y2);
+        const fastu64 mid = (CAST<fastu64>(1) << 63) + y / 6;
+        const fastu64 high = ~CAST<fastu64>(0) / 24 + y / 120 +
+                             mulHigh(y2, ~CAST<fastu64>(0) / 720);
+        const fastu64 tail = y + mulHigh(y2, mid) + mulHigh(y4, high);
+        const fastu64 poly = ONE + ((tail + 2) >> 2);
+
+        const fastu64 mant = Fixed_mulQ62(wide().exp2[f >> (62 - BITS)], poly);
+        return scale(mant, false, k + FRAC - 62);
+    }
+
+    // 2^(k + f) for a Q62 f, in doubles, for results up to 2^DOUBLE_BITS
+    // LSBs. The steps are the ones expWide takes, with e^y to y^5/120,
+    // where y^6/720 is under 2^-54.
+    static fixed exp2Double(fast32 k, fastu64 f){
+        const fast32 shift = k + FRAC;
+        if(shift < -1) return scale(0, false, 0);
+
+        // r * ln(2), r = f's bits under the table index
+        const double LN2_Q62 = 0.693147180559945309417 / 4611686018427387904.0;
+        const double y = CAST<double>(CAST<fast64>(
+            f & ((CAST<fastu64>(1) << (62 - BITS)) - 1))) * LN2_Q62;
+        const double poly = 1 + y * (1 + y * (1.0 / 2 + y * (1.0 / 6 +
+                            y * (1.0 / 24 + y * (1.0 / 120)))));
+
+        // 2^shift, -1 <= shift <= DOUBLE_BITS
+        const double power = CAST<double>(CAST<fast64>(1) << (shift + 1)) / 2;
+        const double ret = doubles().exp2[f >> (62 - BITS)] * poly * power;
+        return scale(CAST<fastu64>(CAST<fast64>(ret + 0.5)), false, 0);
+    }
+
+    // log2 of raw / 2^FRAC in doubles, the steps log2Wide takes. The
+    // mantissa keeps its top 53 bits, and ln(1 + t) goes to t^6/6.
+    static double log2Double(fastu64 raw){
+        const double LOG2E = 1.44269504088896340736;
+        const double Q52 = 4503599627370496.0;      // 2^52
+        const fastu16 lead = leadingZeros(raw);
+        const fastu64 norm = raw << lead;
+        const fastu16 index = CAST<fastu16>(
+            (norm >> (63 - BITS)) & ((1 << BITS) - 1));
+
+        const double mant = CAST<double>(CAST<fast64>(norm >> 11)) / Q52;
+        const double t = mant * doubles().recip[index] - 1;
+        const double lnPoly = t * (1 - t * (1.0 / 2 - t * (1.0 / 3 -
+                              t * (1.0 / 4 - t * (1.0 / 5 - t * (1.0 / 6))))));
+
+        return CAST<double>(63 - lead - FRAC) + doubles().log2[index] +
+               lnPoly * LOG2E;
+    }
+
+    // Rounds num * 2^FRAC to the nearest raw number, half away from zero,
+    // with the overflow policy of the format. |num| is under 2^(DOUBLE_BITS
+    // - FRAC), so it fits.
+    static fixed roundDouble(double num){
+        const double ONE = CAST<double>(CAST<fastu64>(1) << FRAC);
+        const bool negative = num < 0;
+        const double mag = ((negative) ? -num : num) * ONE + 0.5;
+        return scale(CAST<fastu64>(CAST<fast64>(mag)), negative, 0);
+    }
+
+    // log2 of raw / 2^FRAC in Q32, from the power of two, the table entry,
+    // and ln(1 + t) = t - t^2/2 + t^3/3 for what is left
+    static fast64 log2Q32(fastu64 raw){
+        const fastu16 lead = leadingZeros(raw);
+        const fastu64 norm = raw << lead;
+        const fastu16 index = CAST<fastu16>(
+            (norm >> (63 - BITS)) & ((1 << BITS) - 1));
+
+        const fast64 t = spread(norm, index);
+        const fast64 t2 = (t * t) >> 32, t3 = (t2 * t) >> 32;
+        const fast64 lnPoly = t - t2 / 2 + t3 / 3;
+
+        return CAST<fast64>(CAST<fastu64>(63 - lead - FRAC) << 32) +
+               table().log2[index] +
+               ((lnPoly * CAST<fast64>(FIXED_LOG2E_Q31)) >> 31);
+    }
+
+    // log2 of raw / 2^FRAC in Q(LOG_Q). The same steps as log2Q32 in Q62,
+    // with ln(1 + t) to t^7/7, where t^8/8 is under 2^-67.
+    static fast64 log2Wide(fastu64 raw){
+        const fast64 ONE = CAST<fast64>(1) << 62;
+        const fastu16 lead = leadingZeros(raw);
+        const fastu64 norm = raw << lead;
+        const fastu16 index = CAST<fastu16>(
+            (norm >> (63 - BITS)) & ((1 << BITS) - 1));
+
+        // norm * recip = (1 + t) * 2^95
+        fastu64 hi = 0, lo = 0;
+        FixedLimb::mul(norm, table().recip[index], hi, lo);
+        const fast64 t = CAST<fast64>((hi << 31) | (lo >> 33)) - ONE;
+
+        // t (1 - t/2) + t^3 (1/3 - t/4) + t^5 (1/5 - t/6 + t^2/7), in
+        // pairs so the multiplies do not wait on each other
+        const fast64 t2 = mulQ62(t, t), t4 = mulQ62(t2, t2);
+        const fast64 low = ONE - (t >> 1);
+        const fast64 mid = ONE / 3 - (t >> 2);
+        const fast64 high = ONE / 5 - mulQ62(t, ONE / 6) +
+                            mulQ62(t2, ONE / 7);
+        const fast64 lnPoly = mulQ62(t, low + mulQ62(t2, mid) +
+                                        mulQ62(t4, high));
+
+        const fast64 frac = CAST<fast64>(wide().log2[index]) +
+                            mulQ62(lnPoly, FIXED_LOG2E_Q62);
+
+        // Past 2^INT + 1 every format overflows
+        const fast64 RANGE = (INT >= 5) ? 64 : (1 << INT) + 1;
+        fast64 power = 63 - lead - FRAC;
+        if(power > RANGE) power = RANGE;
+        else if(power < -RANGE) power = -RANGE;
+        return CAST<fast64>(CAST<fastu64>(power) << LOG_Q) +
+               (frac >> (62 - LOG_Q));
+    }
+
+    // Q32 t where norm * recip = 1 + t, for a mantissa with the top bit set
+    static fast64 spread(fastu64 norm, fastu16 index){
+        const fastu64 prod = (norm >> 32) * table().recip[index];
+        return CAST<fast64>(prod - (CAST<fastu64>(1) << 63)) >> 31;
+    }
+
+    // sqrt(hi:lo) rounded to the nearest integer, for hi:lo under 2^127.
+    // The double square root is within 2^11, and one Newton step on the
+    // exact remainder brings it within 1. The rounded root r has
+    // (r - 1/2)^2 < hi:lo < (r + 1/2)^2, a remainder in (-r, r].
+    static fastu64 roundedRoot(fastu64 hi, fastu64 lo){
+        const double WORD = 18446744073709551616.0;     // 2^64
+        const double est = std::sqrt(CAST<double>(hi) * WORD +
+                                     CAST<double>(lo));
+        fastu64 root = CAST<fastu64>(est + 0.5);
+        fastu64 sqHi = 0, sqLo = 0;
+        if(root >= (CAST<fastu64>(1) << 52)){
+            root = CAST<fastu64>(est);
+            FixedLimb::mul(root, root, sqHi, sqLo);
+            const fast64 remHi = CAST<fast64>(hi - sqHi -
+                                              ((lo < sqLo) ? 1 : 0));
+            const double step = (CAST<double>(remHi) * WORD +
+                                 CAST<double>(lo - sqLo)) /
+                                (2 * CAST<double>(root));
+            root += CAST<fastu64>(CAST<fast64>(step + ((step < 0) ? -0.5
+                                                                  : 0.5)));
+        }
+
+        FixedLimb::mul(root, root, sqHi, sqLo);
+        const fastu64 remLo = lo - sqLo;
+        const fast64 remHi = CAST<fast64>(hi - sqHi - ((lo < sqLo) ? 1 : 0));
+        if(remHi > 0 || (remHi == 0 && remLo > root)) root++;
+        else if(remHi < -1 || (remHi == -1 && remLo <= 0 - root)) root--;
+        return root;
+    }
+
+    // rsqrt for results of 2^51 LSBs and up. raw * 2^k is put in
+    // [2^124, 2^126) with k + FRAC even, so the result is 2^E over its
+    // 63 bit root. The root is within 1/2, so this is within 2 LSBs.
+    static fixed rsqrtWide(fastu64 raw){
+        fastu16 k = 61 + leadingZeros(raw);
+        if((k + FRAC) % 2 == 1) k++;
+        const fastu64 hi = (k >= 64) ? raw << (k - 64) : raw >> (64 - k);
+        const fastu64 lo = (k >= 64) ? 0 : raw << k;
+        const fastu64 root = roundedRoot(hi, lo);
+
+        // Once the top word of 2^E reaches root the result is over 2^64
+        const fastu16 E = FRAC + (k + FRAC) / 2;
+        if(E >= 127) return scale(~CAST<fastu64>(0), false, 0);
+        const fastu64 numHi = (E >= 64) ? CAST<fastu64>(1) << (E - 64) : 0;
+        const fastu64 numLo = (E >= 64) ? 0 : CAST<fastu64>(1) << E;
+        if(numHi >= root) return scale(~CAST<fastu64>(0), false, 0);
+
+        fastu64 rem = 0;
+        fastu64 ret = FixedLimb::divide(numHi, numLo, root, rem);
+        if(rem >= root - rem) ret++;
+        return scale(ret, false, 0);
+    }
+
+    // Rounds mag * 2^shift to the nearest raw number, with the overflow
+    // policy of the format
+    static fixed scale(fastu64 mag, bool negative, fast32 shift){
+        const fastu64 limit = (negative) ?
+            fixed::magnitude(fixed().getMinValue().getRawNumber()) :
+            fixed::magnitude(fixed().getMaxValue().getRawNumber());
+
+        fastu64 ret = 0;
+        bool over = false;
+        if(shift >= 0){
+            over = shift >= 64 || (shift > 0 && (mag >> (64 - shift)) != 0);
+            ret = (over) ? 0 : mag << shift;
+        }
+        else if(shift > -64){
+            ret = (mag >> -shift) + ((mag >> (-shift - 1)) & 1);
+        }
+        else if(shift == -64) ret = mag >> 63;
+
+        over = over || ret > limit;
+        const fixSize raw = (negative) ? CAST<fixSize>(0 - ret)
+                                       : CAST<fixSize>(ret);
+        fixed out;
+        out.setRawNumber(fixed::applyOverflow(raw, over, !negative));
+        return out;
+    }
+};
+
+
+
+// **************************************************************
+//                      Exp and Log Functions
+// **************************************************************
+#define FIXED_EXPLOG_FUNCTION(NAME, FUNC)                                      \
+template<fastu16 INT, fastu16 FRAC, bool SIGN, FixedOverflow OVER>             \
+Fixed<INT, FRAC, SIGN, OVER> NAME(const Fixed<INT, FRAC, SIGN, OVER> &x){      \
+    return FixedExpLog<INT, FRAC, SIGN, OVER>::FUNC(x);                        \
+}
+
+FIXED_EXPLOG_FUNCTION(Fixed_exp2Table, exp2)
+FIXED_EXPLOG_FUNCTION(Fixed_expTable, exp)
+FIXED_EXPLOG_FUNCTION(Fixed_log2Table, log2)
+FIXED_EXPLOG_FUNCTION(Fixed_lnTable, ln)
+FIXED_EXPLOG_FUNCTION(Fixed_sqrt, sqrt)
+FIXED_EXPLOG_FUNCTION(Fixed_rsqrt, rsqrt)
+
+#undef FIXED_EXPLOG_FUNCTION
+
+// dst[i] = f(src[i]), dst may be the same buffer as src
+#define FIXED_EXPLOG_BATCH(NAME, FUNC)                                         \
+template<fastu16 INT, fastu16 FRAC, bool SIGN, FixedOverflow OVER>             \
+void NAME(Fixed<INT, FRAC, SIGN, OVER> *dst,                                   \
+          const Fixed<INT, FRAC, SIGN, OVER> *src, std::size_t count){         \
+    for(std::size_t i = 0; i < count; i++)                                     \
+        dst[i] = FixedExpLog<INT, FRAC, SIGN, OVER>::FUNC(src[i]);             \
+}
+
+FIXED_EXPLOG_BATCH(Fixed_batchExp2, exp2)
+FIXED_EXPLOG_BATCH(Fixed_batchExp, exp)
+FIXED_EXPLOG_BATCH(Fixed_batchLog2, log2)
+FIXED_EXPLOG_BATCH(Fixed_batchLn, ln)
+FIXED_EXPLOG_BATCH(Fixed_batchSqrt, sqrt)
+FIXED_EXPLOG_BATCH(Fixed_batchRsqrt, rsqrt)
+
+#undef FIXED_EXPLOG_BATCH
+
+#endif // FIXEDEXPLOG_H
@@ -0,0 +1,317 @@
+/*
+ *  @file    FixedFFT.h
+ *
+ *  @brief In-place block floating point FFT over complex Fixed numbers
+ *
+ *  DESCRIPTION
+ *
+ * FixedFFT<INT, FRAC, BITS> transforms 2^BITS FixedComplex<INT, FRAC>
+ * numbers in place, without converting to float:
+ *
+ *     FixedComplex<1, 14> data[1024];
+ *     const fast16 exp = FixedFFT<1, 14, 10>::forward(data);
+ *     // data[k] * 2^exp is bin k of the spectrum
+ *
+ * The FFT grows the numbers by up to 2.4 times per stage. Before each pass
+ * over the data, the largest number is checked, and if there is not enough
+ * headroom for the pass, every number is shifted right by the bits needed.
+ * The shifts are added up into one block exponent that is returned, so the
+ * numbers use as much of the format as they can and never overflow. Small
+ * inputs are shifted up before the first pass, which makes it negative.
+ *
+ * inverse() includes the 1/N, so the exponent it returns is BITS lower.
+ * forwardReal() transforms 2^BITS real numbers with an FFT of half the
+ * size, and returns bins 0 to 2^(BITS - 1).
+ *
+ * After the bit reversal, stages are done two at a time (radix 4), so the
+ * data is only read and written once for every two stages. An odd BITS
+ * starts with one radix 2 stage. The first pass needs no multiplies.
+ *
+ * Twiddle factors are Q1.30, built at compile time with Fixed_constSin
+ * from FixedTrig.h. Each size has its own table of 2^(BITS - 1) cos/sin
+ * pairs, 256KB for 64K points, which takes the compiler a few seconds.
+ */
+
+
+
+
+#ifndef FIXEDFFT_H
+#define FIXEDFFT_H
+
+#include "FixedTrig.h"
+#include <cstddef>
+#include <utility>
+
+template<fastu16 INT, fastu16 FRAC> struct FixedComplex{
+    Fixed<INT, FRAC> re;
+    Fixed<INT, FRAC> im;
+};
+
+
+
+// **************************************************************
+//                         Twiddle Tables
+// **************************************************************
+// cos and sin of 2 pi k / 2^BITS in Q1.30, for k < 2^(BITS - 1)
+template<fastu16 BITS> struct FixedTwiddleTable{
+    fast32 cos[1 << (BITS - 1)];
+    fast32 sin[1 << (BITS - 1)];
+
+    constexpr FixedTwiddleTable(): cos(), sin(){
+        const fast32 HALF = 1 << (BITS - 1), QUARTER = HALF / 2;
+
+        // The first eighth is worked out, the rest are reflections of it
+        for(fast32 i = 0; i <= QUARTER / 2; i++){
+            const double x = 2 * FIXED_CONST_PI * i / (1 << BITS);
+            sin[i] = Fixed_constRound(Fixed_constSin(x) * (1 << 30));
+            cos[i] = Fixed_constRound(
+                Fixed_constSin(x + FIXED_CONST_PI / 2) * (1 << 30));
+        }
+        for(fast32 i = QUARTER / 2 + 1; i <= QUARTER && i < HALF; i++){
+            sin[i] = cos[QUARTER - i];
+            cos[i] = sin[QUARTER - i];
+        }
+        for(fast32 i = QUARTER + 1; i < HALF; i++){
+            sin[i] = sin[HALF - i];
+            cos[i] = -cos[HALF - i];
+        }
+    }
+};
+
+template<fastu16 BITS> struct FixedTwiddles{
+    static constexpr FixedTwiddleTable<BITS> table{};
+};
+template<fastu16 BITS>
+constexpr FixedTwiddleTable<BITS> FixedTwiddles<BITS>::table;
+
+
+
+// **************************************************************
+//                              FFT
+// **************************************************************
+template<fastu16 INT, fastu16 FRAC, fastu16 BITS> class FixedFFT{
+public:
+    typedef Fixed<INT, FRAC> fixed;
+    typedef FixedComplex<INT, FRAC> complex;
+    const static std::size_t SIZE = CAST<std::size_t>(1) << BITS;
+
+    static_assert(BITS >= 2, "FixedFFT.h: FFT needs at least 4 points");
+
+    // Returns the block exponent of the spectrum
+    static fast16 forward(complex *data){
+        return transform<false>(data, BITS, 1);
+    }
+
+    // Returns the block exponent of the signal, with the 1/N included
+    static fast16 inverse(complex *data){
+        return transform<true>(data, BITS, 1) - BITS;
+    }
+
+    // SIZE real numbers from src, SIZE / 2 + 1 bins to dst. dst can not
+    // overlap src.
+    static fast16 forwardReal(complex *dst, const fixed *src){
+        const std::size_t half = SIZE / 2;
+        const FixedTwiddleTable<BITS> &table = FixedTwiddles<BITS>::table;
+
+        // Even samples are the real parts, odd samples the imaginary parts
+        for(std::size_t i = 0; i < half; i++){
+            dst[i].re = src[2 * i];
+            dst[i].im = src[2 * i + 1];
+        }
+        fast16 exp = transform<false>(dst, BITS - 1, 2);
+
+        // Each output is up to twice the largest input
+        const fastu16 shift = headroomShift(scan(dst, half), 2);
+        if(shift > 0){
+            for(std::size_t i = 0; i < half; i++){
+                dst[i].re.setRawNumber(roundShift(raw(dst[i].re), shift));
+                dst[i].im.setRawNumber(roundShift(raw(dst[i].im), shift));
+            }
+            exp += shift;
+        }
+
+        // X[k] = E + W^k O and X[half - k] = conj(E - W^k O), where
+        // E = (Z[k] + conj(Z[half - k])) / 2
+        // O = (Z[k] - conj(Z[half - k])) / 2i
+        const fixSize re0 = raw(dst[0].re), im0 = raw(dst[0].im);
+        dst[0].re.setRawNumber(re0 + im0);
+        dst[0].im.setRawNumber(0);
+        dst[half].re.setRawNumber(re0 - im0);
+        dst[half].im.setRawNumber(0);
+
+        for(std::size_t k = 1; k <= half / 2; k++){
+            const std::size_t j = half - k;
+            const wide kr = raw(dst[k].re), ki = raw(dst[k].im);
+            const wide jr = raw(dst[j].re), ji = raw(dst[j].im);
+
+            const wide er = (kr + jr) * ONE, ei = (ki - ji) * ONE;
+            const wide orr = ki + ji, oi = jr - kr;
+            const wide c = table.cos[k], s = table.sin[k];
+            const wide pr = orr * c + oi * s, pi = oi * c - orr * s;
+            const wide round = CAST<wide>(1) << 30;
+
+            dst[k].re.setRawNumber(CAST<fixSize>((er + pr + round) >> 31));
+            dst[k].im.setRawNumber(CAST<fixSize>((ei + pi + round) >> 31));
+            if(j != k){
+                dst[j].re.setRawNumber(CAST<fixSize>((er - pr + round) >> 31));
+                dst[j].im.setRawNumber(CAST<fixSize>((pi - ei + round) >> 31));
+            }
+        }
+        return exp;
+    }
+
+private:
+    typedef typename fixed::fixSize fixSize;
+    typedef typename std::conditional<sizeof(fixSize) <= sizeof(fast32),
+                                      fast64, fast128>::type wide;
+
+    static_assert(sizeof(fixSize) * 8 + 32 <= sizeof(wide) * 8,
+                  "FixedFFT.h: 64 bit formats need ENABLE_DW_BIT_MATH");
+
+    // 1.0 in the Q1.30 twiddle format
+    const static wide ONE = CAST<wide>(1) << 30;
+
+    static fixSize raw(const fixed &x){ return x.getRawNumber();}
+
+    static fixSize roundShift(wide x, fastu16 shift){
+        const wide round = (shift > 0) ? CAST<wide>(1) << (shift - 1) : 0;
+        return CAST<fixSize>((x + round) >> shift);
+    }
+
+    static fastu64 magnitudeBits(fixSize x){
+        // ~x for negative x, without a branch
+        return CAST<fastu64>(x ^ (x >> (sizeof(fixSize) * 8 - 1)));
+    }
+
+    // OR of the magnitudes, which has the same highest bit as the largest
+    static fastu64 scan(const complex *data, std::size_t n){
+        fastu64 bits = 0;
+        for(std::size_t i = 0; i < n; i++)
+            bits |= magnitudeBits(raw(data[i].re)) |
+                    magnitudeBits(raw(data[i].im));
+        return bits;
+    }
+
+    // Right shift that leaves need free bits under the sign
+    static fastu16 headroomShift(fastu64 bits, fastu16 need){
+        const fastu64 limit = CAST<fastu64>(1) << (fixed::BITSUM - need);
+        fastu16 shift = 0;
+        while((bits >> shift) >= limit) shift++;
+        return shift;
+    }
+
+    static void bitReverse(complex *data, std::size_t n){
+        for(std::size_t i = 1, j = 0; i < n; i++){
+            std::size_t bit = n >> 1;
+            for(; j & bit; bit >>= 1) j ^= bit;
+            j ^= bit;
+            if(i < j) std::swap(data[i], data[j]);
+        }
+    }
+
+    // a + b w and a - b w, rounded and shifted right by shift. w is
+    // c - i s for the forward transform, c + i s for the inverse.
+    template<bool INVERSE>
+    static void butterfly(fixSize &ar, fixSize &ai, fixSize &br, fixSize &bi,
+                          wide c, wide s, fastu16 shift){
+        const wide tr = (INVERSE) ? br * c - bi * s : br * c + bi * s;
+        const wide ti = (INVERSE) ? bi * c + br * s : bi * c - br * s;
+        const wide xr = ar * ONE, xi = ai * ONE;
+        const wide round = CAST<wide>(1) << (29 + shift);
+
+        ar = CAST<fixSize>((xr + tr + round) >> (30 + shift));
+        ai = CAST<fixSize>((xi + ti + round) >> (30 + shift));
+        br = CAST<fixSize>((xr - tr + round) >> (30 + shift));
+        bi = CAST<fixSize>((xi - ti + round) >> (30 + shift));
+    }
+
+    // 2^bits points, using every stride'th twiddle of the BITS table
+    template<bool INVERSE>
+    static fast16 transform(complex *data, fastu16 bits, std::size_t stride){
+        const FixedTwiddleTable<BITS> &table = FixedTwiddles<BITS>::table;
+        const std::size_t n = CAST<std::size_t>(1) << bits;
+        bitReverse(data, n);
+
+        fast16 exp = 0;
+        fastu64 used = scan(data, n);
+        std::size_t m = 1;
+
+        // Small numbers are shifted up first, so the rounding in each
+        // stage costs them less precision
+        const fastu64 limit = CAST<fastu64>(1) << (fixed::BITSUM - 3);
+        fastu16 up = 0;
+        while(used != 0 && (used << (up + 1)) < limit) up++;
+        if(up > 0){
+            const wide scale = CAST<wide>(1) << up;
+            for(std::size_t i = 0; i < n; i++){
+                data[i].re.setRawNumber(CAST<fixSize>(raw(data[i].re) * scale));
+                data[i].im.setRawNumber(CAST<fixSize>(raw(data[i].im) * scale));
+            }
+            used <<= up;
+            exp -= up;
+        }
+
+        // One radix 2 stage if bits is odd. The twiddle is 1.
+        if(bits % 2 == 1){
+            const fastu16 shift = headroomShift(used, 2);
+            used = 0;
+            for(std::size_t i = 0; i < n; i += 2){
+                const wide ar = raw(data[i].re), ai = raw(data[i].im);
+                const wide br = raw(data[i + 1].re), bi = raw(data[i + 1].im);
+                data[i].re.setRawNumber(roundShift(ar + br, shift));
+                data[i].im.setRawNumber(roundShift(ai + bi, shift));
+                data[i + 1].re.setRawNumber(roundShift(ar - br, shift));
+                data[i + 1].im.setRawNumber(roundShift(ai - bi, shift));
+                used |= scan(data + i, 2);
+            }
+            exp += shift;
+            m = 2;
+        }
+
+        // Two stages per pass, sizes 2m and 4m. The 4m stage twiddle for
+        // the upper pair is W^(j + m) = W^j * -i (forward) or * i (inverse).
+        for(; m < n; m *= 4){
+            const fastu16 shift = headroomShift(used, 3);
+            const std::size_t step1 = n / (2 * m) * stride;
+            const std::size_t step2 = n / (4 * m) * stride;
+            used = 0;
+
+            for(std::size_t base = 0; base < n; base += 4 * m){
+                for(std::size_t j = 0; j < m; j++){
+                    complex *x = data + base + j;
+                    fixSize r0 = raw(x[0].re), i0 = raw(x[0].im);
+                    fixSize r1 = raw(x[m].re), i1 = raw(x[m].im);
+                    fixSize r2 = raw(x[2 * m].re), i2 = raw(x[2 * m].im);
+                    fixSize r3 = raw(x[3 * m].re), i3 = raw(x[3 * m].im);
+
+                    const wide c1 = table.cos[j * step1];
+                    const wide s1 = table.sin[j * step1];
+                    butterfly<INVERSE>(r0, i0, r1, i1, c1, s1, shift);
+                    butterfly<INVERSE>(r2, i2, r3, i3, c1, s1, shift);
+
+                    const wide c2 = table.cos[j * step2];
+                    const wide s2 = table.sin[j * step2];
+                    butterfly<INVERSE>(r0, i0, r2, i2, c2, s2, 0);
+                    butterfly<INVERSE>(r1, i1, r3, i3, -s2, c2, 0);
+
+                    x[0].re.setRawNumber(r0);
+                    x[0].im.setRawNumber(i0);
+                    x[m].re.setRawNumber(r1);
+                    x[m].im.setRawNumber(i1);
+                    x[2 * m].re.setRawNumber(r2);
+                    x[2 * m].im.setRawNumber(i2);
+                    x[3 * m].re.setRawNumber(r3);
+                    x[3 * m].im.setRawNumber(i3);
+                    used |= magnitudeBits(r0) | magnitudeBits(i0) |
+                            magnitudeBits(r1) | magnitudeBits(i1) |
+                            magnitudeBits(r2) | magnitudeBits(i2) |
+                            magnitudeBits(r3) | magnitudeBits(i3);
+                }
+            }
+            exp += shift;
+        }
+        return exp;
+    }
+};
+
+#endif // FIXEDFFT_H
@@ -0,0 +1,292 @@
+/*
+ *  @file    FixedFilter.h
+ *
+ *  @brief FIR and biquad IIR filters for streams of Fixed samples
+ *
+ *  DESCRIPTION
+ *
+ * FixedFir<COEFF, SAMPLE, OUT> and FixedBiquad<COEFF, SAMPLE> filter a
+ * stream of SAMPLE numbers with coefficients in the COEFF format. The
+ * formats are Fixed types, and may differ:
+ *
+ *     const Fixed<1, 14> taps[4] = {0.125, 0.375, 0.375, 0.125};
+ *     FixedFir<Fixed<1, 14>, Fixed<10, 5> > smooth(taps, 4);
+ *     smooth.process(out, in, count);
+ *
+ * Every product is added to a wide accumulator with COEFF FRAC + SAMPLE FRAC
+ * fraction bits, so nothing is rounded per tap like operator* does with
+ * MULT_ROUND. The sum is rounded once per output, half up, and the OUT
+ * overflow policy is applied to it.
+ *
+ * The accumulator is fast64 if the product leaves FIXED_FILTER_GUARD_BITS
+ * spare bits, otherwise fast128. With that many spare bits, up to
+ * 2^FIXED_FILTER_GUARD_BITS full scale products can be added without the
+ * accumulator overflowing. 64 bit formats need ENABLE_DW_BIT_MATH.
+ *
+ * Each filter allocates its coefficients and history once, in the
+ * constructor. process() never allocates.
+ */
+
+
+
+
+#ifndef FIXEDFILTER_H
+#define FIXEDFILTER_H
+
+#define FIXED_FILTER_GUARD_BITS 8
+
+#include "FixedVector.h"
+#include <cstddef>
+
+
+
+// **************************************************************
+//                         Accumulator
+// **************************************************************
+template<class COEFF, class SAMPLE> struct FixedFilterAccumulator{
+    // Magnitude bits of one product, plus the sign
+    const static fastu16 PRODUCT_BITS = COEFF::BITSUM + SAMPLE::BITSUM + 1;
+    const static fastu16 FRAC = COEFF::FRAC_BITS + SAMPLE::FRAC_BITS;
+
+    typedef typename std::conditional<
+        PRODUCT_BITS + FIXED_FILTER_GUARD_BITS <= sizeof(fast64) * 8,
+        fast64, fast128>::type type;
+
+    static_assert(PRODUCT_BITS <= sizeof(type) * 8,
+                  "FixedFilter.h: Product does not fit the accumulator, "
+                  "set ENABLE_DW_BIT_MATH to 1");
+
+    static type mul(typename COEFF::fixSize L, typename SAMPLE::fixSize R){
+        return CAST<type>(L) * CAST<type>(R);
+    }
+
+    // Rounds the sum to OUT, half up, with the OUT overflow policy
+    template<class OUT> static OUT round(type acc){
+        static_assert(OUT::FRAC_BITS <= FRAC,
+                      "FixedFilter.h: OUT has more FRAC bits than the sum");
+        typedef typename OUT::fixSize fixSize;
+
+        // 1 << (SHIFT - 1), or 0 when there is no shift
+        const fastu16 SHIFT = FRAC - OUT::FRAC_BITS;
+        const type half = CAST<type>(SHIFT > 0) << (SHIFT - (SHIFT > 0));
+        const type ret = (acc + half) >> SHIFT;
+        const bool over =
+            ret > CAST<type>(OUT().getMaxValue().getRawNumber()) ||
+            ret < CAST<type>(OUT().getMinValue().getRawNumber());
+
+        OUT out;
+        out.setRawNumber(OUT::applyOverflow(CAST<fixSize>(ret), over, ret > 0));
+        return out;
+    }
+};
+
+
+
+// **************************************************************
+//                          FIR Filter
+// **************************************************************
+// y[n] = coeffs[0] * x[n] + coeffs[1] * x[n - 1] + ...
+//
+// The history is a circular buffer of taps + 3 samples, kept twice, back
+// to back, and every sample is written to both copies. The last taps
+// samples are then always one contiguous run starting at the newest one,
+// and the dot product needs no wrap check. The 3 extra samples let four
+// outputs be worked out from one run, see process().
+template<class COEFF, class SAMPLE, class OUT = SAMPLE> class FixedFir{
+public:
+    typedef FixedFilterAccumulator<COEFF, SAMPLE> accumulator;
+    typedef typename accumulator::type accSize;
+    typedef typename COEFF::fixSize coeffSize;
+    typedef typename SAMPLE::fixSize sampleSize;
+
+    FixedFir(const COEFF *coeffs, std::size_t taps):
+        arena(taps * sizeof(coeffSize) + 2 * (taps + 3) * sizeof(sampleSize) +
+              2 * FIXED_VECTOR_ALIGN),
+        coeffs(CAST<coeffSize*>(arena.allocate(taps * sizeof(coeffSize)))),
+        history(CAST<sampleSize*>(
+            arena.allocate(2 * (taps + 3) * sizeof(sampleSize)))),
+        taps(taps), length(taps + 3), pos(0){
+
+        assert(taps > 0);
+        for(std::size_t i = 0; i < taps; i++)
+            this->coeffs[i] = coeffs[i].getRawNumber();
+        reset();
+    }
+
+    FixedFir(const FixedFir&) = delete;
+    const FixedFir& operator=(const FixedFir&) = delete;
+
+    // Clears the history, as if every earlier sample was 0
+    void reset(){
+        std::fill(history, history + 2 * length, CAST<sampleSize>(0));
+        pos = 0;
+    }
+
+    OUT process(const SAMPLE &in){
+        pos = (pos == 0) ? length - 1 : pos - 1;
+        history[pos] = history[pos + length] = in.getRawNumber();
+
+        const sampleSize *window = history + pos;
+        accSize acc = 0;
+        for(std::size_t i = 0; i < taps; i++)
+            acc += accumulator::mul(coeffs[i], window[i]);
+        return accumulator::template round<OUT>(acc);
+    }
+
+    // Runs four samples at a time, so each coefficient is loaded once for
+    // four outputs, except where the history wraps. dst may be the same
+    // buffer as src.
+    void process(OUT *dst, const SAMPLE *src, std::size_t count){
+        std::size_t i = 0;
+        while(i < count){
+            if(pos >= 4 && count - i >= 4){
+                processFour(dst + i, src + i);
+                i += 4;
+            }
+            else{
+                dst[i] = process(src[i]);
+                i++;
+            }
+        }
+    }
+
+    std::size_t getTaps() const{ return taps;}
+
+private:
+    // Needs pos >= 4, so the four windows are next to each other
+    void processFour(OUT *dst, const SAMPLE *src){
+        for(std::size_t j = 0; j < 4; j++){
+            pos--;
+            history[pos] = history[pos + length] = src[j].getRawNumber();
+        }
+
+        // The newest sample is src[3], its window starts at pos
+        const sampleSize *window = history + pos;
+        accSize acc0 = 0, acc1 = 0, acc2 = 0, acc3 = 0;
+        for(std::size_t i = 0; i < taps; i++){
+            const coeffSize c = coeffs[i];
+            acc0 += accumulator::mul(c, window[i + 3]);
+            acc1 += accumulator::mul(c, window[i + 2]);
+            acc2 += accumulator::mul(c, window[i + 1]);
+            acc3 += accumulator::mul(c, window[i]);
+        }
+        dst[0] = accumulator::template round<OUT>(acc0);
+        dst[1] = accumulator::template round<OUT>(acc1);
+        dst[2] = accumulator::template round<OUT>(acc2);
+        dst[3] = accumulator::template round<OUT>(acc3);
+    }
+
+    FixedArena arena;
+    coeffSize *coeffs;
+    sampleSize *history;
+    std::size_t taps;
+    std::size_t length;
+    std::size_t pos;
+};
+
+
+
+// **************************************************************
+//                      Biquad IIR Cascade
+// **************************************************************
+// Sections in series, each one
+//
+//     y[n] = b0 * x[n] + b1 * x[n - 1] + b2 * x[n - 2]
+//                      - a1 * y[n - 1] - a2 * y[n - 2]
+//
+// with coeffs given as {b0, b1, b2, a1, a2} per section, a0 being 1. This
+// is Direct Form I, so the state is the samples themselves and can not
+// overflow inside a section. Each section rounds once, to SAMPLE. a1 is
+// usually close to -2 or 2, so COEFF needs at least 2 INT bits.
+template<class COEFF, class SAMPLE> class FixedBiquad{
+public:
+    typedef FixedFilterAccumulator<COEFF, SAMPLE> accumulator;
+    typedef typename accumulator::type accSize;
+    typedef typename COEFF::fixSize coeffSize;
+    typedef typename SAMPLE::fixSize sampleSize;
+
+    FixedBiquad(const COEFF *coeffs, std::size_t sections):
+        arena(sections * (5 * sizeof(coeffSize) + 4 * sizeof(sampleSize)) +
+              2 * FIXED_VECTOR_ALIGN),
+        coeffs(CAST<coeffSize*>(
+            arena.allocate(5 * sections * sizeof(coeffSize)))),
+        state(CAST<sampleSize*>(
+            arena.allocate(4 * sections * sizeof(sampleSize)))),
+        sections(sections){
+
+        assert(sections > 0);
+        for(std::size_t i = 0; i < 5 * sections; i++)
+            this->coeffs[i] = coeffs[i].getRawNumber();
+        reset();
+    }
+
+    FixedBiquad(const FixedBiquad&) = delete;
+    const FixedBiquad& operator=(const FixedBiquad&) = delete;
+
+    // Clears the state of every section
+    void reset(){
+        std::fill(state, state + 4 * sections, CAST<sampleSize>(0));
+    }
+
+    SAMPLE process(const SAMPLE &in){
+        SAMPLE ret = in;
+        for(std::size_t s = 0; s < sections; s++){
+            const coeffSize *c = coeffs + 5 * s;
+            sampleSize *z = state + 4 * s;
+            const sampleSize x = ret.getRawNumber();
+
+            ret = step(c, x, z[0], z[1], z[2], z[3]);
+            z[1] = z[0];
+            z[0] = x;
+            z[3] = z[2];
+            z[2] = ret.getRawNumber();
+        }
+        return ret;
+    }
+
+    // Runs the whole block through one section at a time, so the section
+    // coefficients and state stay in registers. dst may be the same
+    // buffer as src.
+    void process(SAMPLE *dst, const SAMPLE *src, std::size_t count){
+        for(std::size_t s = 0; s < sections; s++){
+            const coeffSize *c = coeffs + 5 * s;
+            sampleSize *z = state + 4 * s;
+            sampleSize x1 = z[0], x2 = z[1], y1 = z[2], y2 = z[3];
+            const SAMPLE *in = (s == 0) ? src : dst;
+
+            for(std::size_t i = 0; i < count; i++){
+                const sampleSize x = in[i].getRawNumber();
+                dst[i] = step(c, x, x1, x2, y1, y2);
+                x2 = x1;
+                x1 = x;
+                y2 = y1;
+                y1 = dst[i].getRawNumber();
+            }
+
+            z[0] = x1;
+            z[1] = x2;
+            z[2] = y1;
+            z[3] = y2;
+        }
+    }
+
+    std::size_t getSections() const{ return sections;}
+
+private:
+    static SAMPLE step(const coeffSize *c, sampleSize x, sampleSize x1,
+                       sampleSize x2, sampleSize y1, sampleSize y2){
+        const accSize acc = accumulator::mul(c[0], x) +
+                            accumulator::mul(c[1], x1) +
+                            accumulator::mul(c[2], x2) -
+                            accumulator::mul(c[3], y1) -
+                            accumulator::mul(c[4], y2);
+        return accumulator::template round<SAMPLE>(acc);
+    }
+
+    FixedArena arena;
+    coeffSize *coeffs;
+    sampleSize *state;
+    std::size_t sections;
+};
+
+#endif // FIXEDFILTER_H
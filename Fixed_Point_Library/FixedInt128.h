@@ -0,0 +1,529 @@
+/*
+ *  @file    FixedInt128.h
+ *
+ *  @brief A 128 bit integer made of two 64 bit words
+ *
+ *  DESCRIPTION
+ *
+ * FixedInt128<SIGN> is the fixSize of the 127 bit signed and 128 bit
+ * unsigned Fixed formats, like Fixed<64, 63> or Fixed<32, 96, UNSIGNED>.
+ * It is built from two fastu64 words, so it works without __int128 and
+ * with ENABLE_DW_BIT_MATH set to 0. FixedPoint.h includes it, it is not
+ * meant to be included on its own.
+ *
+ * It acts like the built in integers, so Fixed uses it the same way as the
+ * smaller sizes. Math wraps around, >> is arithmetic if SIGNED, and mixing
+ * SIGNED with UNSIGNED, or with a built in integer, gives the same type as
+ * the built in rules would. Converting to a built in integer keeps the low
+ * bits. Everything is constexpr.
+ *
+ * mulWide() gives the full 256 bit product from four 64 x 64 bit products
+ * (schoolbook, Karatsuba does not pay off at two words). Each one is a
+ * single 128 bit multiply when ENABLE_DW_BIT_MATH is 1, which the compiler
+ * turns into one mul, or mulx with BMI2. Otherwise it is built from four
+ * 32 bit products. Division is Knuth's algorithm D on 64 bit digits, with
+ * each digit guessed by a 128 by 64 bit divide done in 32 bit halves.
+ * divWide() divides a 256 bit number by a 128 bit one, which is what a
+ * 128 bit Fixed divide needs.
+ */
+
+
+
+
+#ifndef FIXEDINT128_H
+#define FIXEDINT128_H
+
+#ifndef FIXEDPOINT_H
+    #error "FixedInt128.h: Include FixedPoint.h instead"
+#endif // FIXEDPOINT_H
+
+
+
+// **************************************************************
+//                       64 Bit Word Math
+// **************************************************************
+struct FixedLimb{
+    const static fastu16 BITS = 64;
+    const static fastu64 HALF_MASK = 0xFFFFFFFF;
+
+    // Full 128 bit product of two words
+    static constexpr void mul(fastu64 a, fastu64 b, fastu64 &hi, fastu64 &lo){
+#if ENABLE_64_BIT_USE == 1 && ENABLE_DW_BIT_MATH == 1
+        const fastu128 prod = CAST<fastu128>(a) * b;
+        hi = CAST<fastu64>(prod >> BITS);
+        lo = CAST<fastu64>(prod);
+#else
+        const fastu64 aHi = a >> 32, aLo = a & HALF_MASK;
+        const fastu64 bHi = b >> 32, bLo = b & HALF_MASK;
+        const fastu64 lolo = aLo * bLo, lohi = aLo * bHi;
+        const fastu64 hilo = aHi * bLo, hihi = aHi * bHi;
+        const fastu64 mid = (lolo >> 32) + (lohi & HALF_MASK) +
+                            (hilo & HALF_MASK);
+
+        hi = hihi + (lohi >> 32) + (hilo >> 32) + (mid >> 32);
+        lo = (mid << 32) | (lolo & HALF_MASK);
+#endif // ENABLE_DW_BIT_MATH
+    }
+
+    static constexpr fastu16 leadingZeros(fastu64 num){
+#if defined(__GNUC__)
+        return (num == 0) ? BITS : __builtin_clzll(num);
+#else
+        fastu16 lead = 0;
+        for(fastu16 step = BITS / 2; step > 0; step /= 2){
+            if((num >> (BITS - step)) == 0){
+                num <<= step;
+                lead += step;
+            }
+        }
+        return (num == 0) ? BITS : lead;
+#endif // __GNUC__
+    }
+
+    // (hi:lo) / den, hi < den, with the remainder in rem. Hacker's
+    // Delight divlu: two 64 by 32 bit steps after shifting den up to the
+    // top bit, each guess at most 2 too big.
+    static constexpr fastu64 divide(fastu64 hi, fastu64 lo, fastu64 den,
+                                    fastu64 &rem){
+        const fastu64 BASE = CAST<fastu64>(1) << 32;
+        const fastu16 shift = leadingZeros(den);
+        den <<= shift;
+        const fastu64 denHi = den >> 32, denLo = den & HALF_MASK;
+
+        const fastu64 top = (hi << shift) |
+                            ((shift == 0) ? 0 : lo >> (BITS - shift));
+        const fastu64 low = lo << shift;
+        const fastu64 low1 = low >> 32, low0 = low & HALF_MASK;
+
+        fastu64 q1 = top / denHi;
+        fastu64 rhat = top - q1 * denHi;
+        while(q1 >= BASE || q1 * denLo > ((rhat << 32) | low1)){
+            q1--;
+            rhat += denHi;
+            if(rhat >= BASE) break;
+        }
+
+        const fastu64 mid = (top << 32) + low1 - q1 * den;
+        fastu64 q0 = mid / denHi;
+        rhat = mid - q0 * denHi;
+        while(q0 >= BASE || q0 * denLo > ((rhat << 32) | low0)){
+            q0--;
+            rhat += denHi;
+            if(rhat >= BASE) break;
+        }
+
+        rem = ((mid << 32) + low0 - q0 * den) >> shift;
+        return (q1 << 32) | q0;
+    }
+};
+
+
+
+// **************************************************************
+//                        128 Bit Integer
+// **************************************************************
+template<bool SIGN> class FixedInt128{
+public:
+    // Low word first, the same layout as __int128 on little endian CPUs
+    fastu64 lo;
+    fastu64 hi;
+
+    constexpr FixedInt128(): lo(0), hi(0){}
+    constexpr FixedInt128(fastu64 high, fastu64 low, bool): lo(low), hi(high){}
+
+    // From a built in integer, sign extended if it is signed
+    template<class T, typename std::enable_if<std::is_integral<T>::value,
+                                              int>::type = 0>
+    constexpr FixedInt128(T num):
+        lo(CAST<fastu64>(num)),
+        hi((std::is_signed<T>::value && CAST<fast64>(num) < 0) ?
+           ~CAST<fastu64>(0) : 0){}
+
+    // Between SIGNED and UNSIGNED keeps the bits
+    template<bool OTHER>
+    constexpr FixedInt128(const FixedInt128<OTHER> &num):
+        lo(num.lo), hi(num.hi){}
+
+    // Rounds toward zero, like a cast to a built in integer
+    template<class T, typename std::enable_if<
+                          std::is_floating_point<T>::value, int>::type = 0>
+    constexpr explicit FixedInt128(T num): lo(0), hi(0){
+        const T mag = (num < 0) ? -num : num;
+        hi = CAST<fastu64>(mag / WORD_SCALE);
+        lo = CAST<fastu64>(mag - CAST<T>(hi) * WORD_SCALE);
+        if(num < 0) *this = -*this;
+    }
+
+    // **************************************************************
+    //                         Conversions
+    // **************************************************************
+    constexpr explicit operator bool() const{ return (lo | hi) != 0;}
+
+    template<class T, typename std::enable_if<std::is_integral<T>::value &&
+                          !std::is_same<T, bool>::value, int>::type = 0>
+    constexpr explicit operator T() const{
+        return CAST<T>(lo);
+    }
+
+    // Rounds to nearest like the built in conversions. The top 64 bits are
+    // converted, with the bits below them folded into the lowest one, so
+    // that halfway cases round the right way, then scaled back up.
+    template<class T, typename std::enable_if<
+                          std::is_floating_point<T>::value, int>::type = 0>
+    constexpr explicit operator T() const{
+        const FixedInt128<false> mag = magnitude(*this);
+        const fastu16 shift = (mag.hi == 0) ? 0 :
+            FixedLimb::BITS - FixedLimb::leadingZeros(mag.hi);
+        if(shift == 0) return (isNegative()) ? -CAST<T>(mag.lo)
+                                             : CAST<T>(mag.lo);
+
+        // 1 <= shift <= 64, the bits shifted out are all in lo
+        const fastu64 top = (mag >> shift).lo |
+            ((mag.lo << ((FixedLimb::BITS - shift) % FixedLimb::BITS)) != 0);
+        const T ret = CAST<T>(top) *
+                      (CAST<T>(CAST<fastu64>(1) << (shift - 1)) * 2);
+        return (isNegative()) ? -ret : ret;
+    }
+
+    constexpr bool isNegative() const{
+        return SIGN && (hi >> (FixedLimb::BITS - 1)) != 0;
+    }
+
+    static constexpr FixedInt128<false> magnitude(const FixedInt128 &num){
+        return (num.isNegative()) ? FixedInt128<false>(-num)
+                                  : FixedInt128<false>(num);
+    }
+
+    // **************************************************************
+    //                        Math Operators
+    // **************************************************************
+    constexpr FixedInt128 operator~() const{
+        return FixedInt128(~hi, ~lo, true);
+    }
+    constexpr FixedInt128 operator-() const{
+        return FixedInt128(~hi + (lo == 0), ~lo + 1, true);
+    }
+    constexpr FixedInt128 operator+() const{ return *this;}
+
+    constexpr FixedInt128& operator+=(const FixedInt128 &R){
+        lo += R.lo;
+        hi += R.hi + (lo < R.lo);
+        return *this;
+    }
+    constexpr FixedInt128& operator-=(const FixedInt128 &R){
+        hi -= R.hi + (lo < R.lo);
+        lo -= R.lo;
+        return *this;
+    }
+
+    // Low 128 bits of the product, three word products
+    constexpr FixedInt128& operator*=(const FixedInt128 &R){
+        fastu64 prodHi = 0, prodLo = 0;
+        FixedLimb::mul(lo, R.lo, prodHi, prodLo);
+        hi = prodHi + lo * R.hi + hi * R.lo;
+        lo = prodLo;
+        return *this;
+    }
+
+    // Rounds toward zero, the remainder has the sign of the dividend
+    constexpr FixedInt128& operator/=(const FixedInt128 &R){
+        FixedInt128<false> quot, rem;
+        divMod(magnitude(*this), magnitude(R), quot, rem);
+        *this = (isNegative() != R.isNegative()) ? -FixedInt128(quot)
+                                                 : FixedInt128(quot);
+        return *this;
+    }
+    constexpr FixedInt128& operator%=(const FixedInt128 &R){
+        FixedInt128<false> quot, rem;
+        divMod(magnitude(*this), magnitude(R), quot, rem);
+        *this = (isNegative()) ? -FixedInt128(rem) : FixedInt128(rem);
+        return *this;
+    }
+
+    constexpr FixedInt128& operator&=(const FixedInt128 &R){
+        lo &= R.lo;
+        hi &= R.hi;
+        return *this;
+    }
+    constexpr FixedInt128& operator|=(const FixedInt128 &R){
+        lo |= R.lo;
+        hi |= R.hi;
+        return *this;
+    }
+    constexpr FixedInt128& operator^=(const FixedInt128 &R){
+        lo ^= R.lo;
+        hi ^= R.hi;
+        return *this;
+    }
+
+    constexpr FixedInt128& operator++(){ return *this += 1;}
+    constexpr FixedInt128& operator--(){ return *this -= 1;}
+    constexpr FixedInt128 operator++(int){
+        const FixedInt128 ret = *this;
+        *this += 1;
+        return ret;
+    }
+    constexpr FixedInt128 operator--(int){
+        const FixedInt128 ret = *this;
+        *this -= 1;
+        return ret;
+    }
+
+    // Shifts need 0 <= shift < 128, like the built in shifts
+    template<class T> constexpr FixedInt128& operator<<=(T shift){
+        const fastu16 n = CAST<fastu16>(shift);
+        if(n >= FixedLimb::BITS){
+            hi = lo << (n - FixedLimb::BITS);
+            lo = 0;
+        }
+        else if(n != 0){
+            hi = (hi << n) | (lo >> (FixedLimb::BITS - n));
+            lo <<= n;
+        }
+        return *this;
+    }
+    template<class T> constexpr FixedInt128& operator>>=(T shift){
+        const fastu16 n = CAST<fastu16>(shift);
+        const fastu64 fill = (isNegative()) ? ~CAST<fastu64>(0) : 0;
+        if(n >= FixedLimb::BITS){
+            lo = (n == FixedLimb::BITS) ? hi :
+                 (hi >> (n - FixedLimb::BITS)) |
+                 (fill << (2 * FixedLimb::BITS - n));
+            hi = fill;
+        }
+        else if(n != 0){
+            lo = (lo >> n) | (hi << (FixedLimb::BITS - n));
+            hi = (hi >> n) | (fill << (FixedLimb::BITS - n));
+        }
+        return *this;
+    }
+
+    template<class T> constexpr FixedInt128 operator<<(T shift) const{
+        FixedInt128 ret = *this;
+        return ret <<= shift;
+    }
+    template<class T> constexpr FixedInt128 operator>>(T shift) const{
+        FixedInt128 ret = *this;
+        return ret >>= shift;
+    }
+
+    // **************************************************************
+    //                    Comparison and Division
+    // **************************************************************
+    static constexpr bool less(const FixedInt128 &L, const FixedInt128 &R){
+        return (L.hi != R.hi) ?
+            ((SIGN) ? CAST<fast64>(L.hi) < CAST<fast64>(R.hi) : L.hi < R.hi) :
+            L.lo < R.lo;
+    }
+    static constexpr bool equal(const FixedInt128 &L, const FixedInt128 &R){
+        return L.lo == R.lo && L.hi == R.hi;
+    }
+
+    // Full 256 bit product of two unsigned numbers, as (hi:lo)
+    static constexpr void mulWide(FixedInt128<false> a, FixedInt128<false> b,
+                                  FixedInt128<false> &hi,
+                                  FixedInt128<false> &lo){
+        fastu64 h00 = 0, l00 = 0, h01 = 0, l01 = 0;
+        fastu64 h10 = 0, l10 = 0, h11 = 0, l11 = 0;
+        FixedLimb::mul(a.lo, b.lo, h00, l00);
+        FixedLimb::mul(a.lo, b.hi, h01, l01);
+        FixedLimb::mul(a.hi, b.lo, h10, l10);
+        FixedLimb::mul(a.hi, b.hi, h11, l11);
+
+        // Each column sum fits in two words, the high one is the carry.
+        // Only the compound operators are declared yet.
+        FixedInt128<false> mid = h00;
+        mid += l01;
+        mid += l10;
+        FixedInt128<false> top = h01;
+        top += h10;
+        top += l11;
+        top += mid.hi;
+        lo = FixedInt128<false>(mid.lo, l00, true);
+        hi = FixedInt128<false>(h11 + top.hi, top.lo, true);
+    }
+
+    // num / den and num % den of unsigned numbers, den != 0. Hacker's
+    // Delight udivti3: one word divide if den fits in a word, otherwise a
+    // guess from the top bits that is at most one too small.
+    static constexpr void divMod(FixedInt128<false> num,
+                                 FixedInt128<false> den,
+                                 FixedInt128<false> &quot,
+                                 FixedInt128<false> &rem){
+        if(den.hi == 0){
+            fastu64 r = 0;
+            const fastu64 qHi = num.hi / den.lo;
+            const fastu64 qLo = FixedLimb::divide(num.hi % den.lo, num.lo,
+                                                  den.lo, r);
+            quot = FixedInt128<false>(qHi, qLo, true);
+            rem = r;
+            return;
+        }
+
+        const fastu16 shift = FixedLimb::leadingZeros(den.hi);
+        const fastu64 top = (den << shift).hi;
+        const FixedInt128<false> half = num >> 1;
+        fastu64 r = 0;
+        fastu64 q = FixedLimb::divide(half.hi, half.lo, top, r) >>
+                    (FixedLimb::BITS - 1 - shift);
+        q -= (q != 0);
+
+        FixedInt128<false> prod = den;
+        prod *= q;
+        rem = num;
+        rem -= prod;
+        if(!FixedInt128<false>::less(rem, den)){
+            q++;
+            rem -= den;
+        }
+        quot = q;
+    }
+
+    // (hi:lo) / den for a 256 bit numerator, needs hi < den so the quotient
+    // fits. Knuth's algorithm D with two 64 bit quotient digits.
+    static constexpr FixedInt128<false> divWide(FixedInt128<false> hi,
+                                                FixedInt128<false> lo,
+                                                FixedInt128<false> den){
+        fastu64 r = 0;
+        if(den.hi == 0){
+            const fastu64 qHi = FixedLimb::divide(hi.lo, lo.hi, den.lo, r);
+            const fastu64 qLo = FixedLimb::divide(r, lo.lo, den.lo, r);
+            return FixedInt128<false>(qHi, qLo, true);
+        }
+
+        // Shift den up to the top bit, and the numerator with it
+        const fastu16 shift = FixedLimb::leadingZeros(den.hi);
+        den <<= shift;
+        if(shift != 0){
+            hi <<= shift;
+            hi |= lo >> (2 * FixedLimb::BITS - shift);
+            lo <<= shift;
+        }
+
+        const fastu64 qHi = divDigit(hi, lo.hi, den);
+        const fastu64 qLo = divDigit(hi, lo.lo, den);
+        return FixedInt128<false>(qHi, qLo, true);
+    }
+
+private:
+    // 2^64 as a floating point number
+    static constexpr double WORD_SCALE = 18446744073709551616.0;
+
+    // One quotient digit of (rem:next) / den, den has its top bit set and
+    // rem < den. rem becomes the new remainder. The guess from the top
+    // words is at most 2 too big (Knuth's theorem B).
+    static constexpr fastu64 divDigit(FixedInt128<false> &rem, fastu64 next,
+                                      const FixedInt128<false> &den){
+        fastu64 q = ~CAST<fastu64>(0);
+        fastu64 r = 0;
+        if(rem.hi < den.hi) q = FixedLimb::divide(rem.hi, rem.lo, den.hi, r);
+
+        // (rem:next) - q * den, three words, the top one signed
+        fastu64 prodTop = 0, prodHi = 0, prodLo = 0, carry = 0;
+        FixedLimb::mul(q, den.lo, carry, prodLo);
+        FixedLimb::mul(q, den.hi, prodTop, prodHi);
+        prodHi += carry;
+        prodTop += (prodHi < carry);
+
+        const FixedInt128<false> prod(prodHi, prodLo, true);
+        FixedInt128<false> low(rem.lo, next, true);
+        fast64 top = CAST<fast64>(rem.hi - prodTop -
+                                  FixedInt128<false>::less(low, prod));
+        low -= prod;
+
+        while(top < 0){
+            q--;
+            low += den;
+            top += FixedInt128<false>::less(low, den);
+        }
+
+        rem = low;
+        return q;
+    }
+};
+
+template<bool SIGN> constexpr double FixedInt128<SIGN>::WORD_SCALE;
+
+static_assert(sizeof(FixedInt128<true>) == 16,
+              "FixedInt128.h: FixedInt128 needs to be 128 bits");
+
+
+
+// **************************************************************
+//                      Free Operators
+// **************************************************************
+// SIGNED with UNSIGNED gives UNSIGNED, and a built in integer takes the
+// type of the FixedInt128, the same as the built in promotions
+#define FIXED_INT128_OPERATOR(OP, ASSIGN)                                      \
+template<bool L_SIGN, bool R_SIGN>                                             \
+constexpr FixedInt128<L_SIGN && R_SIGN> operator OP(                           \
+    const FixedInt128<L_SIGN> &L, const FixedInt128<R_SIGN> &R){               \
+    FixedInt128<L_SIGN && R_SIGN> ret = L;                                     \
+    ret ASSIGN R;                                                              \
+    return ret;                                                                \
+}                                                                              \
+template<bool SIGN, class T> constexpr typename std::enable_if<                \
+    std::is_integral<T>::value, FixedInt128<SIGN> >::type                      \
+operator OP(const FixedInt128<SIGN> &L, T R){                                  \
+    return L OP FixedInt128<SIGN>(R);                                          \
+}                                                                              \
+template<bool SIGN, class T> constexpr typename std::enable_if<                \
+    std::is_integral<T>::value, FixedInt128<SIGN> >::type                      \
+operator OP(T L, const FixedInt128<SIGN> &R){                                  \
+    return FixedInt128<SIGN>(L) OP R;                                          \
+}
+
+FIXED_INT128_OPERATOR(+, +=)
+FIXED_INT128_OPERATOR(-, -=)
+FIXED_INT128_OPERATOR(*, *=)
+FIXED_INT128_OPERATOR(/, /=)
+FIXED_INT128_OPERATOR(%, %=)
+FIXED_INT128_OPERATOR(&, &=)
+FIXED_INT128_OPERATOR(|, |=)
+FIXED_INT128_OPERATOR(^, ^=)
+
+#undef FIXED_INT128_OPERATOR
+
+#define FIXED_INT128_COMPARE(OP, RESULT)                                       \
+template<bool L_SIGN, bool R_SIGN>                                             \
+constexpr bool operator OP(const FixedInt128<L_SIGN> &L,                       \
+                           const FixedInt128<R_SIGN> &R){                      \
+    typedef FixedInt128<L_SIGN && R_SIGN> type;                                \
+    return RESULT;                                                             \
+}                                                                              \
+template<bool SIGN, class T> constexpr typename std::enable_if<                \
+    std::is_integral<T>::value, bool>::type                                    \
+operator OP(const FixedInt128<SIGN> &L, T R){                                  \
+    return L OP FixedInt128<SIGN>(R);                                          \
+}                                                                              \
+template<bool SIGN, class T> constexpr typename std::enable_if<                \
+    std::is_integral<T>::value, bool>::type                                    \
+operator OP(T L, const FixedInt128<SIGN> &R){                                  \
+    return FixedInt128<SIGN>(L) OP R;                                          \
+}
+
+FIXED_INT128_COMPARE(==, type::equal(L, R))
+FIXED_INT128_COMPARE(!=, !type::equal(L, R))
+FIXED_INT128_COMPARE(<, type::less(L, R))
+FIXED_INT128_COMPARE(>, type::less(R, L))
+FIXED_INT128_COMPARE(<=, !type::less(R, L))
+FIXED_INT128_COMPARE(>=, !type::less(L, R))
+
+#undef FIXED_INT128_COMPARE
+
+// Same as the built in versions in FixedPoint.h, which need a built in type
+template<bool SIGN>
+constexpr bool Fixed_addOverflow(FixedInt128<SIGN> L, FixedInt128<SIGN> R,
+                                 FixedInt128<SIGN> &ret){
+    ret = L + R;
+    return (SIGN) ? (L < 0) == (R < 0) && (ret < 0) != (L < 0) : ret < L;
+}
+
+template<bool SIGN>
+constexpr bool Fixed_subOverflow(FixedInt128<SIGN> L, FixedInt128<SIGN> R,
+                                 FixedInt128<SIGN> &ret){
+    ret = L - R;
+    return (SIGN) ? (L < 0) != (R < 0) && (ret < 0) != (L < 0) : R > L;
+}
+
+#endif // FIXEDINT128_H
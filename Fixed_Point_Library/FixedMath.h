@@ -5,19 +5,20 @@
 #include <iostream>
 
 #if ENABLE_64_BIT_USE == 1
-    const static Fixed<2, 61> FIXED_PI(3.14159265358979323846264);
-    const static Fixed<2, 61> FIXED_PIDIV2 = FIXED_PI / 2;
+    constexpr static Fixed<2, 61> FIXED_PI(3.14159265358979323846264);
+    constexpr static Fixed<2, 61> FIXED_PIDIV2 = FIXED_PI / 2;
 #elif ENABLE_32_BIT_USE == 1
-    const static Fixed<2, 29> FIXED_PI(3.14159265358979323846264);
-    const static Fixed<2, 29> FIXED_PIDIV2 = FIXED_PI / 2;
+    constexpr static Fixed<2, 29> FIXED_PI(3.14159265358979323846264);
+    constexpr static Fixed<2, 29> FIXED_PIDIV2 = FIXED_PI / 2;
 #else
-    const static Fixed<2, 13> FIXED_PI(3.14159f);
-    const static Fixed<2, 13> FIXED_PIDIV2 = FIXED_PI / 2.0;
+    constexpr static Fixed<2, 13> FIXED_PI(3.14159f);
+    constexpr static Fixed<2, 13> FIXED_PIDIV2 = FIXED_PI / 2.0;
 #endif // ENABLE_64_BIT_USE
 
 // Taylor Series expansion of e^x method
 template<fastu16 INT, fastu16 FRAC>
-Fixed<INT, FRAC> Fixed_exp(Fixed<INT, FRAC> x, fast32 precision = 0){
+constexpr Fixed<INT, FRAC> Fixed_exp(Fixed<INT, FRAC> x,
+                                     fast32 precision = 0){
     Fixed<INT, FRAC> sum(1 + x), iteration(x);
     fast32 n = 2;
 
@@ -38,7 +39,8 @@ Fixed<INT, FRAC> Fixed_exp(Fixed<INT, FRAC> x, fast32 precision = 0){
 
 // http://www.claysturner.com/dsp/BinaryLogarithm.pdf
 template<fastu16 INT, fastu16 FRAC>
-Fixed<INT, FRAC> Fixed_Log2(Fixed<INT, FRAC> x, fastu16 precision = 0){
+constexpr Fixed<INT, FRAC> Fixed_Log2(Fixed<INT, FRAC> x,
+                                      fastu16 precision = 0){
     Fixed<INT, FRAC> y(0), b(0.5);
 
     while(x < 1){
@@ -81,8 +83,8 @@ Fixed<INT, FRAC> Fixed_Log2(Fixed<INT, FRAC> x, fastu16 precision = 0){
 // Quadratic approximation of a sine wave
 // Min/Max Err: +-0.0010946, Avg Err: 0.00050539 rads
 template<fastu16 INT, fastu16 FRAC>
-Fixed<INT, FRAC> Fixed_sin(Fixed<INT, FRAC> x){
-    const static Fixed<INT, FRAC>
+constexpr Fixed<INT, FRAC> Fixed_sin(Fixed<INT, FRAC> x){
+    constexpr Fixed<INT, FRAC>
         FIX_PI(FIXED_PI.fit<INT, FRAC>()),
         FIX_2PI(2 * FIX_PI),
         CONST1(1.27323954),
@@ -106,14 +108,14 @@ Fixed<INT, FRAC> Fixed_sin(Fixed<INT, FRAC> x){
 }
 
 template<fastu16 INT, fastu16 FRAC>
-Fixed<INT, FRAC> Fixed_cos(const Fixed<INT, FRAC> &x){
-    const static Fixed<INT, FRAC> FIX_PIDIV2 = FIXED_PIDIV2.fit<INT, FRAC>();
+constexpr Fixed<INT, FRAC> Fixed_cos(const Fixed<INT, FRAC> &x){
+    constexpr Fixed<INT, FRAC> FIX_PIDIV2 = FIXED_PIDIV2.fit<INT, FRAC>();
     return Fixed_sin<INT, FRAC>(x + FIX_PIDIV2);
 }
 
 template<fastu16 INT, fastu16 FRAC>
-Fixed<INT, FRAC> Fixed_tan(const Fixed<INT, FRAC> &x){
-    const static Fixed<INT, FRAC> FIX_PIDIV2 = FIXED_PIDIV2.fit<INT, FRAC>();
+constexpr Fixed<INT, FRAC> Fixed_tan(const Fixed<INT, FRAC> &x){
+    constexpr Fixed<INT, FRAC> FIX_PIDIV2 = FIXED_PIDIV2.fit<INT, FRAC>();
     Fixed<INT, FRAC> cosVal = Fixed_sin(x + FIX_PIDIV2);
     if(cosVal.isZero()) return cosVal.getMaxValue(); // Saturate
     return Fixed_sin<INT, FRAC>(x) / cosVal;
@@ -124,16 +126,16 @@ Fixed<INT, FRAC> Fixed_tan(const Fixed<INT, FRAC> &x){
 //    Operates in range [-1, 1]
 
 template<fastu16 INT, fastu16 FRAC>
-Fixed<INT, FRAC> Fixed_atan(const Fixed<INT, FRAC> &x){
-    static const Fixed<INT, FRAC> CONST1(0.97239411), CONST2(-0.19194795);
+constexpr Fixed<INT, FRAC> Fixed_atan(const Fixed<INT, FRAC> &x){
+    constexpr Fixed<INT, FRAC> CONST1(0.97239411), CONST2(-0.19194795);
 
     return (CONST1 + (CONST2 * x * x)) * x;
 }
 
 template<fastu16 INT, fastu16 FRAC>
-Fixed<INT, FRAC> Fixed_atan2(const Fixed<INT, FRAC> &y,
-                             const Fixed<INT, FRAC> &x){
-    const static Fixed<INT, FRAC>
+constexpr Fixed<INT, FRAC> Fixed_atan2(const Fixed<INT, FRAC> &y,
+                                       const Fixed<INT, FRAC> &x){
+    constexpr Fixed<INT, FRAC>
         FIX_PI(FIXED_PI.fit<INT, FRAC>()),
         FIX_PIDIV2(FIXED_PIDIV2.fit<INT, FRAC>());
 
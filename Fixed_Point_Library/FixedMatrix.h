@@ -0,0 +1,376 @@
+/*
+ *  @file    FixedMatrix.h
+ *
+ *  @brief Small fixed size vectors, matrices and quaternions of Fixed
+ *
+ *  DESCRIPTION
+ *
+ * FixedVec<FIXED, N> and FixedMat<FIXED, R, C> hold N and R x C numbers of
+ * any Fixed type. Both are aggregates, so they can be brace initialized and
+ * used in constant expressions:
+ *
+ *     typedef Fixed<16, 15> fixed;
+ *     constexpr FixedMat<fixed, 2, 2> spin = {{{0, -1}, {1, 0}}};
+ *     FixedVec<fixed, 2> p = {{3, 4}};
+ *     p = spin * p; // {-4, 3}
+ *
+ * Fixed_dot, Fixed_cross, matrix * vector and matrix * matrix add up the
+ * products of the raw numbers in dfixSize and round once per output, half
+ * up, with the FIXED overflow policy. A loop over operator* and operator+=
+ * rounds every product instead. FixedDot and FixedProducts unroll the dot
+ * products and the outputs at compile time.
+ *
+ * A product is exact in dfixSize with one bit to spare, so a sum can only
+ * overflow dfixSize when its terms are close to full scale, and by then the
+ * result is far outside the format anyway.
+ *
+ * FixedQuat<INT, FRAC> is a rotation quaternion built from an axis and an
+ * angle with Fixed_sin and Fixed_cos from FixedMath.h. rotate() goes
+ * through toMatrix(), so when many vectors get the same rotation, convert
+ * once and multiply by the matrix.
+ *
+ * 64 bit formats need ENABLE_DW_BIT_MATH, since dfixSize is 128 bits.
+ */
+
+
+
+
+#ifndef FIXEDMATRIX_H
+#define FIXEDMATRIX_H
+
+#include "FixedMath.h"
+
+
+
+// **************************************************************
+//                         Dot Products
+// **************************************************************
+// Exact product of the raw numbers
+template<class FIXED>
+constexpr typename FIXED::dfixSize Fixed_product(const FIXED &L,
+                                                 const FIXED &R){
+    return CAST<typename FIXED::dfixSize>(L.getRawNumber()) *
+           CAST<typename FIXED::dfixSize>(R.getRawNumber());
+}
+
+// Sums of N products in dfixSize, unrolled by recursion. sum() is a[i] * b[i],
+// column() is a[i] * m[i][c].
+template<fastu16 N> struct FixedDot{
+    template<class FIXED>
+    static constexpr typename FIXED::dfixSize sum(const FIXED *a,
+                                                  const FIXED *b){
+        return FixedDot<N - 1>::sum(a, b) + Fixed_product(a[N - 1], b[N - 1]);
+    }
+
+    template<class FIXED, fastu16 ROWS, fastu16 C>
+    static constexpr typename FIXED::dfixSize column(const FIXED *a,
+                                                     const FIXED (&m)[ROWS][C],
+                                                     fastu16 c){
+        return FixedDot<N - 1>::column(a, m, c) +
+               Fixed_product(a[N - 1], m[N - 1][c]);
+    }
+};
+
+template<> struct FixedDot<0>{
+    template<class FIXED>
+    static constexpr typename FIXED::dfixSize sum(const FIXED*, const FIXED*){
+        return 0;
+    }
+
+    template<class FIXED, fastu16 ROWS, fastu16 C>
+    static constexpr typename FIXED::dfixSize column(const FIXED*,
+                                                     const FIXED (&)[ROWS][C],
+                                                     fastu16){
+        return 0;
+    }
+};
+
+// Rounds a sum of products back to FIXED, half up like operator*, with the
+// FIXED overflow policy
+template<class FIXED>
+constexpr FIXED Fixed_roundProducts(typename FIXED::dfixSize sum){
+    typedef typename FIXED::fixSize fixSize;
+    typedef typename FIXED::dfixSize dfixSize;
+    static_assert(sizeof(dfixSize) >= 2 * sizeof(fixSize),
+                  "FixedMatrix.h: Products do not fit dfixSize, "
+                  "set ENABLE_DW_BIT_MATH to 1");
+
+    // 1 << (FRAC - 1), or 0 when there are no FRAC bits
+    const fastu16 FRAC = FIXED::FRAC_BITS;
+    const dfixSize half = CAST<dfixSize>(FRAC > 0) << (FRAC - (FRAC > 0));
+    const dfixSize ret = (sum + half) >> FRAC;
+    const bool over =
+        ret > CAST<dfixSize>(FIXED().getMaxValue().getRawNumber()) ||
+        ret < CAST<dfixSize>(FIXED().getMinValue().getRawNumber());
+
+    FIXED out;
+    out.setRawNumber(FIXED::applyOverflow(CAST<fixSize>(ret), over, ret > 0));
+    return out;
+}
+
+
+
+// **************************************************************
+//                            Vectors
+// **************************************************************
+template<class FIXED, fastu16 N> struct FixedVec{
+    typedef FIXED fixed;
+    const static fastu16 SIZE = N;
+
+    FIXED value[N];
+
+    constexpr FIXED& operator[](fastu16 i){ return value[i];}
+    constexpr const FIXED& operator[](fastu16 i) const{ return value[i];}
+
+    constexpr friend FixedVec operator+(const FixedVec &L, const FixedVec &R){
+        FixedVec ret{};
+        for(fastu16 i = 0; i < N; i++) ret.value[i] = L.value[i] + R.value[i];
+        return ret;
+    }
+    constexpr friend FixedVec operator-(const FixedVec &L, const FixedVec &R){
+        FixedVec ret{};
+        for(fastu16 i = 0; i < N; i++) ret.value[i] = L.value[i] - R.value[i];
+        return ret;
+    }
+    constexpr friend FixedVec operator-(const FixedVec &R){
+        FixedVec ret{};
+        for(fastu16 i = 0; i < N; i++) ret.value[i] = -R.value[i];
+        return ret;
+    }
+    constexpr friend FixedVec operator*(const FixedVec &L, const FIXED &R){
+        FixedVec ret{};
+        for(fastu16 i = 0; i < N; i++) ret.value[i] = L.value[i] * R;
+        return ret;
+    }
+    constexpr friend FixedVec operator*(const FIXED &L, const FixedVec &R){
+        return R * L;
+    }
+
+    constexpr void operator+=(const FixedVec &R){ *this = *this + R;}
+    constexpr void operator-=(const FixedVec &R){ *this = *this - R;}
+    constexpr void operator*=(const FIXED &R){ *this = *this * R;}
+
+    constexpr friend bool operator==(const FixedVec &L, const FixedVec &R){
+        for(fastu16 i = 0; i < N; i++)
+            if(L.value[i] != R.value[i]) return false;
+        return true;
+    }
+    constexpr friend bool operator!=(const FixedVec &L, const FixedVec &R){
+        return !(L == R);
+    }
+};
+
+template<class FIXED, fastu16 N>
+constexpr FIXED Fixed_dot(const FixedVec<FIXED, N> &L,
+                          const FixedVec<FIXED, N> &R){
+    return Fixed_roundProducts<FIXED>(FixedDot<N>::sum(L.value, R.value));
+}
+
+template<class FIXED>
+constexpr FixedVec<FIXED, 3> Fixed_cross(const FixedVec<FIXED, 3> &L,
+                                         const FixedVec<FIXED, 3> &R){
+    return {{
+        Fixed_roundProducts<FIXED>(Fixed_product(L[1], R[2]) -
+                                   Fixed_product(L[2], R[1])),
+        Fixed_roundProducts<FIXED>(Fixed_product(L[2], R[0]) -
+                                   Fixed_product(L[0], R[2])),
+        Fixed_roundProducts<FIXED>(Fixed_product(L[0], R[1]) -
+                                   Fixed_product(L[1], R[0]))
+    }};
+}
+
+
+
+// **************************************************************
+//                           Matrices
+// **************************************************************
+// Row major, value[row][column]
+template<class FIXED, fastu16 R, fastu16 C> struct FixedMat{
+    typedef FIXED fixed;
+    const static fastu16 ROWS = R;
+    const static fastu16 COLUMNS = C;
+
+    FIXED value[R][C];
+
+    constexpr FIXED& operator()(fastu16 r, fastu16 c){ return value[r][c];}
+    constexpr const FIXED& operator()(fastu16 r, fastu16 c) const{
+        return value[r][c];
+    }
+
+    static constexpr FixedMat identity(){
+        static_assert(R == C, "FixedMatrix.h: Identity must be square");
+        FixedMat ret{};
+        for(fastu16 i = 0; i < R; i++) ret.value[i][i] = FIXED(1);
+        return ret;
+    }
+
+    constexpr FixedMat<FIXED, C, R> transpose() const{
+        FixedMat<FIXED, C, R> ret{};
+        for(fastu16 r = 0; r < R; r++)
+            for(fastu16 c = 0; c < C; c++)
+                ret.value[c][r] = value[r][c];
+        return ret;
+    }
+
+    constexpr friend FixedMat operator+(const FixedMat &L, const FixedMat &M){
+        FixedMat ret{};
+        for(fastu16 r = 0; r < R; r++)
+            for(fastu16 c = 0; c < C; c++)
+                ret.value[r][c] = L.value[r][c] + M.value[r][c];
+        return ret;
+    }
+    constexpr friend FixedMat operator-(const FixedMat &L, const FixedMat &M){
+        FixedMat ret{};
+        for(fastu16 r = 0; r < R; r++)
+            for(fastu16 c = 0; c < C; c++)
+                ret.value[r][c] = L.value[r][c] - M.value[r][c];
+        return ret;
+    }
+    constexpr friend FixedMat operator*(const FixedMat &L, const FIXED &M){
+        FixedMat ret{};
+        for(fastu16 r = 0; r < R; r++)
+            for(fastu16 c = 0; c < C; c++)
+                ret.value[r][c] = L.value[r][c] * M;
+        return ret;
+    }
+    constexpr friend FixedMat operator*(const FIXED &L, const FixedMat &M){
+        return M * L;
+    }
+
+    constexpr friend bool operator==(const FixedMat &L, const FixedMat &M){
+        for(fastu16 r = 0; r < R; r++)
+            for(fastu16 c = 0; c < C; c++)
+                if(L.value[r][c] != M.value[r][c]) return false;
+        return true;
+    }
+    constexpr friend bool operator!=(const FixedMat &L, const FixedMat &M){
+        return !(L == M);
+    }
+};
+
+// Outputs N - 1 down to 0 of L * M, one dot product each, unrolled by
+// recursion like FixedDot. Matrix products count row by row.
+template<fastu16 N> struct FixedProducts{
+    template<class FIXED, fastu16 R, fastu16 C>
+    static constexpr void vector(FixedVec<FIXED, R> &ret,
+                                 const FixedMat<FIXED, R, C> &L,
+                                 const FixedVec<FIXED, C> &M){
+        FixedProducts<N - 1>::vector(ret, L, M);
+        ret.value[N - 1] = Fixed_roundProducts<FIXED>(
+            FixedDot<C>::sum(L.value[N - 1], M.value));
+    }
+
+    template<class FIXED, fastu16 R, fastu16 K, fastu16 C>
+    static constexpr void matrix(FixedMat<FIXED, R, C> &ret,
+                                 const FixedMat<FIXED, R, K> &L,
+                                 const FixedMat<FIXED, K, C> &M){
+        FixedProducts<N - 1>::matrix(ret, L, M);
+        ret.value[(N - 1) / C][(N - 1) % C] = Fixed_roundProducts<FIXED>(
+            FixedDot<K>::column(L.value[(N - 1) / C], M.value, (N - 1) % C));
+    }
+};
+
+template<> struct FixedProducts<0>{
+    template<class FIXED, fastu16 R, fastu16 C>
+    static constexpr void vector(FixedVec<FIXED, R>&,
+                                 const FixedMat<FIXED, R, C>&,
+                                 const FixedVec<FIXED, C>&){}
+
+    template<class FIXED, fastu16 R, fastu16 K, fastu16 C>
+    static constexpr void matrix(FixedMat<FIXED, R, C>&,
+                                 const FixedMat<FIXED, R, K>&,
+                                 const FixedMat<FIXED, K, C>&){}
+};
+
+template<class FIXED, fastu16 R, fastu16 C>
+constexpr FixedVec<FIXED, R> operator*(const FixedMat<FIXED, R, C> &L,
+                                       const FixedVec<FIXED, C> &M){
+    FixedVec<FIXED, R> ret{};
+    FixedProducts<R>::vector(ret, L, M);
+    return ret;
+}
+
+template<class FIXED, fastu16 R, fastu16 K, fastu16 C>
+constexpr FixedMat<FIXED, R, C> operator*(const FixedMat<FIXED, R, K> &L,
+                                          const FixedMat<FIXED, K, C> &M){
+    FixedMat<FIXED, R, C> ret{};
+    FixedProducts<R * C>::matrix(ret, L, M);
+    return ret;
+}
+
+
+
+// **************************************************************
+//                          Quaternions
+// **************************************************************
+// w + xi + yj + zk. Rotations are unit quaternions, so INT needs to be at
+// least 1, and 2 or more for angles past pi/2 since Fixed_sin takes them.
+template<fastu16 INT, fastu16 FRAC> struct FixedQuat{
+    typedef Fixed<INT, FRAC> fixed;
+    typedef typename fixed::dfixSize dfixSize;
+    typedef FixedVec<fixed, 3> vec3;
+
+    static_assert(INT >= 1, "FixedMatrix.h: Quaternion needs to hold 1");
+
+    fixed w, x, y, z;
+
+    static constexpr FixedQuat identity(){
+        return {fixed(1), fixed(0), fixed(0), fixed(0)};
+    }
+
+    // Rotation of angle radians about axis, which has to be a unit vector
+    static constexpr FixedQuat fromAxisAngle(const vec3 &axis,
+                                             const fixed &angle){
+        const fixed half = angle / 2;
+        const fixed s = Fixed_sin(half);
+        return {Fixed_cos(half), axis[0] * s, axis[1] * s, axis[2] * s};
+    }
+
+    // The inverse rotation, for a unit quaternion
+    constexpr FixedQuat conjugate() const{ return {w, -x, -y, -z};}
+
+    // L * R rotates by R, then by L
+    constexpr friend FixedQuat operator*(const FixedQuat &L,
+                                         const FixedQuat &R){
+        return {
+            round(product(L.w, R.w) - product(L.x, R.x) -
+                  product(L.y, R.y) - product(L.z, R.z)),
+            round(product(L.w, R.x) + product(L.x, R.w) +
+                  product(L.y, R.z) - product(L.z, R.y)),
+            round(product(L.w, R.y) - product(L.x, R.z) +
+                  product(L.y, R.w) + product(L.z, R.x)),
+            round(product(L.w, R.z) + product(L.x, R.y) -
+                  product(L.y, R.x) + product(L.z, R.w))
+        };
+    }
+
+    constexpr FixedMat<fixed, 3, 3> toMatrix() const{
+        const dfixSize ONE = CAST<dfixSize>(1) << (2 * FRAC);
+        const dfixSize xx = product(x, x), yy = product(y, y);
+        const dfixSize zz = product(z, z), xy = product(x, y);
+        const dfixSize xz = product(x, z), yz = product(y, z);
+        const dfixSize wx = product(w, x), wy = product(w, y);
+        const dfixSize wz = product(w, z);
+
+        return {{
+            {round(ONE - 2 * (yy + zz)), round(2 * (xy - wz)),
+             round(2 * (xz + wy))},
+            {round(2 * (xy + wz)), round(ONE - 2 * (xx + zz)),
+             round(2 * (yz - wx))},
+            {round(2 * (xz - wy)), round(2 * (yz + wx)),
+             round(ONE - 2 * (xx + yy))}
+        }};
+    }
+
+    constexpr vec3 rotate(const vec3 &v) const{ return toMatrix() * v;}
+
+private:
+    static constexpr dfixSize product(const fixed &L, const fixed &R){
+        return Fixed_product(L, R);
+    }
+    static constexpr fixed round(dfixSize sum){
+        return Fixed_roundProducts<fixed>(sum);
+    }
+};
+
+#endif // FIXEDMATRIX_H
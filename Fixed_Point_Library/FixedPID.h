@@ -0,0 +1,155 @@
+/*
+ *  @file    FixedPID.h
+ *
+ *  @brief PID controller with anti-windup and a filtered derivative
+ *
+ *  DESCRIPTION
+ *
+ * FixedPID<COEFF, SIGNAL, OUT> turns a setpoint and a measurement, both
+ * SIGNAL numbers, into an OUT number, with gains in the COEFF format:
+ *
+ *     FixedPID<Fixed<3, 12>, Fixed<10, 5> > speed(kp, ki, kd, alpha,
+ *                                                 -255, 255);
+ *     const Fixed<10, 5> pwm = speed.update(target, measured);
+ *
+ * update() is called once per sample period T, and the gains are per
+ * update, so for the usual continuous gains Kp, Ki and Kd:
+ *
+ *     kp = Kp,  ki = Ki * T,  kd = Kd / T
+ *
+ * The derivative is taken on the measurement, not the error, so a step of
+ * the setpoint does not kick the output. It goes through a first order low
+ * pass, alpha = T / (T + Tf) for a filter time constant Tf. An alpha of 1
+ * does no filtering.
+ *
+ * The output is clamped to [outMin, outMax]. Anti-windup is conditional
+ * integration: while the output is clamped, the integral only takes the
+ * steps that move it back inside. The integral is also kept inside the
+ * limits, so after a long stretch of saturation it is never further out
+ * than the output can go.
+ *
+ * Every term is kept in a FixedFilterAccumulator, see FixedFilter.h, with
+ * COEFF FRAC + SIGNAL FRAC fraction bits. Only the output is rounded, half
+ * up, so the integral keeps every bit of ki * error, however small. The
+ * whole update is integer math, the same on every CPU and compiler, and
+ * reset() puts the controller back where it started.
+ */
+
+
+
+
+#ifndef FIXEDPID_H
+#define FIXEDPID_H
+
+#include "FixedFilter.h"
+#include <cassert>
+
+
+
+// **************************************************************
+//                        PID Controller
+// **************************************************************
+template<class COEFF, class SIGNAL, class OUT = SIGNAL> class FixedPID{
+public:
+    typedef FixedFilterAccumulator<COEFF, SIGNAL> accumulator;
+    typedef typename accumulator::type accSize;
+    typedef typename COEFF::fixSize coeffSize;
+
+    static_assert(OUT::FRAC_BITS <= accumulator::FRAC,
+                  "FixedPID.h: OUT has more FRAC bits than the accumulator");
+
+    FixedPID(const COEFF &kp, const COEFF &ki, const COEFF &kd,
+             const COEFF &alpha, const OUT &outMin, const OUT &outMax):
+        integral(0){
+
+        setGains(kp, ki, kd);
+        setFilter(alpha);
+        setLimits(outMin, outMax);
+        reset();
+    }
+
+    // Bumpless start: the derivative starts from measured, and the
+    // integral from output, so the first update picks up from there
+    void reset(const SIGNAL &measured = SIGNAL(), const OUT &output = OUT()){
+        last = measured.getRawNumber();
+        derivative = 0;
+        integral = clamp(widen(output));
+    }
+
+    OUT update(const SIGNAL &setpoint, const SIGNAL &measured){
+        const accSize y = measured.getRawNumber();
+        const accSize error = CAST<accSize>(setpoint.getRawNumber()) - y;
+
+        // -kd * dy / dt, low passed
+        const accSize target = -CAST<accSize>(kd) * (y - last);
+        derivative += scale(alpha, target - derivative);
+        last = measured.getRawNumber();
+
+        // Keep the step unless the output is clamped and it pushes further
+        const accSize step = CAST<accSize>(ki) * error;
+        const accSize proportional = CAST<accSize>(kp) * error;
+        const accSize next = clamp(integral + step);
+        const accSize wanted = proportional + next + derivative;
+        const bool windup = (wanted > outMax && step > 0) ||
+                            (wanted < outMin && step < 0);
+        integral = (windup) ? integral : next;
+
+        return accumulator::template round<OUT>(
+            clamp(proportional + integral + derivative));
+    }
+
+    void setGains(const COEFF &kp, const COEFF &ki, const COEFF &kd){
+        this->kp = kp.getRawNumber();
+        this->ki = ki.getRawNumber();
+        this->kd = kd.getRawNumber();
+    }
+
+    // 0 < alpha <= 1
+    void setFilter(const COEFF &alpha){
+        assert(alpha > COEFF(0) && alpha <= COEFF(1));
+        this->alpha = alpha.getRawNumber();
+    }
+
+    // Also clamps the integral to the new limits
+    void setLimits(const OUT &outMin, const OUT &outMax){
+        assert(outMin < outMax);
+        this->outMin = widen(outMin);
+        this->outMax = widen(outMax);
+        integral = clamp(integral);
+    }
+
+    // The integral term, rounded to OUT
+    OUT getIntegral() const{
+        return accumulator::template round<OUT>(integral);
+    }
+
+private:
+    // x in OUT, moved to the accumulator's fraction bits
+    static accSize widen(const OUT &x){
+        return CAST<accSize>(x.getRawNumber()) *
+               (CAST<accSize>(1) << (accumulator::FRAC - OUT::FRAC_BITS));
+    }
+
+    // c * x, rounded half up to x's fraction bits. x is split at the COEFF
+    // fraction bits so neither product needs more bits than kp * error.
+    static accSize scale(coeffSize c, accSize x){
+        const fastu16 SHIFT = COEFF::FRAC_BITS;
+        const accSize hi = x >> SHIFT;
+        const accSize lo = x - hi * (CAST<accSize>(1) << SHIFT);
+        const accSize half = CAST<accSize>(1) << (SHIFT - 1);
+        return CAST<accSize>(c) * hi +
+               ((CAST<accSize>(c) * lo + half) >> SHIFT);
+    }
+
+    accSize clamp(accSize x) const{
+        return (x > outMax) ? outMax : (x < outMin) ? outMin : x;
+    }
+
+    coeffSize kp, ki, kd, alpha;
+    accSize outMin, outMax;
+    accSize integral;   // Sum of ki * error
+    accSize derivative; // Low passed -kd * dy
+    accSize last;       // Last measurement, raw SIGNAL
+};
+
+#endif // FIXEDPID_H
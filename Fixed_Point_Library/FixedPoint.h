@@ -24,14 +24,21 @@
  * Fixed numbers will default to signed.
 
  * The user will need to choose numbers such that the data bits add up to
- * either 7, 15, 31, or 63 for signed numbers, or 8, 16, 32, or 64 for
- * unsigned. This is done for clarity in knowing the true data size of the
- * fixed point variable.
+ * either 7, 15, 31, 63 or 127 for signed numbers, or 8, 16, 32, 64 or 128
+ * for unsigned. This is done for clarity in knowing the true data size of
+ * the fixed point variable.
  *
  * Fixed<5, 2, true> is an 8 bit signed value, with 2 fractional bits.
  * Fixed<10, 5> is a 16 bit signed value, with 5 fractional bits.
  * Fixed<16, 15, SIGNED> is a 32 bit signed value, with 15 fractional bits.
  * Fixed<20, 44, UNSIGNED> is a 64 bit unsigned value, with 44 fractional bits.
+ * Fixed<32, 96, UNSIGNED> is a 128 bit unsigned value, with 96 fractional bits.
+ *
+ * The 127 and 128 bit formats are for long sums and phase accumulators.
+ * They are stored in a FixedInt128, two 64 bit words, and do not need
+ * __int128 or ENABLE_DW_BIT_MATH. They multiply with four 64 bit products
+ * and divide with Knuth's algorithm D, so they are slower than the 64 bit
+ * formats, and FixedMath and the other headers do not take them.
  *
  *
  *  MODIFICATIONS
@@ -59,19 +66,64 @@
  *        1              X              0           64            64
  *        1              X              1           64            128
  *
+ * Division is the slowest operator, a 128 bit divide for 64-bit numbers, or
+ * two 64 by 32 bit steps if ENABLE_DW_BIT_MATH is 0. FixedReciprocal is the
+ * fast path when many numbers are divided by the same divisor: two
+ * multiplies each, with the same results as operator/. It is usually
+ * faster for 32 and 64-bit formats, up to about 3 times, but can be slower
+ * than the hardware divide for 16 bits and under (9 against 5 cycles on
+ * Fixed<10, 5>). Building one costs several divides, so it does not pay off
+ * for a single quotient. runDivideBenchmarks() in FxPtBench.h times both.
+ *
+ * Setting ENABLE_FIXED_PROFILE to 1, on the command line, makes every
+ * format count its conversions, +, -, *, / and negations, with their
+ * overflows, largest magnitudes and rounding errors, and print a report
+ * when the program exits. It is for picking INT and FRAC, see
+ * FixedProfile.h.
+ *
+ * Fixed is a literal type and almost all of its functions are constexpr, so
+ * the library needs C++14. Constants made with constexpr are computed by the
+ * compiler and stored in read only memory:
+ *
+ *     constexpr Fixed<16, 15> GAIN = Fixed<16, 15>(0.7071) * 2;
+ *
+ * By default results that do not fit wrap around like integers do. A fourth
+ * template argument picks another FixedOverflow policy. FIXED_SATURATE
+ * clamps +, -, *, / and negation to getMaxValue() or getMinValue(), and a
+ * divide by zero to the max or min value by the sign of the dividend.
+ * FIXED_TRAP stops the program instead. Checks use the compiler's overflow
+ * builtins and the double width results, so a wrapping Fixed costs the
+ * same as before:
+ *
+ *     typedef Fixed<4, 3, SIGNED, FIXED_SATURATE> Sample;
+ *     Sample(12) + Sample(12) == Sample(12).getMaxValue(); // 15.875
+ *
+ * Two different formats can be added, subtracted and multiplied directly.
+ * The result format holds the exact answer when it fits, see FixedMixed.
  *
- *  KNOWN BUGS
+ * floor(), ceil(), round() and trunc() round to an integer without
+ * branches, by adding to the raw number and clearing the FRAC bits. Other
+ * FixedRounding modes are picked per call, or at compile time with
+ * round<MODE>(). FIXED_ROUND_STOCHASTIC rounds up with a chance equal to
+ * the fraction, from the FRAC bits of a random raw number:
  *
- * 1. toString() does not function properly if variables with the
- * majority of bits being fractional bits (Fixed<2, 30, UNSIGNED> for instance),
- * the variable fracPart will overflow after being multiplied by 10 if the
- * variable is not able to use the next double width int type.
- *      ENABLE_32_BIT_USE = 0 and ENABLE_64_BIT_USE = 0, 16-bit tests fail.
- *            "Fixed16_Test_toString_testB1: test FAILED.
- *              Expected: 6.50390625, result was: 6.503)0625."
- *            "Fixed16_Test_toString_testF1: test FAILED.
- *              Expected: -0.9998779296875, result was: -0.1110//1.1.0/1." etc
- *      Behavior stops when ENABLE_32_BIT_USE or ENABLE_64_BIT_USE is set to 1
+ *     x.round<FIXED_ROUND_HALF_EVEN>();      // -2.5 to -2, 3.5 to 4
+ *     x.round(FIXED_ROUND_STOCHASTIC, rng.bits<Fixed<16, 15> >()
+ *                                            .getRawNumber());
+ *
+ * Rounding up past getMaxValue() wraps, whatever the overflow policy.
+ *
+ *
+ * toChars() writes a number into a char buffer without allocating, and
+ * fromChars() reads one back, like std::to_chars and std::from_chars. Both
+ * work on the raw number only, so every format prints all of its digits
+ * exactly and reads back to the same number. toString() and operator<< use
+ * toChars(). A buffer of TO_CHARS_MAX chars always fits the default
+ * precision:
+ *
+ *     char buf[Fixed<16, 15>::TO_CHARS_MAX];
+ *     const FixedToCharsResult ret = gain.toChars(buf, buf + sizeof(buf), 4);
+ *     log.write(buf, ret.ptr - buf); // "0.7071"
  */
 
 
@@ -94,12 +146,30 @@
 // 1 if compiler supports double max width bit integers, 0 otherwise
 // If 0, multiplication and division will use the slower
 // algorithms, but will not use doubled integer width variables.
-#define ENABLE_DW_BIT_MATH 1
+// Can also be set on the command line, -DENABLE_DW_BIT_MATH=0.
+#ifndef ENABLE_DW_BIT_MATH
+    #define ENABLE_DW_BIT_MATH 1
+#endif // ENABLE_DW_BIT_MATH
+
+// Dividing through a new reciprocal was slower than operator/ for every
+// format, so the flag was removed. FixedReciprocal is the fast divide.
+#ifdef ENABLE_FAST_DIVIDE
+    #error "ENABLE_FAST_DIVIDE was removed, use FixedReciprocal instead"
+#endif // ENABLE_FAST_DIVIDE
+
+// 1 to count the ops of every format and print a report at exit, 0 for
+// none. Slow, see FixedProfile.h. Set on the command line.
+#ifndef ENABLE_FIXED_PROFILE
+    #define ENABLE_FIXED_PROFILE 0
+#endif // ENABLE_FIXED_PROFILE
 
 #include <cassert>
+#include <cstddef>
 #include <cstdint>
+#include <cstdlib>
 #include <string>
 #include <ostream>
+#include <system_error>
 #include <type_traits>
 
 typedef std::uint8_t  fastu8;
@@ -133,13 +203,17 @@ typedef std::int16_t fast16;
 #if ENABLE_DW_BIT_MATH == 1
     #if ENABLE_64_BIT_USE == 1
         typedef __int128 fast128;
+        typedef unsigned __int128 fastu128;
     #elif ENABLE_32_BIT_USE == 1
         typedef int64_t fast128;
+        typedef uint64_t fastu128;
     #else
         typedef int32_t fast128;
+        typedef uint32_t fastu128;
     #endif // ENABLE_32_BIT_USE
 #else
     typedef fast64 fast128;
+    typedef fastu64 fastu128;
 #endif // ENABLE_DW_BIT_MATH
 
 
@@ -150,6 +224,8 @@ static_assert(ENABLE_64_BIT_USE == 0 || ENABLE_64_BIT_USE == 1,
               "Invalid value for ENABLE_64_BIT_USE");
 static_assert(ENABLE_DW_BIT_MATH == 0 || ENABLE_DW_BIT_MATH == 1,
               "Invalid value for ENABLE_DW_BIT_MATH");
+static_assert(ENABLE_FIXED_PROFILE == 0 || ENABLE_FIXED_PROFILE == 1,
+              "Invalid value for ENABLE_FIXED_PROFILE");
 
 
 static_assert(sizeof(fast8) == sizeof(fastu8),
@@ -184,22 +260,136 @@ static_assert(sizeof(fast16) >= 2, "FixedPoint.h: fast16 size too small");
 static_assert((sizeof(fast8) <= sizeof(fast16)) && (sizeof(fast16) <= 4),
               "FixedPoint.h: Typedefs need to be in correct order");
 
+// Two word integer for the 127 and 128 bit formats
+#include "FixedInt128.h"
+
+
+
+// What Fixed math does when a result does not fit in the format
+enum FixedOverflow{
+    FIXED_WRAP,     // Two's complement wrap around, the default
+    FIXED_SATURATE, // Clamp to getMaxValue() or getMinValue()
+    FIXED_TRAP      // Stop the program
+};
+
+// How round() picks an integer. Halfway cases go up for HALF_UP, and to the
+// even integer for HALF_EVEN. STOCHASTIC rounds up when the fraction plus
+// random bits carries into the integer.
+enum FixedRounding{
+    FIXED_ROUND_FLOOR,      // Toward -inf, floor()
+    FIXED_ROUND_CEIL,       // Toward +inf, ceil()
+    FIXED_ROUND_HALF_UP,    // Nearest, halfway toward +inf, round()
+    FIXED_ROUND_HALF_EVEN,  // Nearest, halfway to the even integer
+    FIXED_ROUND_TO_ZERO,    // Toward 0, trunc()
+    FIXED_ROUND_STOCHASTIC  // Up with a chance of the fraction
+};
+
+// Called when a FIXED_TRAP number overflows
+inline void Fixed_trap(){
+#if defined(__GNUC__)
+    __builtin_trap();
+#else
+    std::abort();
+#endif // __GNUC__
+}
+
+// Ops counted when ENABLE_FIXED_PROFILE is 1
+enum FixedProfileOp{
+    FIXED_PROFILE_CONVERT, // From int, float or double
+    FIXED_PROFILE_NEGATE,
+    FIXED_PROFILE_ADD,
+    FIXED_PROFILE_SUBTRACT,
+    FIXED_PROFILE_MULTIPLY,
+    FIXED_PROFILE_DIVIDE,
+    FIXED_PROFILE_OPS
+};
+
+// True if an op should be counted. Constant expressions never are.
+constexpr bool Fixed_profiling(){
+#if ENABLE_FIXED_PROFILE == 1
+    return !__builtin_is_constant_evaluated();
+#else
+    return false;
+#endif // ENABLE_FIXED_PROFILE
+}
+
+#if ENABLE_FIXED_PROFILE == 1
+    #include "FixedProfile.h"
+#endif // ENABLE_FIXED_PROFILE
+
+// Wrapping add/sub of raw numbers, returns true if the result wrapped
+template<class T> constexpr bool Fixed_addOverflow(T L, T R, T &ret){
+#if defined(__GNUC__)
+    return __builtin_add_overflow(L, R, &ret);
+#else
+    typedef typename std::make_unsigned<T>::type U;
+    ret = CAST<T>(CAST<U>(L) + CAST<U>(R));
+    return (std::is_signed<T>::value) ?
+               ((L < 0) == (R < 0) && (ret < 0) != (L < 0)) :
+               CAST<U>(ret) < CAST<U>(L);
+#endif // __GNUC__
+}
+
+template<class T> constexpr bool Fixed_subOverflow(T L, T R, T &ret){
+#if defined(__GNUC__)
+    return __builtin_sub_overflow(L, R, &ret);
+#else
+    typedef typename std::make_unsigned<T>::type U;
+    ret = CAST<T>(CAST<U>(L) - CAST<U>(R));
+    return (std::is_signed<T>::value) ?
+               ((L < 0) != (R < 0) && (ret < 0) != (L < 0)) :
+               CAST<U>(R) > CAST<U>(L);
+#endif // __GNUC__
+}
+
+// Results of Fixed::toChars() and Fixed::fromChars(), the same as the C++17
+// std::to_chars_result and std::from_chars_result
+struct FixedToCharsResult{
+    char *ptr;
+    std::errc ec;
+};
+
+struct FixedFromCharsResult{
+    const char *ptr;
+    std::errc ec;
+};
 
+template<class U, bool NATIVE = (sizeof(U) * 2 <= sizeof(fastu128))>
+struct FixedWideMul;
 
-template<fastu16 _INT, fastu16 _FRAC, bool _SIGN = SIGNED> class Fixed{
+template<fastu16 _INT, fastu16 _FRAC, bool _SIGN = SIGNED,
+         FixedOverflow _OVER = FIXED_WRAP> class Fixed{
 
     static_assert(_INT > 0, "FixedPoint.h: Not enough INT bits");
-    static_assert(_INT < 64, "FixedPoint.h: Too many INT bits");
+    static_assert(_INT < 128, "FixedPoint.h: Too many INT bits");
     static_assert(_FRAC > 0, "FixedPoint.h: Not enough FRAC bits");
-    static_assert(_FRAC < 64, "FixedPoint.h: Too many INT bits");
+    static_assert(_FRAC < 128, "FixedPoint.h: Too many FRAC bits");
+
+public:
 
+    // **************************************************************
+    //                        Type Information
+    // **************************************************************
     const static fastu16 BITSUM = _INT + _FRAC;
+    const static fastu16 INT_BITS = _INT;
+    const static fastu16 FRAC_BITS = _FRAC;
+    const static bool IS_SIGNED = _SIGN;
+    const static FixedOverflow OVERFLOW = _OVER;
+
+    // Longest toChars() output with precision -1 or up to FRAC: the sign,
+    // the INT digits (INT * log10(2), plus one), the point and FRAC digits
+    const static fastu16 TO_CHARS_MAX = 3 + _INT * 30103 / 100000 + _FRAC;
 
     static_assert(
-    ( _SIGN && (BITSUM == 7 || BITSUM == 15 || BITSUM == 31 || BITSUM == 63)) ||
-    (!_SIGN && (BITSUM == 8 || BITSUM == 16 || BITSUM == 32 || BITSUM == 64)),
-                "FixedPoint.h: Sum of bits needs to equal "
-                "either SIGNED:{7, 15, 31, 63} or UNSIGNED:{8, 16, 32, 64}");
+    ( _SIGN && (BITSUM == 7 || BITSUM == 15 || BITSUM == 31 || BITSUM == 63 ||
+                BITSUM == 127)) ||
+    (!_SIGN && (BITSUM == 8 || BITSUM == 16 || BITSUM == 32 || BITSUM == 64 ||
+                BITSUM == 128)),
+                "FixedPoint.h: Sum of bits needs to equal either "
+                "SIGNED:{7, 15, 31, 63, 127} or UNSIGNED:{8, 16, 32, 64, 128}");
+    static_assert(BITSUM <= 64 || ENABLE_64_BIT_USE == 1,
+                  "FixedPoint.h: 127 and 128 bit formats need "
+                  "ENABLE_64_BIT_USE");
 
 
     using fixSize = // Use smallest int data type and choose sign
@@ -211,7 +401,10 @@ template<fastu16 _INT, fastu16 _FRAC, bool _SIGN = SIGNED> class Fixed{
                     fast16,
                     typename std::conditional<BITSUM == 31,
                         fast32,
-                        fast64
+                        typename std::conditional<BITSUM == 63,
+                            fast64,
+                            FixedInt128<true>
+                        >::type
                     >::type
                 >::type
             >::type,
@@ -222,7 +415,10 @@ template<fastu16 _INT, fastu16 _FRAC, bool _SIGN = SIGNED> class Fixed{
                     fastu16,
                     typename std::conditional<BITSUM == 32,
                         fastu32,
-                        fastu64
+                        typename std::conditional<BITSUM == 64,
+                            fastu64,
+                            FixedInt128<false>
+                        >::type
                     >::type
                 >::type
             >::type
@@ -235,125 +431,278 @@ template<fastu16 _INT, fastu16 _FRAC, bool _SIGN = SIGNED> class Fixed{
                 fastu16,
                 typename std::conditional<BITSUM == 31 || BITSUM == 32,
                     fastu32,
-                    fastu64
+                    typename std::conditional<BITSUM == 63 || BITSUM == 64,
+                        fastu64,
+                        FixedInt128<false>
+                    >::type
                 >::type
             >::type
         >::type;
 
-    using dfixSize = // Double Fixed Size
-        typename std::conditional<BITSUM == 7 || BITSUM == 8,
-            fast16,
-            typename std::conditional<BITSUM == 15 || BITSUM == 16,
-                fast32,
-                typename std::conditional<BITSUM == 31 || BITSUM == 32,
-                    fast64,
-                    fast128
+    // Double Fixed Size, unsigned if fixSize is. There is nothing wider
+    // than FixedInt128, so the 127 and 128 bit formats keep their own size
+    // and always use longMultiply() and wideDivide().
+    using dfixSize =
+        typename std::conditional<_SIGN,
+            typename std::conditional<BITSUM == 7,
+                fast16,
+                typename std::conditional<BITSUM == 15,
+                    fast32,
+                    typename std::conditional<BITSUM == 31,
+                        fast64,
+                        typename std::conditional<BITSUM == 63,
+                            fast128,
+                            FixedInt128<true>
+                        >::type
+                    >::type
+                >::type
+            >::type,
+            typename std::conditional<BITSUM == 8,
+                fastu16,
+                typename std::conditional<BITSUM == 16,
+                    fastu32,
+                    typename std::conditional<BITSUM == 32,
+                        fastu64,
+                        typename std::conditional<BITSUM == 64,
+                            fastu128,
+                            FixedInt128<false>
+                        >::type
+                    >::type
                 >::type
             >::type
         >::type;
 
+    // Applies the overflow policy to a result. over is true if value
+    // wrapped, high is true if the real result was above the max value.
+    static constexpr fixSize applyOverflow(fixSize value, bool over, bool high){
+        if(_OVER == FIXED_TRAP && over) Fixed_trap();
+        if(_OVER == FIXED_SATURATE && over) return (high) ? RAW_MAX : RAW_MIN;
+        return value;
+    }
+
+private:
 
     fixSize number;
-    const static dfixSize MULT_ROUND = TO_DFIX(1) << (_FRAC - 1);
+
+    // constexpr instead of const, since FixedInt128 is not a built in type
+    static constexpr dfixSize MULT_ROUND = TO_DFIX(1) << (_FRAC - 1);
+    static constexpr ufixSize FRAC_MASK = (TO_UFIX(1) << _FRAC) - 1;
+    static constexpr ufixSize HALF_MASK = TO_UFIX(1) << (_FRAC - 1);
+
+    // All ones, without the sign bit if signed
+    static constexpr fixSize RAW_MAX =
+        TO_SFIX(TO_UFIX(~TO_UFIX(0)) >> ((_SIGN) ? 1 : 0));
+    static constexpr fixSize RAW_MIN =
+        (_SIGN) ? TO_SFIX(TO_UFIX(1) << (BITSUM - ((_SIGN) ? 0 : 1))) : 0;
+
+    // Multiply and divide without the double width type
+    const static bool LONG_MATH = BITSUM > 64 ||
+        (ENABLE_DW_BIT_MATH == 0 && BITSUM > BIT_THRESHOLD);
 
     // Private constructor to set raw number directly
-    Fixed(fixSize num, bool): number(num){}
+    constexpr Fixed(fixSize num, bool): number(num){}
 
 public:
 
     // **************************************************************
     //                          Constructors
     // **************************************************************
-    Fixed():                 number(0){}
-    Fixed(int num):          number(TO_SFIX(num) << _FRAC){}
-    Fixed(double num):       number(num * (TO_SFIX(1) << _FRAC)){}
-    Fixed(float num):        number(num * (TO_SFIX(1) << _FRAC)){}
-    Fixed(const Fixed &num): number(num.number){}
-    ~Fixed(){}
-
-    const Fixed& operator=(const Fixed &num){
-        number = num.number;
-        return *this;
+    // All but the string functions are constexpr, so constants and
+    // coefficient tables can be built at compile time. Left shifts are done
+    // on the unsigned type, since shifting a negative number is not allowed
+    // in a constant expression.
+    constexpr Fixed():           number(0){}
+    constexpr Fixed(int num):    number(TO_SFIX(TO_UFIX(num) << _FRAC)){
+        if(Fixed_profiling()) profileConvert(CAST<double>(num));
+    }
+    constexpr Fixed(double num):
+        number(TO_SFIX(num * CAST<double>(TO_UFIX(1) << _FRAC))){
+        if(Fixed_profiling()) profileConvert(num);
     }
+    constexpr Fixed(float num):
+        number(TO_SFIX(num * CAST<float>(TO_UFIX(1) << _FRAC))){
+        if(Fixed_profiling()) profileConvert(num);
+    }
+
+    // Trivial copies, so Fixed is a literal type and arrays of it can be
+    // copied with memcpy
+    Fixed(const Fixed &num) = default;
+    Fixed& operator=(const Fixed &num) = default;
 
     // **************************************************************
     //                    Convert From Functions
     // **************************************************************
-    void fromFloat(float num){
-        number = num * (TO_SFIX(1) << _FRAC);
+    constexpr void fromFloat(float num){
+        number = TO_SFIX(num * CAST<float>(TO_UFIX(1) << _FRAC));
     }
-    void fromDouble(double num){
-        number = num * (TO_SFIX(1) << _FRAC);
+    constexpr void fromDouble(double num){
+        number = TO_SFIX(num * CAST<double>(TO_UFIX(1) << _FRAC));
     }
-    void fromInt(fixSize num){
-        number = num << _FRAC;
+    constexpr void fromInt(fixSize num){
+        number = TO_SFIX(TO_UFIX(num) << _FRAC);
+    }
+
+    // Reads [-]digits[.digits] from [first, last), rounded to the nearest
+    // number. The number is only changed if the text was read and fits.
+    FixedFromCharsResult fromChars(const char *first, const char *last){
+        const char *ptr = first;
+        const bool negative = ptr != last && *ptr == '-';
+        if(negative) ptr++;
+
+        // Largest magnitude the sign allows, 2^INT for signed negatives
+        const ufixSize limit = (negative) ? magnitude(RAW_MIN)
+                                         : TO_UFIX(RAW_MAX);
+        const ufixSize intLimit = TO_UFIX(limit >> _FRAC);
+
+        const char *start = ptr;
+        ufixSize intPart = 0;
+        bool over = false;
+        for(; ptr != last && *ptr >= '0' && *ptr <= '9'; ptr++){
+            const ufixSize digit = TO_UFIX(*ptr - '0');
+            if(intPart > TO_UFIX(intLimit - digit) / 10 || digit > intLimit)
+                over = true;
+            else
+                intPart = TO_UFIX(intPart * 10 + digit);
+        }
+        bool anyDigits = ptr != start;
+
+        // Fraction digits in base 10^9 limbs, or 10^4 if fastu32 is only
+        // 16 bits. FRAC + 1 digits are enough to round correctly, the rest
+        // can never move the result.
+        const fastu16 MAX_DIGITS = _FRAC + 1;
+        const fastu16 LIMB_DIGITS = (sizeof(fastu32) >= 4) ? 9 : 4;
+        const fastu32 LIMB = CAST<fastu32>((LIMB_DIGITS == 9) ? 1000000000
+                                                              : 10000);
+        fastu32 limbs[(MAX_DIGITS + LIMB_DIGITS - 1) / LIMB_DIGITS] = {};
+        fastu16 count = 0;
+        if(ptr != last && *ptr == '.'){
+            start = ++ptr;
+            for(; ptr != last && *ptr >= '0' && *ptr <= '9'; ptr++){
+                if(count == MAX_DIGITS) continue;
+                limbs[count / LIMB_DIGITS] =
+                    limbs[count / LIMB_DIGITS] * 10 + (*ptr - '0');
+                count++;
+            }
+            anyDigits = anyDigits || ptr != start;
+        }
+        if(!anyDigits) return FixedFromCharsResult{first,
+                                                   std::errc::invalid_argument};
+
+        // Left align the last limb, then double the decimal fraction once
+        // per bit. The carry out of the top limb is the next binary digit.
+        const fastu16 used = (count + LIMB_DIGITS - 1) / LIMB_DIGITS;
+        for(fastu16 i = count; i % LIMB_DIGITS != 0; i++)
+            limbs[used - 1] *= 10;
+
+        ufixSize frac = 0;
+        bool roundUp = false;
+        for(fastu16 bit = 0; bit <= _FRAC; bit++){
+            bool carry = false;
+            for(fast16 i = used - 1; i >= 0; i--){
+                const fastu32 twice = limbs[i] * 2 + carry;
+                carry = twice >= LIMB;
+                limbs[i] = twice - ((carry) ? LIMB : 0);
+            }
+            if(bit < _FRAC) frac = TO_UFIX((frac << 1) | carry);
+            else roundUp = carry;
+        }
+
+        const ufixSize mag = TO_UFIX((TO_UFIX(intPart) << _FRAC) | frac);
+        const ufixSize ret = TO_UFIX(mag + roundUp);
+        if(over || intPart > intLimit || ret < mag || ret > limit)
+            return FixedFromCharsResult{ptr, std::errc::result_out_of_range};
+
+        number = (negative) ? TO_SFIX(0 - ret) : TO_SFIX(ret);
+        return FixedFromCharsResult{ptr, std::errc()};
     }
 
     // **************************************************************
     //                      Convert To Functions
     // **************************************************************
-    float toFloat() const{
-        return number / CAST<float>(1 << _FRAC);
+    constexpr float toFloat() const{
+        return CAST<float>(number) / CAST<float>(TO_UFIX(1) << _FRAC);
     }
 
-    double toDouble() const{
-        return number / CAST<double>(1 << _FRAC);
+    constexpr double toDouble() const{
+        return CAST<double>(number) / CAST<double>(TO_UFIX(1) << _FRAC);
     }
 
-    fixSize toInt() const {
+    constexpr fixSize toInt() const {
         return number >> _FRAC;
     }
 
-    std::string toString(fast16 precision = -1) const{
-        static const ufixSize mask = (~TO_UFIX(0)) << _FRAC;
-
-        const bool isNegative = (number < 0);
-        const ufixSize uNum = (isNegative) ? -number : number;
-        const fixSize tempFracBits = _FRAC;
-        ufixSize intPart = (uNum & mask) >> tempFracBits;
-        bool allNines = true;
-
-        // Double size used to prevent overflow
-        dfixSize fracPart = uNum & (~mask);
-
-        std::string fracMsg = ".";
-
-        // If precision is 0, round to nearest integer
-        if(precision == 0) return std::to_string(round().toInt()) + ".0";
-
-        do{ // Convert fractional part to string
-            precision--;
-            fracPart *= 10;
-            fast8 digit = '0' + (fracPart >> tempFracBits);
-            if(allNines && digit != '9') allNines = false;
-
-            if(precision == 0){
-                fracPart &= (TO_DFIX(1) << tempFracBits) - 1;
-                fracPart *= 10;
-                if(('0' + (fracPart >> tempFracBits)) >= '5'){
-                    if(allNines){
-                        fracMsg = ".0";
-                        intPart += 1;
-                        break;
-                    }
-                    digit++;
-                }
-                fracMsg += digit;
-                break;
-            }
-
-            fracMsg += digit;
-            fracPart &= (TO_DFIX(1) << tempFracBits) - 1;
+    // Writes the number to [first, last), with precision digits after the
+    // point, or every digit of the exact value if precision is -1. No null
+    // is added. Returns the end of the text, or last and
+    // std::errc::value_too_large if it does not fit.
+    FixedToCharsResult toChars(char *first, char *last,
+                               fast16 precision = -1) const{
+        const fastu16 WORD = sizeof(ufixSize) * 8;
+        bool negative = number < 0;
+        const ufixSize uNum = magnitude(number);
+        ufixSize intPart = TO_UFIX(uNum >> _FRAC);
+
+        // Fraction with the point above the top bit. Times 10 is 8x + 2x,
+        // the bits shifted out are the next digit, so nothing overflows.
+        ufixSize frac = TO_UFIX(uNum << (WORD - _FRAC));
+        char digits[WORD];
+        fast16 count = 0;
+
+        // Precision 0 rounds to the nearest integer the same way as round(),
+        // and still ends in ".0"
+        if(precision == 0){
+            const ufixSize half = TO_UFIX(TO_UFIX(1) << (WORD - 1));
+            intPart += (negative) ? (frac > half) : (frac >= half);
+            negative = negative && intPart != 0;
+            frac = 0;
+            precision = 1;
+            digits[count++] = 0;
+        }
 
-        }while(fracPart > 0);
+        // At least one digit, and all of them if precision is -1
+        while((frac != 0 || count == 0) && count != precision){
+            const ufixSize times8 = TO_UFIX(frac << 3);
+            const ufixSize times10 = TO_UFIX(times8 + TO_UFIX(frac << 1));
+            digits[count++] = CAST<char>((frac >> (WORD - 3)) +
+                                         (frac >> (WORD - 1)) +
+                                         (times10 < times8));
+            frac = times10;
+        }
 
-        while(precision > 0){ // Append 0's until full precision reached
-            fracMsg += '0';
-            precision--;
+        // Round half up on what is left, carrying through any 9s
+        if(count == precision && (frac >> (WORD - 1)) != 0){
+            fast16 i = count - 1;
+            for(; i >= 0 && digits[i] == 9; i--) digits[i] = 0;
+            if(i >= 0) digits[i]++;
+            else intPart++;
         }
 
+        char intDigits[WORD];
+        fast16 intCount = 0;
+        do{
+            intDigits[intCount++] = CAST<char>(intPart % 10);
+            intPart = TO_UFIX(intPart / 10);
+        }while(intPart != 0);
+
+        const fast16 fracCount = (precision > count) ? precision : count;
+        if(last - first < negative + intCount + 1 + fracCount)
+            return FixedToCharsResult{last, std::errc::value_too_large};
+
+        char *ptr = first;
+        if(negative) *ptr++ = '-';
+        while(intCount > 0) *ptr++ = '0' + intDigits[--intCount];
+        *ptr++ = '.';
+        for(fast16 i = 0; i < fracCount; i++)
+            *ptr++ = (i < count) ? '0' + digits[i] : '0';
+
+        return FixedToCharsResult{ptr, std::errc()};
+    }
 
-        return ((isNegative) ? "-" : "") + std::to_string(intPart) + fracMsg;
+    std::string toString(fast16 precision = -1) const{
+        std::string ret(TO_CHARS_MAX + ((precision > 0) ? precision : 0), ' ');
+        ret.resize(toChars(&ret[0], &ret[0] + ret.size(), precision).ptr -
+                   &ret[0]);
+        return ret;
     }
 
     std::string toBinary() const{
@@ -369,92 +718,109 @@ public:
     // **************************************************************
     //                 Number Information Functions
     // **************************************************************
-    Fixed getMaxValue() const{
-        static const ufixSize maxVal = (TO_UFIX(1) << BITSUM) - 1;
-        static const ufixSize uMaxVal = TO_UFIX(maxVal << 1) | 1;
-
-        if(_SIGN) return Fixed(maxVal, true);
-        else      return Fixed(uMaxVal, true);
+    constexpr Fixed getMaxValue() const{
+        return Fixed(RAW_MAX, true);
     }
 
-    Fixed getMinValue() const{
-        static const fixSize minVal = TO_UFIX(1) << (BITSUM - ((_SIGN) ? 0:1));
-
-        if(_SIGN) return Fixed(minVal, true);
-        else      return Fixed(0, true); // Min of unsigned is 0
+    constexpr Fixed getMinValue() const{
+        return Fixed(RAW_MIN, true); // Min of unsigned is 0
     }
 
-    Fixed getResolution() const{
+    constexpr Fixed getResolution() const{
         return Fixed(1, true);
     }
 
-    Fixed<_INT-1, _FRAC+1, _SIGN> getPrecision() const{
-        Fixed<_INT-1, _FRAC+1, _SIGN> ret;
+    constexpr Fixed<_INT-1, _FRAC+1, _SIGN, _OVER> getPrecision() const{
+        Fixed<_INT-1, _FRAC+1, _SIGN, _OVER> ret;
         ret.setRawNumber(1);
         return ret;
     }
 
-    Fixed getFraction() const{
-        static const fixSize mask = ~(~TO_SFIX(0) << _FRAC);
-        return Fixed((number < 0) ? -((-number) & mask) :
-                                       (number & mask), true);
+    // Keeps the sign, -1.25 gives -0.25. The magnitude is taken with the
+    // sign mask instead of a branch.
+    constexpr Fixed getFraction() const{
+        const ufixSize sign = signMask();
+        const ufixSize frac = ((TO_UFIX(number) ^ sign) - sign) & FRAC_MASK;
+        return Fixed(TO_SFIX((frac ^ sign) - sign), true);
     }
 
-    Fixed abs() const{
+    constexpr Fixed abs() const{
         return Fixed((number < 0) ? -number : number, true);
     }
 
     // **************************************************************
     //                 Number Rounding Functions
     // **************************************************************
-    Fixed floor() const{
-        return Fixed((number >> _FRAC) << _FRAC, true);
+    constexpr Fixed floor() const{
+        // Clearing the frac bits rounds down for negative numbers too
+        return Fixed(TO_SFIX(number & ~FRAC_MASK), true);
     }
 
-    Fixed ceil() const{
-        static const ufixSize mask = ~((~TO_UFIX(0)) << _FRAC);
-        // If any frac bits, return floor + 1
-        if(number & mask)
-            return Fixed(((number >> _FRAC) + 1) << _FRAC, true);
-        return
-            Fixed(number, true);
+    constexpr Fixed ceil() const{
+        return round<FIXED_ROUND_CEIL>();
     }
 
-    Fixed round() const{
-        static const fixSize mask = TO_SFIX(1) << (_FRAC - 1);
-        // Check if fraction is >= 0.5
-        if(number & mask) return ceil();
-        else              return floor();
+    constexpr Fixed round() const{
+        return round<FIXED_ROUND_HALF_UP>();
+    }
 
+    constexpr Fixed trunc() const{
+        return round<FIXED_ROUND_TO_ZERO>();
+    }
+
+    // Every mode adds something below one LSB of the integer part to the
+    // raw number, then clears the FRAC bits. random is only read by
+    // FIXED_ROUND_STOCHASTIC.
+    template<FixedRounding MODE>
+    constexpr Fixed round(ufixSize random = 0) const{
+        return Fixed(TO_SFIX((TO_UFIX(number) + roundAdd(MODE, random)) &
+                             ~FRAC_MASK), true);
+    }
+
+    constexpr Fixed round(FixedRounding mode, ufixSize random = 0) const{
+        return Fixed(TO_SFIX((TO_UFIX(number) + roundAdd(mode, random)) &
+                             ~FRAC_MASK), true);
     }
 
     // Fitting Operation
-    template<fastu16 newINT, fastu16 newFRAC, bool newSIGN = SIGNED>
-    Fixed<newINT, newFRAC, newSIGN> fit() const{
-        // Use largest used data type for most efficient use, prevents data loss
-        // 8 <--> 64 bit conversions
-        static const fast64 shift = (newFRAC >= _FRAC) ?
-                                    (newFRAC - _FRAC): (_FRAC - newFRAC);
-        const fast64 temp = number;
+    template<fastu16 newINT, fastu16 newFRAC, bool newSIGN = SIGNED,
+             FixedOverflow newOVER = _OVER>
+    constexpr Fixed<newINT, newFRAC, newSIGN, newOVER> fit() const{
+        typedef Fixed<newINT, newFRAC, newSIGN, newOVER> result;
 
-        Fixed<newINT, newFRAC, newSIGN> ret;
-        ret.setRawNumber((newFRAC >= _FRAC) ? (temp << shift): (temp >> shift));
+        // Use largest used data type for most efficient use, prevents data loss
+        // 8 <--> 64 bit conversions, or 128 if either side is 128 bits
+        const bool WIDE = BITSUM > 64 || result::BITSUM > 64;
+        typedef typename std::conditional<WIDE, FixedInt128<true>,
+                                          fast64>::type wide;
+        typedef typename std::conditional<WIDE, FixedInt128<false>,
+                                          fastu64>::type uwide;
+
+        const fast64 shift = (newFRAC >= _FRAC) ?
+                             (newFRAC - _FRAC): (_FRAC - newFRAC);
+        const wide temp = CAST<wide>(number);
+
+        result ret;
+        ret.setRawNumber(CAST<typename result::fixSize>((newFRAC >= _FRAC) ?
+                         CAST<wide>(CAST<uwide>(temp) << shift) :
+                         (temp >> shift)));
 
         return ret;
     }
 
     // Additional number information
-    void setRawNumber(fixSize num){ number = num;}
-    fixSize getRawNumber() const{ return number;}
+    constexpr void setRawNumber(fixSize num){ number = num;}
+    constexpr fixSize getRawNumber() const{ return number;}
 
-    bool isZero() const{ return number == 0;}
-    bool isNonZero() const{ return number != 0;}
-    bool isNegative() const{ return number < 0;}
-    bool isPositive() const{ return number > 0;}
+    constexpr bool isZero() const{ return number == 0;}
+    constexpr bool isNonZero() const{ return number != 0;}
+    constexpr bool isNegative() const{ return number < 0;}
+    constexpr bool isPositive() const{ return number > 0;}
 
     // Stream Output
     friend std::ostream& operator<<(std::ostream &out, const Fixed &fp){
-        out << fp.toString();
+        char buf[TO_CHARS_MAX];
+        out.write(buf, fp.toChars(buf, buf + TO_CHARS_MAX).ptr - buf);
         return out;
     }
 
@@ -462,188 +828,773 @@ public:
     //                        Math Operators
     // **************************************************************
 
+    // Results that do not fit wrap, saturate or trap, see FixedOverflow
+
     // Negation
-    Fixed operator-() const{
-        return Fixed(-number, true);
+    constexpr Fixed operator-() const{
+        fixSize ret = 0;
+        const bool over = Fixed_subOverflow(TO_SFIX(0), number, ret);
+        return counted(FIXED_PROFILE_NEGATE,
+                       Fixed(applyOverflow(ret, over, _SIGN), true), over,
+                       -1);
     }
 
     // Addition
-    friend Fixed operator+(const Fixed &L, const Fixed &R){
-        return Fixed(L.number + R.number, true);
+    constexpr friend Fixed operator+(const Fixed &L, const Fixed &R){
+        fixSize ret = 0;
+        const bool over = Fixed_addOverflow(L.number, R.number, ret);
+        return counted(FIXED_PROFILE_ADD,
+                       Fixed(applyOverflow(ret, over, !L.isNegative()), true),
+                       over, -1);
     }
-    void operator+=(const Fixed &R){
-        number += R.number;
+    constexpr void operator+=(const Fixed &R){
+        number = (*this + R).number;
     }
-    void increment(){
-        number += TO_SFIX(1) << _FRAC;
+    constexpr void increment(){
+        *this += Fixed(TO_SFIX(TO_UFIX(1) << _FRAC), true);
     }
 
     // Subtraction
-    friend Fixed operator-(const Fixed &L, const Fixed &R){
-        return Fixed(L.number - R.number, true);
+    constexpr friend Fixed operator-(const Fixed &L, const Fixed &R){
+        fixSize ret = 0;
+        const bool over = Fixed_subOverflow(L.number, R.number, ret);
+        return counted(FIXED_PROFILE_SUBTRACT,
+                       Fixed(applyOverflow(ret, over, _SIGN && !L.isNegative()),
+                             true), over, -1);
     }
-    void operator-=(const Fixed &R){
-        number -= R.number;
+    constexpr void operator-=(const Fixed &R){
+        number = (*this - R).number;
     }
-    void decrement(){
-        number -= TO_SFIX(1) << _FRAC;
+    constexpr void decrement(){
+        *this -= Fixed(TO_SFIX(TO_UFIX(1) << _FRAC), true);
     }
 
     // Multiplication
-    friend Fixed operator*(const Fixed &L, const Fixed &R){
-        if(ENABLE_DW_BIT_MATH == 0 && (BITSUM > BIT_THRESHOLD))
-            return L.longMultiply(R);
-
-        return Fixed(((TO_DFIX(L.number) *
-                       TO_DFIX(R.number)) + MULT_ROUND) >> _FRAC, true);
+    constexpr friend Fixed operator*(const Fixed &L, const Fixed &R){
+        if(LONG_MATH) return L.longMultiply(R);
+
+        const dfixSize sum = TO_DFIX(L.number) * TO_DFIX(R.number) + MULT_ROUND;
+        const dfixSize ret = sum >> _FRAC;
+        const bool over = ret > TO_DFIX(RAW_MAX) || ret < TO_DFIX(RAW_MIN);
+        return counted(FIXED_PROFILE_MULTIPLY,
+                       Fixed(applyOverflow(TO_SFIX(ret), over, ret > 0), true),
+                       over, (Fixed_profiling()) ?
+                           roundError(TO_UFIX(sum)) : 0);
     }
-    void operator*=(const Fixed &R){
-        if(ENABLE_DW_BIT_MATH == 0 && (BITSUM > BIT_THRESHOLD))
-            number = longMultiply(R).number;
-        else
-            number = ((TO_DFIX(number) * TO_DFIX(R.number))
-                        + MULT_ROUND) >> _FRAC;
+    constexpr void operator*=(const Fixed &R){
+        number = (*this * R).number;
     }
 
     // Division
-    friend Fixed operator/(const Fixed &L, const Fixed &R){
+    constexpr friend Fixed operator/(const Fixed &L, const Fixed &R){
+        // Dividing by zero saturates or traps, the same as an overflow
+        if(_OVER != FIXED_WRAP && R.number == 0)
+            return counted(FIXED_PROFILE_DIVIDE,
+                           Fixed(applyOverflow(0, true, !L.isNegative()), true),
+                           true, -1);
+
         assert(R.number != 0); // Exit or set to max val?
         //if(R.number == 0) return L.getMaxValue();
 
-        if(ENABLE_DW_BIT_MATH == 0 && (BITSUM > BIT_THRESHOLD))
-            return L.longDivide(R);
+        // The divides that can't see the remainder only count overflows
+        if(BITSUM > 64)
+            return counted(FIXED_PROFILE_DIVIDE, L.wideDivide(R),
+                Fixed_profiling() && divideOverflow(L.number, R.number), -1);
+
+        if(LONG_MATH){
+            const bool over = (_OVER != FIXED_WRAP || Fixed_profiling()) &&
+                              divideOverflow(L.number, R.number);
+            return counted(FIXED_PROFILE_DIVIDE,
+                           Fixed(applyOverflow(L.longDivide(R).number, over,
+                                               L.isNegative() ==
+                                               R.isNegative()), true),
+                           over, -1);
+        }
+
+        const dfixSize ret = TO_DFIX(L.number) * (TO_DFIX(1) << _FRAC) /
+                             R.number;
+        const bool over = ret > TO_DFIX(RAW_MAX) || ret < TO_DFIX(RAW_MIN);
+        return counted(FIXED_PROFILE_DIVIDE,
+                       Fixed(applyOverflow(TO_SFIX(ret), over, ret > 0), true),
+                       over, (Fixed_profiling()) ?
+                           divideError(L.number, R.number) : 0);
+    }
+    constexpr void operator/=(const Fixed &R){
+        number = (*this / R).number;
+    }
+
+    // True if the raw quotient L / R does not fit in the format, which
+    // is when |L| >= |R| * 2^INT. Only used by the divides that can't see
+    // the full quotient.
+    static constexpr bool divideOverflow(fixSize L, fixSize R){
+        const fastu16 WORD = sizeof(ufixSize) * 8;
+        const ufixSize num = magnitude(L), den = magnitude(R);
+
+        // |R| * 2^INT is past the word, so every |L| fits
+        if(((den >> 1) >> (WORD - 1 - _INT)) != 0) return false;
 
-        return Fixed((TO_DFIX(L.number) << _FRAC) / R.number, true);
+        const ufixSize limit = TO_UFIX(den << _INT);
+        if(num < limit) return false;
+        if(!_SIGN || (L < 0) == (R < 0)) return true;
+
+        // Negative results can reach -2^INT, which is the min value
+        const ufixSize extra = TO_UFIX(num - limit);
+        return ((extra >> 1) >> (WORD - 1 - _FRAC)) != 0 ||
+               TO_UFIX(extra << _FRAC) >= den;
     }
-    void operator/=(const Fixed &R){
-        assert(R.number != 0);
-        //if(R.number == 0)
-            //number = getMaxValue().getRawNumber();
-        if(ENABLE_DW_BIT_MATH == 0 && (BITSUM > BIT_THRESHOLD))
-            number = longDivide(R).number;
-        else
-            number = (TO_DFIX(number) << _FRAC) / R.number;
+
+    static constexpr ufixSize magnitude(fixSize num){
+        return (num < 0) ? TO_UFIX(0 - TO_UFIX(num)) : TO_UFIX(num);
     }
 
     // Left Shift
-    Fixed operator<<(const fast16 shift){
-        return Fixed(number << shift, true);
+    constexpr Fixed operator<<(const fast16 shift) const{
+        return Fixed(TO_SFIX(TO_UFIX(number) << shift), true);
     }
-    void operator<<=(const fast16 shift){
-        number <<= shift;
+    constexpr void operator<<=(const fast16 shift){
+        number = TO_SFIX(TO_UFIX(number) << shift);
     }
 
     // Right Shift
-    Fixed operator>>(const fast16 shift){
+    constexpr Fixed operator>>(const fast16 shift) const{
         return Fixed(number >> shift, true);
     }
-    void operator>>=(const fast16 shift){
+    constexpr void operator>>=(const fast16 shift){
         number >>= shift;
     }
 
     // **************************************************************
     //                      Comparison Operators
     // **************************************************************
-    friend bool operator>(const Fixed &L, const Fixed &R){
+    constexpr friend bool operator>(const Fixed &L, const Fixed &R){
         return L.number > R.number;
     }
-    friend bool operator<(const Fixed &L, const Fixed &R){
+    constexpr friend bool operator<(const Fixed &L, const Fixed &R){
         return L.number < R.number;
     }
-    friend bool operator>=(const Fixed &L, const Fixed &R){
+    constexpr friend bool operator>=(const Fixed &L, const Fixed &R){
         return L.number >= R.number;
     }
-    friend bool operator<=(const Fixed &L, const Fixed &R){
+    constexpr friend bool operator<=(const Fixed &L, const Fixed &R){
         return L.number <= R.number;
     }
-    friend bool operator!=(const Fixed &L, const Fixed &R){
+    constexpr friend bool operator!=(const Fixed &L, const Fixed &R){
         return L.number != R.number;
     }
-    friend bool operator==(const Fixed &L, const Fixed &R){
+    constexpr friend bool operator==(const Fixed &L, const Fixed &R){
         return L.number == R.number;
     }
 
 private:
-    //  https://stackoverflow.com/questions/79677/
-    //      whats-the-best-way-to-do-fixed-point-math
-    //  Based on Evan Teran's multiply implementation
-    Fixed longMultiply(const Fixed &R) const{
-        static const fast64 mask = (TO_SFIX(1) << _FRAC) - 1;
-
-        const fast64 LHi = (number & (~mask)) >> _FRAC;
-        const fast64 RHi = (R.number & (~mask)) >> _FRAC;
-        const fast64 LLo = number & mask;
-        const fast64 RLo = R.number & mask;
-
-        const fast64 x1 = LHi * RHi;
-        const fast64 x2 = LHi * RLo;
-        const fast64 x3 = LLo * RHi;
-        const fast64 x4 = LLo * RLo + MULT_ROUND;
-
-        return Fixed((x1 << _FRAC) + x2 + x3 + (x4 >> _FRAC), true);
-    }
-
-    //  https://codereview.stackexchange.com/questions/
-    //      67962/mostly-portable-128-by-64-bit-division
-    //  Based on joe63074's division implementation, with some modifications
-    Fixed longDivide(const Fixed &R) const{
-        bool LNegative = false, RNegative = false;
-        fastu64 left = number, right = R.number;
-        if(number < 0){
-            left = -number;
-            LNegative = true;
+    // All ones if the number is negative, 0 otherwise
+    constexpr ufixSize signMask() const{
+        return TO_UFIX(0) - TO_UFIX(number < 0);
+    }
+
+    // What round() adds before clearing the FRAC bits. HALF_EVEN adds one
+    // less than half, plus the integer's low bit, so only odd halves carry.
+    constexpr ufixSize roundAdd(FixedRounding mode, ufixSize random) const{
+        return (mode == FIXED_ROUND_FLOOR)     ? TO_UFIX(0) :
+               (mode == FIXED_ROUND_CEIL)      ? FRAC_MASK :
+               (mode == FIXED_ROUND_HALF_UP)   ? HALF_MASK :
+               (mode == FIXED_ROUND_HALF_EVEN) ?
+                   TO_UFIX(HALF_MASK - 1 + ((TO_UFIX(number) >> _FRAC) & 1)) :
+               (mode == FIXED_ROUND_TO_ZERO)   ? TO_UFIX(FRAC_MASK &
+                                                         signMask()) :
+                                                 TO_UFIX(random & FRAC_MASK);
+    }
+
+    // Multiply without the double width type. FixedWideMul gives the
+    // full product of the magnitudes as two words, which are then signed,
+    // rounded and shifted the same way as the double width multiply.
+    constexpr Fixed longMultiply(const Fixed &R) const{
+        typedef FixedWideMul<ufixSize> wide;
+        const fastu16 WORD = sizeof(ufixSize) * 8;
+        const bool negative = isNegative() != R.isNegative();
+
+        ufixSize hi = 0, lo = 0;
+        wide::mul(magnitude(number), magnitude(R.number), hi, lo);
+        if(negative){
+            lo = TO_UFIX(~lo + 1);
+            hi = TO_UFIX(~hi + (lo == 0));
+        }
+
+        const ufixSize round = TO_UFIX(TO_UFIX(1) << (_FRAC - 1));
+        lo = TO_UFIX(lo + round);
+        hi = TO_UFIX(hi + (lo < round));
+
+        // Everything above the kept bits has to match their sign
+        const ufixSize ret = TO_UFIX((lo >> _FRAC) | (hi << (WORD - _FRAC)));
+        const ufixSize upper = (_SIGN) ?
+            TO_UFIX(TO_SFIX(hi) >> (_FRAC - 1)) : TO_UFIX(hi >> _FRAC);
+        const bool over = (_SIGN) ? upper != TO_UFIX(0) && upper != ~TO_UFIX(0)
+                                  : upper != 0;
+
+        return counted(FIXED_PROFILE_MULTIPLY,
+                       Fixed(applyOverflow(TO_SFIX(ret), over, !negative),
+                             true),
+                       over, (Fixed_profiling()) ? roundError(lo) : 0);
+    }
+
+    // Divide for the 127 and 128 bit formats. |L| * 2^FRAC is two words,
+    // and FixedInt128::divWide() gives the quotient.
+    constexpr Fixed wideDivide(const Fixed &R) const{
+        typedef FixedInt128<false> word;
+        const fastu16 WORD = sizeof(word) * 8;
+        const word num = CAST<word>(magnitude(number));
+        const word den = CAST<word>(magnitude(R.number));
+
+        // The quotient only fits when hi < den. Otherwise the result
+        // overflows, and this keeps the low bits of it, as a wrap.
+        word hi = num >> (WORD - _FRAC);
+        if(hi >= den) hi %= den;
+        const word quotient = word::divWide(hi, num << _FRAC, den);
+
+        const bool negative = isNegative() != R.isNegative();
+        const bool over = _OVER != FIXED_WRAP &&
+                          divideOverflow(number, R.number);
+        return Fixed(applyOverflow((negative) ? TO_SFIX(0 - quotient)
+                                              : TO_SFIX(quotient),
+                                   over, !negative), true);
+    }
+
+    // Divide without the double width type. |L| * 2^FRAC is two words,
+    // hi:lo, divided by |R|. The quotient rounds toward zero and overflows
+    // wrap, the same as the double width divide.
+    constexpr Fixed longDivide(const Fixed &R) const{
+        const fastu16 WORD = sizeof(ufixSize) * 8;
+        const ufixSize den = magnitude(R.number);
+        const ufixSize lo = TO_UFIX(magnitude(number) << _FRAC);
+        ufixSize hi = (_FRAC == 0) ? TO_UFIX(0) :
+                      TO_UFIX((magnitude(number) >> 1) >> (WORD - 1 - _FRAC));
+
+        // The quotient only fits when hi < den. Otherwise this keeps the
+        // low bits of it, as a wrap.
+        if(hi >= den) hi %= den;
+        const ufixSize quotient = divideWords(hi, lo, den);
+
+        const bool negative = isNegative() != R.isNegative();
+        return Fixed((negative) ? TO_SFIX(0 - quotient) : TO_SFIX(quotient),
+                     true);
+    }
+
+    // (hi:lo) / den, hi < den. 64 bit words use FixedLimb::divide(), the
+    // others a restoring divide, one quotient bit per loop.
+    static constexpr fastu64 divideWords(fastu64 hi, fastu64 lo, fastu64 den){
+        fastu64 rem = 0;
+        return FixedLimb::divide(hi, lo, den, rem);
+    }
+    template<class WORD_T>
+    static constexpr WORD_T divideWords(WORD_T hi, WORD_T lo, WORD_T den){
+        const fastu16 WORD = sizeof(WORD_T) * 8;
+        for(fastu16 i = 0; i < WORD; i++){
+            const bool top = (hi >> (WORD - 1)) != CAST<WORD_T>(0);
+            hi = CAST<WORD_T>((hi << 1) | (lo >> (WORD - 1)));
+            lo = CAST<WORD_T>(lo << 1);
+            if(top || hi >= den){
+                hi = CAST<WORD_T>(hi - den);
+                lo = CAST<WORD_T>(lo | CAST<WORD_T>(1));
+            }
+        }
+        return lo;
+    }
+
+    // Counts ret when profiling, see FixedProfile.h. err is the rounding
+    // error in LSBs, or negative when it is not measured.
+    static constexpr Fixed counted(FixedProfileOp op, const Fixed &ret,
+                                   bool over, double err){
+        if(Fixed_profiling()) profile(op, ret.number, over, err);
+        return ret;
+    }
+
+    static void profile(FixedProfileOp op, fixSize result, bool over,
+                        double err){
+#if ENABLE_FIXED_PROFILE == 1
+        fastu64 hi = 0, lo = 0;
+        Fixed_profileWords(magnitude(result), hi, lo);
+        FixedProfileThread<_INT, _FRAC, _SIGN, _OVER>::record(op, hi, lo,
+                                                              over, err);
+#else
+        (void)op;
+        (void)result;
+        (void)over;
+        (void)err;
+#endif // ENABLE_FIXED_PROFILE
+    }
+
+    // A conversion overflows when num is outside the format, and loses
+    // what is below the last FRAC bit
+    void profileConvert(double num) const{
+        const double scaled = num * CAST<double>(TO_UFIX(1) << _FRAC);
+        const bool over = !(scaled >= CAST<double>(RAW_MIN) &&
+                            scaled <= CAST<double>(RAW_MAX));
+        const double err = scaled - CAST<double>(number);
+        profile(FIXED_PROFILE_CONVERT, number, over,
+                (over) ? -1 : (err < 0) ? -err : err);
+    }
+
+    // |error| of a rounded multiply, from the low FRAC bits of the raw
+    // product plus MULT_ROUND
+    static double roundError(ufixSize sum){
+        const double err = CAST<double>(TO_UFIX(sum & FRAC_MASK)) -
+                           CAST<double>(TO_UFIX(TO_UFIX(1) << (_FRAC - 1)));
+        return ((err < 0) ? -err : err) /
+               CAST<double>(TO_UFIX(TO_UFIX(1) << _FRAC));
+    }
+
+    // |error| of a truncated divide, |remainder| / |R|
+    static double divideError(fixSize L, fixSize R){
+        const dfixSize rem = TO_DFIX(L) * (TO_DFIX(1) << _FRAC) % R;
+        return CAST<double>((rem < 0) ? TO_DFIX(0 - rem) : rem) /
+               CAST<double>(magnitude(R));
+    }
+
+};
+
+// Definitions for the constexpr members, needed when FixedInt128 ones are
+// passed by reference
+template<fastu16 _INT, fastu16 _FRAC, bool _SIGN, FixedOverflow _OVER>
+constexpr typename Fixed<_INT, _FRAC, _SIGN, _OVER>::dfixSize
+    Fixed<_INT, _FRAC, _SIGN, _OVER>::MULT_ROUND;
+template<fastu16 _INT, fastu16 _FRAC, bool _SIGN, FixedOverflow _OVER>
+constexpr typename Fixed<_INT, _FRAC, _SIGN, _OVER>::ufixSize
+    Fixed<_INT, _FRAC, _SIGN, _OVER>::FRAC_MASK;
+template<fastu16 _INT, fastu16 _FRAC, bool _SIGN, FixedOverflow _OVER>
+constexpr typename Fixed<_INT, _FRAC, _SIGN, _OVER>::ufixSize
+    Fixed<_INT, _FRAC, _SIGN, _OVER>::HALF_MASK;
+template<fastu16 _INT, fastu16 _FRAC, bool _SIGN, FixedOverflow _OVER>
+constexpr typename Fixed<_INT, _FRAC, _SIGN, _OVER>::fixSize
+    Fixed<_INT, _FRAC, _SIGN, _OVER>::RAW_MAX;
+template<fastu16 _INT, fastu16 _FRAC, bool _SIGN, FixedOverflow _OVER>
+constexpr typename Fixed<_INT, _FRAC, _SIGN, _OVER>::fixSize
+    Fixed<_INT, _FRAC, _SIGN, _OVER>::RAW_MIN;
+
+
+
+// **************************************************************
+//                      Reciprocal Division
+// **************************************************************
+// Seed for 1 / m, m in [0.5, 1), from the 8 bits after the leading one.
+// Entry i is 1 / m at the top of [(256 + i) / 512, (257 + i) / 512) as a
+// Q1.15 number, so it is never above the true reciprocal.
+struct FixedRecipSeed{
+    fastu16 value[256];
+    constexpr FixedRecipSeed(): value(){
+        for(fast32 i = 0; i < 256; i++)
+            value[i] = CAST<fastu16>((CAST<fast32>(1) << 24) / (257 + i));
+    }
+};
+
+template<bool UNUSED = true> struct FixedRecipTable{
+    static constexpr FixedRecipSeed seed{};
+};
+template<bool UNUSED>
+constexpr FixedRecipSeed FixedRecipTable<UNUSED>::seed;
+
+// Full width unsigned multiply. Uses the next larger type if there is one,
+// otherwise builds the product from half width pieces.
+template<class U, bool NATIVE>
+struct FixedWideMul{
+    typedef typename std::conditional<sizeof(U) * 2 <= sizeof(fastu64),
+                                      fastu64, fastu128>::type wide;
+    const static fastu16 BITS = sizeof(U) * 8;
+
+    static constexpr void mul(U a, U b, U &hi, U &lo){
+        const wide prod = CAST<wide>(a) * b;
+        hi = CAST<U>(prod >> BITS);
+        lo = CAST<U>(prod);
+    }
+
+    // (a * b) >> BITS
+    static constexpr U mulHi(U a, U b){
+        return CAST<U>((CAST<wide>(a) * b) >> BITS);
+    }
+
+    // (a * b) >> shift, for 0 < shift < 2 * BITS
+    static constexpr U mulShift(U a, U b, fastu16 shift){
+        return CAST<U>((CAST<wide>(a) * b) >> shift);
+    }
+};
+
+template<class U> struct FixedWideMul<U, false>{
+    const static fastu16 BITS = sizeof(U) * 8;
+    const static fastu16 HALF = BITS / 2;
+    const static U MASK = (CAST<U>(1) << HALF) - 1;
+
+    static constexpr void mul(U a, U b, U &hi, U &lo){
+        const U aHi = a >> HALF, aLo = a & MASK;
+        const U bHi = b >> HALF, bLo = b & MASK;
+        const U lolo = aLo * bLo, lohi = aLo * bHi;
+        const U hilo = aHi * bLo, hihi = aHi * bHi;
+        const U mid = (lolo >> HALF) + (lohi & MASK) + (hilo & MASK);
+
+        hi = hihi + (lohi >> HALF) + (hilo >> HALF) + (mid >> HALF);
+        lo = CAST<U>(mid << HALF) | (lolo & MASK);
+    }
+
+    static constexpr U mulHi(U a, U b){
+        U hi = 0, lo = 0;
+        mul(a, b, hi, lo);
+        return hi;
+    }
+
+    static constexpr U mulShift(U a, U b, fastu16 shift){
+        U hi = 0, lo = 0;
+        mul(a, b, hi, lo);
+        return (shift >= BITS) ? CAST<U>(hi >> (shift - BITS)) :
+                                 CAST<U>((hi << (BITS - shift)) | (lo >> shift));
+    }
+};
+
+// Two words of FixedInt128, from four 64 bit products
+template<> struct FixedWideMul<FixedInt128<false>, false>{
+    typedef FixedInt128<false> U;
+    const static fastu16 BITS = sizeof(U) * 8;
+
+    static constexpr void mul(U a, U b, U &hi, U &lo){
+        U::mulWide(a, b, hi, lo);
+    }
+
+    static constexpr U mulHi(U a, U b){
+        U hi, lo;
+        mul(a, b, hi, lo);
+        return hi;
+    }
+
+    static constexpr U mulShift(U a, U b, fastu16 shift){
+        U hi, lo;
+        mul(a, b, hi, lo);
+        return (shift >= BITS) ? U(hi >> (shift - BITS)) :
+                                 U((hi << (BITS - shift)) | (lo >> shift));
+    }
+};
+
+// Divides by the same number many times with a multiply instead of a divide.
+// The divisor is normalized to m * 2^e, m in [0.5, 1), and 1 / m comes from
+// the seed table plus Newton-Raphson steps, y = y * (2 - m * y), each one
+// doubling the correct bits (8 -> 16 -> 32 -> 64 -> 128).
+//
+//     FixedReciprocal<16, 15> gain(sum);
+//     for(i = 0; i < count; i++) out[i] = gain.divide(in[i]);
+//
+// Newton-Raphson gets y within 2 LSB, then the constructor steps it to
+// exactly floor(1 / m). With y never too big, the first quotient is never
+// too big either, and is at most 1 too small (2 if the format uses every
+// bit of word). The remainder fixes that, so divide() returns the same
+// number as the integer divide for every result that fits in the format.
+// Results that overflow the format follow the overflow policy, and are not
+// defined when wrapping, like the integer divide.
+template<fastu16 _INT, fastu16 _FRAC, bool _SIGN = SIGNED,
+         FixedOverflow _OVER = FIXED_WRAP>
+class FixedReciprocal{
+public:
+    typedef Fixed<_INT, _FRAC, _SIGN, _OVER> fixed;
+    typedef typename fixed::fixSize fixSize;
+
+    // Work in at least 32 bits, the seed alone is good to 8
+    typedef typename std::conditional<(sizeof(fixSize) < sizeof(fastu32)),
+                                      fastu32, typename fixed::ufixSize
+                                     >::type word;
+    typedef FixedWideMul<word> wide;
+
+    const static fastu16 BITS = sizeof(word) * 8;
+    const static fastu16 ITERATIONS =
+        (BITS <= 16) ? 1 : (BITS <= 32) ? 2 : (BITS <= 64) ? 3 : 4;
+    const static fastu16 CORRECTIONS = (fixed::BITSUM == BITS) ? 2 : 1;
+
+    constexpr explicit FixedReciprocal(const fixed &divisor):
+        denom(magnitude(divisor.getRawNumber())), recip(0), shift(0),
+        raw(divisor.getRawNumber()), negative(divisor.isNegative()){
+
+        assert(divisor.isNonZero());
+
+        // Shift the top bit up to the MSB, norm is m in Q0.BITS
+        const fastu16 lead = leadingZeros(denom);
+        const word norm = CAST<word>(denom << lead);
+        const word half = CAST<word>(CAST<word>(1) << (BITS - 1));
+
+        // recip is y = 1 / m in Q1.(BITS - 1). m = 0.5 gives y = 2, which
+        // does not fit, so use the largest number under it
+        if(norm == half){
+            recip = CAST<word>(~CAST<word>(0));
         }
-        if(R.number < 0){
-            right = -R.number;
-            RNegative = true;
+        else{
+            recip = CAST<word>(CAST<word>(FixedRecipTable<>::seed.value[
+                        CAST<fastu16>((norm >> (BITS - 9)) & 0xFF)])
+                    << (BITS - 16));
+
+            for(fastu16 i = 0; i < ITERATIONS; i++){
+                const word err = CAST<word>(0 - wide::mulHi(norm, recip));
+                recip = CAST<word>(wide::mulHi(recip, err) << 1);
+            }
+
+            // Start under 2^(2 BITS - 1) / norm, and step up to its floor
+            recip = CAST<word>(recip - 2);
+
+            word prodHi = 0, prodLo = 0;
+            wide::mul(norm, recip, prodHi, prodLo);
+            word remLo = CAST<word>(0 - prodLo);
+            word remHi = CAST<word>(half - prodHi - (prodLo != 0));
+
+            while(remHi != 0 || remLo >= norm){
+                recip++;
+                remHi = CAST<word>(remHi - (remLo < norm));
+                remLo = CAST<word>(remLo - norm);
+            }
+        }
+
+        // L / divisor = L * 2^FRAC * y / (2^(BITS - 1) * 2^(BITS - lead))
+        shift = 2 * BITS - 1 - _FRAC - lead;
+    }
+
+    constexpr fixed divide(const fixed &L) const{
+        const word num = magnitude(L.getRawNumber());
+        word quotient = wide::mulShift(num, recip, shift);
+
+        // Remainder num * 2^FRAC - quotient * denom, two words wide
+        word prodHi = 0, prodLo = 0;
+        wide::mul(quotient, denom, prodHi, prodLo);
+        const word numLo = CAST<word>(num << _FRAC);
+        word remLo = CAST<word>(numLo - prodLo);
+        word remHi = CAST<word>(CAST<word>(num >> (BITS - _FRAC)) - prodHi -
+                                (numLo < prodLo));
+
+        for(fastu16 i = 0; i < CORRECTIONS; i++){
+            const bool under = remHi != 0 || remLo >= denom;
+            quotient = CAST<word>(quotient + under);
+            remHi = CAST<word>(remHi - (under && remLo < denom));
+            remLo = CAST<word>(remLo - ((under) ? denom : 0));
         }
 
-        const fastu64 ALo = left << _FRAC;
-        const fastu64 AHi = left >> (BITSUM - _FRAC);
-
-        fast64 ret = 0;
-
-        fastu64 quotient = ALo << 1;
-        fastu64 remainder = AHi;
-        fastu64 carry = ALo >> (BITSUM - 1);
-        fastu64 tempCarry = 0;
-
-        for(fastu16 i = 0; i < BITSUM; i++){
-            tempCarry = remainder >> (BITSUM - 1);
-            remainder <<= 1;
-            remainder |= carry;
-            carry = tempCarry;
-
-            if(carry == 0){
-                if(remainder >= right){
-                    carry = 1;
-                }
-                else{
-                    tempCarry = quotient >> (BITSUM - 1);
-                    quotient <<= 1;
-                    quotient |= carry;
-                    carry = tempCarry;
-                    continue;
-                }
+        // Same overflow check as Fixed division, skipped when wrapping
+        const bool over = _OVER != FIXED_WRAP &&
+                          fixed::divideOverflow(L.getRawNumber(), raw);
+        fixed ret;
+        ret.setRawNumber(fixed::applyOverflow(
+                         (L.isNegative() != negative) ?
+                         CAST<fixSize>(0 - quotient) : CAST<fixSize>(quotient),
+                         over, L.isNegative() == negative));
+        return ret;
+    }
+
+    void divide(fixed *dst, const fixed *L, std::size_t count) const{
+        for(std::size_t i = 0; i < count; i++) dst[i] = divide(L[i]);
+    }
+
+private:
+    word denom;
+    word recip;
+    fastu16 shift;
+    fixSize raw;
+    bool negative;
+
+    static constexpr word magnitude(fixSize num){
+        return (num < 0) ? CAST<word>(0 - CAST<word>(num)) : CAST<word>(num);
+    }
+
+    static constexpr fastu16 leadingZeros(word num){
+#if defined(__GNUC__)
+        if(BITS <= 64) return __builtin_clzll(CAST<fastu64>(num)) - (64 - BITS);
+#endif // __GNUC__
+        fastu16 lead = 0;
+        for(fastu16 step = BITS / 2; step > 0; step /= 2){
+            if((num >> (BITS - step)) == 0){
+                num = CAST<word>(num << step);
+                lead += step;
             }
+        }
+        return lead;
+    }
+};
 
-            remainder -= right;
-            remainder -= (1 - carry);
-            carry = 1;
-            tempCarry = quotient >> (BITSUM - 1);
-            quotient <<= 1;
-            quotient |= carry;
-            carry = tempCarry;
+
+
+// **************************************************************
+//                    Mixed Format Arithmetic
+// **************************************************************
+// +, - and * between two different formats, without fit<> on either side.
+// The result format is worked out at compile time from the bits the exact
+// answer needs:
+//
+//     L * R        INT = INT_L + INT_R,      FRAC = FRAC_L + FRAC_R
+//     L + R, L - R INT = max(INT_L, INT_R) + 1, FRAC = max(FRAC_L, FRAC_R)
+//
+// then rounded up to the next supported width, with the spare bits given to
+// INT. When the largest width is too small, FRAC bits are dropped, rounded
+// off for * and cut off for + and -. The result is signed if either side
+// is, and uses the stricter of the two overflow policies.
+//
+//     Fixed<2, 29> coeff(0.75);
+//     Fixed<16, 15> sample(-3);
+//     auto product = coeff * sample; // Fixed<19, 44>, -2.25, no rounding
+//
+// The multiply is one widened integer multiply, and a shift only if FRAC
+// bits were dropped.
+template<fastu16 INT, fastu16 FRAC, bool SIGN, FixedOverflow OVER>
+struct FixedFormat{
+    const static fastu16 MAX_BITS = sizeof(fast64) * 8 - ((SIGN) ? 1 : 0);
+    const static fastu16 NEED = (INT + FRAC < MAX_BITS) ? INT + FRAC : MAX_BITS;
+    const static fastu16 BITS =
+        (NEED <= 8 - SIGN) ? 8 - SIGN : (NEED <= 16 - SIGN) ? 16 - SIGN :
+        (NEED <= 32 - SIGN) ? 32 - SIGN : MAX_BITS;
+
+    // Keep every INT bit that fits, and at least one FRAC bit
+    const static fastu16 NEW_INT = (INT + FRAC <= MAX_BITS) ? BITS - FRAC :
+                                   (INT < MAX_BITS) ? INT : MAX_BITS - 1;
+
+    typedef Fixed<NEW_INT, BITS - NEW_INT, SIGN, OVER> type;
+};
+
+template<class L, class R> struct FixedMixed;
+
+template<fastu16 INT_L, fastu16 FRAC_L, bool SIGN_L, FixedOverflow OVER_L,
+         fastu16 INT_R, fastu16 FRAC_R, bool SIGN_R, FixedOverflow OVER_R>
+struct FixedMixed<Fixed<INT_L, FRAC_L, SIGN_L, OVER_L>,
+                  Fixed<INT_R, FRAC_R, SIGN_R, OVER_R> >{
+    typedef Fixed<INT_L, FRAC_L, SIGN_L, OVER_L> left;
+    typedef Fixed<INT_R, FRAC_R, SIGN_R, OVER_R> right;
+
+    const static bool SIGN = SIGN_L || SIGN_R;
+    const static FixedOverflow OVER = (OVER_L > OVER_R) ? OVER_L : OVER_R;
+    const static fastu16 MAX_INT = (INT_L > INT_R) ? INT_L : INT_R;
+    const static fastu16 MAX_FRAC = (FRAC_L > FRAC_R) ? FRAC_L : FRAC_R;
+
+    typedef typename FixedFormat<INT_L + INT_R, FRAC_L + FRAC_R,
+                                 SIGN, OVER>::type product;
+    typedef typename FixedFormat<MAX_INT + 1, MAX_FRAC, SIGN, OVER>::type sum;
+
+    static constexpr product mul(const left &L, const right &R){
+        static_assert(left::BITSUM <= 64 && right::BITSUM <= 64,
+                      "FixedPoint.h: Mixed formats need 64 bits or less, "
+                      "fit() 127 and 128 bit formats first");
+        typedef typename product::fixSize fixSize;
+        typedef typename product::ufixSize ufixSize;
+
+        // Product bits dropped to fit the result, 0 if none were
+        const fastu16 SHIFT = FRAC_L + FRAC_R - product::FRAC_BITS;
+        const bool NATIVE = sizeof(typename left::fixSize) +
+                            sizeof(typename right::fixSize) <= sizeof(fast64);
+
+        if(NATIVE || ENABLE_DW_BIT_MATH == 1){
+            typedef typename std::conditional<NATIVE,
+                typename std::conditional<SIGN, fast64, fastu64>::type,
+                typename std::conditional<SIGN, fast128, fastu128>::type
+            >::type wide;
+
+            // 1 << (SHIFT - 1), or 0 when there is no shift
+            const wide round = CAST<wide>(SHIFT > 0) << (SHIFT - (SHIFT > 0));
+            const wide ret = (CAST<wide>(L.getRawNumber()) *
+                              CAST<wide>(R.getRawNumber()) + round) >> SHIFT;
+            const bool over =
+                ret > CAST<wide>(product().getMaxValue().getRawNumber()) ||
+                ret < CAST<wide>(product().getMinValue().getRawNumber());
+
+            product out;
+            out.setRawNumber(product::applyOverflow(CAST<fixSize>(ret), over,
+                                                    ret > 0));
+            return out;
         }
 
-        if(LNegative ^ RNegative) ret = -quotient;
-        else ret = quotient;
+        // Without the double width type, the product is two words. Sign it,
+        // round it and shift it the same way as Fixed::longMultiply.
+        const fastu16 WORD = sizeof(fastu64) * 8;
+        const bool negative = L.isNegative() != R.isNegative();
+
+        fastu64 hi = 0, lo = 0;
+        FixedWideMul<fastu64>::mul(left::magnitude(L.getRawNumber()),
+                                   right::magnitude(R.getRawNumber()), hi, lo);
+        if(negative){
+            lo = ~lo + 1;
+            hi = ~hi + (lo == 0);
+        }
 
-        return Fixed(ret, true);
+        if(SHIFT > 0){
+            const fastu64 round = CAST<fastu64>(1) << ((SHIFT - 1) % WORD);
+            if(SHIFT <= WORD){
+                lo += round;
+                hi += (lo < round);
+            }
+            else hi += round;
+
+            // Arithmetic shift of the two words, the sign is in hi
+            const fastu64 fill =
+                (SIGN && CAST<fast64>(hi) < 0) ? ~CAST<fastu64>(0) : 0;
+            if(SHIFT < WORD){
+                lo = (lo >> SHIFT) | (hi << ((WORD - SHIFT) % WORD));
+                hi = (hi >> SHIFT) | (fill << ((WORD - SHIFT) % WORD));
+            }
+            else{
+                const fastu16 fillShift = (2 * WORD - SHIFT) % WORD;
+                lo = (hi >> (SHIFT % WORD)) |
+                     ((SHIFT == WORD) ? 0 : fill << fillShift);
+                hi = fill;
+            }
+        }
+
+        // Fits if hi is only the sign of the result, and lo is in range
+        const fixSize ret = CAST<fixSize>(lo);
+        const bool over = (SIGN) ?
+            hi != ((ret < 0) ? ~CAST<fastu64>(0) : 0) ||
+            ret > product().getMaxValue().getRawNumber() ||
+            ret < product().getMinValue().getRawNumber() :
+            hi != 0 || CAST<ufixSize>(lo) != lo;
+
+        product out;
+        out.setRawNumber(product::applyOverflow(ret, over, !negative));
+        return out;
+    }
+
+    static constexpr sum add(const left &L, const right &R){
+        return align<FRAC_L>(L.getRawNumber()) +
+               align<FRAC_R>(R.getRawNumber());
+    }
+
+    static constexpr sum sub(const left &L, const right &R){
+        return align<FRAC_L>(L.getRawNumber()) -
+               align<FRAC_R>(R.getRawNumber());
     }
 
+private:
+    // Moves a raw number to the FRAC bits of the sum
+    template<fastu16 FROM, class T>
+    static constexpr sum align(T raw){
+        static_assert(left::BITSUM <= 64 && right::BITSUM <= 64,
+                      "FixedPoint.h: Mixed formats need 64 bits or less, "
+                      "fit() 127 and 128 bit formats first");
+        typedef typename sum::fixSize fixSize;
+        typedef typename sum::ufixSize ufixSize;
+        const fastu16 FRAC = sum::FRAC_BITS;
+        const fastu16 up = (FRAC > FROM) ? FRAC - FROM : 0;
+        const fastu16 down = (FROM > FRAC) ? FROM - FRAC : 0;
+
+        sum ret;
+        ret.setRawNumber(CAST<fixSize>(CAST<ufixSize>(
+                                       CAST<fixSize>(raw >> down)) << up));
+        return ret;
+    }
 };
 
+// Only used when the formats differ, same formats use the Fixed operators
+#define FIXED_MIXED_OPERATOR(OP, RESULT, FUNC)                                 \
+template<fastu16 INT_L, fastu16 FRAC_L, bool SIGN_L, FixedOverflow OVER_L,     \
+         fastu16 INT_R, fastu16 FRAC_R, bool SIGN_R, FixedOverflow OVER_R>     \
+constexpr typename std::enable_if<                                             \
+    !std::is_same<Fixed<INT_L, FRAC_L, SIGN_L, OVER_L>,                        \
+                  Fixed<INT_R, FRAC_R, SIGN_R, OVER_R> >::value,               \
+    typename FixedMixed<Fixed<INT_L, FRAC_L, SIGN_L, OVER_L>,                  \
+                        Fixed<INT_R, FRAC_R, SIGN_R, OVER_R> >::RESULT>::type  \
+operator OP(const Fixed<INT_L, FRAC_L, SIGN_L, OVER_L> &L,                     \
+            const Fixed<INT_R, FRAC_R, SIGN_R, OVER_R> &R){                    \
+    return FixedMixed<Fixed<INT_L, FRAC_L, SIGN_L, OVER_L>,                    \
+                      Fixed<INT_R, FRAC_R, SIGN_R, OVER_R> >::FUNC(L, R);      \
+}
+
+FIXED_MIXED_OPERATOR(*, product, mul)
+FIXED_MIXED_OPERATOR(+, sum, add)
+FIXED_MIXED_OPERATOR(-, sum, sub)
+
+#undef FIXED_MIXED_OPERATOR
+
 // Test to make sure Fixed auto sizing is working
 static_assert(sizeof(Fixed<4, 3>) == sizeof(fast8),
         "FixedPoint.h: Fixed<4, 3> is not the same size as fast8");
@@ -663,5 +1614,94 @@ static_assert(sizeof(Fixed<12, 20, false>) == sizeof(fast32),
 static_assert(sizeof(Fixed<34, 30, false>) == sizeof(fast64),
         "FixedPoint.h: Fixed<34, 30, false> is not the same size as fast64");
 
+// Test to make sure Fixed works in constant expressions
+static_assert(Fixed<10, 5>(1.5) * Fixed<10, 5>(-2) == Fixed<10, 5>(-3),
+        "FixedPoint.h: Fixed<10, 5> constexpr multiply failed");
+static_assert(Fixed<16, 15>(-3) / Fixed<16, 15>(4) == Fixed<16, 15>(-0.75),
+        "FixedPoint.h: Fixed<16, 15> constexpr divide failed");
+static_assert(Fixed<16, 15>(-1.25).floor() == Fixed<16, 15>(-2) &&
+              Fixed<16, 15>(-1.25).ceil() == Fixed<16, 15>(-1) &&
+              Fixed<16, 15>(-1.5).round() == Fixed<16, 15>(-1),
+        "FixedPoint.h: Fixed<16, 15> constexpr rounding failed");
+static_assert(Fixed<16, 15>(-2.5).round<FIXED_ROUND_HALF_EVEN>() ==
+                  Fixed<16, 15>(-2) &&
+              Fixed<16, 15>(3.5).round<FIXED_ROUND_HALF_EVEN>() ==
+                  Fixed<16, 15>(4) &&
+              Fixed<16, 15>(-1.75).trunc() == Fixed<16, 15>(-1) &&
+              Fixed<16, 15>(1.75).trunc() == Fixed<16, 15>(1) &&
+              Fixed<16, 15>(-1.25).getFraction() == Fixed<16, 15>(-0.25) &&
+              Fixed<16, 15>(1.25).round(FIXED_ROUND_STOCHASTIC, 0x6000) ==
+                  Fixed<16, 15>(2) &&
+              Fixed<16, 15>(1.25).round(FIXED_ROUND_STOCHASTIC, 0x5FFF) ==
+                  Fixed<16, 15>(1),
+        "FixedPoint.h: Fixed<16, 15> constexpr rounding modes failed");
+static_assert(Fixed<2, 61>(-0.5).fit<16, 15>() == Fixed<16, 15>(-0.5),
+        "FixedPoint.h: Fixed<2, 61> constexpr fit failed");
+static_assert(Fixed<34, 30, false>().getMaxValue().getRawNumber() ==
+              ~CAST<fastu64>(0),
+        "FixedPoint.h: Fixed<34, 30, false> constexpr max value failed");
+
+// Test to make sure the 128 bit formats work in constant expressions
+static_assert(sizeof(Fixed<64, 63>) == 16 &&
+              sizeof(Fixed<32, 96, false>) == 16,
+        "FixedPoint.h: 128 bit formats are not 128 bits");
+static_assert(Fixed<64, 63>(1.5) * Fixed<64, 63>(-2) == Fixed<64, 63>(-3) &&
+              Fixed<64, 63>(-3) / Fixed<64, 63>(4) == Fixed<64, 63>(-0.75),
+        "FixedPoint.h: Fixed<64, 63> constexpr multiply or divide failed");
+static_assert(Fixed<2, 61>(-0.5).fit<64, 63>().fit<16, 15>() ==
+              Fixed<16, 15>(-0.5),
+        "FixedPoint.h: Fixed<64, 63> constexpr fit failed");
+
+// Test to make sure the reciprocal divide matches the exact divide
+static_assert(FixedReciprocal<16, 15>(Fixed<16, 15>(-3)).divide(1) ==
+              Fixed<16, 15>(1) / Fixed<16, 15>(-3),
+        "FixedPoint.h: Fixed<16, 15> reciprocal divide failed");
+static_assert(FixedReciprocal<4, 4, false>(Fixed<4, 4, false>(0.1875))
+                  .divide(Fixed<4, 4, false>(1.5)) == Fixed<4, 4, false>(8),
+        "FixedPoint.h: Fixed<4, 4, false> reciprocal divide failed");
+static_assert(FixedReciprocal<2, 61>(Fixed<2, 61>(1.75)).divide(0.875) ==
+              Fixed<2, 61>(0.875) / Fixed<2, 61>(1.75),
+        "FixedPoint.h: Fixed<2, 61> reciprocal divide failed");
+
+// Test to make sure the overflow policies clamp
+static_assert(Fixed<4, 3, SIGNED, FIXED_SATURATE>(12) +
+              Fixed<4, 3, SIGNED, FIXED_SATURATE>(12) ==
+              Fixed<4, 3, SIGNED, FIXED_SATURATE>(15.875),
+        "FixedPoint.h: Fixed<4, 3> saturating add failed");
+static_assert(Fixed<4, 4, UNSIGNED, FIXED_SATURATE>(1) -
+              Fixed<4, 4, UNSIGNED, FIXED_SATURATE>(2) ==
+              Fixed<4, 4, UNSIGNED, FIXED_SATURATE>(0),
+        "FixedPoint.h: Fixed<4, 4, false> saturating subtract failed");
+static_assert(Fixed<10, 5, SIGNED, FIXED_SATURATE>(-100) *
+              Fixed<10, 5, SIGNED, FIXED_SATURATE>(100) ==
+              Fixed<10, 5, SIGNED, FIXED_SATURATE>(-1024),
+        "FixedPoint.h: Fixed<10, 5> saturating multiply failed");
+static_assert(Fixed<2, 61, SIGNED, FIXED_SATURATE>(1.5) *
+              Fixed<2, 61, SIGNED, FIXED_SATURATE>(-3) ==
+              Fixed<2, 61, SIGNED, FIXED_SATURATE>(-4),
+        "FixedPoint.h: Fixed<2, 61> saturating multiply failed");
+static_assert((Fixed<16, 15, SIGNED, FIXED_SATURATE>(-1) /
+               Fixed<16, 15, SIGNED, FIXED_SATURATE>(0)).getRawNumber() ==
+              Fixed<16, 15>().getMinValue().getRawNumber(),
+        "FixedPoint.h: Fixed<16, 15> saturating divide by zero failed");
+static_assert(Fixed<4, 3>(12) + Fixed<4, 3>(12) == Fixed<4, 3>(-8),
+        "FixedPoint.h: Fixed<4, 3> wrapping add failed");
+
+// Test to make sure mixed formats pick the right result and keep every bit
+static_assert(std::is_same<decltype(Fixed<2, 29>() * Fixed<16, 15>()),
+                           Fixed<19, 44> >::value &&
+              std::is_same<decltype(Fixed<10, 5>() + Fixed<4, 4, false>()),
+                           Fixed<26, 5> >::value &&
+              std::is_same<decltype(Fixed<1, 62>() * Fixed<16, 15>()),
+                           Fixed<17, 46> >::value,
+        "FixedPoint.h: mixed format result types failed");
+static_assert(Fixed<2, 29>(0.75) * Fixed<16, 15>(-3) == Fixed<19, 44>(-2.25),
+        "FixedPoint.h: Fixed<2, 29> * Fixed<16, 15> failed");
+static_assert(Fixed<1, 62>(0.5) * Fixed<30, 33>(-5) == Fixed<31, 32>(-2.5),
+        "FixedPoint.h: Fixed<1, 62> * Fixed<30, 33> failed");
+static_assert(Fixed<10, 5>(-1.5) - Fixed<4, 4, false>(15.9375) ==
+              Fixed<26, 5>(-17.4375),
+        "FixedPoint.h: Fixed<10, 5> - Fixed<4, 4, false> failed");
+
 
 #endif // FIXEDPOINT_H
@@ -0,0 +1,305 @@
+/*
+ *  @file    FixedProfile.h
+ *
+ *  @brief Per format op counters for picking INT and FRAC sizes
+ *
+ *  DESCRIPTION
+ *
+ * Building with ENABLE_FIXED_PROFILE set to 1 makes every Fixed format
+ * count what is done with it:
+ *
+ *     g++ -std=c++14 -O2 -DENABLE_FIXED_PROFILE=1 main.cpp
+ *
+ * Each conversion from int, float or double, negation, +, -, * and / is
+ * counted, along with how many of them overflowed, the largest magnitude
+ * and the finest bit any result used. Conversions, * and / also keep a
+ * histogram of the rounding error, how far the kept result is from the
+ * exact one in LSBs. Divides that go through longDivide(), wideDivide()
+ * or FixedReciprocal are counted, but their rounding is not measured.
+ * Constant expressions are never counted.
+ *
+ * The counters are thread_local, so the ops do not share anything between
+ * threads. When a thread exits its counters are added to the totals, and
+ * the totals are printed to std::cerr when the program exits. The report
+ * lists, per format:
+ *
+ *     Fixed<16, 15>, FIXED_WRAP
+ *                   convert    negate       add       sub       mul       div
+ *       ops            2001         0      1000         0      1000      1000
+ *       overflows         0         0         0         0         0         0
+ *       max |x| 42.2981, needs 6 of 16 INT bits, finest bit 2^-15
+ *       smallest legal size 31 bits
+ *       rounding  exact   1/8   1/4   3/8   1/2   5/8   3/4   7/8     1   mean
+ *         convert   52.0   6.0   6.0   6.0   6.0   6.0   6.0   6.0   6.0  0.240
+ *         mul        4.0  12.0  28.0  28.0  28.0   0.0   0.0   0.0   0.0  0.242
+ *         div       16.6   0.0   0.0  35.6   0.0   0.0  47.8   0.0   0.0  0.437
+ *
+ * Rounding is the percent of the op's results whose |error| is up to the
+ * column's LSBs, and the mean |error|. * rounds to nearest, so it stays
+ * within 1/2, while conversions and / truncate and can be off by up to 1.
+ * INT bits needed is the bit length of the largest magnitude, and the
+ * smallest legal size is that plus the FRAC bits down to the finest bit
+ * used, rounded up to a legal BITSUM. A format whose overflows are 0 and
+ * whose finest bit is well above 2^-FRAC can move to a smaller fixSize.
+ *
+ * Counting costs a thread_local lookup and a few adds per op, plus a
+ * divide for the rounding of /, so a profiled build is only for finding
+ * formats. With ENABLE_FIXED_PROFILE at 0 none of this is compiled in.
+ * FixedPoint.h includes this file when it is needed, and it needs
+ * __builtin_is_constant_evaluated(), GCC 9 or Clang 9 and up.
+ */
+
+
+
+
+#ifndef FIXEDPROFILE_H
+#define FIXEDPROFILE_H
+
+#ifndef FIXEDPOINT_H
+    #error "FixedProfile.h: Include FixedPoint.h instead"
+#endif // FIXEDPOINT_H
+
+#if !defined(__GNUC__)
+    #error "FixedProfile.h: Needs __builtin_is_constant_evaluated()"
+#endif // __GNUC__
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <tuple>
+#include <vector>
+
+// Bin 0 is an exact result, bin k is an error of (k - 1) / 8 to k / 8 LSBs
+const static fastu16 FIXED_PROFILE_BINS = 9;
+
+struct FixedProfileCounters{
+    fastu64 ops[FIXED_PROFILE_OPS];
+    fastu64 overflows[FIXED_PROFILE_OPS];
+    fastu64 rounding[FIXED_PROFILE_OPS][FIXED_PROFILE_BINS];
+    double roundingSum[FIXED_PROFILE_OPS]; // Sum of |error| in LSBs
+    fastu64 maxHi, maxLo;   // Largest raw magnitude, as two words
+    fastu64 usedHi, usedLo; // Every raw magnitude or'd together
+
+    void merge(const FixedProfileCounters &R){
+        for(fastu16 i = 0; i < FIXED_PROFILE_OPS; i++){
+            ops[i] += R.ops[i];
+            overflows[i] += R.overflows[i];
+            for(fastu16 k = 0; k < FIXED_PROFILE_BINS; k++)
+                rounding[i][k] += R.rounding[i][k];
+            roundingSum[i] += R.roundingSum[i];
+        }
+        if(R.maxHi > maxHi || (R.maxHi == maxHi && R.maxLo > maxLo)){
+            maxHi = R.maxHi;
+            maxLo = R.maxLo;
+        }
+        usedHi |= R.usedHi;
+        usedLo |= R.usedLo;
+    }
+};
+
+// Splits a raw magnitude into two words
+template<class T> void Fixed_profileWords(T num, fastu64 &hi, fastu64 &lo){
+    hi = 0;
+    lo = CAST<fastu64>(num);
+}
+inline void Fixed_profileWords(FixedInt128<false> num, fastu64 &hi,
+                               fastu64 &lo){
+    hi = num.hi;
+    lo = num.lo;
+}
+
+
+
+// **************************************************************
+//                            Totals
+// **************************************************************
+// Counters of every thread that has exited, one entry per format. The
+// report is printed when the registry is destroyed, after the main
+// thread's thread_local counters have been added.
+class FixedProfileRegistry{
+public:
+    static FixedProfileRegistry& get(){
+        static FixedProfileRegistry registry;
+        return registry;
+    }
+
+    ~FixedProfileRegistry(){ report(std::cerr);}
+
+    std::size_t add(fastu16 INT, fastu16 FRAC, bool SIGN,
+                    FixedOverflow OVER){
+        std::lock_guard<std::mutex> guard(lock);
+        formats.push_back(Format{INT, FRAC, SIGN, OVER,
+                                 FixedProfileCounters()});
+        return formats.size() - 1;
+    }
+
+    void merge(std::size_t index, const FixedProfileCounters &counters){
+        std::lock_guard<std::mutex> guard(lock);
+        formats[index].total.merge(counters);
+    }
+
+    // Prints every format that was used, smallest first
+    void report(std::ostream &out){
+        std::lock_guard<std::mutex> guard(lock);
+        std::vector<Format> sorted(formats);
+        std::sort(sorted.begin(), sorted.end(),
+                  [](const Format &L, const Format &R){
+            return std::make_tuple(L.INT + L.FRAC, L.INT, L.SIGN, L.OVER) <
+                   std::make_tuple(R.INT + R.FRAC, R.INT, R.SIGN, R.OVER);
+        });
+
+        out << "Fixed profile\n";
+        for(const Format &format : sorted) reportFormat(out, format);
+    }
+
+private:
+    struct Format{
+        fastu16 INT;
+        fastu16 FRAC;
+        bool SIGN;
+        FixedOverflow OVER;
+        FixedProfileCounters total;
+    };
+
+    FixedProfileRegistry() = default;
+
+    static fastu16 bitLength(fastu64 hi, fastu64 lo){
+        fastu16 bits = 0;
+        while(hi != 0 || lo != 0){
+            lo = (lo >> 1) | (hi << (sizeof(fastu64) * 8 - 1));
+            hi >>= 1;
+            bits++;
+        }
+        return bits;
+    }
+
+    static void reportFormat(std::ostream &out, const Format &format){
+        const char *OP_NAMES[FIXED_PROFILE_OPS] =
+            {"convert", "negate", "add", "sub", "mul", "div"};
+        const char *OVER_NAMES[] =
+            {"FIXED_WRAP", "FIXED_SATURATE", "FIXED_TRAP"};
+        const char *BIN_NAMES[FIXED_PROFILE_BINS] =
+            {"exact", "1/8", "1/4", "3/8", "1/2", "5/8", "3/4", "7/8", "1"};
+        const FixedProfileCounters &c = format.total;
+
+        fastu64 total = 0;
+        for(fastu16 i = 0; i < FIXED_PROFILE_OPS; i++) total += c.ops[i];
+        if(total == 0) return;
+
+        out << "Fixed<" << format.INT << ", " << format.FRAC
+            << ((format.SIGN) ? "" : ", UNSIGNED") << ">, "
+            << OVER_NAMES[format.OVER] << "\n" << std::setw(11) << "";
+        for(fastu16 i = 0; i < FIXED_PROFILE_OPS; i++)
+            out << std::setw(10) << OP_NAMES[i];
+        out << "\n  ops      ";
+        for(fastu16 i = 0; i < FIXED_PROFILE_OPS; i++)
+            out << std::setw(10) << c.ops[i];
+        out << "\n  overflows";
+        for(fastu16 i = 0; i < FIXED_PROFILE_OPS; i++)
+            out << std::setw(10) << c.overflows[i];
+
+        // The finest bit is the lowest one set in any result, 2^-finest
+        const fast32 top = bitLength(c.maxHi, c.maxLo);
+        fast32 finest = format.FRAC;
+        fastu64 hi = c.usedHi, lo = c.usedLo;
+        while((hi != 0 || lo != 0) && (lo & 1) == 0){
+            lo = (lo >> 1) | (hi << (sizeof(fastu64) * 8 - 1));
+            hi >>= 1;
+            finest--;
+        }
+
+        const fast32 intBits = std::max<fast32>(1, top - format.FRAC);
+        const fast32 bits = intBits + std::max<fast32>(1, finest);
+        fast32 legal = (format.SIGN) ? 7 : 8;
+        while(legal < bits) legal = 2 * legal + ((format.SIGN) ? 1 : 0);
+
+        out << "\n  max |x| " << std::ldexp(CAST<long double>(c.maxHi), 64 -
+                                            format.FRAC) +
+                                 std::ldexp(CAST<long double>(c.maxLo),
+                                            -format.FRAC)
+            << ", needs " << intBits << " of " << format.INT << " INT bits"
+            << ", finest bit 2^" << -finest
+            << "\n  smallest legal size " << legal << " bits\n";
+
+        // Percent of each op's measured results, by |error| in LSBs up to
+        // the bin's name, and the mean |error|
+        out << "  rounding " << std::setw(6) << BIN_NAMES[0];
+        for(fastu16 k = 1; k < FIXED_PROFILE_BINS; k++)
+            out << std::setw(6) << BIN_NAMES[k];
+        out << std::setw(7) << "mean" << "\n" << std::fixed;
+        for(fastu16 i = 0; i < FIXED_PROFILE_OPS; i++){
+            fastu64 measured = 0;
+            for(fastu16 k = 0; k < FIXED_PROFILE_BINS; k++)
+                measured += c.rounding[i][k];
+            if(measured == 0) continue;
+
+            out << "    " << std::left << std::setw(8) << OP_NAMES[i]
+                << std::right << std::setprecision(1);
+            for(fastu16 k = 0; k < FIXED_PROFILE_BINS; k++)
+                out << std::setw(6) << 100.0 * c.rounding[i][k] / measured;
+            out << std::setprecision(3) << std::setw(7)
+                << c.roundingSum[i] / measured << "\n";
+        }
+        out.unsetf(std::ios::floatfield);
+        out << std::setprecision(6);
+    }
+
+    std::mutex lock;
+    std::vector<Format> formats;
+};
+
+
+
+// **************************************************************
+//                     Per Thread Counters
+// **************************************************************
+// One per format per thread, added to the totals when the thread exits
+template<fastu16 INT, fastu16 FRAC, bool SIGN, FixedOverflow OVER>
+class FixedProfileThread{
+public:
+    // hi and lo are the raw magnitude of the result, err the rounding
+    // error in LSBs, or negative when it is not measured
+    static void record(FixedProfileOp op, fastu64 hi, fastu64 lo, bool over,
+                       double err){
+        FixedProfileCounters &c = local().counters;
+        c.ops[op]++;
+        c.overflows[op] += over;
+        if(hi > c.maxHi || (hi == c.maxHi && lo > c.maxLo)){
+            c.maxHi = hi;
+            c.maxLo = lo;
+        }
+        c.usedHi |= hi;
+        c.usedLo |= lo;
+
+        if(err >= 0){
+            const fastu16 bin = (err == 0) ? 0 : std::max<fastu16>(1,
+                std::min<fastu16>(FIXED_PROFILE_BINS - 1,
+                                  CAST<fastu16>(std::ceil(err * 8))));
+            c.rounding[op][bin]++;
+            c.roundingSum[op] += err;
+        }
+    }
+
+private:
+    FixedProfileThread(): counters(), index(formatIndex()){}
+    ~FixedProfileThread(){ FixedProfileRegistry::get().merge(index, counters);}
+
+    // Registers the format once, for every thread
+    static std::size_t formatIndex(){
+        static const std::size_t index =
+            FixedProfileRegistry::get().add(INT, FRAC, SIGN, OVER);
+        return index;
+    }
+
+    static FixedProfileThread& local(){
+        thread_local FixedProfileThread thread;
+        return thread;
+    }
+
+    FixedProfileCounters counters;
+    std::size_t index;
+};
+
+#endif // FIXEDPROFILE_H
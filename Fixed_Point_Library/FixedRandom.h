@@ -0,0 +1,537 @@
+/*
+ *  @file    FixedRandom.h
+ *
+ *  @brief Random Fixed numbers, uniform and Gaussian, the same on every
+ *         platform
+ *
+ *  DESCRIPTION
+ *
+ * FixedRandom turns the raw bits of a generator straight into Fixed
+ * numbers, with no float or double in between. Two generators come with
+ * it, both seeded from one 64 bit number and a stream number:
+ *
+ *     FixedXoshiro256  xoshiro256**, 64 bits per step, the default
+ *     FixedPcg32       PCG XSH RR 64/32, 32 bits per step, 16 bytes of state
+ *
+ *     FixedRandom<> rng(12345);
+ *     Fixed<16, 15> a = rng.uniform(Fixed<16, 15>(-2), Fixed<16, 15>(2));
+ *     Fixed<1, 14> b = rng.unit<Fixed<1, 14> >();         // [0, 1)
+ *     Fixed<1, 14> n = rng.normal(Fixed<1, 14>(0.1));     // sigma of 0.1
+ *
+ * bits() fills every bit of the raw number, unit() is the top FRAC bits of
+ * a step, so [0, 1) with every LSB equally likely, and uniform(lo, hi) is
+ * [lo, hi) by Lemire's multiply and reject, which has no bias. normal()
+ * is a standard Gaussian from a 128 layer ziggurat, and normal(sigma)
+ * scales it by sigma with one rounding. Gaussian results that do not fit
+ * the format are clamped to getMaxValue() or getMinValue(). Formats up to
+ * 64 bits are supported, and formats up to 32 bits take 32 bits per step.
+ *
+ * fillBits(), fillUnit(), fillUniform() and fillNormal() do the same over a
+ * buffer. fillBits() and fillUnit() cut each 64 bit step into as many
+ * numbers as fit, so they give a different sequence than calling bits() or
+ * unit() in a loop, but the same one on every platform.
+ *
+ * Every result is bit exact across compilers and CPUs for the same seed.
+ * The generators are plain 64 bit integer math, and the ziggurat works on
+ * Q31 and Q59 integers. Its tables are built at compile time and checked
+ * against known values below, and its wedge and tail use Fixed_expTable()
+ * and Fixed_lnTable() in Fixed<7, 56>, not <cmath>. A stream is its own
+ * sequence from the same seed, one per thread: 2^128 steps apart for
+ * FixedXoshiro256, a different increment for FixedPcg32.
+ */
+
+
+
+
+#ifndef FIXEDRANDOM_H
+#define FIXEDRANDOM_H
+
+#include "FixedExpLog.h"
+#include <cassert>
+#include <cstddef>
+
+// Layers of the Gaussian ziggurat, the index is the low bits of a step
+#define FIXED_ZIGGURAT_LAYERS 128
+
+#define FIXED_ZIGGURAT_R 3.442619855899         // Start of the tail
+#define FIXED_ZIGGURAT_V 9.91256303526217e-3    // Area of each layer
+
+// FRAC bits of the ziggurat's results, the tail reaches about 14.7
+#define FIXED_NORMAL_FRAC 59
+
+
+
+// **************************************************************
+//                          Generators
+// **************************************************************
+// Seeds other generators, one 64 bit number in, well mixed steps out
+constexpr fastu64 Fixed_splitMix64(fastu64 &state){
+    fastu64 z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+// xoshiro256** by Blackman and Vigna, a period of 2^256 - 1
+class FixedXoshiro256{
+public:
+    constexpr explicit FixedXoshiro256(fastu64 seed = 0, fastu64 stream = 0)
+        : state(){
+        for(fastu16 i = 0; i < 4; i++) state[i] = Fixed_splitMix64(seed);
+        for(fastu64 i = 0; i < stream; i++) jump();
+    }
+
+    constexpr fastu64 next64(){
+        const fastu64 ret = rotl(state[1] * 5, 7) * 9;
+        const fastu64 t = state[1] << 17;
+        state[2] ^= state[0];
+        state[3] ^= state[1];
+        state[1] ^= state[2];
+        state[0] ^= state[3];
+        state[2] ^= t;
+        state[3] = rotl(state[3], 45);
+        return ret;
+    }
+
+    // The top bits are the best ones
+    constexpr fastu32 next32(){ return CAST<fastu32>(next64() >> 32);}
+
+    // Same as 2^128 steps
+    constexpr void jump(){
+        const fastu64 JUMP[4] = {0x180EC6D33CFD0ABAULL, 0xD5A61266F0C9392CULL,
+                                 0xA9582618E03FC9AAULL, 0x39ABDC4529B1661CULL};
+        fastu64 next[4] = {0, 0, 0, 0};
+        for(fastu16 i = 0; i < 4; i++)
+            for(fastu16 b = 0; b < 64; b++){
+                if((JUMP[i] >> b) & 1)
+                    for(fastu16 k = 0; k < 4; k++) next[k] ^= state[k];
+                next64();
+            }
+        for(fastu16 k = 0; k < 4; k++) state[k] = next[k];
+    }
+
+private:
+    static constexpr fastu64 rotl(fastu64 x, fastu16 k){
+        return (x << k) | (x >> (64 - k));
+    }
+
+    fastu64 state[4];
+};
+
+// PCG XSH RR 64/32 by O'Neill, a period of 2^64 per stream
+class FixedPcg32{
+public:
+    constexpr explicit FixedPcg32(fastu64 seed = 0, fastu64 stream = 0)
+        : state(0), inc((stream << 1) | 1){
+        next32();
+        state += seed;
+        next32();
+    }
+
+    constexpr fastu32 next32(){
+        const fastu64 old = state;
+        state = old * 6364136223846793005ULL + inc;
+        const fastu32 xorShifted = CAST<fastu32>(((old >> 18) ^ old) >> 27);
+        const fastu32 rot = CAST<fastu32>(old >> 59);
+        return (xorShifted >> rot) | (xorShifted << ((0 - rot) & 31));
+    }
+
+    // Two steps, the first one on top
+    constexpr fastu64 next64(){
+        const fastu64 hi = next32();
+        return (hi << 32) | next32();
+    }
+
+private:
+    fastu64 state;
+    fastu64 inc;
+};
+
+
+
+// **************************************************************
+//                       Ziggurat Tables
+// **************************************************************
+// e^(-x^2 / 2) for |x| up to about 4, only run by the compiler. The
+// series is run on x^2 / 32, then squared four times.
+constexpr double Fixed_constGauss(double x){
+    double ret = Fixed_constExp(-x * x / 32);
+    for(fastu16 i = 0; i < 4; i++) ret *= ret;
+    return ret;
+}
+
+// Marsaglia and Tsang's layers, x[0] being the base strip's width of
+// V / f(R) and x[127] = R
+struct FixedZigguratTable{
+    // |hz| below k[i] is inside the rectangle of layer i, Q31
+    fastu32 k[FIXED_ZIGGURAT_LAYERS];
+    // x[i], Q30
+    fastu32 w[FIXED_ZIGGURAT_LAYERS];
+    // e^(-x[i]^2 / 2), Q31
+    fastu32 f[FIXED_ZIGGURAT_LAYERS];
+    // R in Q59, and 1 / R in Q56 for the tail
+    fastu64 r;
+    fastu64 invR;
+
+    constexpr FixedZigguratTable(): k(), w(), f(), r(0), invR(0){
+        const double Q30 = 1073741824.0, Q31 = 2147483648.0;
+        const fastu16 TOP = FIXED_ZIGGURAT_LAYERS - 1;
+        double x = FIXED_ZIGGURAT_R, last = x;
+        const double q = FIXED_ZIGGURAT_V / Fixed_constGauss(x);
+
+        k[0] = Fixed_constRoundU32(x / q * Q31);
+        k[1] = 0;
+        w[0] = Fixed_constRoundU32(q * Q30);
+        w[TOP] = Fixed_constRoundU32(x * Q30);
+        f[0] = Fixed_constRoundU32(Q31);
+        f[TOP] = Fixed_constRoundU32(Fixed_constGauss(x) * Q31);
+        for(fast32 i = TOP - 1; i >= 1; i--){
+            x = Fixed_constSqrt(-2 * Fixed_constLn(FIXED_ZIGGURAT_V / x +
+                                                  Fixed_constGauss(x)));
+            k[i + 1] = Fixed_constRoundU32(x / last * Q31);
+            last = x;
+            f[i] = Fixed_constRoundU32(Fixed_constGauss(x) * Q31);
+            w[i] = Fixed_constRoundU32(x * Q30);
+        }
+
+        r = CAST<fastu64>(FIXED_ZIGGURAT_R * Q30 * 536870912.0 + 0.5);
+        invR = CAST<fastu64>(Q30 * 67108864.0 / FIXED_ZIGGURAT_R + 0.5);
+    }
+};
+
+template<bool UNUSED = true> struct FixedZigguratTables{
+    static constexpr FixedZigguratTable table{};
+};
+template<bool UNUSED>
+constexpr FixedZigguratTable FixedZigguratTables<UNUSED>::table;
+
+
+
+// **************************************************************
+//                        Fixed Numbers
+// **************************************************************
+template<class GEN = FixedXoshiro256>
+class FixedRandom{
+public:
+    constexpr explicit FixedRandom(fastu64 seed = 0, fastu64 stream = 0)
+        : gen(seed, stream){}
+
+    // Every raw number equally likely
+    template<class FIXED> FIXED bits(){
+        checkFormat<FIXED>();
+        FIXED ret;
+        ret.setRawNumber(CAST<typename FIXED::fixSize>(
+            step<typename word<FIXED>::type>()));
+        return ret;
+    }
+
+    // [0, 1), the top FRAC bits of a step
+    template<class FIXED> FIXED unit(){
+        checkFormat<FIXED>();
+        typedef typename word<FIXED>::type U;
+        FIXED ret;
+        ret.setRawNumber(toUnit<FIXED>(step<U>(), sizeof(U) * 8));
+        return ret;
+    }
+
+    // [lo, hi), lo < hi
+    template<fastu16 INT, fastu16 FRAC, bool SIGN, FixedOverflow OVER>
+    Fixed<INT, FRAC, SIGN, OVER> uniform(
+        const Fixed<INT, FRAC, SIGN, OVER> &lo,
+        const Fixed<INT, FRAC, SIGN, OVER> &hi){
+        typedef Fixed<INT, FRAC, SIGN, OVER> fixed;
+        typedef typename word<fixed>::type U;
+        checkFormat<fixed>();
+        assert(lo < hi);
+
+        // The high word of step * span is in [0, span), reject the few low
+        // words that would make some of them more likely
+        const U span = CAST<U>(hi.getRawNumber()) - CAST<U>(lo.getRawNumber());
+        U top = 0, bottom = 0;
+        FixedWideMul<U>::mul(step<U>(), span, top, bottom);
+        if(bottom < span){
+            const U least = CAST<U>(0 - span) % span;
+            while(bottom < least)
+                FixedWideMul<U>::mul(step<U>(), span, top, bottom);
+        }
+
+        fixed ret;
+        ret.setRawNumber(CAST<typename fixed::fixSize>(
+            CAST<U>(lo.getRawNumber()) + top));
+        return ret;
+    }
+
+    // Mean 0, standard deviation 1
+    template<class FIXED> FIXED normal(){
+        checkNormal<FIXED>();
+        return fromNormal<FIXED>(normalQ59());
+    }
+
+    // Mean 0, standard deviation sigma
+    template<fastu16 INT, fastu16 FRAC, bool SIGN, FixedOverflow OVER>
+    Fixed<INT, FRAC, SIGN, OVER> normal(
+        const Fixed<INT, FRAC, SIGN, OVER> &sigma){
+        typedef Fixed<INT, FRAC, SIGN, OVER> fixed;
+        checkNormal<fixed>();
+        return scaleNormal<fixed>(normalQ59(), sigma.getRawNumber());
+    }
+
+    // **************************************************************
+    //                        Buffer Fills
+    // **************************************************************
+    template<fastu16 INT, fastu16 FRAC, bool SIGN, FixedOverflow OVER>
+    void fillBits(Fixed<INT, FRAC, SIGN, OVER> *dst, std::size_t count){
+        typedef Fixed<INT, FRAC, SIGN, OVER> fixed;
+        checkFormat<fixed>();
+        fillPieces<fixed>(dst, count, [](fastu64 piece, fastu16){
+            return CAST<typename fixed::fixSize>(piece);
+        });
+    }
+
+    template<fastu16 INT, fastu16 FRAC, bool SIGN, FixedOverflow OVER>
+    void fillUnit(Fixed<INT, FRAC, SIGN, OVER> *dst, std::size_t count){
+        typedef Fixed<INT, FRAC, SIGN, OVER> fixed;
+        checkFormat<fixed>();
+        fillPieces<fixed>(dst, count, [](fastu64 piece, fastu16 width){
+            return toUnit<fixed>(piece, width);
+        });
+    }
+
+    template<fastu16 INT, fastu16 FRAC, bool SIGN, FixedOverflow OVER>
+    void fillUniform(Fixed<INT, FRAC, SIGN, OVER> *dst, std::size_t count,
+                     const Fixed<INT, FRAC, SIGN, OVER> &lo,
+                     const Fixed<INT, FRAC, SIGN, OVER> &hi){
+        for(std::size_t i = 0; i < count; i++) dst[i] = uniform(lo, hi);
+    }
+
+    template<fastu16 INT, fastu16 FRAC, bool SIGN, FixedOverflow OVER>
+    void fillNormal(Fixed<INT, FRAC, SIGN, OVER> *dst, std::size_t count){
+        typedef Fixed<INT, FRAC, SIGN, OVER> fixed;
+        checkNormal<fixed>();
+        for(std::size_t i = 0; i < count; i++)
+            dst[i] = fromNormal<fixed>(normalQ59());
+    }
+
+    template<fastu16 INT, fastu16 FRAC, bool SIGN, FixedOverflow OVER>
+    void fillNormal(Fixed<INT, FRAC, SIGN, OVER> *dst, std::size_t count,
+                    const Fixed<INT, FRAC, SIGN, OVER> &sigma){
+        typedef Fixed<INT, FRAC, SIGN, OVER> fixed;
+        checkNormal<fixed>();
+        for(std::size_t i = 0; i < count; i++)
+            dst[i] = scaleNormal<fixed>(normalQ59(), sigma.getRawNumber());
+    }
+
+    GEN& getGenerator(){ return gen;}
+
+private:
+    // Fixed<7, 56> holds -ln of a Q56 step, and the tail's x^2
+    typedef Fixed<7, 56> wide;
+
+    // The step size a format takes its bits from
+    template<class FIXED> struct word{
+        typedef typename std::conditional<
+            FIXED::BITSUM + FIXED::IS_SIGNED <= 32, fastu32, fastu64>::type
+            type;
+    };
+
+    template<class FIXED> static constexpr void checkFormat(){
+        static_assert(FIXED::BITSUM + FIXED::IS_SIGNED <= 64,
+                      "FixedRandom.h: Formats need 64 bits or less");
+    }
+
+    template<class FIXED> static constexpr void checkNormal(){
+        checkFormat<FIXED>();
+        static_assert(FIXED::IS_SIGNED,
+                      "FixedRandom.h: Gaussian numbers need a signed format");
+    }
+
+    static const FixedZigguratTable& table(){
+        return FixedZigguratTables<>::table;
+    }
+
+    template<class U> U step(){
+        return (sizeof(U) <= sizeof(fastu32)) ? CAST<U>(gen.next32())
+                                              : CAST<U>(gen.next64());
+    }
+
+    // Top FRAC bits of the low width bits of piece
+    template<class FIXED>
+    static typename FIXED::fixSize toUnit(fastu64 piece, fastu16 width){
+        if(FIXED::FRAC_BITS == 0) return 0;
+        return CAST<typename FIXED::fixSize>(
+            piece >> (width - FIXED::FRAC_BITS));
+    }
+
+    // Cuts each 64 bit step into 64 / width pieces of width bits
+    template<class FIXED, class PIECE>
+    void fillPieces(FIXED *dst, std::size_t count, PIECE piece){
+        const fastu16 WIDTH = FIXED::BITSUM + FIXED::IS_SIGNED;
+        const fastu16 PER_STEP = 64 / WIDTH;
+        const fastu64 MASK = ~CAST<fastu64>(0) >> (64 - WIDTH);
+
+        std::size_t i = 0;
+        for(; i + PER_STEP <= count; i += PER_STEP){
+            fastu64 bits = gen.next64();
+            for(fastu16 k = 0; k < PER_STEP; k++){
+                dst[i + k].setRawNumber(piece(bits & MASK, WIDTH));
+                bits = (WIDTH < 64) ? bits >> (WIDTH % 64) : 0;
+            }
+        }
+        fastu64 bits = gen.next64();
+        for(; i < count; i++){
+            dst[i].setRawNumber(piece(bits & MASK, WIDTH));
+            bits = (WIDTH < 64) ? bits >> (WIDTH % 64) : 0;
+        }
+    }
+
+    // Standard Gaussian in Q59. The low 7 bits of a step pick the layer
+    // and the top 32 are a signed position in it, scaled by x[layer].
+    fast64 normalQ59(){
+        const FixedZigguratTable &zig = table();
+        while(true){
+            const fastu64 bits = gen.next64();
+            const fastu16 layer = bits & (FIXED_ZIGGURAT_LAYERS - 1);
+            const fast32 hz = CAST<fast32>(CAST<fastu32>(bits >> 32));
+            const fastu32 mag = (hz < 0) ? 0 - CAST<fastu32>(hz)
+                                         : CAST<fastu32>(hz);
+
+            // Q31 * Q30 >> 2
+            const fast64 x = (CAST<fast64>(hz) * zig.w[layer]) >> 2;
+            if(mag < zig.k[layer]) return x;
+
+            if(layer == 0){
+                const fast64 tail = tailQ59();
+                return (hz < 0) ? -tail : tail;
+            }
+
+            // Under the curve between layers, f in Q31 against e^(-x^2 / 2)
+            const fastu32 y = zig.f[layer] + CAST<fastu32>(
+                (CAST<fastu64>(gen.next32()) *
+                 (zig.f[layer - 1] - zig.f[layer])) >> 32);
+            wide xw;
+            xw.setRawNumber(x >> (FIXED_NORMAL_FRAC - wide::FRAC_BITS));
+            const wide gauss = Fixed_expTable(-((xw * xw) >> 1));
+            if(CAST<fast64>(CAST<fastu64>(y) << (wide::FRAC_BITS - 31)) <
+               gauss.getRawNumber())
+                return x;
+        }
+    }
+
+    // Marsaglia's tail past R: x = -ln(u1) / R until -2 ln(u2) > x^2
+    fast64 tailQ59(){
+        const FixedZigguratTable &zig = table();
+        wide invR, u1, u2, x, y;
+        invR.setRawNumber(CAST<fast64>(zig.invR));
+        do{
+            // (0, 1], never 0 so ln() has an answer
+            u1.setRawNumber(CAST<fast64>(gen.next64() >> 8) + 1);
+            u2.setRawNumber(CAST<fast64>(gen.next64() >> 8) + 1);
+            x = -Fixed_lnTable(u1) * invR;
+            y = -Fixed_lnTable(u2);
+        } while(y + y < x * x);
+        return CAST<fast64>(zig.r) + (x.getRawNumber() <<
+                                      (FIXED_NORMAL_FRAC - wide::FRAC_BITS));
+    }
+
+    // Rounds a Q59 number to FIXED, clamped to its range
+    template<class FIXED> static FIXED fromNormal(fast64 z){
+        const fastu16 FRAC = FIXED::FRAC_BITS;
+        const fast64 max = CAST<fast64>(FIXED().getMaxValue().getRawNumber());
+        const fast64 min = CAST<fast64>(FIXED().getMinValue().getRawNumber());
+
+        fast64 raw = 0;
+        if(FRAC <= FIXED_NORMAL_FRAC){
+            const fastu16 shift = (FIXED_NORMAL_FRAC - FRAC) % 64;
+            const fast64 round = (shift > 0) ? CAST<fast64>(1) << (shift - 1)
+                                             : 0;
+            raw = (z + round) >> shift;
+            raw = (raw > max) ? max : (raw < min) ? min : raw;
+        }
+        else{
+            const fastu16 shift = (FRAC - FIXED_NORMAL_FRAC) % 64;
+            raw = (z > (max >> shift)) ? max : (z < (min >> shift)) ? min :
+                  CAST<fast64>(CAST<fastu64>(z) << shift);
+        }
+
+        FIXED ret;
+        ret.setRawNumber(CAST<typename FIXED::fixSize>(raw));
+        return ret;
+    }
+
+    // z * sigma, Q59 times the raw sigma, rounded back to FIXED and clamped
+    template<class FIXED> static FIXED scaleNormal(fast64 z, fast64 sigma){
+        const bool negative = (z < 0) != (sigma < 0);
+        const fastu64 zMag = (z < 0) ? 0 - CAST<fastu64>(z) : CAST<fastu64>(z);
+        const fastu64 sMag = (sigma < 0) ? 0 - CAST<fastu64>(sigma)
+                                         : CAST<fastu64>(sigma);
+        fastu64 hi = 0, lo = 0;
+        FixedWideMul<fastu64>::mul(zMag, sMag, hi, lo);
+
+        const fastu64 ROUND = CAST<fastu64>(1) << (FIXED_NORMAL_FRAC - 1);
+        hi += (lo + ROUND < lo);
+        lo += ROUND;
+        const fastu64 mag = (hi << (64 - FIXED_NORMAL_FRAC)) |
+                            (lo >> FIXED_NORMAL_FRAC);
+
+        const fastu64 limit = (negative) ?
+            0 - CAST<fastu64>(FIXED().getMinValue().getRawNumber()) :
+            CAST<fastu64>(FIXED().getMaxValue().getRawNumber());
+        const bool over = (hi >> FIXED_NORMAL_FRAC) != 0 || mag > limit;
+        const fastu64 out = (over) ? limit : mag;
+
+        FIXED ret;
+        ret.setRawNumber(CAST<typename FIXED::fixSize>(
+            (negative) ? 0 - out : out));
+        return ret;
+    }
+
+    GEN gen;
+};
+
+
+
+// **************************************************************
+//                     Bit Exactness Tests
+// **************************************************************
+// The n'th step of a generator, counting from 0
+template<class GEN>
+constexpr fastu64 Fixed_randomStep(GEN gen, fastu16 n){
+    for(fastu16 i = 0; i < n; i++) gen.next64();
+    return gen.next64();
+}
+
+constexpr fastu32 Fixed_pcgStep(FixedPcg32 gen, fastu16 n){
+    for(fastu16 i = 0; i < n; i++) gen.next32();
+    return gen.next32();
+}
+
+// Test to make sure the generators match the reference implementations,
+// xoshiro256** seeded by splitmix64, and the PCG demo's seed of 42, 54
+static_assert(Fixed_randomStep(FixedXoshiro256(12345), 0) ==
+                  0xBE6A36374160D49BULL &&
+              Fixed_randomStep(FixedXoshiro256(12345), 3) ==
+                  0x0C60048C4E96E033ULL &&
+              Fixed_pcgStep(FixedPcg32(42, 54), 0) == 0xA15C02B7UL &&
+              Fixed_pcgStep(FixedPcg32(42, 54), 5) == 0xCBED606EUL,
+        "FixedRandom.h: Generator does not match the reference");
+
+// Sum of one table's entries
+constexpr fastu64 Fixed_zigguratSum(const fastu32 *table){
+    fastu64 sum = 0;
+    for(fastu16 i = 0; i < FIXED_ZIGGURAT_LAYERS; i++) sum += table[i];
+    return sum;
+}
+
+// Test to make sure the compiler built the same ziggurat as everywhere else
+static_assert(Fixed_zigguratSum(FixedZigguratTables<>::table.k) ==
+                  267302381054ULL &&
+              Fixed_zigguratSum(FixedZigguratTables<>::table.w) ==
+                  220187349990ULL &&
+              Fixed_zigguratSum(FixedZigguratTables<>::table.f) ==
+                  99177666516ULL &&
+              FixedZigguratTables<>::table.k[0] == 1991057938UL &&
+              FixedZigguratTables<>::table.r == 0x1B8A7C476D2BE800ULL &&
+              FixedZigguratTables<>::table.invR == 0x4A5CAA2BF185D4ULL,
+        "FixedRandom.h: Ziggurat table is not the same on this compiler");
+
+#endif // FIXEDRANDOM_H
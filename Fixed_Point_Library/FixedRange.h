@@ -0,0 +1,267 @@
+/*
+ *  @file    FixedRange.h
+ *
+ *  @brief Fixed formats picked from value ranges at compile time
+ *
+ *  DESCRIPTION
+ *
+ * FixedSelect<LO, HI, FRAC>::type is the narrowest legal Fixed that holds
+ * every number from LO to HI with at least FRAC FRAC bits. It is signed if
+ * LO is negative. INT is the fewest bits that hold both bounds, and the
+ * width is the smallest legal BITSUM that fits INT + FRAC, with the spare
+ * bits given to FRAC:
+ *
+ *     FixedSelect<-1, 1, 14>::type       // Fixed<1, 14>
+ *     FixedSelect<0, 200, 6>::type       // Fixed<8, 8, UNSIGNED>
+ *     FixedSelect<-1000, 1000, 10>::type // Fixed<10, 21>
+ *
+ * The bounds are integers, so a range like -0.5 to 0.5 is given as -1 to 1,
+ * which can cost a bit. |LO| and HI need to be under 2^62.
+ *
+ * FixedRanged<LO, HI, FRAC> is a number stored in that format which keeps
+ * its range in its type. +, -, * and negation give a FixedRanged whose
+ * range holds every possible result, so an expression can not overflow:
+ *
+ *     FixedRanged<-1, 1, 14> a(0.75);      // Fixed<1, 14>
+ *     FixedRanged<-100, 100, 8> b(-3);     // Fixed<7, 8>
+ *     FixedRanged<-10, 10, 8> c(2.5);      // Fixed<4, 11>
+ *     auto y = a * b + c;                  // -110 to 110, Fixed<7, 24>
+ *
+ * A result has the finer of the two resolutions, the same as Fixed * keeps
+ * FRAC, and bits past it are cut off. The product itself is exact, see
+ * FixedMixed. A FixedRanged converts implicitly to one whose range holds
+ * its own, and explicitly, with an assert, to any other.
+ *
+ * / is not ranged, since a divisor near 0 has no bound. Use get() for the
+ * Fixed number, divide, and convert back with an explicit range.
+ */
+
+
+
+
+#ifndef FIXEDRANGE_H
+#define FIXEDRANGE_H
+
+#include "FixedPoint.h"
+#include <cassert>
+#include <limits>
+#include <ostream>
+#include <type_traits>
+
+// **************************************************************
+//                         Range Math
+// **************************************************************
+// Bounds saturate instead of overflowing, and a saturated bound is too
+// large for FixedSelect, so it stops the compile with its static_assert
+const static fast64 FIXED_RANGE_LIMIT = std::numeric_limits<fast64>::max();
+
+constexpr fast64 Fixed_rangeAdd(fast64 a, fast64 b){
+    return (b > 0 && a > FIXED_RANGE_LIMIT - b) ? FIXED_RANGE_LIMIT :
+           (b < 0 && a < -FIXED_RANGE_LIMIT - b) ? -FIXED_RANGE_LIMIT : a + b;
+}
+
+constexpr fast64 Fixed_rangeMul(fast64 a, fast64 b){
+    const bool negative = (a < 0) != (b < 0);
+    const fast64 absA = (a < 0) ? -a : a, absB = (b < 0) ? -b : b;
+    return (absA != 0 && absB > FIXED_RANGE_LIMIT / absA) ?
+               ((negative) ? -FIXED_RANGE_LIMIT : FIXED_RANGE_LIMIT) : a * b;
+}
+
+constexpr fast64 Fixed_rangeMin(fast64 a, fast64 b){ return (a < b) ? a : b;}
+constexpr fast64 Fixed_rangeMax(fast64 a, fast64 b){ return (a > b) ? a : b;}
+
+// Fewest INT bits that hold lo and hi, which is hi < 2^INT and
+// lo >= -2^INT
+constexpr fastu16 Fixed_rangeIntBits(fast64 lo, fast64 hi){
+    const fastu64 high = (hi > 0) ? CAST<fastu64>(hi) : 0;
+    const fastu64 low = (lo < 0) ? CAST<fastu64>(-(lo + 1)) : 0;
+
+    fastu16 bits = 1;
+    while((high >> bits) != 0 || (low >> bits) != 0) bits++;
+    return bits;
+}
+
+
+
+// **************************************************************
+//                       Format Selection
+// **************************************************************
+template<fast64 LO, fast64 HI, fastu16 FRAC = 1,
+         FixedOverflow OVER = FIXED_WRAP>
+struct FixedSelect{
+    static_assert(LO <= HI, "FixedRange.h: LO needs to be <= HI");
+
+    const static bool SIGN = LO < 0;
+    const static fastu16 INT = Fixed_rangeIntBits(LO, HI);
+    const static fastu16 NEED = INT + ((FRAC > 0) ? FRAC : 1);
+
+    static_assert(INT <= 62, "FixedRange.h: Range needs to be under 2^62");
+    static_assert(NEED <= 64 - SIGN,
+                  "FixedRange.h: Range and resolution need more than 64 "
+                  "bits, lower FRAC");
+
+    const static fastu16 BITS =
+        (NEED <= 8 - SIGN) ? 8 - SIGN : (NEED <= 16 - SIGN) ? 16 - SIGN :
+        (NEED <= 32 - SIGN) ? 32 - SIGN : 64 - SIGN;
+
+    typedef Fixed<INT, BITS - INT, SIGN, OVER> type;
+};
+
+// Moves raw from a FROM number to the format of TO, cutting off FRAC bits
+// that do not fit. The number has to be in range of TO.
+template<class TO, class FROM> constexpr TO Fixed_rangeCast(const FROM &num){
+    typedef typename TO::fixSize fixSize;
+    typedef typename TO::ufixSize ufixSize;
+    const fastu16 up = (TO::FRAC_BITS > FROM::FRAC_BITS) ?
+                       TO::FRAC_BITS - FROM::FRAC_BITS : 0;
+    const fastu16 down = (FROM::FRAC_BITS > TO::FRAC_BITS) ?
+                         FROM::FRAC_BITS - TO::FRAC_BITS : 0;
+
+    TO ret;
+    ret.setRawNumber(CAST<fixSize>(CAST<ufixSize>(
+                     CAST<fixSize>(num.getRawNumber() >> down)) << up));
+    return ret;
+}
+
+
+
+// **************************************************************
+//                        Ranged Numbers
+// **************************************************************
+template<fast64 LO, fast64 HI, fastu16 FRAC = 1,
+         FixedOverflow OVER = FIXED_WRAP>
+class FixedRanged{
+public:
+    typedef typename FixedSelect<LO, HI, FRAC, OVER>::type type;
+
+    const static fast64 MIN = LO;
+    const static fast64 MAX = HI;
+    const static fastu16 RESOLUTION = FRAC;
+
+    constexpr FixedRanged(): value(){}
+    constexpr FixedRanged(const type &num): value(num){
+        assert(num >= type(CAST<double>(LO)) && num <= type(CAST<double>(HI)));
+    }
+    constexpr FixedRanged(int num): FixedRanged(type(num)){}
+    constexpr FixedRanged(double num): FixedRanged(type(num)){}
+
+    // Implicit from a range inside this one, explicit from any other
+    template<fast64 LO2, fast64 HI2, fastu16 FRAC2, FixedOverflow OVER2,
+             typename std::enable_if<(LO2 >= LO && HI2 <= HI), int>::type = 0>
+    constexpr FixedRanged(const FixedRanged<LO2, HI2, FRAC2, OVER2> &num):
+        value(Fixed_rangeCast<type>(num.get())){}
+
+    template<fast64 LO2, fast64 HI2, fastu16 FRAC2, FixedOverflow OVER2,
+             typename std::enable_if<!(LO2 >= LO && HI2 <= HI), int>::type = 0>
+    constexpr explicit FixedRanged(
+        const FixedRanged<LO2, HI2, FRAC2, OVER2> &num):
+        value(Fixed_rangeCast<type>(num.get())){
+        assert(num.toDouble() >= LO && num.toDouble() <= HI);
+    }
+
+    constexpr const type& get() const{ return value;}
+    constexpr double toDouble() const{ return value.toDouble();}
+
+    friend std::ostream& operator<<(std::ostream &out, const FixedRanged &x){
+        return out << x.value;
+    }
+
+private:
+    type value;
+};
+
+// Result types of the ranged operators
+template<class L, class R> struct FixedRangeOp{
+    const static fastu16 FRAC = (L::RESOLUTION > R::RESOLUTION) ?
+                                L::RESOLUTION : R::RESOLUTION;
+    const static FixedOverflow OVER =
+        (L::type::OVERFLOW > R::type::OVERFLOW) ? L::type::OVERFLOW :
+                                                  R::type::OVERFLOW;
+
+    typedef FixedRanged<Fixed_rangeAdd(L::MIN, R::MIN),
+                        Fixed_rangeAdd(L::MAX, R::MAX), FRAC, OVER> sum;
+    typedef FixedRanged<Fixed_rangeAdd(L::MIN, -R::MAX),
+                        Fixed_rangeAdd(L::MAX, -R::MIN), FRAC, OVER> difference;
+    typedef FixedRanged<
+        Fixed_rangeMin(
+            Fixed_rangeMin(Fixed_rangeMul(L::MIN, R::MIN),
+                           Fixed_rangeMul(L::MIN, R::MAX)),
+            Fixed_rangeMin(Fixed_rangeMul(L::MAX, R::MIN),
+                           Fixed_rangeMul(L::MAX, R::MAX))),
+        Fixed_rangeMax(
+            Fixed_rangeMax(Fixed_rangeMul(L::MIN, R::MIN),
+                           Fixed_rangeMul(L::MIN, R::MAX)),
+            Fixed_rangeMax(Fixed_rangeMul(L::MAX, R::MIN),
+                           Fixed_rangeMul(L::MAX, R::MAX))),
+        FRAC, OVER> product;
+};
+
+// Both sides are moved to the result format first, which holds them, so
+// the Fixed + and - can not overflow
+template<fast64 LO_L, fast64 HI_L, fastu16 FRAC_L, FixedOverflow OVER_L,
+         fast64 LO_R, fast64 HI_R, fastu16 FRAC_R, FixedOverflow OVER_R>
+constexpr typename FixedRangeOp<FixedRanged<LO_L, HI_L, FRAC_L, OVER_L>,
+                                FixedRanged<LO_R, HI_R, FRAC_R, OVER_R> >::sum
+operator+(const FixedRanged<LO_L, HI_L, FRAC_L, OVER_L> &L,
+          const FixedRanged<LO_R, HI_R, FRAC_R, OVER_R> &R){
+    typedef typename FixedRangeOp<FixedRanged<LO_L, HI_L, FRAC_L, OVER_L>,
+        FixedRanged<LO_R, HI_R, FRAC_R, OVER_R> >::sum::type type;
+    return Fixed_rangeCast<type>(L.get()) + Fixed_rangeCast<type>(R.get());
+}
+
+template<fast64 LO_L, fast64 HI_L, fastu16 FRAC_L, FixedOverflow OVER_L,
+         fast64 LO_R, fast64 HI_R, fastu16 FRAC_R, FixedOverflow OVER_R>
+constexpr typename FixedRangeOp<FixedRanged<LO_L, HI_L, FRAC_L, OVER_L>,
+    FixedRanged<LO_R, HI_R, FRAC_R, OVER_R> >::difference
+operator-(const FixedRanged<LO_L, HI_L, FRAC_L, OVER_L> &L,
+          const FixedRanged<LO_R, HI_R, FRAC_R, OVER_R> &R){
+    typedef typename FixedRangeOp<FixedRanged<LO_L, HI_L, FRAC_L, OVER_L>,
+        FixedRanged<LO_R, HI_R, FRAC_R, OVER_R> >::difference::type type;
+    return Fixed_rangeCast<type>(L.get()) - Fixed_rangeCast<type>(R.get());
+}
+
+// The exact product from FixedMixed, then cut to the result format
+template<fast64 LO_L, fast64 HI_L, fastu16 FRAC_L, FixedOverflow OVER_L,
+         fast64 LO_R, fast64 HI_R, fastu16 FRAC_R, FixedOverflow OVER_R>
+constexpr typename FixedRangeOp<FixedRanged<LO_L, HI_L, FRAC_L, OVER_L>,
+    FixedRanged<LO_R, HI_R, FRAC_R, OVER_R> >::product
+operator*(const FixedRanged<LO_L, HI_L, FRAC_L, OVER_L> &L,
+          const FixedRanged<LO_R, HI_R, FRAC_R, OVER_R> &R){
+    typedef FixedRanged<LO_L, HI_L, FRAC_L, OVER_L> left;
+    typedef FixedRanged<LO_R, HI_R, FRAC_R, OVER_R> right;
+    typedef typename FixedRangeOp<left, right>::product::type type;
+    return Fixed_rangeCast<type>(
+        FixedMixed<typename left::type, typename right::type>::mul(L.get(),
+                                                                   R.get()));
+}
+
+template<fast64 LO, fast64 HI, fastu16 FRAC, FixedOverflow OVER>
+constexpr FixedRanged<-HI, -LO, FRAC, OVER>
+operator-(const FixedRanged<LO, HI, FRAC, OVER> &x){
+    typedef typename FixedRanged<-HI, -LO, FRAC, OVER>::type type;
+    return -Fixed_rangeCast<type>(x.get());
+}
+
+// Test to make sure the formats are the narrowest legal ones
+static_assert(std::is_same<FixedSelect<-1, 1, 14>::type,
+                           Fixed<1, 14> >::value &&
+              std::is_same<FixedSelect<0, 200, 6>::type,
+                           Fixed<8, 8, UNSIGNED> >::value &&
+              std::is_same<FixedSelect<-1000, 1000, 10>::type,
+                           Fixed<10, 21> >::value &&
+              std::is_same<FixedSelect<-128, 127, 1>::type,
+                           Fixed<7, 8> >::value,
+        "FixedRange.h: FixedSelect picked the wrong format");
+
+// Test to make sure a * b + c keeps its range and value
+static_assert(std::is_same<decltype(FixedRanged<-1, 1, 14>() *
+                                    FixedRanged<-100, 100, 8>() +
+                                    FixedRanged<-10, 10, 8>()),
+                           FixedRanged<-110, 110, 14> >::value,
+        "FixedRange.h: a * b + c has the wrong range");
+static_assert((FixedRanged<-1, 1, 14>(0.75) * FixedRanged<-100, 100, 8>(-3) +
+               FixedRanged<-10, 10, 8>(2.5)).get() ==
+              FixedSelect<-110, 110, 14>::type(0.25),
+        "FixedRange.h: constexpr a * b + c failed");
+
+#endif // FIXEDRANGE_H
@@ -0,0 +1,339 @@
+/*
+ *  @file    FixedResample.h
+ *
+ *  @brief Linear, cubic Hermite and polyphase sinc resamplers
+ *
+ *  DESCRIPTION
+ *
+ * A resampler turns a stream of SAMPLE numbers at inRate into a stream of
+ * OUT numbers at outRate, with weights in the COEFF format:
+ *
+ *     FixedSincResampler<Fixed<1, 14>, Fixed<10, 5> > resample(48000, 44100);
+ *     std::vector<Fixed<10, 5> > out(resample.maxOutput(block));
+ *     const std::size_t made = resample.process(out.data(), in, block);
+ *
+ * process() takes any number of input samples and writes every output
+ * sample they complete, at most maxOutput(count). How the stream is split
+ * into blocks does not change the output.
+ *
+ *     FixedLinearResampler   2 taps, weights 1 - t and t
+ *     FixedHermiteResampler  4 taps, Catmull-Rom cubic Hermite
+ *     FixedSincResampler     Any even number of taps, Blackman windowed sinc
+ *
+ * The phase, where the next output sits between two input samples, is a
+ * FixedResamplePhase, an unsigned Fixed<16, 48>. Every output adds the step,
+ * inRate / outRate rounded up in the last bit, and every input takes away 1.
+ * The ratio can be up to 65535 either way, and after 2^32 outputs the phase
+ * is off by at most 2^-16 samples.
+ *
+ * The sinc resampler keeps a table of 2^phaseBits + 1 rows of taps weights,
+ * one row per phase, and uses the row nearest the phase. Each row is scaled
+ * so its weights add up to exactly 1, so a constant input comes out
+ * unchanged. The cutoff is a fraction of the lower of the two Nyquist
+ * rates, which keeps the images out when downsampling.
+ *
+ * Each weighted sum goes through a FixedFilterAccumulator, see
+ * FixedFilter.h, and is rounded once per output. The output is delayed by
+ * taps / 2 input samples. Every resampler allocates its history and table
+ * once, in the constructor, and process() never allocates.
+ */
+
+
+
+
+#ifndef FIXEDRESAMPLE_H
+#define FIXEDRESAMPLE_H
+
+#include "FixedFilter.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+typedef Fixed<16, 48, UNSIGNED> FixedResamplePhase;
+
+
+
+// **************************************************************
+//                        Shared Streaming
+// **************************************************************
+inline fastu32 Fixed_resampleGcd(fastu32 a, fastu32 b){
+    while(b != 0){
+        const fastu32 next = a % b;
+        a = b;
+        b = next;
+    }
+    return a;
+}
+
+// inRate / outRate, rounded up so there are never more outputs than
+// maxOutput() allows. Both rates are divided by their gcd first.
+inline FixedResamplePhase Fixed_resampleStep(fastu32 inRate, fastu32 outRate){
+    assert(inRate > 0 && outRate > 0);
+    const fastu16 FRAC = FixedResamplePhase::FRAC_BITS;
+    const fastu32 gcd = Fixed_resampleGcd(inRate, outRate);
+    inRate /= gcd;
+    outRate /= gcd;
+
+    // Long division, 24 bits at a time so nothing overflows
+    const fastu64 quot = inRate / outRate;
+    fastu64 rem = inRate % outRate;
+    fastu64 frac = 0;
+    for(fastu16 bits = 0; bits < FRAC; bits += 24){
+        rem <<= 24;
+        frac = (frac << 24) | (rem / outRate);
+        rem %= outRate;
+    }
+    assert(quot < (CAST<fastu64>(1) << FixedResamplePhase::INT_BITS));
+
+    FixedResamplePhase ret;
+    ret.setRawNumber((quot << FRAC) + frac + (rem != 0));
+    return ret;
+}
+
+// History and phase shared by the resamplers. The history is the last taps
+// input samples, kept twice back to back like FixedFir, so the window for
+// an output is one contiguous run from oldest to newest.
+template<class COEFF, class SAMPLE, class OUT> class FixedResampler{
+public:
+    typedef FixedFilterAccumulator<COEFF, SAMPLE> accumulator;
+    typedef typename accumulator::type accSize;
+    typedef typename COEFF::fixSize coeffSize;
+    typedef typename SAMPLE::fixSize sampleSize;
+
+    static_assert(COEFF::IS_SIGNED,
+                  "FixedResample.h: COEFF needs to be signed");
+    static_assert(COEFF::FRAC_BITS <= 30,
+                  "FixedResample.h: COEFF needs 30 FRAC bits or less");
+
+    FixedResampler(const FixedResampler&) = delete;
+    const FixedResampler& operator=(const FixedResampler&) = delete;
+
+    // Most outputs count more input samples can make
+    std::size_t maxOutput(std::size_t count) const{
+        return CAST<std::size_t>((CAST<fastu64>(count) * outRate + inRate - 1) /
+                                 inRate) + 1;
+    }
+
+    // Clears the history and phase, as if every earlier sample was 0
+    void reset(){
+        std::fill(history, history + 2 * taps, CAST<sampleSize>(0));
+        pos = 0;
+        phase = FixedResamplePhase();
+    }
+
+    std::size_t getTaps() const{ return taps;}
+    FixedResamplePhase getStep() const{ return step;}
+
+protected:
+    // The phase rounded to COEFF FRAC bits, 0 to 1 << FRAC
+    static fast64 weight(fastu64 t){
+        const fastu16 SHIFT = FixedResamplePhase::FRAC_BITS - COEFF::FRAC_BITS;
+        return CAST<fast64>((t + (CAST<fastu64>(1) << (SHIFT - 1))) >> SHIFT);
+    }
+
+    FixedResampler(fastu32 inRate, fastu32 outRate, std::size_t taps,
+                   std::size_t tableBytes):
+        arena(2 * taps * sizeof(sampleSize) + tableBytes +
+              2 * FIXED_VECTOR_ALIGN),
+        history(CAST<sampleSize*>(
+            arena.allocate(2 * taps * sizeof(sampleSize)))),
+        taps(taps), pos(0),
+        inRate(inRate / Fixed_resampleGcd(inRate, outRate)),
+        outRate(outRate / Fixed_resampleGcd(inRate, outRate)),
+        step(Fixed_resampleStep(inRate, outRate)){
+
+        assert(taps >= 2 && taps % 2 == 0);
+        reset();
+    }
+
+    // Pushes each input, then writes kernel(window, t) while the phase is
+    // under 1, where t is the phase's raw FRAC bits. window[taps / 2 - 1]
+    // is the sample just before the output.
+    template<class KERNEL>
+    std::size_t run(OUT *dst, const SAMPLE *src, std::size_t count,
+                    KERNEL kernel){
+        const FixedResamplePhase one(1);
+        std::size_t made = 0;
+        for(std::size_t i = 0; i < count; i++){
+            history[pos] = history[pos + taps] = src[i].getRawNumber();
+            pos = (pos + 1 == taps) ? 0 : pos + 1;
+
+            const sampleSize *window = history + pos;
+            while(phase < one){
+                dst[made++] = kernel(window, phase.getRawNumber());
+                phase += step;
+            }
+            phase -= one;
+        }
+        return made;
+    }
+
+    FixedArena arena;
+    sampleSize *history;
+    std::size_t taps;
+    std::size_t pos;
+    fastu64 inRate;
+    fastu64 outRate;
+    FixedResamplePhase step;
+    FixedResamplePhase phase;
+};
+
+
+
+// **************************************************************
+//                      Linear Interpolation
+// **************************************************************
+template<class COEFF, class SAMPLE, class OUT = SAMPLE>
+class FixedLinearResampler: public FixedResampler<COEFF, SAMPLE, OUT>{
+public:
+    typedef FixedResampler<COEFF, SAMPLE, OUT> base;
+    typedef typename base::accumulator accumulator;
+    typedef typename base::sampleSize sampleSize;
+
+    FixedLinearResampler(fastu32 inRate, fastu32 outRate):
+        base(inRate, outRate, 2, 0){}
+
+    std::size_t process(OUT *dst, const SAMPLE *src, std::size_t count){
+        return this->run(dst, src, count, [](const sampleSize *w, fastu64 t){
+            const fast64 ONE = CAST<fast64>(1) << COEFF::FRAC_BITS;
+            const fast64 frac = base::weight(t);
+            return accumulator::template round<OUT>(
+                accumulator::mul(ONE - frac, w[0]) +
+                accumulator::mul(frac, w[1]));
+        });
+    }
+};
+
+
+
+// **************************************************************
+//                     Cubic Hermite (Catmull-Rom)
+// **************************************************************
+// y = w0 * x[-1] + w1 * x[0] + w2 * x[1] + w3 * x[2], with t = phase
+//
+//     w0 = (-t^3 + 2t^2 - t) / 2     w2 = (-3t^3 + 4t^2 + t) / 2
+//     w1 = 1 - w0 - w2 - w3          w3 = (t^3 - t^2) / 2
+//
+// The weights are worked out per output in COEFF FRAC bits. w1 takes the
+// rounding of the others, so they always add up to exactly 1.
+template<class COEFF, class SAMPLE, class OUT = SAMPLE>
+class FixedHermiteResampler: public FixedResampler<COEFF, SAMPLE, OUT>{
+public:
+    typedef FixedResampler<COEFF, SAMPLE, OUT> base;
+    typedef typename base::accumulator accumulator;
+    typedef typename base::sampleSize sampleSize;
+
+    FixedHermiteResampler(fastu32 inRate, fastu32 outRate):
+        base(inRate, outRate, 4, 0){}
+
+    std::size_t process(OUT *dst, const SAMPLE *src, std::size_t count){
+        return this->run(dst, src, count, [](const sampleSize *w, fastu64 t){
+            const fastu16 FRAC = COEFF::FRAC_BITS;
+            const fast64 ONE = CAST<fast64>(1) << FRAC;
+            const fast64 HALF = ONE >> 1;
+            const fast64 t1 = base::weight(t);
+            const fast64 t2 = (t1 * t1 + HALF) >> FRAC;
+            const fast64 t3 = (t2 * t1 + HALF) >> FRAC;
+
+            const fast64 w0 = (2 * t2 - t3 - t1 + 1) >> 1;
+            const fast64 w2 = (4 * t2 - 3 * t3 + t1 + 1) >> 1;
+            const fast64 w3 = (t3 - t2 + 1) >> 1;
+            const fast64 w1 = ONE - w0 - w2 - w3;
+            return accumulator::template round<OUT>(
+                accumulator::mul(w0, w[0]) + accumulator::mul(w1, w[1]) +
+                accumulator::mul(w2, w[2]) + accumulator::mul(w3, w[3]));
+        });
+    }
+};
+
+
+
+// **************************************************************
+//                   Polyphase Windowed Sinc
+// **************************************************************
+// Row r of the table is the filter for t = r / 2^phaseBits. Tap k weighs
+// the input d = k - (taps / 2 - 1) - t samples from the output:
+//
+//     h(d) = fc * sinc(fc * d) * blackman(d / (taps / 2))
+//
+// with fc = cutoff * min(1, outRate / inRate).
+template<class COEFF, class SAMPLE, class OUT = SAMPLE>
+class FixedSincResampler: public FixedResampler<COEFF, SAMPLE, OUT>{
+public:
+    typedef FixedResampler<COEFF, SAMPLE, OUT> base;
+    typedef typename base::accumulator accumulator;
+    typedef typename base::accSize accSize;
+    typedef typename base::coeffSize coeffSize;
+    typedef typename base::sampleSize sampleSize;
+
+    FixedSincResampler(fastu32 inRate, fastu32 outRate, std::size_t taps = 16,
+                       fastu16 phaseBits = 8, double cutoff = 0.9):
+        base(inRate, outRate, taps,
+             ((CAST<std::size_t>(1) << phaseBits) + 1) * taps *
+             sizeof(coeffSize)),
+        table(CAST<coeffSize*>(this->arena.allocate(
+            ((CAST<std::size_t>(1) << phaseBits) + 1) * taps *
+            sizeof(coeffSize)))),
+        phaseBits(phaseBits){
+
+        assert(phaseBits > 0 && phaseBits < FixedResamplePhase::FRAC_BITS);
+        const double fc = cutoff * std::fmin(1.0, CAST<double>(outRate) /
+                                                  inRate);
+        const double one = std::ldexp(1.0, COEFF::FRAC_BITS);
+        const std::size_t rows = (CAST<std::size_t>(1) << phaseBits) + 1;
+
+        for(std::size_t r = 0; r < rows; r++){
+            const double t = CAST<double>(r) / (rows - 1);
+            double sum = 0;
+            for(std::size_t k = 0; k < taps; k++)
+                sum += sincWeight(k, t, fc, taps);
+
+            // Round each weight, then give what is left to the largest
+            coeffSize *dst = table + r * taps;
+            fast64 total = 0;
+            std::size_t largest = 0;
+            for(std::size_t k = 0; k < taps; k++){
+                dst[k] = CAST<coeffSize>(std::lround(
+                    sincWeight(k, t, fc, taps) / sum * one));
+                total += dst[k];
+                if(dst[k] > dst[largest]) largest = k;
+            }
+            dst[largest] = CAST<coeffSize>(dst[largest] +
+                                           (CAST<fast64>(one) - total));
+        }
+    }
+
+    std::size_t process(OUT *dst, const SAMPLE *src, std::size_t count){
+        const coeffSize *coeffs = table;
+        const std::size_t taps = this->taps;
+        const fastu16 shift = FixedResamplePhase::FRAC_BITS - phaseBits;
+        const fastu64 half = CAST<fastu64>(1) << (shift - 1);
+
+        return this->run(dst, src, count, [=](const sampleSize *w, fastu64 t){
+            const coeffSize *c = coeffs + ((t + half) >> shift) * taps;
+            accSize acc = 0;
+            for(std::size_t k = 0; k < taps; k++)
+                acc += accumulator::mul(c[k], w[k]);
+            return accumulator::template round<OUT>(acc);
+        });
+    }
+
+    fastu16 getPhaseBits() const{ return phaseBits;}
+
+private:
+    static double sincWeight(std::size_t k, double t, double fc,
+                             std::size_t taps){
+        const double PI = 3.14159265358979323846;
+        const double d = CAST<double>(k) - (CAST<double>(taps / 2) - 1) - t;
+        const double x = PI * fc * d;
+        const double win = 2 * d / taps;
+        return fc * ((x == 0) ? 1 : std::sin(x) / x) *
+               (0.42 + 0.5 * std::cos(PI * win) +
+                0.08 * std::cos(2 * PI * win));
+    }
+
+    coeffSize *table;
+    fastu16 phaseBits;
+};
+
+#endif // FIXEDRESAMPLE_H
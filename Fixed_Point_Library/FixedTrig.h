@@ -0,0 +1,374 @@
+/*
+ *  @file    FixedTrig.h
+ *
+ *  @brief Selectable table and CORDIC engines for sine and cosine
+ *
+ *  DESCRIPTION
+ *
+ * Fixed_sincos<ENGINE>(x, s, c) returns sin(x) and cos(x) in one call, using
+ * one of three engines:
+ *
+ *     FIXED_TRIG_POLY    Fixed_sin/Fixed_cos from FixedMath.h (two calls)
+ *     FIXED_TRIG_TABLE   Sine table with linear interpolation
+ *     FIXED_TRIG_CORDIC  Iterative CORDIC rotation
+ *
+ * If no engine is given, FIXED_TRIG_ENGINE is used. Fixed_atan2Cordic and
+ * Fixed_atanCordic use CORDIC vectoring, and unlike Fixed_atan they are valid
+ * for any input.
+ *
+ * The table and CORDIC engines first turn x into a 32 bit phase, where 2^32
+ * is one full turn. This does the range reduction with one multiply, and
+ * wraps for free, instead of the while loops in Fixed_sin. Both engines then
+ * work on Q1.30 numbers, so formats with more FRAC bits do not gain from
+ * them: the table engine is within about 5e-9 (2^-27) and CORDIC within
+ * about 2e-8 (2^-25). Only formats up to 64 bits are supported.
+ *
+ * Both engines size themselves from FRAC:
+ *   Table:  2^((FRAC + 5) / 2) entries, clamped to 64..4096 (max 16KB).
+ *           Past 19 FRAC bits a second order step using the cosine entry
+ *           replaces linear interpolation, which floors at about 3e-7.
+ *   CORDIC: FRAC + 2 iterations, clamped to 30
+ *
+ * The tables are built at compile time, so this file needs C++14.
+ */
+
+
+
+
+#ifndef FIXEDTRIG_H
+#define FIXEDTRIG_H
+
+#include "FixedMath.h"
+
+enum FixedTrigEngine{
+    FIXED_TRIG_POLY,
+    FIXED_TRIG_TABLE,
+    FIXED_TRIG_CORDIC
+};
+
+// Engine used by Fixed_sincos when one is not given
+#define FIXED_TRIG_ENGINE FIXED_TRIG_TABLE
+
+// 2^64 / (2 * pi), turns radians into a phase
+#define FIXED_INV_2PI_Q64 0x28BE60DB9391054AULL
+
+// 2 * pi * 2^28, turns a phase back into radians
+#define FIXED_2PI_Q28 1686629713LL
+
+
+
+// **************************************************************
+//                  Compile Time Table Helpers
+// **************************************************************
+// These use double math and are only run by the compiler
+constexpr double FIXED_CONST_PI = 3.14159265358979323846264;
+
+constexpr double Fixed_constSin(double x){
+    while(x > FIXED_CONST_PI)  x -= 2 * FIXED_CONST_PI;
+    while(x < -FIXED_CONST_PI) x += 2 * FIXED_CONST_PI;
+
+    // Fold into [-pi/2, pi/2] where the series converges quickly
+    if(x > FIXED_CONST_PI / 2)       x = FIXED_CONST_PI - x;
+    else if(x < -FIXED_CONST_PI / 2) x = -FIXED_CONST_PI - x;
+
+    double term = x, sum = x;
+    for(fast32 n = 1; n < 15; n++){
+        term *= -x * x / ((2 * n) * (2 * n + 1));
+        sum += term;
+    }
+    return sum;
+}
+
+// Only valid in [0, 1]
+constexpr double Fixed_constAtan(double x){
+    if(x == 1.0) return FIXED_CONST_PI / 4;
+
+    double term = x, sum = x;
+    for(fast32 n = 1; n < 40; n++){
+        term *= -x * x;
+        sum += term / (2 * n + 1);
+    }
+    return sum;
+}
+
+constexpr double Fixed_constSqrt(double x){
+    double guess = (x > 1.0) ? x : 1.0;
+    for(fast32 i = 0; i < 64; i++) guess = (guess + x / guess) / 2;
+    return guess;
+}
+
+constexpr fast32 Fixed_constRound(double x){
+    return CAST<fast32>((x >= 0) ? x + 0.5 : x - 0.5);
+}
+
+// sin over one full turn, in Q1.30, with one extra entry for interpolation
+template<fastu16 BITS> struct FixedSinTable{
+    fast32 value[(1 << BITS) + 1];
+
+    constexpr FixedSinTable(): value(){
+        for(fast32 i = 0; i <= (1 << BITS); i++)
+            value[i] = Fixed_constRound(
+                Fixed_constSin(2 * FIXED_CONST_PI * i / (1 << BITS)) *
+                (1 << 30));
+    }
+};
+
+// atan(2^-i) as a phase, and the CORDIC gain for ITER iterations in Q1.30
+template<fastu16 ITER> struct FixedCordicTable{
+    fast32 angle[ITER];
+    fast32 gain;
+
+    constexpr FixedCordicTable(): angle(), gain(0){
+        double k = 1.0, pow2 = 1.0;
+        for(fastu16 i = 0; i < ITER; i++){
+            angle[i] = CAST<fast32>(CAST<fast64>(
+                Fixed_constAtan(pow2) / (2 * FIXED_CONST_PI) * 4294967296.0
+                + 0.5));
+            k /= Fixed_constSqrt(1.0 + pow2 * pow2);
+            pow2 /= 2;
+        }
+        gain = Fixed_constRound(k * (1 << 30));
+    }
+};
+
+// Holds one copy of each table, shared by every format that uses it
+template<fastu16 BITS> struct FixedTrigTables{
+    static constexpr FixedSinTable<BITS> sine{};
+    static constexpr FixedCordicTable<BITS> cordic{};
+};
+template<fastu16 BITS>
+constexpr FixedSinTable<BITS> FixedTrigTables<BITS>::sine;
+template<fastu16 BITS>
+constexpr FixedCordicTable<BITS> FixedTrigTables<BITS>::cordic;
+
+
+
+// **************************************************************
+//                     Phase Conversion Functions
+// **************************************************************
+// Radians to phase, where 2^32 is one turn: phase = raw * 2^32 / (2 pi 2^FRAC)
+template<fastu16 FRAC, class T>
+fastu32 Fixed_toPhase(T raw){
+    // A FixedInt128 raw number would be cut to 64 bits below
+    static_assert(sizeof(T) <= 8,
+                  "FixedTrig.h: only formats up to 64 bits are supported");
+
+    const bool negative = raw < 0;
+    const fastu64 mag = (negative) ? -CAST<fastu64>(raw) : CAST<fastu64>(raw);
+    const fastu64 invHi = FIXED_INV_2PI_Q64 >> 32;
+    const fastu64 invLo = FIXED_INV_2PI_Q64 & 0xFFFFFFFF;
+    fastu32 phase = 0;
+
+    if(sizeof(T) <= 4){
+        // 32x64 bit product, the low bits of mag * invLo are shifted out
+        const fastu64 hi = mag * invHi;
+        const fastu64 lo = mag * invLo;
+        phase = CAST<fastu32>((hi + (lo >> 32)) >> FRAC);
+    }
+    else{
+        // 64x64 -> 128 bit product from 32 bit halves
+        const fastu64 magHi = mag >> 32, magLo = mag & 0xFFFFFFFF;
+        const fastu64 lolo = magLo * invLo, lohi = magLo * invHi;
+        const fastu64 hilo = magHi * invLo, hihi = magHi * invHi;
+        const fastu64 mid = (lolo >> 32) + (lohi & 0xFFFFFFFF) +
+                            (hilo & 0xFFFFFFFF);
+        const fastu64 hi = hihi + (lohi >> 32) + (hilo >> 32) + (mid >> 32);
+        const fastu64 lo = (mid << 32) | (lolo & 0xFFFFFFFF);
+
+        const fastu16 shift = FRAC + 32;
+        phase = (shift >= 64) ?
+            CAST<fastu32>(hi >> (shift - 64)) :
+            CAST<fastu32>((hi << (64 - shift)) | (lo >> shift));
+    }
+
+    return (negative) ? 0u - phase : phase;
+}
+
+// Signed phase to radians, phase can be +2^31 to return +pi
+template<fastu16 INT, fastu16 FRAC>
+Fixed<INT, FRAC> Fixed_fromPhase(fast64 phase){
+    // phase * 2pi * 2^28 is a Q60 number of radians
+    static const fastu16 down = (FRAC < 60) ? 60 - FRAC : 0;
+    static const fastu16 up   = (FRAC > 60) ? FRAC - 60 : 0;
+    const fast64 rads = phase * FIXED_2PI_Q28;
+
+    Fixed<INT, FRAC> ret;
+    ret.setRawNumber(
+        ((rads + ((CAST<fast64>(1) << down) >> 1)) >> down) << up);
+    return ret;
+}
+
+// Q1.30 to Fixed, rounding to nearest
+template<fastu16 INT, fastu16 FRAC>
+Fixed<INT, FRAC> Fixed_fromQ30(fast32 num){
+    static const fastu16 down = (FRAC < 30) ? 30 - FRAC : 0;
+    static const fastu16 up   = (FRAC > 30) ? FRAC - 30 : 0;
+
+    Fixed<INT, FRAC> ret;
+    ret.setRawNumber(((CAST<fast64>(num) + ((CAST<fast64>(1) << down) >> 1))
+                        >> down) << up);
+    return ret;
+}
+
+
+
+// **************************************************************
+//                          Trig Engines
+// **************************************************************
+template<FixedTrigEngine ENGINE, fastu16 INT, fastu16 FRAC> class FixedTrig;
+
+// The existing quadratic approximation, kept as the baseline
+template<fastu16 INT, fastu16 FRAC>
+class FixedTrig<FIXED_TRIG_POLY, INT, FRAC>{
+public:
+    static void sincos(const Fixed<INT, FRAC> &x,
+                       Fixed<INT, FRAC> &s, Fixed<INT, FRAC> &c){
+        s = Fixed_sin<INT, FRAC>(x);
+        c = Fixed_cos<INT, FRAC>(x);
+    }
+};
+
+template<fastu16 INT, fastu16 FRAC>
+class FixedTrig<FIXED_TRIG_TABLE, INT, FRAC>{
+public:
+    static const fastu16 TABLE_BITS =
+        ((FRAC + 5) / 2 < 6) ? 6 : ((FRAC + 5) / 2 > 12) ? 12 : (FRAC + 5) / 2;
+
+    // Past 19 FRAC bits the table stops growing, and linear interpolation
+    // floors at about 3e-7, so those formats use the second order step
+    static const bool SECOND_ORDER = (FRAC + 5) / 2 > 12;
+
+    static void sincos(const Fixed<INT, FRAC> &x,
+                       Fixed<INT, FRAC> &s, Fixed<INT, FRAC> &c){
+        const fastu32 phase = Fixed_toPhase<FRAC>(x.getRawNumber());
+        s = Fixed_fromQ30<INT, FRAC>(lookup(phase));
+        c = Fixed_fromQ30<INT, FRAC>(lookup(phase + (1u << 30)));
+    }
+
+private:
+    static fast32 lookup(fastu32 phase){
+        const fast32 *table = FixedTrigTables<TABLE_BITS>::sine.value;
+        const fastu32 index = phase >> (32 - TABLE_BITS);
+        if(SECOND_ORDER) return lookupSecondOrder(table, index, phase);
+        const fast64 frac = (phase >> (16 - TABLE_BITS)) & 0xFFFF;
+        const fast32 a = table[index], b = table[index + 1];
+
+        return a + CAST<fast32>(((b - a) * frac) >> 16);
+    }
+
+    // sin(a + d) = sin(a) + cos(a) d - sin(a) d^2 / 2, where cos(a) is the
+    // entry a quarter turn on and d is under 2pi / 4096. The d^3 term left
+    // out is under an LSB of Q1.30.
+    static fast32 lookupSecondOrder(const fast32 *table, fastu32 index,
+                                    fastu32 phase){
+        static const fastu32 SIZE = CAST<fastu32>(1) << TABLE_BITS;
+        const fast64 sine = table[index];
+        const fast64 cosine = table[(index + SIZE / 4) & (SIZE - 1)];
+
+        // The rest of the phase in Q1.30 radians, and d^2 / 2
+        const fast64 rest =
+            phase & ((CAST<fastu32>(1) << (32 - TABLE_BITS)) - 1);
+        const fast64 d = (rest * FIXED_2PI_Q28 + (1 << 29)) >> 30;
+        const fast64 half = (d * d) >> 31;
+
+        return CAST<fast32>(
+            sine + ((cosine * d - sine * half + (1 << 29)) >> 30));
+    }
+};
+
+template<fastu16 INT, fastu16 FRAC>
+class FixedTrig<FIXED_TRIG_CORDIC, INT, FRAC>{
+public:
+    static const fastu16 ITERATIONS = (FRAC + 2 > 30) ? 30 : FRAC + 2;
+
+    static void sincos(const Fixed<INT, FRAC> &x,
+                       Fixed<INT, FRAC> &s, Fixed<INT, FRAC> &c){
+        const FixedCordicTable<ITERATIONS> &table =
+            FixedTrigTables<ITERATIONS>::cordic;
+
+        fast32 z = CAST<fast32>(Fixed_toPhase<FRAC>(x.getRawNumber()));
+
+        // CORDIC only converges up to ~1.74 rads, so fold into
+        // [-pi/2, pi/2] by rotating pi and flipping the results
+        const bool flip = (z > (1 << 30) || z < -(1 << 30));
+        if(flip) z = CAST<fast32>(CAST<fastu32>(z) + (1u << 31));
+
+        fast32 cx = table.gain, cy = 0;
+        for(fastu16 i = 0; i < ITERATIONS; i++){
+            // Branchless rotation direction: m is 0 for z >= 0, else -1
+            const fast32 m = z >> 31;
+            const fast32 dx = cx >> i, dy = cy >> i;
+            cx -= (dy ^ m) - m;
+            cy += (dx ^ m) - m;
+            z  -= (table.angle[i] ^ m) - m;
+        }
+
+        s = Fixed_fromQ30<INT, FRAC>((flip) ? -cy : cy);
+        c = Fixed_fromQ30<INT, FRAC>((flip) ? -cx : cx);
+    }
+
+    static Fixed<INT, FRAC> atan2(const Fixed<INT, FRAC> &y,
+                                  const Fixed<INT, FRAC> &x){
+        const FixedCordicTable<ITERATIONS> &table =
+            FixedTrigTables<ITERATIONS>::cordic;
+
+        fast64 vx = x.getRawNumber(), vy = y.getRawNumber();
+        if(vx == 0 && vy == 0) return Fixed<INT, FRAC>(0);
+
+        // atan2 does not care about scale, so normalize to leave headroom
+        // for the CORDIC gain (~1.65) and the sqrt(2) of the vector length
+        fastu64 mag = ((vx < 0) ? -CAST<fastu64>(vx) : CAST<fastu64>(vx)) |
+                      ((vy < 0) ? -CAST<fastu64>(vy) : CAST<fastu64>(vy));
+        while(mag >= (1u << 28)){ vx >>= 1; vy >>= 1; mag >>= 1;}
+        while(mag < (1u << 27)){ vx <<= 1; vy <<= 1; mag <<= 1;}
+
+        // Left half plane, rotate by pi first. z wraps, so keep it unsigned
+        fastu32 z = 0;
+        if(vx < 0){
+            vx = -vx;
+            vy = -vy;
+            z = 1u << 31;
+        }
+
+        fast32 cx = CAST<fast32>(vx), cy = CAST<fast32>(vy);
+        for(fastu16 i = 0; i < ITERATIONS; i++){
+            // Rotate towards y = 0: m is 0 for y < 0, else -1
+            const fast32 m = ~(cy >> 31);
+            const fast32 dx = cx >> i, dy = cy >> i;
+            cx -= (dy ^ m) - m;
+            cy += (dx ^ m) - m;
+            z  -= CAST<fastu32>((table.angle[i] ^ m) - m);
+        }
+
+        // Keep atan2(0, -x) at +pi like Fixed_atan2
+        fast64 phase = CAST<fast32>(z);
+        if(phase == -(CAST<fast64>(1) << 31) && !y.isNegative()) phase = -phase;
+
+        return Fixed_fromPhase<INT, FRAC>(phase);
+    }
+};
+
+
+
+// **************************************************************
+//                         Trig Functions
+// **************************************************************
+template<FixedTrigEngine ENGINE = FIXED_TRIG_ENGINE,
+         fastu16 INT, fastu16 FRAC>
+void Fixed_sincos(const Fixed<INT, FRAC> &x,
+                  Fixed<INT, FRAC> &s, Fixed<INT, FRAC> &c){
+    FixedTrig<ENGINE, INT, FRAC>::sincos(x, s, c);
+}
+
+template<fastu16 INT, fastu16 FRAC>
+Fixed<INT, FRAC> Fixed_atan2Cordic(const Fixed<INT, FRAC> &y,
+                                   const Fixed<INT, FRAC> &x){
+    return FixedTrig<FIXED_TRIG_CORDIC, INT, FRAC>::atan2(y, x);
+}
+
+template<fastu16 INT, fastu16 FRAC>
+Fixed<INT, FRAC> Fixed_atanCordic(const Fixed<INT, FRAC> &x){
+    return FixedTrig<FIXED_TRIG_CORDIC, INT, FRAC>::atan2(x, 1);
+}
+
+#endif // FIXEDTRIG_H
@@ -0,0 +1,331 @@
+/*
+ *  @file    FixedVector.h
+ *
+ *  @brief Aligned structure-of-arrays storage for Fixed numbers
+ *
+ *  DESCRIPTION
+ *
+ * A FixedVector<INT, FRAC, SIGN, OVER> holds count raw fixSize numbers in one
+ * contiguous block, aligned to FIXED_VECTOR_ALIGN bytes (64, one cache line,
+ * by default). A Fixed<4, 3> buffer is one byte per element, so 64 samples
+ * fit in a single cache line and a single AVX2 register holds 32 of them.
+ *
+ * The memory comes from a FixedArena. A FixedVector can either make its own
+ * arena, or be carved out of a shared one so several buffers sit next to
+ * each other and are freed together:
+ *
+ *     FixedArena arena(16384);
+ *     FixedVector<10, 5> samples(arena, 1024), gains(arena, 1024);
+ *
+ * Indexing returns a proxy that reads and writes a Fixed, so the usual
+ * operators keep working on single elements:
+ *
+ *     samples[i] = samples[i] * gains[i] + Fixed<10, 5>(0.5);
+ *     samples[i] += gains[i];
+ *
+ * Whole vectors use the batch kernels from FixedBatch.h, and fromFloat(),
+ * toFloat(), fromDouble() and toDouble() convert whole buffers at once.
+ * Like the batch kernels, it only takes formats up to 64 bits.
+ */
+
+
+
+
+#ifndef FIXEDVECTOR_H
+#define FIXEDVECTOR_H
+
+#define FIXED_VECTOR_ALIGN 64 // Use 32 for AVX2 alignment only
+
+#include "FixedBatch.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <memory>
+#include <new>
+
+static_assert(FIXED_VECTOR_ALIGN == 32 || FIXED_VECTOR_ALIGN == 64,
+              "Invalid value for FIXED_VECTOR_ALIGN");
+
+
+
+// **************************************************************
+//                          Arena Memory
+// **************************************************************
+// Bump allocator over one aligned block. Allocations are only given back
+// all at once, with reset() or when the arena is destroyed.
+class FixedArena{
+public:
+    explicit FixedArena(std::size_t bytes):
+        block(new char[roundUp(bytes) + FIXED_VECTOR_ALIGN]), base(block),
+        capacity(roundUp(bytes) + FIXED_VECTOR_ALIGN), offset(0){
+
+        void *ptr = base;
+        std::align(FIXED_VECTOR_ALIGN, roundUp(bytes), ptr, capacity);
+        base = CAST<char*>(ptr);
+    }
+    ~FixedArena(){ delete[] block;}
+
+    FixedArena(const FixedArena&) = delete;
+    const FixedArena& operator=(const FixedArena&) = delete;
+
+    // Returns nullptr if the arena does not have room left
+    void* allocate(std::size_t bytes){
+        // Round up so the next allocation stays aligned
+        const std::size_t size = roundUp(bytes);
+        if(size > capacity - offset) return nullptr;
+
+        void *ret = base + offset;
+        offset += size;
+        return ret;
+    }
+
+    void reset(){ offset = 0;}
+
+    std::size_t getUsed() const{ return offset;}
+    std::size_t getCapacity() const{ return capacity;}
+
+private:
+    static std::size_t roundUp(std::size_t bytes){
+        return (bytes + FIXED_VECTOR_ALIGN - 1) &
+               ~CAST<std::size_t>(FIXED_VECTOR_ALIGN - 1);
+    }
+
+    char *block;
+    char *base;
+    std::size_t capacity;
+    std::size_t offset;
+};
+
+
+
+// **************************************************************
+//                    Structure-of-Arrays Vector
+// **************************************************************
+template<fastu16 _INT, fastu16 _FRAC, bool _SIGN = SIGNED,
+         FixedOverflow _OVER = FIXED_WRAP> class FixedVector{
+public:
+    typedef Fixed<_INT, _FRAC, _SIGN, _OVER> fixed;
+    typedef FixedBatch<_INT, _FRAC, _SIGN, _OVER> batch;
+    typedef typename fixed::fixSize fixSize;
+
+    static_assert(_INT + _FRAC + _SIGN <= 64,
+                  "FixedVector.h: only formats up to 64 bits can be stored");
+
+    // Element proxy, reads and writes one raw number as a Fixed
+    class reference{
+    public:
+        operator fixed() const{
+            fixed ret;
+            ret.setRawNumber(*num);
+            return ret;
+        }
+
+        const reference& operator=(const fixed &R) const{
+            *num = R.getRawNumber();
+            return *this;
+        }
+        const reference& operator=(const reference &R) const{
+            *num = *R.num;
+            return *this;
+        }
+
+        void operator+=(const fixed &R) const{ *this = fixed(*this) + R;}
+        void operator-=(const fixed &R) const{ *this = fixed(*this) - R;}
+        void operator*=(const fixed &R) const{ *this = fixed(*this) * R;}
+        void operator/=(const fixed &R) const{ *this = fixed(*this) / R;}
+
+        fixSize getRawNumber() const{ return *num;}
+        void setRawNumber(fixSize R) const{ *num = R;}
+
+        float toFloat() const{ return fixed(*this).toFloat();}
+        double toDouble() const{ return fixed(*this).toDouble();}
+
+        // The operators of Fixed are hidden friends, so they are not found
+        // through the proxy. Forward them here instead.
+        #define FIXED_REFERENCE_OPERATOR(OP, RET)                              \
+        friend RET operator OP(const reference &L, const reference &R){       \
+            return fixed(L) OP fixed(R);                                       \
+        }                                                                      \
+        friend RET operator OP(const reference &L, const fixed &R){           \
+            return fixed(L) OP R;                                              \
+        }                                                                      \
+        friend RET operator OP(const fixed &L, const reference &R){           \
+            return L OP fixed(R);                                              \
+        }
+
+        FIXED_REFERENCE_OPERATOR(+, fixed)
+        FIXED_REFERENCE_OPERATOR(-, fixed)
+        FIXED_REFERENCE_OPERATOR(*, fixed)
+        FIXED_REFERENCE_OPERATOR(/, fixed)
+        FIXED_REFERENCE_OPERATOR(>, bool)
+        FIXED_REFERENCE_OPERATOR(<, bool)
+        FIXED_REFERENCE_OPERATOR(>=, bool)
+        FIXED_REFERENCE_OPERATOR(<=, bool)
+        FIXED_REFERENCE_OPERATOR(!=, bool)
+        FIXED_REFERENCE_OPERATOR(==, bool)
+
+        #undef FIXED_REFERENCE_OPERATOR
+
+        friend std::ostream& operator<<(std::ostream &out, const reference &R){
+            return out << fixed(R);
+        }
+
+    private:
+        friend class FixedVector;
+        explicit reference(fixSize *ptr): num(ptr){}
+
+        fixSize *num;
+    };
+
+    // **************************************************************
+    //                          Constructors
+    // **************************************************************
+    // Uses its own arena
+    explicit FixedVector(std::size_t count):
+        ownArena(new FixedArena(count * sizeof(fixSize))),
+        number(CAST<fixSize*>(ownArena->allocate(count * sizeof(fixSize)))),
+        count(count){
+
+        std::fill(number, number + count, TO_SFIX(0));
+    }
+
+    // Uses memory from a shared arena, which has to outlive the vector
+    FixedVector(FixedArena &arena, std::size_t count):
+        ownArena(nullptr),
+        number(CAST<fixSize*>(arena.allocate(count * sizeof(fixSize)))),
+        count(count){
+
+        if(number == nullptr) throw std::bad_alloc();
+        std::fill(number, number + count, TO_SFIX(0));
+    }
+
+    FixedVector(FixedVector &&R):
+        ownArena(R.ownArena), number(R.number), count(R.count){
+        R.ownArena = nullptr;
+        R.number = nullptr;
+        R.count = 0;
+    }
+
+    ~FixedVector(){ delete ownArena;}
+
+    FixedVector(const FixedVector&) = delete;
+    const FixedVector& operator=(const FixedVector&) = delete;
+
+    // **************************************************************
+    //                         Element Access
+    // **************************************************************
+    reference operator[](std::size_t i){ return reference(number + i);}
+    fixed operator[](std::size_t i) const{
+        fixed ret;
+        ret.setRawNumber(number[i]);
+        return ret;
+    }
+
+    fixSize* data(){ return number;}
+    const fixSize* data() const{ return number;}
+    std::size_t size() const{ return count;}
+
+    // **************************************************************
+    //                     Bulk Conversion Functions
+    // **************************************************************
+    // Same truncating conversion as Fixed::fromFloat(), for count values
+    // starting at element offset. Values out of the format's range, and
+    // NaN, follow the overflow policy, see toRaw().
+    void fromFloat(const float *src, std::size_t num, std::size_t offset = 0){
+        const double scale = CAST<double>(TO_UFIX(1) << _FRAC);
+        const double high = std::ldexp(1.0, _INT + _FRAC);
+        const double low = (_SIGN) ? -high : 0;
+        fixSize *dst = number + offset;
+        for(std::size_t i = 0; i < num; i++)
+            dst[i] = toRaw(CAST<double>(src[i]) * scale, low, high);
+    }
+
+    void fromDouble(const double *src, std::size_t num,
+                    std::size_t offset = 0){
+        const double scale = CAST<double>(TO_UFIX(1) << _FRAC);
+        const double high = std::ldexp(1.0, _INT + _FRAC);
+        const double low = (_SIGN) ? -high : 0;
+        fixSize *dst = number + offset;
+        for(std::size_t i = 0; i < num; i++)
+            dst[i] = toRaw(src[i] * scale, low, high);
+    }
+
+    // Multiplying by 2^-FRAC is exact, and vectorizes where a divide won't
+    void toFloat(float *dst, std::size_t num, std::size_t offset = 0) const{
+        const float scale = 1.0f / CAST<float>(TO_UFIX(1) << _FRAC);
+        const fixSize *src = number + offset;
+        for(std::size_t i = 0; i < num; i++)
+            dst[i] = src[i] * scale;
+    }
+
+    void toDouble(double *dst, std::size_t num, std::size_t offset = 0) const{
+        const double scale = 1.0 / CAST<double>(TO_UFIX(1) << _FRAC);
+        const fixSize *src = number + offset;
+        for(std::size_t i = 0; i < num; i++)
+            dst[i] = src[i] * scale;
+    }
+
+    // **************************************************************
+    //                      Element-wise Operators
+    // **************************************************************
+    // Both vectors need to be the same size
+    void operator+=(const FixedVector &R){
+        assert(R.count == count);
+        batch::add(number, number, R.number, count);
+    }
+    void operator-=(const FixedVector &R){
+        assert(R.count == count);
+        batch::sub(number, number, R.number, count);
+    }
+    void operator*=(const FixedVector &R){
+        assert(R.count == count);
+        batch::mul(number, number, R.number, count);
+    }
+    void operator/=(const FixedVector &R){
+        assert(R.count == count);
+        batch::div(number, number, R.number, count);
+    }
+
+    // this += L * R
+    void multiplyAccumulate(const FixedVector &L, const FixedVector &R){
+        assert(L.count == count && R.count == count);
+        batch::mac(number, L.number, R.number, count);
+    }
+
+private:
+    typedef typename fixed::ufixSize ufixSize;
+
+    // Truncates a scaled number to a raw number, where [low, high) is the
+    // range of the format. Outside it FIXED_WRAP keeps the low bits, as the
+    // integer operators do, FIXED_SATURATE clamps, and FIXED_TRAP stops.
+    // NaN and the infinities wrap to 0, and NaN saturates to 0.
+    static fixSize toRaw(double num, double low, double high){
+        if(num >= low && num < high) return TO_SFIX(num);
+        return toRawOutside(num, low, high);
+    }
+
+    static fixSize toRawOutside(double num, double low, double high){
+        const double TWO_63 = 9223372036854775808.0;
+        const double whole = std::trunc(num);
+        if(whole >= low && whole < high) return TO_SFIX(whole);
+        if(_OVER == FIXED_TRAP) Fixed_trap();
+        if(num != num) return TO_SFIX(0);
+        if(_OVER == FIXED_SATURATE){
+            return (num < 0) ? fixed().getMinValue().getRawNumber()
+                             : fixed().getMaxValue().getRawNumber();
+        }
+
+        // The low 64 bits as a number in [-2^63, 2^63), which is exact
+        double wrapped = std::fmod(whole, 2 * TWO_63);
+        if(wrapped != wrapped) return TO_SFIX(0);
+        if(wrapped >= TWO_63) wrapped -= 2 * TWO_63;
+        else if(wrapped < -TWO_63) wrapped += 2 * TWO_63;
+        return TO_SFIX(CAST<fast64>(wrapped));
+    }
+
+    FixedArena *ownArena;
+    fixSize *number;
+    std::size_t count;
+};
+
+#endif // FIXEDVECTOR_H
@@ -0,0 +1,2359 @@
+/*
+ *  @file    FxPtBench.h
+ *
+ *  @brief Throughput benchmarks for the fixed point library
+ *
+ *  DESCRIPTION
+ *
+ * Each run function times one part of the library and prints the results
+ * to the given stream. Results are reported in elements per second, with
+ * the scalar operators from FixedPoint.h as the baseline.
+ *
+ * Accuracy is measured against the <cmath> double functions, reading the
+ * raw number directly so formats with more than 30 FRAC bits are exact.
+ *
+ * runOperatorSuite() is for tracking regressions instead. It times every
+ * operator and FixedMath.h function over signed and unsigned 8, 16, 32, 64
+ * and 128 bit formats and prints one CSV line per op:
+ *
+ *     dw_math,int,frac,bits,signed,op,ns_per_op,ops_per_cycle
+ *
+ * Cycles are time stamp counter ticks, which run at a fixed rate on most
+ * x86 CPUs, and 0 on CPUs without one. The Makefile runs the suite with
+ * ENABLE_DW_BIT_MATH set to 1 and 0, see "make bench".
+ *
+ * runOperatorSuite(out, true) runs the same ops once each and checks them
+ * instead, printing the mismatches and a hash of the results per op:
+ *
+ *     dw_math,int,frac,bits,signed,op,mismatches,result_hash
+ *
+ * Formats up to 64 bits are compared with a reference worked out in 128 bit
+ * math. "make check" also fails if the hashes of the two ENABLE_DW_BIT_MATH
+ * builds differ, which covers the 128 bit formats and FixedMath.h.
+ *
+ * A check also compares every Fixed_batch function, and Fixed_batchRound
+ * in all six modes, with the scalar operators, for signed and unsigned
+ * 8, 16, 32 and 64 bit formats under each FixedOverflow policy. "make check"
+ * runs it in a native build and an SSE2 only build, so both the AVX2 and
+ * the SSE2 kernels are covered. FixedVector's fromDouble() and fromFloat()
+ * are checked on out of range numbers and NaN under FIXED_SATURATE.
+ */
+
+
+
+
+#ifndef FXPTBENCH_H
+#define FXPTBENCH_H
+
+#include "FixedBatch.h"
+#include "FixedExpLog.h"
+#include "FixedFFT.h"
+#include "FixedFilter.h"
+#include "FixedMatrix.h"
+#include "FixedPID.h"
+#include "FixedRandom.h"
+#include "FixedResample.h"
+#include "FixedTrig.h"
+#include "FixedVector.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <complex>
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <ostream>
+#include <random>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+    #include <x86intrin.h>
+#endif
+
+#define BENCH_BUFFER_SIZE 4096
+#define BENCH_ELEMENTS    (1 << 24)
+#define BENCH_FORMAT_VALUES 10000000
+#define BENCH_SUITE_SECONDS 0.02 // Per op, per measurement
+
+// Written after every timed loop so the work can not be optimized out
+static volatile fast64 benchSink = 0;
+
+// Runs func reps times, returns the elapsed seconds
+template<class FUNC>
+double benchSeconds(FUNC func, fast32 reps){
+    const auto start = std::chrono::steady_clock::now();
+    for(fast32 i = 0; i < reps; i++) func();
+    const auto stop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double>(stop - start).count();
+}
+
+// Runs func reps times, returns the elapsed time stamp counter ticks, or 0
+// if the CPU does not have one
+template<class FUNC>
+double benchCycles(FUNC func, fast32 reps){
+#if defined(__x86_64__) || defined(__i386__)
+    const fastu64 start = __rdtsc();
+    for(fast32 i = 0; i < reps; i++) func();
+    return CAST<double>(__rdtsc() - start);
+#else
+    for(fast32 i = 0; i < reps; i++) func();
+    return 0;
+#endif
+}
+
+// Random bits for every bit of a raw number
+template<class T> T benchRandomRaw(std::mt19937_64 &gen, T){
+    return CAST<T>(gen());
+}
+template<bool SIGN>
+FixedInt128<SIGN> benchRandomRaw(std::mt19937_64 &gen, FixedInt128<SIGN>){
+    const fastu64 hi = gen();
+    return FixedInt128<SIGN>(hi, gen(), true);
+}
+
+// Fills buf with random raw numbers, never zero so it can be a divisor
+template<class FIXED>
+void benchFill(std::vector<FIXED> &buf, std::mt19937_64 &gen){
+    typedef typename FIXED::fixSize fixSize;
+    for(auto &x : buf){
+        x.setRawNumber(benchRandomRaw(gen, fixSize()) | 1);
+    }
+}
+
+template<fastu16 INT, fastu16 FRAC, bool SIGN = SIGNED>
+void benchBatchFormat(std::ostream &out, const char *name){
+    typedef Fixed<INT, FRAC, SIGN> fixed;
+    const fast32 reps = BENCH_ELEMENTS / BENCH_BUFFER_SIZE;
+    const double elements = CAST<double>(reps) * BENCH_BUFFER_SIZE;
+    std::mt19937_64 gen(BENCH_BUFFER_SIZE);
+
+    std::vector<fixed> L(BENCH_BUFFER_SIZE), R(BENCH_BUFFER_SIZE),
+                       dst(BENCH_BUFFER_SIZE);
+    benchFill(L, gen);
+    benchFill(R, gen);
+
+    // Scalar baselines use the operators one element at a time
+    const double scalarAdd = benchSeconds([&]{
+        for(fast32 i = 0; i < BENCH_BUFFER_SIZE; i++) dst[i] = L[i] + R[i];
+        benchSink = dst[0].getRawNumber();
+    }, reps);
+    const double scalarMul = benchSeconds([&]{
+        for(fast32 i = 0; i < BENCH_BUFFER_SIZE; i++) dst[i] = L[i] * R[i];
+        benchSink = dst[0].getRawNumber();
+    }, reps);
+    const double scalarMac = benchSeconds([&]{
+        for(fast32 i = 0; i < BENCH_BUFFER_SIZE; i++) dst[i] += L[i] * R[i];
+        benchSink = dst[0].getRawNumber();
+    }, reps);
+    const double scalarDiv = benchSeconds([&]{
+        for(fast32 i = 0; i < BENCH_BUFFER_SIZE; i++) dst[i] = L[i] / R[i];
+        benchSink = dst[0].getRawNumber();
+    }, reps);
+
+    const double batchAdd = benchSeconds([&]{
+        Fixed_batchAdd(dst.data(), L.data(), R.data(), dst.size());
+        benchSink = dst[0].getRawNumber();
+    }, reps);
+    const double batchMul = benchSeconds([&]{
+        Fixed_batchMul(dst.data(), L.data(), R.data(), dst.size());
+        benchSink = dst[0].getRawNumber();
+    }, reps);
+    const double batchMac = benchSeconds([&]{
+        Fixed_batchMac(dst.data(), L.data(), R.data(), dst.size());
+        benchSink = dst[0].getRawNumber();
+    }, reps);
+    const double batchDiv = benchSeconds([&]{
+        Fixed_batchDiv(dst.data(), L.data(), R.data(), dst.size());
+        benchSink = dst[0].getRawNumber();
+    }, reps);
+
+    const double M = 1e6;
+    out << std::left << std::setw(20) << name << std::right << std::fixed
+        << std::setprecision(1)
+        << std::setw(9) << elements / scalarAdd / M
+        << std::setw(9) << elements / batchAdd / M
+        << std::setw(9) << elements / scalarMul / M
+        << std::setw(9) << elements / batchMul / M
+        << std::setw(9) << elements / scalarMac / M
+        << std::setw(9) << elements / batchMac / M
+        << std::setw(9) << elements / scalarDiv / M
+        << std::setw(9) << elements / batchDiv / M << std::endl;
+}
+
+inline void runBatchBenchmarks(std::ostream &out){
+    out << "Batch arithmetic, millions of elements/second (SSE2: "
+        << FIXED_BATCH_SSE2 << ", AVX2: " << FIXED_BATCH_AVX2 << ")\n"
+        << std::left << std::setw(20) << "Format" << std::right
+        << std::setw(9) << "add" << std::setw(9) << "b-add"
+        << std::setw(9) << "mul" << std::setw(9) << "b-mul"
+        << std::setw(9) << "mac" << std::setw(9) << "b-mac"
+        << std::setw(9) << "div" << std::setw(9) << "b-div" << std::endl;
+
+    benchBatchFormat<4, 3>(out, "Fixed<4, 3>");
+    benchBatchFormat<4, 4, UNSIGNED>(out, "Fixed<4, 4, U>");
+    benchBatchFormat<10, 5>(out, "Fixed<10, 5>");
+    benchBatchFormat<6, 10, UNSIGNED>(out, "Fixed<6, 10, U>");
+    benchBatchFormat<16, 15>(out, "Fixed<16, 15>");
+    benchBatchFormat<12, 20, UNSIGNED>(out, "Fixed<12, 20, U>");
+    benchBatchFormat<30, 33>(out, "Fixed<30, 33>");
+    benchBatchFormat<34, 30, UNSIGNED>(out, "Fixed<34, 30, U>");
+}
+
+// Rounding the way it is written with branches, the way FixedPoint.h did
+// before round<MODE>(). The baseline for the branchless versions.
+template<FixedRounding MODE, class FIXED>
+FIXED benchBranchyRound(const FIXED &x, typename FIXED::ufixSize random){
+    typedef typename FIXED::ufixSize ufixSize;
+    const ufixSize one = CAST<ufixSize>(1) << FIXED::FRAC_BITS;
+    const ufixSize mask = one - 1, half = one >> 1;
+    const ufixSize raw = CAST<ufixSize>(x.getRawNumber());
+    const ufixSize frac = raw & mask;
+
+    bool up = false;
+    if(MODE == FIXED_ROUND_CEIL) up = frac != 0;
+    if(MODE == FIXED_ROUND_HALF_UP) up = (raw & half) != 0;
+    if(MODE == FIXED_ROUND_HALF_EVEN){
+        if(frac > half)      up = true;
+        else if(frac < half) up = false;
+        else                 up = (raw & one) != 0;
+    }
+    if(MODE == FIXED_ROUND_TO_ZERO) up = x.isNegative() && frac != 0;
+    if(MODE == FIXED_ROUND_STOCHASTIC) up = frac > (~random & mask);
+
+    FIXED ret;
+    if(up) ret.setRawNumber(CAST<typename FIXED::fixSize>((raw & ~mask) +
+                                                          one));
+    else   ret.setRawNumber(CAST<typename FIXED::fixSize>(raw & ~mask));
+    return ret;
+}
+
+// Times one mode three ways: the branchy version on numbers that all have
+// the same fraction, so every branch is predicted, then on random numbers,
+// then round<MODE>() and Fixed_batchRound<MODE>() on the random numbers
+template<FixedRounding MODE, class FIXED>
+void benchRoundMode(std::ostream &out, const char *name,
+                    const std::vector<FIXED> &same,
+                    const std::vector<FIXED> &random,
+                    const std::vector<FIXED> &noise){
+    const fast32 reps = BENCH_ELEMENTS / BENCH_BUFFER_SIZE;
+    const double M = CAST<double>(reps) * BENCH_BUFFER_SIZE / 1e6;
+    std::vector<FIXED> dst(BENCH_BUFFER_SIZE);
+
+    auto branchy = [&](const std::vector<FIXED> &src){
+        return benchSeconds([&]{
+            for(fast32 i = 0; i < BENCH_BUFFER_SIZE; i++)
+                dst[i] = benchBranchyRound<MODE>(src[i],
+                                                 noise[i].getRawNumber());
+            benchSink = dst[0].getRawNumber();
+        }, reps);
+    };
+    const double predicted = branchy(same);
+    const double mispredicted = branchy(random);
+    const double branchless = benchSeconds([&]{
+        for(fast32 i = 0; i < BENCH_BUFFER_SIZE; i++)
+            dst[i] = random[i].template round<MODE>(noise[i].getRawNumber());
+        benchSink = dst[0].getRawNumber();
+    }, reps);
+    const double batch = benchSeconds([&]{
+        Fixed_batchRound<MODE>(dst.data(), random.data(), dst.size(),
+                               noise.data());
+        benchSink = dst[0].getRawNumber();
+    }, reps);
+
+    out << "  " << std::left << std::setw(18) << name << std::right
+        << std::fixed << std::setprecision(1)
+        << std::setw(10) << M / predicted << std::setw(10) << M / mispredicted
+        << std::setw(10) << M / branchless << std::setw(10) << M / batch
+        << std::endl;
+}
+
+template<fastu16 INT, fastu16 FRAC, bool SIGN = SIGNED>
+void benchRoundFormat(std::ostream &out, const char *name){
+    typedef Fixed<INT, FRAC, SIGN> fixed;
+    std::mt19937_64 gen(BENCH_BUFFER_SIZE);
+
+    // Random raw numbers, and numbers that are all 1.75 from an integer
+    std::vector<fixed> random(BENCH_BUFFER_SIZE), noise(BENCH_BUFFER_SIZE),
+                       same(BENCH_BUFFER_SIZE);
+    benchFill(random, gen);
+    benchFill(noise, gen);
+    for(auto &x : same) x = fixed(1.75);
+
+    out << name << std::endl;
+    benchRoundMode<FIXED_ROUND_CEIL>(out, "ceil", same, random, noise);
+    benchRoundMode<FIXED_ROUND_HALF_UP>(out, "round", same, random, noise);
+    benchRoundMode<FIXED_ROUND_HALF_EVEN>(out, "half even", same, random,
+                                          noise);
+    benchRoundMode<FIXED_ROUND_TO_ZERO>(out, "trunc", same, random, noise);
+    benchRoundMode<FIXED_ROUND_STOCHASTIC>(out, "stochastic", same, random,
+                                           noise);
+}
+
+inline void runRoundBenchmarks(std::ostream &out){
+    out << "Rounding to an integer, millions of elements/second\n"
+        << "  predicted: with branches, every number 1.75\n"
+        << "  random:    with branches, random numbers\n"
+        << "  round:     round<MODE>(), random numbers\n"
+        << "  batch:     Fixed_batchRound<MODE>(), random numbers\n"
+        << std::left << std::setw(20) << "Format, Mode" << std::right
+        << std::setw(10) << "predicted" << std::setw(10) << "random"
+        << std::setw(10) << "round" << std::setw(10) << "batch" << std::endl;
+
+    benchRoundFormat<4, 3>(out, "Fixed<4, 3>");
+    benchRoundFormat<16, 15>(out, "Fixed<16, 15>");
+    benchRoundFormat<30, 33>(out, "Fixed<30, 33>");
+}
+
+// Raw number as a double, exact for every format
+template<fastu16 INT, fastu16 FRAC, bool SIGN>
+double benchToDouble(const Fixed<INT, FRAC, SIGN> &x){
+    return std::ldexp(CAST<double>(x.getRawNumber()), -FRAC);
+}
+
+template<FixedTrigEngine ENGINE, fastu16 INT, fastu16 FRAC>
+void benchTrigEngine(std::ostream &out, const char *name, const char *engine){
+    typedef Fixed<INT, FRAC> fixed;
+    const fast32 reps = BENCH_ELEMENTS / BENCH_BUFFER_SIZE / 4;
+    const double calls = CAST<double>(reps) * BENCH_BUFFER_SIZE;
+
+    // Sweep one turn for accuracy, the period is where the engines differ
+    std::vector<fixed> angles(BENCH_BUFFER_SIZE);
+    for(fast32 i = 0; i < BENCH_BUFFER_SIZE; i++)
+        angles[i] = fixed(-3.14159 + 6.28318 * i / BENCH_BUFFER_SIZE);
+
+    double maxErr = 0;
+    for(const fixed &x : angles){
+        fixed s, c;
+        Fixed_sincos<ENGINE>(x, s, c);
+        const double rads = benchToDouble(x);
+        maxErr = std::fmax(maxErr, std::fabs(benchToDouble(s) - std::sin(rads)));
+        maxErr = std::fmax(maxErr, std::fabs(benchToDouble(c) - std::cos(rads)));
+    }
+
+    const double seconds = benchSeconds([&]{
+        fixed s, c;
+        fast64 sum = 0;
+        for(const fixed &x : angles){
+            Fixed_sincos<ENGINE>(x, s, c);
+            sum += s.getRawNumber() + c.getRawNumber();
+        }
+        benchSink = sum;
+    }, reps);
+
+    out << std::left << std::setw(16) << name << std::setw(8) << engine
+        << std::right << std::scientific << std::setprecision(2)
+        << std::setw(12) << maxErr
+        << std::setw(12) << std::ldexp(1.0, -FRAC)
+        << std::fixed << std::setprecision(1)
+        << std::setw(12) << calls / seconds / 1e6 << std::endl;
+}
+
+template<fastu16 INT, fastu16 FRAC>
+void benchTrigFormat(std::ostream &out, const char *name){
+    benchTrigEngine<FIXED_TRIG_POLY, INT, FRAC>(out, name, "poly");
+    benchTrigEngine<FIXED_TRIG_TABLE, INT, FRAC>(out, name, "table");
+    benchTrigEngine<FIXED_TRIG_CORDIC, INT, FRAC>(out, name, "cordic");
+}
+
+inline void runTrigBenchmarks(std::ostream &out){
+    out << "sin/cos engines, one call returns both, over [-pi, pi)\n"
+        << std::left << std::setw(16) << "Format" << std::setw(8) << "Engine"
+        << std::right << std::setw(12) << "Max error" << std::setw(12)
+        << "Resolution" << std::setw(12) << "Mcalls/s" << std::endl;
+
+    benchTrigFormat<10, 5>(out, "Fixed<10, 5>");
+    benchTrigFormat<16, 15>(out, "Fixed<16, 15>");
+    benchTrigFormat<3, 28>(out, "Fixed<3, 28>");
+    benchTrigFormat<8, 55>(out, "Fixed<8, 55>");
+}
+
+template<fastu16 INT, fastu16 FRAC, bool SIGN = SIGNED>
+void benchDivideFormat(std::ostream &out, const char *name){
+    typedef Fixed<INT, FRAC, SIGN> fixed;
+    const fast32 reps = BENCH_ELEMENTS / BENCH_BUFFER_SIZE / 4;
+    const double calls = CAST<double>(reps) * BENCH_BUFFER_SIZE;
+    std::mt19937_64 gen(BENCH_BUFFER_SIZE);
+
+    std::vector<fixed> L(BENCH_BUFFER_SIZE), R(BENCH_BUFFER_SIZE),
+                       dst(BENCH_BUFFER_SIZE);
+    benchFill(L, gen);
+    benchFill(R, gen);
+    const FixedReciprocal<INT, FRAC, SIGN> recip(R[0]);
+
+    // Count results different from operator/, skipping quotients that
+    // do not fit in the format
+    fast32 mismatch = 0;
+    for(fast32 i = 0; i < BENCH_BUFFER_SIZE; i++){
+        const double quotient = std::ldexp(CAST<double>(L[i].getRawNumber()) /
+                                           R[i].getRawNumber(), FRAC);
+        if(std::fabs(quotient) > std::ldexp(0.99, fixed::BITSUM)) continue;
+        mismatch += FixedReciprocal<INT, FRAC, SIGN>(R[i]).divide(L[i]) !=
+                    L[i] / R[i];
+    }
+
+    const double exact = benchCycles([&]{
+        for(fast32 i = 0; i < BENCH_BUFFER_SIZE; i++) dst[i] = L[i] / R[i];
+        benchSink = dst[0].getRawNumber();
+    }, reps);
+    const double fast = benchCycles([&]{
+        for(fast32 i = 0; i < BENCH_BUFFER_SIZE; i++)
+            dst[i] = FixedReciprocal<INT, FRAC, SIGN>(R[i]).divide(L[i]);
+        benchSink = dst[0].getRawNumber();
+    }, reps);
+    const double same = benchCycles([&]{
+        recip.divide(dst.data(), L.data(), dst.size());
+        benchSink = dst[0].getRawNumber();
+    }, reps);
+
+    out << std::left << std::setw(20) << name << std::right << std::fixed
+        << std::setprecision(1)
+        << std::setw(10) << exact / calls
+        << std::setw(10) << fast / calls
+        << std::setw(10) << same / calls
+        << std::setw(10) << mismatch << std::endl;
+}
+
+inline void runDivideBenchmarks(std::ostream &out){
+    out << "Division, cycles per divide (ENABLE_DW_BIT_MATH: "
+        << ENABLE_DW_BIT_MATH << ")\n"
+        << "  exact: operator/\n"
+        << "  fast:  new FixedReciprocal for every divide\n"
+        << "  same:  one FixedReciprocal for the whole buffer\n"
+        << std::left << std::setw(20) << "Format" << std::right
+        << std::setw(10) << "exact" << std::setw(10) << "fast"
+        << std::setw(10) << "same" << std::setw(10) << "mismatch"
+        << std::endl;
+
+    benchDivideFormat<4, 3>(out, "Fixed<4, 3>");
+    benchDivideFormat<10, 5>(out, "Fixed<10, 5>");
+    benchDivideFormat<6, 10, UNSIGNED>(out, "Fixed<6, 10, U>");
+    benchDivideFormat<16, 15>(out, "Fixed<16, 15>");
+    benchDivideFormat<12, 20, UNSIGNED>(out, "Fixed<12, 20, U>");
+    benchDivideFormat<30, 33>(out, "Fixed<30, 33>");
+    benchDivideFormat<2, 61>(out, "Fixed<2, 61>");
+    benchDivideFormat<34, 30, UNSIGNED>(out, "Fixed<34, 30, U>");
+}
+
+// Times batch add and mul of one format under an overflow policy. The
+// numbers are kept small so nothing overflows and FIXED_TRAP never stops.
+template<fastu16 INT, fastu16 FRAC, bool SIGN, FixedOverflow OVER>
+void benchOverflowPolicy(std::ostream &out){
+    typedef Fixed<INT, FRAC, SIGN, OVER> fixed;
+    typedef typename fixed::fixSize fixSize;
+    const fast32 reps = BENCH_ELEMENTS / BENCH_BUFFER_SIZE;
+    const double elements = CAST<double>(reps) * BENCH_BUFFER_SIZE;
+    std::mt19937_64 gen(BENCH_BUFFER_SIZE);
+
+    std::vector<fixed> L(BENCH_BUFFER_SIZE), R(BENCH_BUFFER_SIZE),
+                       dst(BENCH_BUFFER_SIZE);
+    benchFill(L, gen);
+    benchFill(R, gen);
+    for(fast32 i = 0; i < BENCH_BUFFER_SIZE; i++){
+        L[i].setRawNumber(TO_SFIX(L[i].getRawNumber() / (TO_SFIX(1) <<
+                                  (sizeof(fixSize) * 4))));
+        R[i].setRawNumber(TO_SFIX(R[i].getRawNumber() / (TO_SFIX(1) <<
+                                  (sizeof(fixSize) * 4))));
+    }
+
+    const double scalarAdd = benchSeconds([&]{
+        for(fast32 i = 0; i < BENCH_BUFFER_SIZE; i++) dst[i] = L[i] + R[i];
+        benchSink = dst[0].getRawNumber();
+    }, reps);
+    const double batchAdd = benchSeconds([&]{
+        Fixed_batchAdd(dst.data(), L.data(), R.data(), dst.size());
+        benchSink = dst[0].getRawNumber();
+    }, reps);
+    const double scalarMul = benchSeconds([&]{
+        for(fast32 i = 0; i < BENCH_BUFFER_SIZE; i++) dst[i] = L[i] * R[i];
+        benchSink = dst[0].getRawNumber();
+    }, reps);
+    const double batchMul = benchSeconds([&]{
+        Fixed_batchMul(dst.data(), L.data(), R.data(), dst.size());
+        benchSink = dst[0].getRawNumber();
+    }, reps);
+
+    const double M = 1e6;
+    out << std::setw(9) << elements / scalarAdd / M
+        << std::setw(9) << elements / batchAdd / M
+        << std::setw(9) << elements / scalarMul / M
+        << std::setw(9) << elements / batchMul / M;
+}
+
+template<fastu16 INT, fastu16 FRAC, bool SIGN = SIGNED>
+void benchOverflowFormat(std::ostream &out, const char *name){
+    const char *policies[] = {"wrap", "saturate", "trap"};
+    for(fast32 i = 0; i < 3; i++){
+        out << std::left << std::setw(20) << ((i == 0) ? name : "")
+            << std::setw(10) << policies[i] << std::right << std::fixed
+            << std::setprecision(1);
+        if(i == 0) benchOverflowPolicy<INT, FRAC, SIGN, FIXED_WRAP>(out);
+        if(i == 1) benchOverflowPolicy<INT, FRAC, SIGN, FIXED_SATURATE>(out);
+        if(i == 2) benchOverflowPolicy<INT, FRAC, SIGN, FIXED_TRAP>(out);
+        out << std::endl;
+    }
+}
+
+inline void runOverflowBenchmarks(std::ostream &out){
+    out << "Overflow policies, millions of elements/second (SSE2: "
+        << FIXED_BATCH_SSE2 << ", AVX2: " << FIXED_BATCH_AVX2 << ")\n"
+        << std::left << std::setw(20) << "Format" << std::setw(10) << "Policy"
+        << std::right
+        << std::setw(9) << "add" << std::setw(9) << "b-add"
+        << std::setw(9) << "mul" << std::setw(9) << "b-mul" << std::endl;
+
+    benchOverflowFormat<4, 3>(out, "Fixed<4, 3>");
+    benchOverflowFormat<4, 4, UNSIGNED>(out, "Fixed<4, 4, U>");
+    benchOverflowFormat<10, 5>(out, "Fixed<10, 5>");
+    benchOverflowFormat<6, 10, UNSIGNED>(out, "Fixed<6, 10, U>");
+    benchOverflowFormat<16, 15>(out, "Fixed<16, 15>");
+    benchOverflowFormat<30, 33>(out, "Fixed<30, 33>");
+}
+
+// Multiplies coefficients by samples of another format, either by fitting
+// the coefficients to the sample format first, or with the mixed operator
+template<fastu16 C_INT, fastu16 C_FRAC, fastu16 S_INT, fastu16 S_FRAC>
+void benchMixedFormat(std::ostream &out, const char *name){
+    typedef Fixed<C_INT, C_FRAC> coeff;
+    typedef Fixed<S_INT, S_FRAC> sample;
+    typedef decltype(coeff() * sample()) product;
+    const fast32 reps = BENCH_ELEMENTS / BENCH_BUFFER_SIZE;
+    const double elements = CAST<double>(reps) * BENCH_BUFFER_SIZE;
+    std::mt19937_64 gen(BENCH_BUFFER_SIZE);
+
+    std::vector<coeff> L(BENCH_BUFFER_SIZE);
+    std::vector<sample> R(BENCH_BUFFER_SIZE), fitDst(BENCH_BUFFER_SIZE);
+    std::vector<product> mixedDst(BENCH_BUFFER_SIZE);
+    benchFill(L, gen);
+    benchFill(R, gen);
+
+    // Coefficients are under 2^C_INT, so keep the samples small enough that
+    // the products still fit in the sample format
+    for(auto &x : R) x.setRawNumber(x.getRawNumber() / (1 << C_INT));
+
+    const double fitted = benchSeconds([&]{
+        for(fast32 i = 0; i < BENCH_BUFFER_SIZE; i++)
+            fitDst[i] = L[i].template fit<S_INT, S_FRAC>() * R[i];
+        benchSink = fitDst[0].getRawNumber();
+    }, reps);
+    const double mixed = benchSeconds([&]{
+        for(fast32 i = 0; i < BENCH_BUFFER_SIZE; i++)
+            mixedDst[i] = L[i] * R[i];
+        benchSink = mixedDst[0].getRawNumber();
+    }, reps);
+
+    // Error of each product in sample LSBs. The exact product of the raw
+    // numbers has C_FRAC + S_FRAC bits, long double keeps enough of them.
+    long double fitErr = 0, mixedErr = 0;
+    for(fast32 i = 0; i < BENCH_BUFFER_SIZE; i++){
+        const long double exact = std::ldexp(
+            CAST<long double>(L[i].getRawNumber()) * R[i].getRawNumber(),
+            -C_FRAC);
+        fitErr = std::fmax(fitErr, std::fabs(CAST<long double>(
+                               fitDst[i].getRawNumber()) - exact));
+        mixedErr = std::fmax(mixedErr, std::fabs(std::ldexp(CAST<long double>(
+                                 mixedDst[i].getRawNumber()),
+                                 S_FRAC - product::FRAC_BITS) - exact));
+    }
+
+    const double M = 1e6;
+    out << std::left << std::setw(32) << name << std::right << std::fixed
+        << std::setprecision(1)
+        << std::setw(9) << elements / fitted / M
+        << std::setw(9) << elements / mixed / M
+        << std::setprecision(3)
+        << std::setw(14) << CAST<double>(fitErr)
+        << std::setw(14) << CAST<double>(mixedErr) << std::endl;
+}
+
+inline void runMixedBenchmarks(std::ostream &out){
+    out << "Mixed formats, millions of products/second, max error in sample "
+        << "LSBs\n"
+        << std::left << std::setw(32) << "Coefficient * Sample" << std::right
+        << std::setw(9) << "fit" << std::setw(9) << "mixed"
+        << std::setw(14) << "fit err" << std::setw(14) << "mixed err"
+        << std::endl;
+
+    benchMixedFormat<1, 6, 10, 5>(out, "Fixed<1, 6> * Fixed<10, 5>");
+    benchMixedFormat<1, 14, 4, 3>(out, "Fixed<1, 14> * Fixed<4, 3>");
+    benchMixedFormat<2, 29, 16, 15>(out, "Fixed<2, 29> * Fixed<16, 15>");
+    benchMixedFormat<2, 13, 16, 15>(out, "Fixed<2, 13> * Fixed<16, 15>");
+    benchMixedFormat<1, 62, 30, 33>(out, "Fixed<1, 62> * Fixed<30, 33>");
+}
+
+// Stream buffer that throws its characters away, so operator<< is timed
+// without the cost of a real device
+class BenchNullBuffer : public std::streambuf{
+protected:
+    int_type overflow(int_type ch){ return traits_type::not_eof(ch);}
+    std::streamsize xsputn(const char*, std::streamsize count){
+        return count;
+    }
+};
+
+// Formats BENCH_FORMAT_VALUES numbers of one format each way, and parses
+// them back with fromChars()
+template<fastu16 INT, fastu16 FRAC, bool SIGN = SIGNED>
+void benchFormatFormat(std::ostream &out, const char *name){
+    typedef Fixed<INT, FRAC, SIGN> fixed;
+    const fast32 reps = BENCH_FORMAT_VALUES / BENCH_BUFFER_SIZE;
+    const double values = CAST<double>(reps) * BENCH_BUFFER_SIZE;
+    std::mt19937_64 gen(BENCH_BUFFER_SIZE);
+
+    std::vector<fixed> src(BENCH_BUFFER_SIZE), dst(BENCH_BUFFER_SIZE);
+    benchFill(src, gen);
+
+    char buf[fixed::TO_CHARS_MAX + 16];
+    const double strings = benchSeconds([&]{
+        std::size_t length = 0;
+        for(fast32 i = 0; i < BENCH_BUFFER_SIZE; i++)
+            length += src[i].toString().size();
+        benchSink = length;
+    }, reps);
+
+    BenchNullBuffer nullBuffer;
+    std::ostream nullStream(&nullBuffer);
+    const double stream = benchSeconds([&]{
+        for(fast32 i = 0; i < BENCH_BUFFER_SIZE; i++) nullStream << src[i];
+    }, reps);
+
+    const double chars = benchSeconds([&]{
+        std::size_t length = 0;
+        for(fast32 i = 0; i < BENCH_BUFFER_SIZE; i++)
+            length += src[i].toChars(buf, buf + sizeof(buf)).ptr - buf;
+        benchSink = length;
+    }, reps);
+
+    // Six digits, against printf of the double conversion
+    const double chars6 = benchSeconds([&]{
+        std::size_t length = 0;
+        for(fast32 i = 0; i < BENCH_BUFFER_SIZE; i++)
+            length += src[i].toChars(buf, buf + sizeof(buf), 6).ptr - buf;
+        benchSink = length;
+    }, reps);
+    const double printf6 = benchSeconds([&]{
+        std::size_t length = 0;
+        for(fast32 i = 0; i < BENCH_BUFFER_SIZE; i++)
+            length += std::snprintf(buf, sizeof(buf), "%.6f",
+                                    src[i].toDouble());
+        benchSink = length;
+    }, reps);
+
+    // Every number is printed exactly, so parsing it gives it back
+    std::vector<std::string> text(BENCH_BUFFER_SIZE);
+    fast32 mismatch = 0;
+    for(fast32 i = 0; i < BENCH_BUFFER_SIZE; i++){
+        text[i] = src[i].toString();
+        dst[i].fromChars(text[i].data(), text[i].data() + text[i].size());
+        mismatch += dst[i] != src[i];
+    }
+    const double parse = benchSeconds([&]{
+        for(fast32 i = 0; i < BENCH_BUFFER_SIZE; i++)
+            dst[i].fromChars(text[i].data(), text[i].data() + text[i].size());
+        benchSink = dst[0].getRawNumber();
+    }, reps);
+
+    const double M = 1e6;
+    out << std::left << std::setw(20) << name << std::right << std::fixed
+        << std::setprecision(1)
+        << std::setw(9) << values / strings / M
+        << std::setw(9) << values / stream / M
+        << std::setw(9) << values / chars / M
+        << std::setw(9) << values / chars6 / M
+        << std::setw(9) << values / printf6 / M
+        << std::setw(9) << values / parse / M
+        << std::setw(10) << mismatch << std::endl;
+}
+
+inline void runFormatBenchmarks(std::ostream &out){
+    out << "Formatting " << BENCH_FORMAT_VALUES << " values, millions of "
+        << "values/second\n"
+        << "  string, stream, chars: every digit of the exact value\n"
+        << "  chars6, printf6: 6 digits, printf of toDouble() as the baseline\n"
+        << "  parse: fromChars() of the exact text\n"
+        << std::left << std::setw(20) << "Format" << std::right
+        << std::setw(9) << "string" << std::setw(9) << "stream"
+        << std::setw(9) << "chars" << std::setw(9) << "chars6"
+        << std::setw(9) << "printf6" << std::setw(9) << "parse"
+        << std::setw(10) << "mismatch" << std::endl;
+
+    benchFormatFormat<10, 5>(out, "Fixed<10, 5>");
+    benchFormatFormat<16, 15>(out, "Fixed<16, 15>");
+    benchFormatFormat<30, 33>(out, "Fixed<30, 33>");
+    benchFormatFormat<2, 61>(out, "Fixed<2, 61>");
+    benchFormatFormat<34, 30, UNSIGNED>(out, "Fixed<34, 30, U>");
+}
+
+// Random samples in a quarter of the SAMPLE range, so a filter with a gain
+// of 1 never overflows
+template<class SAMPLE>
+void benchFillQuarter(std::vector<SAMPLE> &buf, std::mt19937_64 &gen){
+    benchFill(buf, gen);
+    for(auto &x : buf) x.setRawNumber(x.getRawNumber() / 4);
+}
+
+// Prints samples/second of the hand written loop and the filter, and the
+// max error of each against the exact output, in SAMPLE LSBs
+template<class SAMPLE>
+void benchFilterReport(std::ostream &out, const char *name, fast32 size,
+                       double samples, double naive, double filter,
+                       long double naiveErr, long double filterErr){
+    const double M = 1e6;
+    out << std::left << std::setw(32) << name << std::right << std::fixed
+        << std::setprecision(1) << std::setw(6) << size
+        << std::setw(9) << samples / naive / M
+        << std::setw(9) << samples / filter / M
+        << std::setprecision(3)
+        << std::setw(12) << CAST<double>(std::ldexp(naiveErr,
+                                                    SAMPLE::FRAC_BITS))
+        << std::setw(12) << CAST<double>(std::ldexp(filterErr,
+                                                    SAMPLE::FRAC_BITS))
+        << std::endl;
+}
+
+// Windowed sinc low pass with taps coefficients, against a loop over
+// operator* and operator+= with the coefficients in the SAMPLE format
+template<class COEFF, class SAMPLE>
+void benchFirFormat(std::ostream &out, const char *name, fast32 taps){
+    const fast32 reps = BENCH_ELEMENTS / BENCH_BUFFER_SIZE / 16;
+    const double samples = CAST<double>(reps) * BENCH_BUFFER_SIZE;
+    std::mt19937_64 gen(BENCH_BUFFER_SIZE);
+
+    std::vector<double> h(taps);
+    double gain = 0;
+    for(fast32 i = 0; i < taps; i++){
+        const double x = (i - (taps - 1) / 2.0) * 0.2;
+        const double window = 0.54 - 0.46 * std::cos(2 * FIXED_CONST_PI * i /
+                                                     (taps - 1));
+        h[i] = ((x == 0) ? 1 : std::sin(FIXED_CONST_PI * x) /
+                               (FIXED_CONST_PI * x)) * window;
+        gain += h[i];
+    }
+    std::vector<COEFF> coeffs(taps);
+    std::vector<SAMPLE> naiveCoeffs(taps);
+    for(fast32 i = 0; i < taps; i++){
+        coeffs[i] = COEFF(h[i] / gain);
+        naiveCoeffs[i] = SAMPLE(h[i] / gain);
+    }
+
+    std::vector<SAMPLE> src(BENCH_BUFFER_SIZE), dst(BENCH_BUFFER_SIZE),
+                        naiveDst(BENCH_BUFFER_SIZE), history(2 * taps);
+    benchFillQuarter(src, gen);
+    FixedFir<COEFF, SAMPLE> fir(coeffs.data(), taps);
+
+    // Hand written version, newest sample first in a doubled buffer
+    fast32 pos = 0;
+    auto naive = [&]{
+        for(fast32 n = 0; n < BENCH_BUFFER_SIZE; n++){
+            pos = (pos == 0) ? taps - 1 : pos - 1;
+            history[pos] = history[pos + taps] = src[n];
+            SAMPLE acc = 0;
+            for(fast32 i = 0; i < taps; i++)
+                acc += naiveCoeffs[i] * history[pos + i];
+            naiveDst[n] = acc;
+        }
+        benchSink = naiveDst[0].getRawNumber();
+    };
+    auto filter = [&]{
+        fir.process(dst.data(), src.data(), dst.size());
+        benchSink = dst[0].getRawNumber();
+    };
+
+    naive();
+    filter();
+    long double naiveErr = 0, filterErr = 0;
+    for(fast32 n = 0; n < BENCH_BUFFER_SIZE; n++){
+        long double exact = 0;
+        for(fast32 i = 0; i < taps && i <= n; i++)
+            exact += CAST<long double>(coeffs[i].toDouble()) *
+                     src[n - i].toDouble();
+        naiveErr = std::fmax(naiveErr, std::fabs(naiveDst[n].toDouble() -
+                                                 exact));
+        filterErr = std::fmax(filterErr, std::fabs(dst[n].toDouble() -
+                                                   exact));
+    }
+
+    benchFilterReport<SAMPLE>(out, name, taps, samples,
+                              benchSeconds(naive, reps),
+                              benchSeconds(filter, reps),
+                              naiveErr, filterErr);
+}
+
+// Butterworth low pass at fs / 20, two poles per section
+template<class COEFF, class SAMPLE>
+void benchBiquadFormat(std::ostream &out, const char *name,
+                       fast32 sections){
+    const fast32 reps = BENCH_ELEMENTS / BENCH_BUFFER_SIZE / 4;
+    const double samples = CAST<double>(reps) * BENCH_BUFFER_SIZE;
+    std::mt19937_64 gen(BENCH_BUFFER_SIZE);
+
+    std::vector<COEFF> coeffs(5 * sections);
+    std::vector<SAMPLE> naiveCoeffs(5 * sections);
+    const double w0 = 2 * FIXED_CONST_PI / 20;
+    for(fast32 s = 0; s < sections; s++){
+        const double Q = 1 / (2 * std::cos(FIXED_CONST_PI * (2 * s + 1) /
+                                           (8 * sections)));
+        const double alpha = std::sin(w0) / (2 * Q);
+        const double a0 = 1 + alpha;
+        const double c[5] = {(1 - std::cos(w0)) / 2 / a0,
+                             (1 - std::cos(w0)) / a0,
+                             (1 - std::cos(w0)) / 2 / a0,
+                             -2 * std::cos(w0) / a0, (1 - alpha) / a0};
+        for(fast32 i = 0; i < 5; i++){
+            coeffs[5 * s + i] = COEFF(c[i]);
+            naiveCoeffs[5 * s + i] = SAMPLE(c[i]);
+        }
+    }
+
+    std::vector<SAMPLE> src(BENCH_BUFFER_SIZE), dst(BENCH_BUFFER_SIZE),
+                        naiveDst(BENCH_BUFFER_SIZE), state(4 * sections);
+    benchFillQuarter(src, gen);
+    FixedBiquad<COEFF, SAMPLE> biquad(coeffs.data(), sections);
+
+    auto naive = [&]{
+        for(fast32 n = 0; n < BENCH_BUFFER_SIZE; n++){
+            SAMPLE x = src[n];
+            for(fast32 s = 0; s < sections; s++){
+                const SAMPLE *c = naiveCoeffs.data() + 5 * s;
+                SAMPLE *z = state.data() + 4 * s;
+                const SAMPLE y = c[0] * x + c[1] * z[0] + c[2] * z[1] -
+                                 c[3] * z[2] - c[4] * z[3];
+                z[1] = z[0];
+                z[0] = x;
+                z[3] = z[2];
+                z[2] = y;
+                x = y;
+            }
+            naiveDst[n] = x;
+        }
+        benchSink = naiveDst[0].getRawNumber();
+    };
+    auto filter = [&]{
+        biquad.process(dst.data(), src.data(), dst.size());
+        benchSink = dst[0].getRawNumber();
+    };
+
+    // The exact output keeps every bit of the state, with the same
+    // quantized coefficients as the filter
+    naive();
+    filter();
+    std::vector<long double> exact(BENCH_BUFFER_SIZE), y(BENCH_BUFFER_SIZE);
+    for(fast32 n = 0; n < BENCH_BUFFER_SIZE; n++)
+        exact[n] = src[n].toDouble();
+    for(fast32 s = 0; s < sections; s++){
+        const COEFF *c = coeffs.data() + 5 * s;
+        for(fast32 n = 0; n < BENCH_BUFFER_SIZE; n++){
+            y[n] = c[0].toDouble() * exact[n];
+            if(n >= 1) y[n] += c[1].toDouble() * exact[n - 1] -
+                               c[3].toDouble() * y[n - 1];
+            if(n >= 2) y[n] += c[2].toDouble() * exact[n - 2] -
+                               c[4].toDouble() * y[n - 2];
+        }
+        exact.swap(y);
+    }
+    long double naiveErr = 0, filterErr = 0;
+    for(fast32 n = 0; n < BENCH_BUFFER_SIZE; n++){
+        naiveErr = std::fmax(naiveErr, std::fabs(naiveDst[n].toDouble() -
+                                                 exact[n]));
+        filterErr = std::fmax(filterErr, std::fabs(dst[n].toDouble() -
+                                                   exact[n]));
+    }
+
+    benchFilterReport<SAMPLE>(out, name, sections, samples,
+                              benchSeconds(naive, reps),
+                              benchSeconds(filter, reps),
+                              naiveErr, filterErr);
+}
+
+inline void runFilterBenchmarks(std::ostream &out){
+    out << "Filters, millions of samples/second, max error in sample LSBs\n"
+        << "  naive:  operator* and operator+= in the sample format\n"
+        << "  filter: FixedFir and FixedBiquad, one rounding per output\n"
+        << std::left << std::setw(32) << "FIR Coefficient, Sample"
+        << std::right << std::setw(6) << "taps"
+        << std::setw(9) << "naive" << std::setw(9) << "filter"
+        << std::setw(12) << "naive err" << std::setw(12) << "filter err"
+        << std::endl;
+
+    benchFirFormat<Fixed<1, 14>, Fixed<1, 14> >(
+        out, "Fixed<1, 14>, Fixed<1, 14>", 32);
+    benchFirFormat<Fixed<1, 14>, Fixed<1, 14> >(
+        out, "Fixed<1, 14>, Fixed<1, 14>", 128);
+    benchFirFormat<Fixed<1, 14>, Fixed<16, 15> >(
+        out, "Fixed<1, 14>, Fixed<16, 15>", 32);
+    benchFirFormat<Fixed<1, 30>, Fixed<1, 30> >(
+        out, "Fixed<1, 30>, Fixed<1, 30>", 32);
+
+    out << std::left << std::setw(32) << "Biquad Coefficient, Sample"
+        << std::right << std::setw(6) << "secs" << std::endl;
+    benchBiquadFormat<Fixed<2, 13>, Fixed<2, 13> >(
+        out, "Fixed<2, 13>, Fixed<2, 13>", 2);
+    benchBiquadFormat<Fixed<2, 29>, Fixed<16, 15> >(
+        out, "Fixed<2, 29>, Fixed<16, 15>", 2);
+    benchBiquadFormat<Fixed<2, 29>, Fixed<2, 29> >(
+        out, "Fixed<2, 29>, Fixed<2, 29>", 4);
+}
+
+// Times one function over src: the iterative version from FixedMath.h if
+// there is one, a round trip through the <cmath> double function, the
+// FixedExpLog.h version, and the batch version. ref takes double or long double, errors
+// are the max in LSBs against long double, with the answer clamped to the
+// format's range.
+template<class FIXED, class ITER, class LIB, class BATCH, class REF>
+void benchExpLogFunction(std::ostream &out, const char *name,
+                         const char *func, const std::vector<FIXED> &src,
+                         bool hasIter, ITER iter, LIB lib, BATCH batch,
+                         REF ref){
+    const fast32 reps = BENCH_ELEMENTS / BENCH_BUFFER_SIZE / 16;
+    const double calls = CAST<double>(reps) * BENCH_BUFFER_SIZE;
+    const fastu16 FRAC = FIXED::FRAC_BITS;
+    std::vector<FIXED> dst(BENCH_BUFFER_SIZE);
+
+    const long double hi = std::ldexp(CAST<long double>(
+        FIXED().getMaxValue().getRawNumber()), -FRAC);
+    const long double lo = std::ldexp(CAST<long double>(
+        FIXED().getMinValue().getRawNumber()), -FRAC);
+    long double iterErr = 0, libErr = 0;
+    for(const FIXED &x : src){
+        const long double want = std::fmin(std::fmax(ref(std::ldexp(
+            CAST<long double>(x.getRawNumber()), -FRAC)), lo), hi);
+        auto lsbs = [&](const FIXED &got){
+            return std::fabs(std::ldexp(CAST<long double>(
+                got.getRawNumber()), -FRAC) - want) * std::ldexp(1.0L, FRAC);
+        };
+        if(hasIter) iterErr = std::fmax(iterErr, lsbs(iter(x)));
+        libErr = std::fmax(libErr, lsbs(lib(x)));
+    }
+
+    auto time = [&](auto f){
+        return calls / benchSeconds([&]{
+            for(fast32 i = 0; i < BENCH_BUFFER_SIZE; i++) dst[i] = f(src[i]);
+            benchSink = dst[0].getRawNumber();
+        }, reps) / 1e6;
+    };
+    const double iterRate = (hasIter) ? time(iter) : 0;
+    const double doubleRate = time([&](const FIXED &x){
+        return FIXED(ref(x.toDouble()));
+    });
+    const double libRate = time(lib);
+    const double batchRate = calls / benchSeconds([&]{
+        batch(dst.data(), src.data(), dst.size());
+        benchSink = dst[0].getRawNumber();
+    }, reps) / 1e6;
+
+    out << std::left << std::setw(16) << name << std::setw(7) << func
+        << std::right << std::fixed << std::setprecision(1);
+    if(hasIter) out << std::setw(8) << iterRate;
+    else out << std::setw(8) << "-";
+    out << std::setw(8) << doubleRate << std::setw(8) << libRate
+        << std::setw(8) << batchRate << std::setprecision(2);
+    if(hasIter) out << std::setw(12) << CAST<double>(iterErr);
+    else out << std::setw(12) << "-";
+    out << std::setw(12) << CAST<double>(libErr) << std::endl;
+}
+
+template<fastu16 INT, fastu16 FRAC>
+void benchExpLogFormat(std::ostream &out, const char *name){
+    typedef Fixed<INT, FRAC> fixed;
+    std::mt19937_64 gen(BENCH_BUFFER_SIZE);
+    std::uniform_real_distribution<double> expRange(-4, 4), logRange(0, 64);
+
+    // exp over [-4, 4], the rest over (0, 64]
+    std::vector<fixed> expSrc(BENCH_BUFFER_SIZE), logSrc(BENCH_BUFFER_SIZE);
+    for(fast32 i = 0; i < BENCH_BUFFER_SIZE; i++){
+        expSrc[i] = fixed(expRange(gen));
+        logSrc[i] = fixed(logRange(gen));
+        if(logSrc[i].getRawNumber() <= 0) logSrc[i].setRawNumber(1);
+    }
+
+    auto none = [](const fixed &x){ return x;};
+    benchExpLogFunction(out, name, "exp2", expSrc, false, none,
+        [](const fixed &x){ return Fixed_exp2Table(x);},
+        Fixed_batchExp2<INT, FRAC, SIGNED, FIXED_WRAP>,
+        [](auto x){ return std::exp2(x);});
+    benchExpLogFunction(out, "", "exp", expSrc, true,
+        [](const fixed &x){ return Fixed_exp(x);},
+        [](const fixed &x){ return Fixed_expTable(x);},
+        Fixed_batchExp<INT, FRAC, SIGNED, FIXED_WRAP>,
+        [](auto x){ return std::exp(x);});
+    benchExpLogFunction(out, "", "log2", logSrc, true,
+        [](const fixed &x){ return Fixed_Log2(x);},
+        [](const fixed &x){ return Fixed_log2Table(x);},
+        Fixed_batchLog2<INT, FRAC, SIGNED, FIXED_WRAP>,
+        [](auto x){ return std::log2(x);});
+    benchExpLogFunction(out, "", "ln", logSrc, false, none,
+        [](const fixed &x){ return Fixed_lnTable(x);},
+        Fixed_batchLn<INT, FRAC, SIGNED, FIXED_WRAP>,
+        [](auto x){ return std::log(x);});
+    benchExpLogFunction(out, "", "sqrt", logSrc, false, none,
+        [](const fixed &x){ return Fixed_sqrt(x);},
+        Fixed_batchSqrt<INT, FRAC, SIGNED, FIXED_WRAP>,
+        [](auto x){ return std::sqrt(x);});
+    benchExpLogFunction(out, "", "rsqrt", logSrc, false, none,
+        [](const fixed &x){ return Fixed_rsqrt(x);},
+        Fixed_batchRsqrt<INT, FRAC, SIGNED, FIXED_WRAP>,
+        [](auto x){ return 1 / std::sqrt(x);});
+}
+
+inline void runExpLogBenchmarks(std::ostream &out){
+    out << "exp/log/sqrt, millions of calls/second, max error in LSBs\n"
+        << "  iter:   Fixed_exp and Fixed_Log2 from FixedMath.h\n"
+        << "  double: toDouble(), the <cmath> function, and back\n"
+        << "  lib, batch: FixedExpLog.h, table exp and log, and sqrt and\n"
+        << "              rsqrt from the <cmath> double root, rounded\n"
+        << std::left << std::setw(16) << "Format" << std::setw(7) << "Func"
+        << std::right << std::setw(8) << "iter" << std::setw(8) << "double"
+        << std::setw(8) << "lib" << std::setw(8) << "batch"
+        << std::setw(12) << "iter err" << std::setw(12) << "lib err"
+        << std::endl;
+
+    benchExpLogFormat<7, 8>(out, "Fixed<7, 8>");
+    benchExpLogFormat<16, 15>(out, "Fixed<16, 15>");
+    benchExpLogFormat<8, 23>(out, "Fixed<8, 23>");
+    benchExpLogFormat<30, 33>(out, "Fixed<30, 33>");
+}
+
+// Plain radix 2 FFT in float or double, the baseline for FixedFFT
+template<class T>
+void benchFloatFFT(std::vector<std::complex<T> > &data,
+                   const std::vector<std::complex<T> > &twiddles){
+    const std::size_t n = data.size();
+    for(std::size_t i = 1, j = 0; i < n; i++){
+        std::size_t bit = n >> 1;
+        for(; j & bit; bit >>= 1) j ^= bit;
+        j ^= bit;
+        if(i < j) std::swap(data[i], data[j]);
+    }
+    for(std::size_t m = 1; m < n; m *= 2){
+        const std::size_t step = n / (2 * m);
+        for(std::size_t base = 0; base < n; base += 2 * m){
+            for(std::size_t j = 0; j < m; j++){
+                const std::complex<T> a = data[base + j];
+                const std::complex<T> b = data[base + j + m] *
+                                          twiddles[j * step];
+                data[base + j] = a + b;
+                data[base + j + m] = a - b;
+            }
+        }
+    }
+}
+
+template<class T>
+std::vector<std::complex<T> > benchTwiddles(std::size_t n){
+    std::vector<std::complex<T> > ret(n / 2);
+    for(std::size_t k = 0; k < n / 2; k++)
+        ret[k] = std::polar(CAST<T>(1), CAST<T>(-2 * M_PI * k / n));
+    return ret;
+}
+
+// Signal to noise ratio in dB of spectrum * 2^exp against exact
+template<class COMPLEX>
+double benchSpectrumSNR(const COMPLEX *spectrum, fast16 exp,
+                        const std::vector<std::complex<double> > &exact,
+                        std::size_t bins){
+    double signal = 0, noise = 0;
+    for(std::size_t k = 0; k < bins; k++){
+        const std::complex<double> x(
+            std::ldexp(spectrum[k].re.toDouble(), exp),
+            std::ldexp(spectrum[k].im.toDouble(), exp));
+        signal += std::norm(exact[k]);
+        noise += std::norm(x - exact[k]);
+    }
+    return 10 * std::log10(signal / noise);
+}
+
+inline double benchSpectrumSNR(const std::vector<std::complex<float> > &
+                               spectrum,
+                               const std::vector<std::complex<double> > &
+                               exact){
+    double signal = 0, noise = 0;
+    for(std::size_t k = 0; k < exact.size(); k++){
+        const std::complex<double> x(spectrum[k]);
+        signal += std::norm(exact[k]);
+        noise += std::norm(x - exact[k]);
+    }
+    return 10 * std::log10(signal / noise);
+}
+
+// Times 2^BITS point transforms of random numbers in [-1/2, 1/2): the
+// complex FFT, the real FFT, and a round trip through float. Each rep
+// copies the input first, for all three.
+template<fastu16 INT, fastu16 FRAC, fastu16 BITS>
+void benchFFTSize(std::ostream &out, const char *name){
+    typedef FixedFFT<INT, FRAC, BITS> fft;
+    typedef typename fft::fixed fixed;
+    typedef typename fft::complex complex;
+    const std::size_t n = fft::SIZE;
+    const fast32 reps = std::max<fast32>(1, BENCH_ELEMENTS / 16 / n);
+    std::mt19937_64 gen(BENCH_BUFFER_SIZE);
+    std::uniform_real_distribution<double> dist(-0.5, 0.5);
+
+    std::vector<complex> src(n), work(n);
+    std::vector<fixed> realSrc(n);
+    std::vector<std::complex<double> > exact(n), realExact(n);
+    for(std::size_t i = 0; i < n; i++){
+        src[i].re = fixed(dist(gen));
+        src[i].im = fixed(dist(gen));
+        realSrc[i] = fixed(dist(gen));
+        exact[i] = std::complex<double>(src[i].re.toDouble(),
+                                        src[i].im.toDouble());
+        realExact[i] = realSrc[i].toDouble();
+    }
+    const std::vector<std::complex<double> > twiddlesD =
+        benchTwiddles<double>(n);
+    benchFloatFFT(exact, twiddlesD);
+    benchFloatFFT(realExact, twiddlesD);
+
+    fast16 exp = 0, realExp = 0;
+    auto complexFFT = [&](){
+        std::copy(src.begin(), src.end(), work.begin());
+        exp = fft::forward(work.data());
+        benchSink = work[1].re.getRawNumber();
+    };
+    auto realFFT = [&](){
+        realExp = fft::forwardReal(work.data(), realSrc.data());
+        benchSink = work[1].re.getRawNumber();
+    };
+
+    // Back to Fixed with the 1/N the block exponent would otherwise hold.
+    // The float spectrum is the one checked, before it loses bits to that.
+    const std::vector<std::complex<float> > twiddles =
+        benchTwiddles<float>(n);
+    std::vector<std::complex<float> > floats(n);
+    std::vector<complex> floatDst(n);
+    auto floatFFT = [&](){
+        for(std::size_t i = 0; i < n; i++)
+            floats[i] = std::complex<float>(src[i].re.toFloat(),
+                                            src[i].im.toFloat());
+        benchFloatFFT(floats, twiddles);
+        for(std::size_t i = 0; i < n; i++){
+            floatDst[i].re = fixed(std::ldexp(floats[i].real(), -BITS));
+            floatDst[i].im = fixed(std::ldexp(floats[i].imag(), -BITS));
+        }
+        benchSink = floatDst[1].re.getRawNumber();
+    };
+
+    const double us = 1e6 / reps;
+    const double complexTime = benchSeconds(complexFFT, reps) * us;
+    const double complexSNR = benchSpectrumSNR(work.data(), exp, exact, n);
+    const double realTime = benchSeconds(realFFT, reps) * us;
+    const double realSNR = benchSpectrumSNR(work.data(), realExp, realExact,
+                                            n / 2 + 1);
+    const double floatTime = benchSeconds(floatFFT, reps) * us;
+    const double floatSNR = benchSpectrumSNR(floats, exact);
+
+    out << std::left << std::setw(16) << name << std::right << std::fixed
+        << std::setw(7) << n << std::setprecision(1)
+        << std::setw(10) << complexTime << std::setw(10) << realTime
+        << std::setw(10) << floatTime << std::setw(9) << complexSNR
+        << std::setw(9) << realSNR << std::setw(9) << floatSNR << std::endl;
+}
+
+template<fastu16 INT, fastu16 FRAC>
+void benchFFTFormat(std::ostream &out, const char *name){
+    benchFFTSize<INT, FRAC, 8>(out, name);
+    benchFFTSize<INT, FRAC, 10>(out, "");
+    benchFFTSize<INT, FRAC, 12>(out, "");
+    benchFFTSize<INT, FRAC, 14>(out, "");
+    benchFFTSize<INT, FRAC, 16>(out, "");
+}
+
+inline void runFFTBenchmarks(std::ostream &out){
+    out << "FFT, microseconds per transform, signal to noise in dB\n"
+        << "  complex: FixedFFT forward, N complex points\n"
+        << "  real:    FixedFFT forwardReal, N real points\n"
+        << "  float:   toFloat(), a radix 2 float FFT, and back\n"
+        << std::left << std::setw(16) << "Format" << std::right
+        << std::setw(7) << "N" << std::setw(10) << "complex"
+        << std::setw(10) << "real" << std::setw(10) << "float"
+        << std::setw(9) << "cpx dB" << std::setw(9) << "real dB"
+        << std::setw(9) << "flt dB" << std::endl;
+
+    benchFFTFormat<1, 14>(out, "Fixed<1, 14>");
+    benchFFTFormat<1, 30>(out, "Fixed<1, 30>");
+}
+
+// Raw number as a long double, exact for every format on x86
+template<class FIXED>
+long double benchToLongDouble(const FIXED &x){
+    return std::ldexp(CAST<long double>(x.getRawNumber()), -FIXED::FRAC_BITS);
+}
+
+// Max difference of got and exact, in FIXED LSBs
+template<class FIXED>
+double benchMaxLSB(const std::vector<FIXED> &got,
+                   const std::vector<long double> &exact){
+    long double ret = 0;
+    for(std::size_t i = 0; i < got.size(); i++)
+        ret = std::fmax(ret, std::fabs(benchToLongDouble(got[i]) -
+                                       exact[i]));
+    return CAST<double>(std::ldexp(ret, FIXED::FRAC_BITS));
+}
+
+// dst = m * v the way it is written without FixedMatrix.h, with T being
+// Fixed or float
+template<class T, fastu16 R, fastu16 C>
+void benchLoopMul(const T (&m)[R][C], const T *v, T *dst){
+    for(fastu16 r = 0; r < R; r++){
+        T acc = 0;
+        for(fastu16 c = 0; c < C; c++) acc += m[r][c] * v[c];
+        dst[r] = acc;
+    }
+}
+
+// Rotation matrix of the unit quaternion {w, x, y, z}, T as above
+template<class T>
+void benchQuatMatrix(const T *q, T (&m)[3][3]){
+    const T one = 1, two = 2;
+    m[0][0] = one - two * (q[2] * q[2] + q[3] * q[3]);
+    m[0][1] = two * (q[1] * q[2] - q[0] * q[3]);
+    m[0][2] = two * (q[1] * q[3] + q[0] * q[2]);
+    m[1][0] = two * (q[1] * q[2] + q[0] * q[3]);
+    m[1][1] = one - two * (q[1] * q[1] + q[3] * q[3]);
+    m[1][2] = two * (q[2] * q[3] - q[0] * q[1]);
+    m[2][0] = two * (q[1] * q[3] - q[0] * q[2]);
+    m[2][1] = two * (q[2] * q[3] + q[0] * q[1]);
+    m[2][2] = one - two * (q[1] * q[1] + q[2] * q[2]);
+}
+
+template<class FIXED>
+void benchMatrixReport(std::ostream &out, const char *name, const char *op,
+                       double ops, double loop, double matrix, double flt,
+                       const std::vector<FIXED> &loopDst,
+                       const std::vector<FIXED> &matrixDst,
+                       const std::vector<long double> &exact){
+    const double M = 1e6;
+    out << std::left << std::setw(16) << name << std::setw(14) << op
+        << std::right << std::fixed << std::setprecision(1)
+        << std::setw(9) << ops / loop / M << std::setw(9) << ops / matrix / M
+        << std::setw(9) << ops / flt / M << std::setprecision(3)
+        << std::setw(11) << benchMaxLSB(loopDst, exact)
+        << std::setw(11) << benchMaxLSB(matrixDst, exact) << std::endl;
+}
+
+// Numbers are uniform in [-range, range). Each op reads its input from a
+// buffer and writes every output number to a flat buffer.
+template<fastu16 INT, fastu16 FRAC>
+void benchMatrixFormat(std::ostream &out, const char *name, double range){
+    typedef Fixed<INT, FRAC> fixed;
+    typedef FixedVec<fixed, 3> vec3;
+    typedef FixedVec<fixed, 4> vec4;
+    typedef FixedMat<fixed, 3, 3> mat3;
+    typedef FixedMat<fixed, 4, 4> mat4;
+    const fast32 reps = BENCH_ELEMENTS / BENCH_BUFFER_SIZE / 16;
+    const fast32 MATS = BENCH_BUFFER_SIZE / 16;
+    std::mt19937_64 gen(BENCH_BUFFER_SIZE);
+    std::uniform_real_distribution<double> dist(-range, range);
+
+    mat4 A{};
+    float AF[4][4];
+    for(fastu16 r = 0; r < 4; r++){
+        for(fastu16 c = 0; c < 4; c++){
+            A(r, c) = fixed(dist(gen));
+            AF[r][c] = A(r, c).toFloat();
+        }
+    }
+    mat3 A3{};
+    float A3F[3][3];
+    for(fastu16 r = 0; r < 3; r++){
+        for(fastu16 c = 0; c < 3; c++){
+            A3(r, c) = A(r, c);
+            A3F[r][c] = AF[r][c];
+        }
+    }
+
+    std::vector<vec4> src(BENCH_BUFFER_SIZE);
+    std::vector<vec3> src3(BENCH_BUFFER_SIZE);
+    std::vector<float> srcF(4 * BENCH_BUFFER_SIZE);
+    for(fast32 i = 0; i < BENCH_BUFFER_SIZE; i++){
+        for(fastu16 k = 0; k < 4; k++){
+            src[i][k] = fixed(dist(gen));
+            srcF[4 * i + k] = src[i][k].toFloat();
+            if(k < 3) src3[i][k] = src[i][k];
+        }
+    }
+    std::vector<mat4> mats(MATS);
+    for(auto &m : mats)
+        for(fastu16 r = 0; r < 4; r++)
+            for(fastu16 c = 0; c < 4; c++)
+                m(r, c) = fixed(dist(gen));
+
+    // A unit axis, and an angle in [-pi, pi)
+    std::uniform_real_distribution<double> angleDist(-3.14159, 3.14159);
+    double axis[3] = {dist(gen), dist(gen), dist(gen)};
+    const double length = std::sqrt(axis[0] * axis[0] + axis[1] * axis[1] +
+                                    axis[2] * axis[2]);
+    const FixedQuat<INT, FRAC> q = FixedQuat<INT, FRAC>::fromAxisAngle(
+        {{fixed(axis[0] / length), fixed(axis[1] / length),
+          fixed(axis[2] / length)}}, fixed(angleDist(gen)));
+    const fixed qFixed[4] = {q.w, q.x, q.y, q.z};
+    const float qFloat[4] = {q.w.toFloat(), q.x.toFloat(), q.y.toFloat(),
+                             q.z.toFloat()};
+
+    std::vector<fixed> loopDst(4 * BENCH_BUFFER_SIZE);
+    std::vector<fixed> matrixDst(4 * BENCH_BUFFER_SIZE);
+    std::vector<float> floatDst(16 * MATS);
+    std::vector<long double> exact(4 * BENCH_BUFFER_SIZE);
+    const double ops = CAST<double>(reps) * BENCH_BUFFER_SIZE;
+
+    // mat3 * vec3
+    loopDst.resize(3 * BENCH_BUFFER_SIZE);
+    matrixDst.resize(3 * BENCH_BUFFER_SIZE);
+    exact.resize(3 * BENCH_BUFFER_SIZE);
+    const double loop3 = benchSeconds([&]{
+        for(fast32 i = 0; i < BENCH_BUFFER_SIZE; i++)
+            benchLoopMul(A3.value, src3[i].value, &loopDst[3 * i]);
+        benchSink = loopDst[0].getRawNumber();
+    }, reps);
+    const double matrix3 = benchSeconds([&]{
+        for(fast32 i = 0; i < BENCH_BUFFER_SIZE; i++){
+            const vec3 v = A3 * src3[i];
+            for(fastu16 k = 0; k < 3; k++) matrixDst[3 * i + k] = v[k];
+        }
+        benchSink = matrixDst[0].getRawNumber();
+    }, reps);
+    const double float3 = benchSeconds([&]{
+        for(fast32 i = 0; i < BENCH_BUFFER_SIZE; i++)
+            benchLoopMul(A3F, &srcF[4 * i], &floatDst[3 * (i % MATS)]);
+        benchSink = CAST<fast64>(floatDst[0]);
+    }, reps);
+    for(fast32 i = 0; i < BENCH_BUFFER_SIZE; i++)
+        for(fastu16 r = 0; r < 3; r++){
+            exact[3 * i + r] = 0;
+            for(fastu16 c = 0; c < 3; c++)
+                exact[3 * i + r] += benchToLongDouble(A3(r, c)) *
+                                    benchToLongDouble(src3[i][c]);
+        }
+    benchMatrixReport(out, name, "mat3 * vec3", ops, loop3, matrix3, float3,
+                      loopDst, matrixDst, exact);
+
+    // mat4 * vec4
+    loopDst.resize(4 * BENCH_BUFFER_SIZE);
+    matrixDst.resize(4 * BENCH_BUFFER_SIZE);
+    exact.resize(4 * BENCH_BUFFER_SIZE);
+    const double loop4 = benchSeconds([&]{
+        for(fast32 i = 0; i < BENCH_BUFFER_SIZE; i++)
+            benchLoopMul(A.value, src[i].value, &loopDst[4 * i]);
+        benchSink = loopDst[0].getRawNumber();
+    }, reps);
+    const double matrix4 = benchSeconds([&]{
+        for(fast32 i = 0; i < BENCH_BUFFER_SIZE; i++){
+            const vec4 v = A * src[i];
+            for(fastu16 k = 0; k < 4; k++) matrixDst[4 * i + k] = v[k];
+        }
+        benchSink = matrixDst[0].getRawNumber();
+    }, reps);
+    const double float4 = benchSeconds([&]{
+        for(fast32 i = 0; i < BENCH_BUFFER_SIZE; i++)
+            benchLoopMul(AF, &srcF[4 * i], &floatDst[4 * (i % MATS)]);
+        benchSink = CAST<fast64>(floatDst[0]);
+    }, reps);
+    for(fast32 i = 0; i < BENCH_BUFFER_SIZE; i++)
+        for(fastu16 r = 0; r < 4; r++){
+            exact[4 * i + r] = 0;
+            for(fastu16 c = 0; c < 4; c++)
+                exact[4 * i + r] += benchToLongDouble(A(r, c)) *
+                                    benchToLongDouble(src[i][c]);
+        }
+    benchMatrixReport(out, "", "mat4 * vec4", ops, loop4, matrix4, float4,
+                      loopDst, matrixDst, exact);
+
+    // mat4 * mat4, over MATS right hand sides 16 times as often, for the
+    // same number of ops as the others
+    loopDst.resize(16 * MATS);
+    matrixDst.resize(16 * MATS);
+    exact.resize(16 * MATS);
+    std::vector<float> matsF(16 * MATS);
+    for(fast32 i = 0; i < MATS; i++)
+        for(fastu16 k = 0; k < 16; k++)
+            matsF[16 * i + k] = mats[i](k / 4, k % 4).toFloat();
+    const double loopM = benchSeconds([&]{
+        for(fast32 i = 0; i < MATS; i++)
+            for(fastu16 r = 0; r < 4; r++)
+                for(fastu16 c = 0; c < 4; c++){
+                    fixed acc = 0;
+                    for(fastu16 k = 0; k < 4; k++)
+                        acc += A(r, k) * mats[i](k, c);
+                    loopDst[16 * i + 4 * r + c] = acc;
+                }
+        benchSink = loopDst[0].getRawNumber();
+    }, 16 * reps);
+    const double matrixM = benchSeconds([&]{
+        for(fast32 i = 0; i < MATS; i++){
+            const mat4 m = A * mats[i];
+            for(fastu16 k = 0; k < 16; k++)
+                matrixDst[16 * i + k] = m(k / 4, k % 4);
+        }
+        benchSink = matrixDst[0].getRawNumber();
+    }, 16 * reps);
+    const double floatM = benchSeconds([&]{
+        for(fast32 i = 0; i < MATS; i++)
+            for(fastu16 r = 0; r < 4; r++)
+                for(fastu16 c = 0; c < 4; c++){
+                    float acc = 0;
+                    for(fastu16 k = 0; k < 4; k++)
+                        acc += AF[r][k] * matsF[16 * i + 4 * k + c];
+                    floatDst[16 * i + 4 * r + c] = acc;
+                }
+        benchSink = CAST<fast64>(floatDst[0]);
+    }, 16 * reps);
+    for(fast32 i = 0; i < MATS; i++)
+        for(fastu16 k = 0; k < 16; k++){
+            exact[16 * i + k] = 0;
+            for(fastu16 j = 0; j < 4; j++)
+                exact[16 * i + k] += benchToLongDouble(A(k / 4, j)) *
+                                     benchToLongDouble(mats[i](j, k % 4));
+        }
+    benchMatrixReport(out, "", "mat4 * mat4", ops, loopM, matrixM, floatM,
+                      loopDst, matrixDst, exact);
+
+    // Quaternion rotation, the matrix worked out for every vector
+    loopDst.resize(3 * BENCH_BUFFER_SIZE);
+    matrixDst.resize(3 * BENCH_BUFFER_SIZE);
+    exact.resize(3 * BENCH_BUFFER_SIZE);
+    const double loopQ = benchSeconds([&]{
+        for(fast32 i = 0; i < BENCH_BUFFER_SIZE; i++){
+            fixed m[3][3];
+            benchQuatMatrix(qFixed, m);
+            benchLoopMul(m, src3[i].value, &loopDst[3 * i]);
+        }
+        benchSink = loopDst[0].getRawNumber();
+    }, reps);
+    const double matrixQ = benchSeconds([&]{
+        for(fast32 i = 0; i < BENCH_BUFFER_SIZE; i++){
+            const vec3 v = q.rotate(src3[i]);
+            for(fastu16 k = 0; k < 3; k++) matrixDst[3 * i + k] = v[k];
+        }
+        benchSink = matrixDst[0].getRawNumber();
+    }, reps);
+    const double floatQ = benchSeconds([&]{
+        for(fast32 i = 0; i < BENCH_BUFFER_SIZE; i++){
+            float m[3][3];
+            benchQuatMatrix(qFloat, m);
+            benchLoopMul(m, &srcF[4 * i], &floatDst[3 * (i % MATS)]);
+        }
+        benchSink = CAST<fast64>(floatDst[0]);
+    }, reps);
+    const long double qExact[4] = {benchToLongDouble(q.w),
+                                   benchToLongDouble(q.x),
+                                   benchToLongDouble(q.y),
+                                   benchToLongDouble(q.z)};
+    long double mExact[3][3];
+    benchQuatMatrix(qExact, mExact);
+    for(fast32 i = 0; i < BENCH_BUFFER_SIZE; i++)
+        for(fastu16 r = 0; r < 3; r++){
+            exact[3 * i + r] = 0;
+            for(fastu16 c = 0; c < 3; c++)
+                exact[3 * i + r] += mExact[r][c] *
+                                    benchToLongDouble(src3[i][c]);
+        }
+    benchMatrixReport(out, "", "quat rotate", ops, loopQ, matrixQ, floatQ,
+                      loopDst, matrixDst, exact);
+}
+
+inline void runMatrixBenchmarks(std::ostream &out){
+    out << "Vectors and matrices, millions of ops/second, max error in LSBs\n"
+        << "  loop:   loops over Fixed operator* and operator+=\n"
+        << "  matrix: FixedMatrix.h, one rounding per output\n"
+        << "  float:  the same loops over float numbers\n"
+        << std::left << std::setw(16) << "Format" << std::setw(14) << "Op"
+        << std::right << std::setw(9) << "loop" << std::setw(9) << "matrix"
+        << std::setw(9) << "float" << std::setw(11) << "loop err"
+        << std::setw(11) << "matrix err" << std::endl;
+
+    benchMatrixFormat<7, 8>(out, "Fixed<7, 8>", 4);
+    benchMatrixFormat<16, 15>(out, "Fixed<16, 15>", 100);
+    benchMatrixFormat<2, 29>(out, "Fixed<2, 29>", 0.5);
+#if ENABLE_DW_BIT_MATH == 1
+    benchMatrixFormat<20, 43>(out, "Fixed<20, 43>", 100);
+#endif // ENABLE_DW_BIT_MATH
+}
+
+// Times RESAMPLER over a 1 kHz sine at a quarter of full scale and prints
+// input and output samples/second, and the SNR against the exact sine at
+// each output's time, skipping the first taps outputs. The SNR counts the
+// filter's own roll off, which is what limits the sinc when downsampling.
+template<class RESAMPLER, class SAMPLE>
+void benchResampler(std::ostream &out, const char *name, fastu32 inRate,
+                    fastu32 outRate){
+    const fast32 reps = BENCH_ELEMENTS / BENCH_BUFFER_SIZE / 16;
+    const double M = 1e6;
+    const double hz = 2 * FIXED_CONST_PI * 1000 / inRate;
+
+    std::vector<SAMPLE> src(BENCH_BUFFER_SIZE);
+    for(fast32 n = 0; n < BENCH_BUFFER_SIZE; n++)
+        src[n] = SAMPLE(0.25 * std::sin(hz * n));
+
+    RESAMPLER resampler(inRate, outRate);
+    std::vector<SAMPLE> dst(resampler.maxOutput(BENCH_BUFFER_SIZE));
+    const std::size_t made = resampler.process(dst.data(), src.data(),
+                                               BENCH_BUFFER_SIZE);
+
+    // Output k sits at input time k * inRate / outRate - taps / 2
+    const double delay = resampler.getTaps() / 2.0;
+    long double signal = 0, noise = 0;
+    for(std::size_t k = resampler.getTaps(); k < made; k++){
+        const double exact = 0.25 * std::sin(hz * (CAST<double>(k) * inRate /
+                                                   outRate - delay));
+        signal += CAST<long double>(exact) * exact;
+        noise += std::pow(CAST<long double>(dst[k].toDouble()) - exact, 2);
+    }
+
+    std::size_t total = 0;
+    const double seconds = benchSeconds([&]{
+        total += resampler.process(dst.data(), src.data(), BENCH_BUFFER_SIZE);
+        benchSink = dst[0].getRawNumber();
+    }, reps);
+
+    out << std::left << std::setw(32) << name << std::right << std::fixed
+        << std::setw(14) << (std::to_string(inRate) + "->" +
+                             std::to_string(outRate))
+        << std::setprecision(1)
+        << std::setw(9) << CAST<double>(reps) * BENCH_BUFFER_SIZE / seconds / M
+        << std::setw(9) << total / seconds / M
+        << std::setw(9) << CAST<double>(10 * std::log10(signal / noise))
+        << std::endl;
+}
+
+template<class COEFF, class SAMPLE>
+void benchResampleFormat(std::ostream &out, const char *name){
+    const fastu32 rates[][2] = {{44100, 48000}, {48000, 44100},
+                                {48000, 16000}};
+    for(const auto &r : rates){
+        out << name << std::endl;
+        benchResampler<FixedLinearResampler<COEFF, SAMPLE>, SAMPLE>(
+            out, "  Linear", r[0], r[1]);
+        benchResampler<FixedHermiteResampler<COEFF, SAMPLE>, SAMPLE>(
+            out, "  Hermite", r[0], r[1]);
+        benchResampler<FixedSincResampler<COEFF, SAMPLE>, SAMPLE>(
+            out, "  Sinc, 16 taps", r[0], r[1]);
+    }
+}
+
+inline void runResampleBenchmarks(std::ostream &out){
+    out << "Resamplers, millions of samples/second in and out, SNR in dB\n"
+        << std::left << std::setw(32) << "Coefficient, Sample"
+        << std::right << std::setw(14) << "rates"
+        << std::setw(9) << "in" << std::setw(9) << "out"
+        << std::setw(9) << "SNR" << std::endl;
+
+    benchResampleFormat<Fixed<1, 14>, Fixed<1, 14> >(
+        out, "Fixed<1, 14>, Fixed<1, 14>");
+    benchResampleFormat<Fixed<1, 30>, Fixed<16, 15> >(
+        out, "Fixed<1, 30>, Fixed<16, 15>");
+}
+
+// Hash of the first BENCH_BUFFER_SIZE Fixed<4, 59> Gaussians from
+// FixedRandom<>(1), the same on every platform and compiler
+#define BENCH_NORMAL_HASH 0x9714B7A4C96E2FD0ULL
+
+// Times one generator filling a buffer of FIXED numbers: unit() and
+// uniform() in a loop, fillUnit(), normal() in a loop, fillNormal(), and
+// std::mt19937_64 with the <random> double distributions converted to
+// FIXED. Prints the Gaussian's variance against 1.
+template<class GEN, class FIXED>
+void benchRandomFormat(std::ostream &out, const char *name){
+    const fast32 reps = BENCH_ELEMENTS / BENCH_BUFFER_SIZE / 4;
+    const double M = CAST<double>(reps) * BENCH_BUFFER_SIZE / 1e6;
+    FixedRandom<GEN> rng(BENCH_BUFFER_SIZE);
+    std::mt19937_64 gen(BENCH_BUFFER_SIZE);
+    std::uniform_real_distribution<double> uniDist(0, 1);
+    std::normal_distribution<double> normDist(0, 1);
+    std::vector<FIXED> dst(BENCH_BUFFER_SIZE);
+    const FIXED lo(-1), hi(1);
+
+    const double unit = benchSeconds([&]{
+        for(fast32 i = 0; i < BENCH_BUFFER_SIZE; i++)
+            dst[i] = rng.template unit<FIXED>();
+        benchSink = dst[0].getRawNumber();
+    }, reps);
+    const double fill = benchSeconds([&]{
+        rng.fillUnit(dst.data(), dst.size());
+        benchSink = dst[0].getRawNumber();
+    }, reps);
+    const double uniform = benchSeconds([&]{
+        for(fast32 i = 0; i < BENCH_BUFFER_SIZE; i++)
+            dst[i] = rng.uniform(lo, hi);
+        benchSink = dst[0].getRawNumber();
+    }, reps);
+    const double stdUnit = benchSeconds([&]{
+        for(fast32 i = 0; i < BENCH_BUFFER_SIZE; i++)
+            dst[i] = FIXED(uniDist(gen));
+        benchSink = dst[0].getRawNumber();
+    }, reps);
+    const double normal = benchSeconds([&]{
+        for(fast32 i = 0; i < BENCH_BUFFER_SIZE; i++)
+            dst[i] = rng.template normal<FIXED>();
+        benchSink = dst[0].getRawNumber();
+    }, reps);
+    const double fillNormal = benchSeconds([&]{
+        rng.fillNormal(dst.data(), dst.size());
+        benchSink = dst[0].getRawNumber();
+    }, reps);
+    const double stdNormal = benchSeconds([&]{
+        for(fast32 i = 0; i < BENCH_BUFFER_SIZE; i++)
+            dst[i] = FIXED(normDist(gen));
+        benchSink = dst[0].getRawNumber();
+    }, reps);
+
+    // Variance of fresh normal() numbers, clamped ones included
+    long double var = 0;
+    for(fast32 r = 0; r < 64; r++){
+        rng.fillNormal(dst.data(), dst.size());
+        for(const FIXED &x : dst) var += std::pow(x.toDouble(), 2);
+    }
+    var /= 64.0 * BENCH_BUFFER_SIZE;
+
+    out << std::left << std::setw(32) << name << std::right << std::fixed
+        << std::setprecision(1)
+        << std::setw(8) << M / unit << std::setw(8) << M / fill
+        << std::setw(8) << M / uniform << std::setw(8) << M / stdUnit
+        << std::setw(8) << M / normal << std::setw(8) << M / fillNormal
+        << std::setw(9) << M / stdNormal << std::setprecision(4)
+        << std::setw(9) << CAST<double>(var) << std::endl;
+}
+
+inline void runRandomBenchmarks(std::ostream &out){
+    out << "Random numbers, millions of numbers/second\n"
+        << "  unit, uniform: FixedRandom::unit(), uniform(-1, 1) per number\n"
+        << "  fill:          FixedRandom::fillUnit()\n"
+        << "  normal, nfill: FixedRandom::normal() and fillNormal()\n"
+        << "  std, std norm: std::mt19937_64 with the <random> uniform and\n"
+        << "                 normal double distributions, then converted\n"
+        << std::left << std::setw(32) << "Generator, Format" << std::right
+        << std::setw(8) << "unit" << std::setw(8) << "fill"
+        << std::setw(8) << "uniform" << std::setw(8) << "std"
+        << std::setw(8) << "normal" << std::setw(8) << "nfill"
+        << std::setw(9) << "std norm" << std::setw(9) << "variance"
+        << std::endl;
+
+    benchRandomFormat<FixedXoshiro256, Fixed<1, 14> >(
+        out, "xoshiro256**, Fixed<1, 14>");
+    benchRandomFormat<FixedPcg32, Fixed<1, 14> >(out, "PCG32, Fixed<1, 14>");
+    benchRandomFormat<FixedXoshiro256, Fixed<16, 15> >(
+        out, "xoshiro256**, Fixed<16, 15>");
+    benchRandomFormat<FixedPcg32, Fixed<16, 15> >(
+        out, "PCG32, Fixed<16, 15>");
+    benchRandomFormat<FixedXoshiro256, Fixed<4, 59> >(
+        out, "xoshiro256**, Fixed<4, 59>");
+
+    // Same seed, same numbers, whatever the compiler, CPU or DW math
+    FixedRandom<> rng(1);
+    std::vector<Fixed<4, 59> > normals(BENCH_BUFFER_SIZE);
+    rng.fillNormal(normals.data(), normals.size());
+    fastu64 hash = 0;
+    for(const auto &x : normals)
+        hash = hash * 1000003 ^ CAST<fastu64>(x.getRawNumber());
+    out << "Gaussian known answer: "
+        << ((hash == BENCH_NORMAL_HASH) ? "bit exact" : "DIFFERENT")
+        << std::endl;
+}
+
+// Time stamp counter, fenced so the CPU can not start the timed code early
+// or finish it late, or 0 if the CPU does not have one
+inline fastu64 benchTicks(){
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_lfence();
+    const fastu64 ticks = __rdtsc();
+    _mm_lfence();
+    return ticks;
+#else
+    return 0;
+#endif
+}
+
+// Fewest ticks between two benchTicks(), taken off every timed update
+inline fastu64 benchTicksOverhead(){
+    fastu64 empty = ~CAST<fastu64>(0);
+    for(fast32 i = 0; i < 1000; i++){
+        const fastu64 start = benchTicks();
+        empty = std::min(empty, benchTicks() - start);
+    }
+    return empty;
+}
+
+inline double benchToDouble(double x){ return x;}
+
+// Motor speed loop for the PID benchmarks, one update per ms. The motor is
+// first order, speed += A * (K * drive - speed - load), with the drive a
+// PWM count in [-255, 255] like handleDCMotor() sets and the speed in
+// rad/s. The setpoint steps to 60, a constant load of 20 comes on, the
+// setpoint reverses to -40, then goes back to 0.
+#define BENCH_PID_UPDATES 4000
+#define BENCH_PID_RUNS    50
+
+template<class T> T benchMotorSetpoint(fast32 n){
+    return (n < 2000) ? T(60) : (n < 3000) ? T(-40) : T(0);
+}
+
+// Runs the motor once, control(setpoint, speed) returns the drive. Writes
+// the speed after every update to speeds.
+template<class T, class CONTROL>
+void benchMotorRun(std::vector<T> &speeds, CONTROL control){
+    const T A(0.02), K(0.4), LOAD(20);
+    T speed(0);
+    for(fast32 n = 0; n < BENCH_PID_UPDATES; n++){
+        const T drive = control(benchMotorSetpoint<T>(n), speed);
+        const T load = (n >= 1000) ? LOAD : T(0);
+        speed = speed + A * (K * drive - speed - load);
+        speeds[n] = speed;
+    }
+}
+
+// The FixedPID update in double, for the reference run
+struct BenchDoublePID{
+    double kp, ki, kd, alpha, outMin, outMax;
+    double integral, derivative, last;
+
+    double clamp(double x) const{ return std::fmin(outMax,
+                                                   std::fmax(outMin, x));}
+
+    double update(double setpoint, double measured){
+        const double error = setpoint - measured;
+        derivative += alpha * (-kd * (measured - last) - derivative);
+        last = measured;
+
+        const double step = ki * error;
+        const double next = clamp(integral + step);
+        const double wanted = kp * error + next + derivative;
+        const bool windup = (wanted > outMax && step > 0) ||
+                            (wanted < outMin && step < 0);
+        integral = (windup) ? integral : next;
+        return clamp(kp * error + integral + derivative);
+    }
+};
+
+// Gains of every motor run
+#define BENCH_PID_KP    6.0
+#define BENCH_PID_KI    0.2
+#define BENCH_PID_KD    4.0
+#define BENCH_PID_ALPHA 0.25
+
+// Hash of the drive of every update of the Fixed<3, 12>, Fixed<10, 5> run,
+// the same on every platform and compiler
+#define BENCH_PID_HASH 0xE560A05E5A27EA9CULL
+
+// Prints the cycles per update, sorted, and how the speed followed the
+// setpoint: the overshoot of the first step, the updates until it stays
+// within 2%, the largest dip when the load comes on, and the largest
+// difference from the double controller's run
+template<class T>
+void benchPIDReport(std::ostream &out, const char *name,
+                    std::vector<fastu64> &ticks, const std::vector<T> &speeds,
+                    const std::vector<double> &reference){
+    std::sort(ticks.begin(), ticks.end());
+    double mean = 0;
+    for(fastu64 t : ticks) mean += CAST<double>(t);
+    mean /= ticks.size();
+
+    double peak = 0, dip = 0, diff = 0;
+    fast32 settle = 0;
+    for(fast32 n = 0; n < BENCH_PID_UPDATES; n++){
+        const double speed = benchToDouble(speeds[n]);
+        if(n < 1000){
+            peak = std::fmax(peak, speed);
+            settle = (std::fabs(speed - 60) > 1.2) ? n + 1 : settle;
+        }
+        else if(n < 2000) dip = std::fmax(dip, 60 - speed);
+        diff = std::fmax(diff, std::fabs(speed - reference[n]));
+    }
+
+    out << std::left << std::setw(32) << name << std::right << std::fixed
+        << std::setprecision(1) << std::setw(8) << mean
+        << std::setw(8) << ticks[ticks.size() * 999 / 1000]
+        << std::setw(10) << ticks.back()
+        << std::setw(10) << 100 * std::fmax(0, peak - 60) / 60
+        << std::setw(8) << settle << std::setw(8) << dip
+        << std::setprecision(3) << std::setw(10) << diff << std::endl;
+}
+
+// Runs the motor with FixedPID<COEFF, SIGNAL>, the drive in SIGNAL, and the
+// motor in Fixed<16, 15>, so the whole loop is integer math. Every update
+// is timed on its own, less the time of timing nothing. The first run is
+// not timed, so the caches and branch predictor are warm. Returns the hash
+// of the drive of the last run.
+template<class COEFF, class SIGNAL>
+fastu64 benchPIDFormat(std::ostream &out, const char *name,
+                       const std::vector<double> &reference){
+    typedef Fixed<16, 15> motor;
+    FixedPID<COEFF, SIGNAL> pid(COEFF(BENCH_PID_KP), COEFF(BENCH_PID_KI),
+                                COEFF(BENCH_PID_KD), COEFF(BENCH_PID_ALPHA),
+                                SIGNAL(-255), SIGNAL(255));
+    const fastu64 empty = benchTicksOverhead();
+
+    std::vector<motor> speeds(BENCH_PID_UPDATES);
+    std::vector<fastu64> ticks;
+    ticks.reserve(BENCH_PID_RUNS * BENCH_PID_UPDATES);
+    fastu64 hash = 0;
+    for(fast32 run = 0; run <= BENCH_PID_RUNS; run++){
+        pid.reset();
+        hash = 0;
+        benchMotorRun(speeds, [&](const motor &setpoint, const motor &speed){
+            const SIGNAL s = setpoint.template fit<SIGNAL::INT_BITS,
+                                                   SIGNAL::FRAC_BITS>();
+            const SIGNAL y = speed.template fit<SIGNAL::INT_BITS,
+                                                SIGNAL::FRAC_BITS>();
+
+            const fastu64 start = benchTicks();
+            const SIGNAL drive = pid.update(s, y);
+            benchSink = drive.getRawNumber();
+            const fastu64 stop = benchTicks();
+
+            if(run > 0) ticks.push_back(std::max(stop - start, empty) - empty);
+            hash = hash * 1000003 ^ CAST<fastu64>(drive.getRawNumber());
+            return drive.template fit<motor::INT_BITS, motor::FRAC_BITS>();
+        });
+    }
+
+    benchPIDReport(out, name, ticks, speeds, reference);
+    return hash;
+}
+
+inline void runPIDBenchmarks(std::ostream &out){
+    out << "PID motor speed loop, " << BENCH_PID_UPDATES << " updates, "
+        << "cycles per update\n"
+        << "  p99.9, worst: 99.9th percentile and slowest update, which\n"
+        << "                counts any interrupt that hit it\n"
+        << "  overshoot:    percent over the first step of 60 rad/s\n"
+        << "  settle:       updates until the speed stays within 2%\n"
+        << "  dip:          rad/s lost when the load comes on\n"
+        << "  vs double:    largest rad/s from the double controller's run\n"
+        << std::left << std::setw(32) << "Gains, Signal" << std::right
+        << std::setw(8) << "mean" << std::setw(8) << "p99.9"
+        << std::setw(10) << "worst" << std::setw(10) << "overshoot"
+        << std::setw(8) << "settle" << std::setw(8) << "dip"
+        << std::setw(10) << "vs double" << std::endl;
+
+    // The reference run, in double, is also timed
+    BenchDoublePID ref{BENCH_PID_KP, BENCH_PID_KI, BENCH_PID_KD,
+                       BENCH_PID_ALPHA, -255, 255, 0, 0, 0};
+    std::vector<double> reference(BENCH_PID_UPDATES);
+    std::vector<fastu64> ticks;
+    const fastu64 empty = benchTicksOverhead();
+    for(fast32 run = 0; run <= BENCH_PID_RUNS; run++){
+        ref.integral = ref.derivative = ref.last = 0;
+        benchMotorRun(reference, [&](double setpoint, double speed){
+            const fastu64 start = benchTicks();
+            const double drive = ref.update(setpoint, speed);
+            benchSink = CAST<fast64>(drive);
+            const fastu64 stop = benchTicks();
+            if(run > 0) ticks.push_back(std::max(stop - start, empty) - empty);
+            return drive;
+        });
+    }
+    benchPIDReport(out, "double", ticks, reference, reference);
+
+    const fastu64 hash = benchPIDFormat<Fixed<3, 12>, Fixed<10, 5> >(
+        out, "Fixed<3, 12>, Fixed<10, 5>", reference);
+    benchPIDFormat<Fixed<7, 24>, Fixed<16, 15> >(
+        out, "Fixed<7, 24>, Fixed<16, 15>", reference);
+    out << "PID known answer: "
+        << ((hash == BENCH_PID_HASH) ? "bit exact" : "DIFFERENT")
+        << std::endl;
+}
+
+// Value written to benchSink for each type an op can return
+template<fastu16 INT, fastu16 FRAC, bool SIGN, FixedOverflow OVER>
+fast64 benchSinkValue(const Fixed<INT, FRAC, SIGN, OVER> &x){
+    return CAST<fast64>(x.getRawNumber());
+}
+template<class T> fast64 benchSinkValue(const T &x){ return CAST<fast64>(x);}
+
+// Adds each type an op can return to a hash, every bit of it
+template<class T> fastu64 benchHashValue(fastu64 hash, const T &x){
+    return hash * 1000003 ^ CAST<fastu64>(x);
+}
+template<bool SIGN>
+fastu64 benchHashValue(fastu64 hash, const FixedInt128<SIGN> &x){
+    return benchHashValue(benchHashValue(hash, x.hi), x.lo);
+}
+template<fastu16 INT, fastu16 FRAC, bool SIGN, FixedOverflow OVER>
+fastu64 benchHashValue(fastu64 hash, const Fixed<INT, FRAC, SIGN, OVER> &x){
+    return benchHashValue(hash, x.getRawNumber());
+}
+
+// Where the operator suite prints, and whether it times the ops or checks
+// them. A check runs every op once over the buffer, compares each result
+// with the reference if the format has one, and counts the mismatches.
+struct BenchSuite{
+    std::ostream &out;
+    bool check;
+    std::string prefix;
+    fast64 mismatches;
+};
+
+// Reference results for the operator suite, worked out from the raw
+// numbers in 128 bit math, so only formats up to 64 bits have one. The
+// rest, and the FixedMath.h functions, are checked by "make check", which
+// compares the result hashes of both ENABLE_DW_BIT_MATH modes.
+struct BenchNoReference{
+    static const bool exact = false;
+};
+
+template<fastu16 INT, fastu16 FRAC, bool SIGN,
+         bool EXACT = (INT + FRAC + SIGN <= 64)>
+struct BenchReference: BenchNoReference{};
+
+#ifdef __SIZEOF_INT128__
+template<fastu16 INT, fastu16 FRAC, bool SIGN>
+struct BenchReference<INT, FRAC, SIGN, true>{
+    typedef Fixed<INT, FRAC, SIGN> fixed;
+    typedef typename fixed::fixSize fixSize;
+    typedef typename std::conditional<SIGN, __int128,
+                                      unsigned __int128>::type wide;
+    static const bool exact = true;
+
+    static wide one(){ return CAST<wide>(1) << FRAC;}
+    static wide mask(){ return one() - 1;}
+    static wide raw(const fixed &x){ return x.getRawNumber();}
+
+    // Keeps the low bits, the same as the library's wrap
+    static fixed make(wide x){
+        fixed ret;
+        ret.setRawNumber(CAST<fixSize>(x));
+        return ret;
+    }
+
+    // Adds before clearing the fraction, the way round() does
+    static fixed roundUp(wide x, wide add){ return make((x + add) & ~mask());}
+
+    static fixed add(const fixed &L, const fixed &R){
+        return make(raw(L) + raw(R));
+    }
+    static fixed sub(const fixed &L, const fixed &R){
+        return make(raw(L) - raw(R));
+    }
+    // Rounded half up, the way the library rounds a product
+    static fixed mul(const fixed &L, const fixed &R){
+        return make((raw(L) * raw(R) + (one() >> 1)) >> FRAC);
+    }
+    // Truncated toward zero
+    static fixed div(const fixed &L, const fixed &R){
+        return make(raw(L) * one() / raw(R));
+    }
+    static fixed neg(const fixed &L){ return make(-raw(L));}
+    static fixed shl(const fixed &L){ return make(raw(L) * 8);}
+    static fixed shr(const fixed &L){ return make(raw(L) >> 3);}
+    static fast32 lt(const fixed &L, const fixed &R){
+        return raw(L) < raw(R);
+    }
+    static fast32 eq(const fixed &L, const fixed &R){
+        return raw(L) == raw(R);
+    }
+    static fixed abs(const fixed &L){
+        return make((raw(L) < 0) ? -raw(L) : raw(L));
+    }
+    static fixed floor(const fixed &L){ return roundUp(raw(L), 0);}
+    static fixed ceil(const fixed &L){ return roundUp(raw(L), mask());}
+    static fixed round(const fixed &L){ return roundUp(raw(L), one() >> 1);}
+    static fixed trunc(const fixed &L){
+        return roundUp(raw(L), (raw(L) < 0) ? mask() : 0);
+    }
+    static fixed roundEven(const fixed &L){
+        return roundUp(raw(L), (one() >> 1) - 1 + ((raw(L) >> FRAC) & 1));
+    }
+    // Keeps the sign, so L is its integer part plus its fraction
+    static fixed fraction(const fixed &L){
+        return make((raw(L) < 0) ? -(-raw(L) & mask()) : raw(L) & mask());
+    }
+    // Truncated toward zero
+    static fixed fromDouble(double num){
+        return make(CAST<wide>(std::ldexp(num, FRAC)));
+    }
+    static fast64 toDouble(const fixed &L){
+        return CAST<fast64>(std::ldexp(CAST<double>(raw(L)), -FRAC));
+    }
+    // Length of every digit of the exact value, at least one on each side
+    static fast32 toChars(const fixed &L){
+        wide magnitude = (raw(L) < 0) ? -raw(L) : raw(L);
+        wide frac = magnitude & mask();
+        fast32 length = (raw(L) < 0) + 1;
+        do{
+            length++;
+            magnitude /= 10;
+        }while(magnitude >= one());
+        do{
+            length++;
+            frac = frac * 10 & mask();
+        }while(frac != 0);
+        return length;
+    }
+    // Every digit was printed, so the text reads back exactly
+    static fixed fromChars(const fixed &L){ return L;}
+};
+#endif // __SIZEOF_INT128__
+
+// Looks up the reference result of element i, if REFERENCE has one
+template<class REFERENCE, class T, class CHECK>
+bool benchSuiteExpect(T &expected, fast32 i, CHECK check, std::true_type){
+    expected = check(REFERENCE(), i);
+    return true;
+}
+template<class REFERENCE, class T, class CHECK>
+bool benchSuiteExpect(T&, fast32, CHECK, std::false_type){ return false;}
+
+// Times op(i) over i < BENCH_BUFFER_SIZE for about BENCH_SUITE_SECONDS,
+// then the same count of reps again for the ticks, and prints one CSV line.
+// A check prints the mismatches with check(REFERENCE(), i) and the result
+// hash instead.
+template<class REFERENCE = BenchNoReference, class OP, class CHECK = fast32>
+void benchSuiteOp(BenchSuite &suite, const char *name, OP op,
+                  CHECK check = 0){
+    typedef decltype(op(0)) result;
+    std::vector<result> dst(BENCH_BUFFER_SIZE);
+
+    if(suite.check){
+        fastu64 hash = 0;
+        fast64 mismatches = 0;
+        for(fast32 i = 0; i < BENCH_BUFFER_SIZE; i++){
+            dst[i] = op(i);
+            hash = benchHashValue(hash, dst[i]);
+            result expected;
+            if(benchSuiteExpect<REFERENCE>(expected, i, check,
+                   std::integral_constant<bool, REFERENCE::exact>()) &&
+               !(dst[i] == expected) && mismatches++ == 0){
+                std::cerr << suite.prefix << name << ": element " << i
+                          << " is " << benchSinkValue(dst[i]) << ", expected "
+                          << benchSinkValue(expected) << std::endl;
+            }
+        }
+        suite.mismatches += mismatches;
+        suite.out << suite.prefix << name << "," << mismatches << ","
+                  << std::hex << hash << std::dec << std::endl;
+        return;
+    }
+
+    auto loop = [&]{
+        for(fast32 i = 0; i < BENCH_BUFFER_SIZE; i++) dst[i] = op(i);
+        benchSink = benchSinkValue(dst[0]);
+    };
+
+    const double once = benchSeconds(loop, 1);
+    const fast32 reps = CAST<fast32>(std::fmax(1, std::fmin(
+        BENCH_SUITE_SECONDS / std::fmax(once, 1e-9), 1 << 20)));
+    const double ops = CAST<double>(reps) * BENCH_BUFFER_SIZE;
+    const double seconds = benchSeconds(loop, reps);
+    const double ticks = benchCycles(loop, reps);
+
+    suite.out << suite.prefix << name << std::fixed << std::setprecision(3)
+              << "," << seconds / ops * 1e9 << ","
+              << ((ticks > 0) ? ops / ticks : 0) << std::endl;
+}
+
+// Uniform numbers in [low, high], clamped to the format
+template<class FIXED>
+std::vector<FIXED> benchSuiteRange(std::mt19937_64 &gen, double low,
+                                   double high){
+    const double max = benchToDouble(FIXED().getMaxValue());
+    const double min = benchToDouble(FIXED().getMinValue());
+    std::uniform_real_distribution<double> dist(std::fmax(low, min),
+                                                std::fmin(high, max));
+    std::vector<FIXED> ret(BENCH_BUFFER_SIZE);
+    for(auto &x : ret) x = FIXED(dist(gen));
+    return ret;
+}
+
+// FixedMath.h only has signed versions, up to 64 bits
+template<fastu16 INT, fastu16 FRAC>
+void benchSuiteMath(BenchSuite&, std::mt19937_64&, std::false_type){}
+
+template<fastu16 INT, fastu16 FRAC>
+void benchSuiteMath(BenchSuite &suite, std::mt19937_64 &gen,
+                    std::true_type){
+    typedef Fixed<INT, FRAC> fixed;
+    const std::vector<fixed> exps = benchSuiteRange<fixed>(gen, -2, 2);
+    std::vector<fixed> logs = benchSuiteRange<fixed>(gen, 0.01, 1000);
+    for(auto &x : logs) if(x.getRawNumber() <= 0) x.setRawNumber(1);
+    const std::vector<fixed> angles = benchSuiteRange<fixed>(gen, -3, 3);
+    const std::vector<fixed> units = benchSuiteRange<fixed>(gen, -1, 1);
+    const std::vector<fixed> ys = benchSuiteRange<fixed>(gen, -100, 100);
+    const std::vector<fixed> xs = benchSuiteRange<fixed>(gen, -100, 100);
+
+    benchSuiteOp(suite, "exp", [&](fast32 i){ return Fixed_exp(exps[i]);});
+    benchSuiteOp(suite, "log2", [&](fast32 i){ return Fixed_Log2(logs[i]);});
+    benchSuiteOp(suite, "sin", [&](fast32 i){ return Fixed_sin(angles[i]);});
+    benchSuiteOp(suite, "cos", [&](fast32 i){ return Fixed_cos(angles[i]);});
+    benchSuiteOp(suite, "tan", [&](fast32 i){ return Fixed_tan(angles[i]);});
+    benchSuiteOp(suite, "atan", [&](fast32 i){ return Fixed_atan(units[i]);});
+    benchSuiteOp(suite, "atan2", [&](fast32 i){
+        return Fixed_atan2(ys[i], xs[i]);});
+}
+
+// The first five CSV columns of every op of a format
+template<fastu16 INT, fastu16 FRAC, bool SIGN>
+std::string benchSuitePrefix(){
+    return std::to_string(ENABLE_DW_BIT_MATH) + "," +
+        std::to_string(INT) + "," + std::to_string(FRAC) + "," +
+        std::to_string(INT + FRAC + SIGN) + "," + std::to_string(SIGN) + ",";
+}
+
+template<fastu16 INT, fastu16 FRAC, bool SIGN>
+void benchSuiteFormat(BenchSuite &suite){
+    typedef Fixed<INT, FRAC, SIGN> fixed;
+    typedef BenchReference<INT, FRAC, SIGN> reference;
+    std::mt19937_64 gen(BENCH_BUFFER_SIZE);
+    suite.prefix = benchSuitePrefix<INT, FRAC, SIGN>();
+
+    // Raw numbers over the whole range, never zero. Text is one number
+    // per TO_CHARS_MAX chars.
+    std::vector<fixed> L(BENCH_BUFFER_SIZE), R(BENCH_BUFFER_SIZE);
+    benchFill(L, gen);
+    benchFill(R, gen);
+    const fastu16 WIDTH = fixed::TO_CHARS_MAX;
+    std::vector<char> text(BENCH_BUFFER_SIZE * WIDTH);
+    std::vector<fastu16> length(BENCH_BUFFER_SIZE);
+    for(fast32 i = 0; i < BENCH_BUFFER_SIZE; i++){
+        char *first = &text[i * WIDTH];
+        length[i] = L[i].toChars(first, first + WIDTH).ptr - first;
+    }
+    const std::vector<double> doubles = [&]{
+        std::vector<double> ret(BENCH_BUFFER_SIZE);
+        for(fast32 i = 0; i < BENCH_BUFFER_SIZE; i++)
+            ret[i] = benchToDouble(R[i]);
+        return ret;
+    }();
+
+    // The checks are generic lambdas, only built for formats that have a
+    // reference
+    benchSuiteOp<reference>(suite, "add", [&](fast32 i){ return L[i] + R[i];},
+        [&](auto ref, fast32 i){ return ref.add(L[i], R[i]);});
+    benchSuiteOp<reference>(suite, "sub", [&](fast32 i){ return L[i] - R[i];},
+        [&](auto ref, fast32 i){ return ref.sub(L[i], R[i]);});
+    benchSuiteOp<reference>(suite, "mul", [&](fast32 i){ return L[i] * R[i];},
+        [&](auto ref, fast32 i){ return ref.mul(L[i], R[i]);});
+    benchSuiteOp<reference>(suite, "div", [&](fast32 i){ return L[i] / R[i];},
+        [&](auto ref, fast32 i){ return ref.div(L[i], R[i]);});
+    benchSuiteOp<reference>(suite, "neg", [&](fast32 i){ return -L[i];},
+        [&](auto ref, fast32 i){ return ref.neg(L[i]);});
+    benchSuiteOp<reference>(suite, "shl", [&](fast32 i){ return L[i] << 3;},
+        [&](auto ref, fast32 i){ return ref.shl(L[i]);});
+    benchSuiteOp<reference>(suite, "shr", [&](fast32 i){ return L[i] >> 3;},
+        [&](auto ref, fast32 i){ return ref.shr(L[i]);});
+    benchSuiteOp<reference>(suite, "lt", [&](fast32 i){
+        return CAST<fast32>(L[i] < R[i]);},
+        [&](auto ref, fast32 i){ return ref.lt(L[i], R[i]);});
+    benchSuiteOp<reference>(suite, "eq", [&](fast32 i){
+        return CAST<fast32>(L[i] == R[i]);},
+        [&](auto ref, fast32 i){ return ref.eq(L[i], R[i]);});
+    benchSuiteOp<reference>(suite, "abs", [&](fast32 i){ return L[i].abs();},
+        [&](auto ref, fast32 i){ return ref.abs(L[i]);});
+    benchSuiteOp<reference>(suite, "floor", [&](fast32 i){
+        return L[i].floor();},
+        [&](auto ref, fast32 i){ return ref.floor(L[i]);});
+    benchSuiteOp<reference>(suite, "ceil", [&](fast32 i){ return L[i].ceil();},
+        [&](auto ref, fast32 i){ return ref.ceil(L[i]);});
+    benchSuiteOp<reference>(suite, "round", [&](fast32 i){
+        return L[i].round();},
+        [&](auto ref, fast32 i){ return ref.round(L[i]);});
+    benchSuiteOp<reference>(suite, "trunc", [&](fast32 i){
+        return L[i].trunc();},
+        [&](auto ref, fast32 i){ return ref.trunc(L[i]);});
+    benchSuiteOp<reference>(suite, "roundEven", [&](fast32 i){
+        return L[i].template round<FIXED_ROUND_HALF_EVEN>();},
+        [&](auto ref, fast32 i){ return ref.roundEven(L[i]);});
+    benchSuiteOp<reference>(suite, "fraction", [&](fast32 i){
+        return L[i].getFraction();},
+        [&](auto ref, fast32 i){ return ref.fraction(L[i]);});
+    benchSuiteOp<reference>(suite, "fromDouble", [&](fast32 i){
+        return fixed(doubles[i]);},
+        [&](auto ref, fast32 i){ return ref.fromDouble(doubles[i]);});
+    benchSuiteOp<reference>(suite, "toDouble", [&](fast32 i){
+        return CAST<fast64>(L[i].toDouble());},
+        [&](auto ref, fast32 i){ return ref.toDouble(L[i]);});
+    benchSuiteOp<reference>(suite, "toChars", [&](fast32 i){
+        char buf[WIDTH];
+        return L[i].toChars(buf, buf + WIDTH).ptr - buf;},
+        [&](auto ref, fast32 i){ return ref.toChars(L[i]);});
+    benchSuiteOp<reference>(suite, "fromChars", [&](fast32 i){
+        fixed ret;
+        const char *first = &text[i * WIDTH];
+        ret.fromChars(first, first + length[i]);
+        return ret;},
+        [&](auto ref, fast32 i){ return ref.fromChars(L[i]);});
+
+    benchSuiteMath<INT, FRAC>(suite, gen,
+        std::integral_constant<bool, SIGN && INT + FRAC < 64>());
+}
+
+// The scalar operators, the reference of the batch checks
+struct BenchScalarReference{
+    static const bool exact = true;
+};
+
+// Runs run(first, count) over elements 1 to BENCH_BUFFER_SIZE - 1, an odd
+// count from an unaligned start, then over element 0 alone, so the 256 and
+// 128 bit loops and the scalar tail all run
+template<class RUN> void benchBatchSplit(RUN run){
+    run(1, BENCH_BUFFER_SIZE - 1);
+    run(0, 1);
+}
+
+template<FixedRounding MODE, class FIXED>
+void benchBatchCheckRound(BenchSuite &suite, const std::string &name,
+                          const std::vector<FIXED> &src,
+                          const std::vector<FIXED> &noise){
+    std::vector<FIXED> dst(BENCH_BUFFER_SIZE);
+    benchBatchSplit([&](fast32 i, std::size_t count){
+        Fixed_batchRound<MODE>(&dst[i], &src[i], count, &noise[i]);});
+    benchSuiteOp<BenchScalarReference>(suite, name.c_str(),
+        [&](fast32 i){ return dst[i];},
+        [&](auto, fast32 i){
+            typedef typename FIXED::ufixSize ufixSize;
+            return src[i].template round<MODE>(
+                CAST<ufixSize>(noise[i].getRawNumber()));});
+}
+
+// Checks every Fixed_batch function of one format and overflow policy
+// against the scalar operators. Wrapping and saturating buffers take raw
+// numbers over the whole range, so they overflow. FIXED_TRAP ones are kept
+// small enough that nothing does, with L[i] >= R[i] for the unsigned
+// subtract, and skip the divide, which could.
+template<fastu16 INT, fastu16 FRAC, bool SIGN, FixedOverflow OVER>
+void benchBatchCheckPolicy(BenchSuite &suite, const char *policy){
+    typedef Fixed<INT, FRAC, SIGN, OVER> fixed;
+    std::mt19937_64 gen(BENCH_BUFFER_SIZE);
+    std::vector<fixed> L(BENCH_BUFFER_SIZE), R(BENCH_BUFFER_SIZE),
+                       D(BENCH_BUFFER_SIZE);
+    benchFill(L, gen);
+    benchFill(R, gen);
+    benchFill(D, gen);
+    const std::vector<fixed> noise = R;
+    if(OVER == FIXED_TRAP){
+        for(auto *buf : {&L, &R, &D})
+            for(auto &x : *buf)
+                x.setRawNumber((x.getRawNumber() >> ((INT + FRAC) / 2 + 1)) | 1);
+        if(!SIGN) for(fast32 i = 0; i < BENCH_BUFFER_SIZE; i++) L[i] += R[i];
+    }
+
+    const std::string name = std::string("batch") + policy;
+    std::vector<fixed> dst(BENCH_BUFFER_SIZE);
+    benchBatchSplit([&](fast32 i, std::size_t count){
+        Fixed_batchAdd(&dst[i], &L[i], &R[i], count);});
+    benchSuiteOp<BenchScalarReference>(suite, (name + "Add").c_str(),
+        [&](fast32 i){ return dst[i];},
+        [&](auto, fast32 i){ return L[i] + R[i];});
+    benchBatchSplit([&](fast32 i, std::size_t count){
+        Fixed_batchSub(&dst[i], &L[i], &R[i], count);});
+    benchSuiteOp<BenchScalarReference>(suite, (name + "Sub").c_str(),
+        [&](fast32 i){ return dst[i];},
+        [&](auto, fast32 i){ return L[i] - R[i];});
+    benchBatchSplit([&](fast32 i, std::size_t count){
+        Fixed_batchMul(&dst[i], &L[i], &R[i], count);});
+    benchSuiteOp<BenchScalarReference>(suite, (name + "Mul").c_str(),
+        [&](fast32 i){ return dst[i];},
+        [&](auto, fast32 i){ return L[i] * R[i];});
+    if(OVER != FIXED_TRAP){
+        benchBatchSplit([&](fast32 i, std::size_t count){
+            Fixed_batchDiv(&dst[i], &L[i], &R[i], count);});
+        benchSuiteOp<BenchScalarReference>(suite, (name + "Div").c_str(),
+            [&](fast32 i){ return dst[i];},
+            [&](auto, fast32 i){ return L[i] / R[i];});
+    }
+    dst = D;
+    benchBatchSplit([&](fast32 i, std::size_t count){
+        Fixed_batchMac(&dst[i], &L[i], &R[i], count);});
+    benchSuiteOp<BenchScalarReference>(suite, (name + "Mac").c_str(),
+        [&](fast32 i){ return dst[i];},
+        [&](auto, fast32 i){ return D[i] + L[i] * R[i];});
+
+    benchBatchCheckRound<FIXED_ROUND_FLOOR>(suite, name + "Floor", L, noise);
+    benchBatchCheckRound<FIXED_ROUND_CEIL>(suite, name + "Ceil", L, noise);
+    benchBatchCheckRound<FIXED_ROUND_HALF_UP>(suite, name + "HalfUp", L,
+                                              noise);
+    benchBatchCheckRound<FIXED_ROUND_HALF_EVEN>(suite, name + "HalfEven", L,
+                                                noise);
+    benchBatchCheckRound<FIXED_ROUND_TO_ZERO>(suite, name + "ToZero", L,
+                                              noise);
+    benchBatchCheckRound<FIXED_ROUND_STOCHASTIC>(suite, name + "Stochastic",
+                                                 L, noise);
+}
+
+template<fastu16 INT, fastu16 FRAC, bool SIGN>
+void benchBatchCheckFormat(BenchSuite &suite){
+    suite.prefix = benchSuitePrefix<INT, FRAC, SIGN>();
+    benchBatchCheckPolicy<INT, FRAC, SIGN, FIXED_WRAP>(suite, "Wrap");
+    benchBatchCheckPolicy<INT, FRAC, SIGN, FIXED_SATURATE>(suite, "Saturate");
+    benchBatchCheckPolicy<INT, FRAC, SIGN, FIXED_TRAP>(suite, "Trap");
+}
+
+// Checks FixedVector::fromDouble() and fromFloat() of a saturating format
+// on numbers up to four times past its range, NaN and the infinities,
+// against the scalar conversion clamped to the format
+template<fastu16 INT, fastu16 FRAC, bool SIGN>
+void benchVectorCheckFormat(BenchSuite &suite){
+    typedef Fixed<INT, FRAC, SIGN, FIXED_SATURATE> fixed;
+    std::mt19937_64 gen(BENCH_BUFFER_SIZE);
+    suite.prefix = benchSuitePrefix<INT, FRAC, SIGN>();
+    const double high = std::ldexp(1.0, INT);
+    std::uniform_real_distribution<double> dist(-4 * high, 4 * high);
+    std::vector<double> doubles(BENCH_BUFFER_SIZE);
+    std::vector<float> floats(BENCH_BUFFER_SIZE);
+    for(fast32 i = 0; i < BENCH_BUFFER_SIZE; i++){
+        doubles[i] = dist(gen);
+        floats[i] = CAST<float>(doubles[i]);
+    }
+    const double specials[] = {NAN, INFINITY, -INFINITY, 1e300, -1e300};
+    const float floatSpecials[] = {NAN, INFINITY, -INFINITY, 3e38f, -3e38f};
+    std::copy(std::begin(specials), std::end(specials), doubles.begin());
+    std::copy(std::begin(floatSpecials), std::end(floatSpecials),
+              floats.begin());
+
+    // In the format's range after truncating, the scalar conversion is
+    // exact. Outside it the number is clamped, and NaN is 0.
+    auto expected = [&](double x){
+        const double low = (SIGN) ? -high : 0;
+        const double lsb = std::ldexp(1.0, -FRAC);
+        return (x != x)         ? fixed(0) :
+               (x >= high)      ? fixed().getMaxValue() :
+               (x <= low - lsb) ? fixed().getMinValue() : fixed(x);
+    };
+
+    FixedVector<INT, FRAC, SIGN, FIXED_SATURATE> vec(BENCH_BUFFER_SIZE);
+    vec.fromDouble(doubles.data(), BENCH_BUFFER_SIZE);
+    benchSuiteOp<BenchScalarReference>(suite, "vectorFromDouble",
+        [&](fast32 i){ return fixed(vec[i]);},
+        [&](auto, fast32 i){ return expected(doubles[i]);});
+    vec.fromFloat(floats.data(), BENCH_BUFFER_SIZE);
+    benchSuiteOp<BenchScalarReference>(suite, "vectorFromFloat",
+        [&](fast32 i){ return fixed(vec[i]);},
+        [&](auto, fast32 i){ return expected(floats[i]);});
+}
+
+// Times every op of every format, or with check set, checks them instead
+// and returns the count of mismatches with the reference
+inline fast64 runOperatorSuite(std::ostream &out, bool check = false){
+    out << "dw_math,int,frac,bits,signed,op,"
+        << ((check) ? "mismatches,result_hash" : "ns_per_op,ops_per_cycle")
+        << std::endl;
+    BenchSuite suite{out, check, "", 0};
+    benchSuiteFormat<4, 3, SIGNED>(suite);
+    benchSuiteFormat<4, 4, UNSIGNED>(suite);
+    benchSuiteFormat<10, 5, SIGNED>(suite);
+    benchSuiteFormat<6, 10, UNSIGNED>(suite);
+    benchSuiteFormat<16, 15, SIGNED>(suite);
+    benchSuiteFormat<12, 20, UNSIGNED>(suite);
+    benchSuiteFormat<30, 33, SIGNED>(suite);
+    benchSuiteFormat<34, 30, UNSIGNED>(suite);
+    benchSuiteFormat<64, 63, SIGNED>(suite);
+    benchSuiteFormat<32, 96, UNSIGNED>(suite);
+    if(check){
+        benchBatchCheckFormat<4, 3, SIGNED>(suite);
+        benchBatchCheckFormat<4, 4, UNSIGNED>(suite);
+        benchBatchCheckFormat<10, 5, SIGNED>(suite);
+        benchBatchCheckFormat<6, 10, UNSIGNED>(suite);
+        benchBatchCheckFormat<16, 15, SIGNED>(suite);
+        benchBatchCheckFormat<12, 20, UNSIGNED>(suite);
+        benchBatchCheckFormat<30, 33, SIGNED>(suite);
+        benchBatchCheckFormat<34, 30, UNSIGNED>(suite);
+        benchVectorCheckFormat<4, 3, SIGNED>(suite);
+        benchVectorCheckFormat<6, 10, UNSIGNED>(suite);
+        benchVectorCheckFormat<16, 15, SIGNED>(suite);
+        benchVectorCheckFormat<30, 33, SIGNED>(suite);
+        benchVectorCheckFormat<34, 30, UNSIGNED>(suite);
+    }
+    return suite.mismatches;
+}
+
+#endif // FXPTBENCH_H
@@ -1,14 +1,40 @@
 #include "FixedPoint.h"
-#include "FxPtTests.h"
+#include "FxPtBench.h"
 #include <iostream>
+#include <string>
 
 
 
-int main()
+// No argument prints a few example results, "suite" prints the operator
+// suite as CSV, "check" checks every op of the suite and every batch
+// function and fails on a mismatch, and "bench" runs every benchmark.
+int main(int argc, char *argv[])
 {
-    //run8BitFixedPointTests(std::cout);
-    //run16BitFixedPointTests(std::cout);
-
+    const std::string mode = (argc > 1) ? argv[1] : "";
+    if(mode == "suite"){
+        runOperatorSuite(std::cout);
+        return 0;
+    }
+    if(mode == "check"){
+        return (runOperatorSuite(std::cout, true) == 0) ? 0 : 1;
+    }
+    if(mode == "bench"){
+        runBatchBenchmarks(std::cout);
+        runRoundBenchmarks(std::cout);
+        runTrigBenchmarks(std::cout);
+        runDivideBenchmarks(std::cout);
+        runOverflowBenchmarks(std::cout);
+        runMixedBenchmarks(std::cout);
+        runFormatBenchmarks(std::cout);
+        runFilterBenchmarks(std::cout);
+        runExpLogBenchmarks(std::cout);
+        runFFTBenchmarks(std::cout);
+        runMatrixBenchmarks(std::cout);
+        runResampleBenchmarks(std::cout);
+        runRandomBenchmarks(std::cout);
+        runPIDBenchmarks(std::cout);
+        return 0;
+    }
 
     Fixed<14, 18, UNSIGNED> x = 541.515625, y = 23.375;
     std::cout << "x = " << x << ", y = " << y << std::endl;
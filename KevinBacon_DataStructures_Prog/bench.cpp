@@ -0,0 +1,532 @@
+/*************************************************************************//**
+ * @file
+ * @brief .cpp file holds the benchmark comparing the pointer graph to the packed movieGraph
+ *
+ * @details
+ * Bacon_Bench reads the same '/' separated file as Bacon_Number twice, once into the
+ * original graph of new-ed actor/movie structs, and once into a movieSet. It prints
+ * how long each took to build, how much memory each holds, and how long a breadth
+ * first search from the starting node takes over each one. The packed search is
+ * movieSet::NumberActors() itself.
+ *
+ * It then times the packed search again on 1 thread up to the given number of threads,
+ * one per hardware thread by default, and prints the speedup over 1 thread and the
+ * direction, top-down or bottom-up, each half level of the search took.
+ *
+ * @par Usage:
+   @verbatim
+   Bacon_Bench fileName.txt ["Actor/Movie Name"] [repetitions] [threads]
+   @endverbatim
+ **************************************************************************/
+
+#include "functions.h"
+
+#include <chrono>
+#include <iomanip>
+#include <thread>
+#include <unordered_map>
+
+using namespace std;
+
+// Forward declaration so actor struct knows the movie struct exists
+struct movie;
+
+/// Actor struct of the pointer graph. Points to movies
+/**************************************************************************//**
+* @brief Actor struct will point to its surrounding movies. It has a bacon number
+* and a name. This is the layout movieSet used before the movieGraph.
+*****************************************************************************/
+struct actor
+{
+    /// Name of the actor
+    std::string name = "";
+
+    /// Array of pointers to surrounding movies
+    std::vector<movie*> movies;
+
+    /// Distance from starting node
+    int baconNumber = 999999;
+};
+
+/// Movie struct of the pointer graph. Points to actors
+/**************************************************************************//**
+* @brief Movie struct will point to its surrounding actors. It has a depth
+* and a name. This is the layout movieSet used before the movieGraph.
+*****************************************************************************/
+struct movie
+{
+    /// Name of the movie
+    std::string name = "";
+
+    /// Array of pointers to surrounding actors
+    std::vector<actor*> actors;
+
+    /// Distance from starting node
+    int depth = 999999;
+};
+
+/// Unordered map's iterator for actor nodes, actor Iterator
+typedef unordered_map<string, actor*>::iterator aIter;
+
+/// Unordered map's iterator for movie nodes, movie Iterator
+typedef unordered_map<string, movie*>::iterator mIter;
+
+/// Clock used for every timing
+typedef chrono::steady_clock benchClock;
+
+/// Represents a node with an infinite distance from the start node
+const int INF = 999999;
+
+/**************************************************************************//**
+* @class pointerGraph
+*
+* @brief pointerGraph class holds the actor/movie graph the way movieSet used to
+*
+* @brief Every actor and movie is its own new-ed struct, found by name through an
+* unordered_map, with a vector of pointers to its neighbours.
+*****************************************************************************/
+class pointerGraph
+{
+public:
+    /// pointerGraph constructor
+    pointerGraph() : selectedMovie(nullptr)
+    {
+        knownActors.max_load_factor(0.75f);
+        knownMovies.max_load_factor(0.75f);
+    }
+
+    /// pointerGraph destructor, deletes every node
+    ~pointerGraph()
+    {
+        for(aIter it = knownActors.begin(); it != knownActors.end(); it++)
+        {
+            delete it->second;
+        }
+
+        for(mIter it = knownMovies.begin(); it != knownMovies.end(); it++)
+        {
+            delete it->second;
+        }
+    }
+
+    /// Insert a movie or actor/actress, the same way movieSet::Insert used to
+    void Insert(const string &name, bool isMovie);
+
+    /// Breadth first search from a node, returns how many actors were reached
+    int NumberActors(const string &start);
+
+    /// Estimated heap bytes held by the graph
+    size_t MemoryUsage();
+
+    /// Holds the actors that have been read in
+    unordered_map<string, actor*> knownActors;
+
+    /// Holds the movies that have been read in
+    unordered_map<string, movie*> knownMovies;
+
+    /// Holds the current in-use movie for inserting
+    movie* selectedMovie;
+
+    /// Number of (movie, actor) links
+    size_t castings = 0;
+};
+
+/**************************************************************************//**
+ * @author Chris Kolegraff
+ *
+ * @par Description:
+ * Bytes glibc's malloc takes for a request: the size plus an 8 byte header, rounded
+ * up to 16, and never less than 32.
+ *
+ * @param[in]   size - Bytes asked for
+ *
+ * @returns size_t Bytes used on the heap
+ *****************************************************************************/
+size_t heapBytes(size_t size)
+{
+    return max<size_t>(32, (size + 8 + 15) / 16 * 16);
+}
+
+/**************************************************************************//**
+ * @author Chris Kolegraff
+ *
+ * @par Description:
+ * Heap bytes held by a string, nothing if it fits in the string itself.
+ *
+ * @param[in]   name - String to measure
+ *
+ * @returns size_t Bytes used on the heap
+ *****************************************************************************/
+size_t heapBytes(const string &name)
+{
+    return (name.capacity() > string().capacity()) ? heapBytes(name.capacity() + 1) : 0;
+}
+
+/**************************************************************************//**
+ * @author Chris Kolegraff
+ *
+ * @par Description:
+ * Inserts a movie or an actor, linking a new actor to the selected movie with new-ed
+ * nodes and pointers, the way movieSet::Insert did before the movieGraph.
+ *
+ * @param[in]   name - Name of the actor/movie being inserted
+ * @param[in]   isMovie - Whether or not the incoming name is a movie
+ *****************************************************************************/
+void pointerGraph::Insert(const string &name, bool isMovie)
+{
+    if(isMovie)
+    {
+        mIter it = knownMovies.find(name);
+
+        if(it == knownMovies.end())
+        {
+            selectedMovie = new movie;
+            selectedMovie->name = name;
+            knownMovies.insert(make_pair(name, selectedMovie));
+        }
+        else
+        {
+            selectedMovie = it->second;
+        }
+        return;
+    }
+
+    aIter it = knownActors.find(name);
+    actor* act = nullptr;
+
+    if(it == knownActors.end())
+    {
+        act = new actor;
+        act->name = name;
+        knownActors.insert(make_pair(name, act));
+    }
+    else
+    {
+        act = it->second;
+    }
+
+    act->movies.push_back(selectedMovie);
+    selectedMovie->actors.push_back(act);
+    castings++;
+}
+
+/**************************************************************************//**
+ * @author Chris Kolegraff
+ *
+ * @par Description:
+ * Level by level breadth first search from an actor or movie, following pointers.
+ * Every node's distance is reset through the hash tables first. The distances are
+ * the ones movieSet gives: a movie's depth is the Bacon Number of the actors that
+ * reach it, plus one when the starting node is a movie.
+ *
+ * @param[in]   start - Name of the starting actor/movie
+ *
+ * @returns int Number of actors reached
+ *****************************************************************************/
+int pointerGraph::NumberActors(const string &start)
+{
+    for(aIter it = knownActors.begin(); it != knownActors.end(); it++)
+    {
+        it->second->baconNumber = INF;
+    }
+
+    for(mIter it = knownMovies.begin(); it != knownMovies.end(); it++)
+    {
+        it->second->depth = INF;
+    }
+
+    vector<actor*> actors;
+    vector<movie*> movies;
+    aIter aStart = knownActors.find(start);
+    mIter mStart = knownMovies.find(start);
+    int reached = 0;
+    int shift = (aStart == knownActors.end()) ? 1 : 0;
+
+    if(aStart != knownActors.end())
+    {
+        aStart->second->baconNumber = 0;
+        actors.push_back(aStart->second);
+        reached++;
+    }
+    else if(mStart != knownMovies.end())
+    {
+        mStart->second->depth = 0;
+        movies.push_back(mStart->second);
+    }
+
+    // distance is the Bacon Number of the actors in this level
+    for(int distance = 0; !actors.empty() || !movies.empty(); distance++)
+    {
+        for(size_t i = 0; i < actors.size(); i++)
+        {
+            for(size_t j = 0; j < actors[i]->movies.size(); j++)
+            {
+                movie* mov = actors[i]->movies[j];
+                if(mov->depth == INF)
+                {
+                    mov->depth = distance + shift;
+                    movies.push_back(mov);
+                }
+            }
+        }
+        actors.clear();
+
+        for(size_t i = 0; i < movies.size(); i++)
+        {
+            for(size_t j = 0; j < movies[i]->actors.size(); j++)
+            {
+                actor* act = movies[i]->actors[j];
+                if(act->baconNumber == INF)
+                {
+                    act->baconNumber = distance + 1;
+                    actors.push_back(act);
+                    reached++;
+                }
+            }
+        }
+        movies.clear();
+    }
+
+    return reached;
+}
+
+/**************************************************************************//**
+ * @author Chris Kolegraff
+ *
+ * @par Description:
+ * Adds up the heap bytes of every node, name, pointer vector, hash table node and
+ * bucket array, counting glibc's per allocation overhead.
+ *
+ * @returns size_t Estimated bytes used by the graph
+ *****************************************************************************/
+size_t pointerGraph::MemoryUsage()
+{
+    // A hash table node holds the next pointer, the key/value pair and the hash
+    size_t node = sizeof(void*) + sizeof(pair<const string, void*>) + sizeof(size_t);
+    size_t bytes = sizeof(*this) +
+                   heapBytes(knownActors.bucket_count() * sizeof(void*)) +
+                   heapBytes(knownMovies.bucket_count() * sizeof(void*));
+
+    for(aIter it = knownActors.begin(); it != knownActors.end(); it++)
+    {
+        bytes += heapBytes(node) + heapBytes(it->first) + heapBytes(sizeof(actor)) +
+                 heapBytes(it->second->name) +
+                 heapBytes(it->second->movies.capacity() * sizeof(movie*));
+    }
+
+    for(mIter it = knownMovies.begin(); it != knownMovies.end(); it++)
+    {
+        bytes += heapBytes(node) + heapBytes(it->first) + heapBytes(sizeof(movie)) +
+                 heapBytes(it->second->name) +
+                 heapBytes(it->second->actors.capacity() * sizeof(actor*));
+    }
+
+    return bytes;
+}
+
+/**************************************************************************//**
+ * @author Chris Kolegraff
+ *
+ * @par Description:
+ * Seconds since a starting time.
+ *
+ * @param[in]   start - Starting time
+ *
+ * @returns double Seconds since start
+ *****************************************************************************/
+double secondsSince(benchClock::time_point start)
+{
+    return chrono::duration<double>(benchClock::now() - start).count();
+}
+
+/**************************************************************************//**
+ * @author Chris Kolegraff
+ *
+ * @par Description:
+ * Outputs one row of the results table.
+ *
+ * @param[in]   label - What the row measures
+ * @param[in]   pointer - Result for the pointer graph
+ * @param[in]   packed - Result for the packed graph
+ *****************************************************************************/
+void outputRow(const string &label, double pointer, double packed)
+{
+    cout << left << setw(24) << label << right << fixed << setprecision(2)
+         << setw(14) << pointer << setw(14) << packed << setw(10) << pointer / packed
+         << endl;
+}
+
+/**************************************************************************//**
+ * @author Chris Kolegraff
+ *
+ * @par Description:
+ * Checks that the pointer graph and the movieSet gave every actor the same Bacon
+ * Number, and every movie the same depth. Outputs the first one that differs.
+ *
+ * @param[in]   pointers - Pointer graph, already searched
+ * @param[in]   packed - movieSet, already searched from the same node
+ *
+ * @returns true Every actor and movie matches
+ * @returns false An actor or movie differs
+ *****************************************************************************/
+bool sameNumbers(pointerGraph &pointers, movieSet &packed)
+{
+    for(aIter it = pointers.knownActors.begin(); it != pointers.knownActors.end(); it++)
+    {
+        if(it->second->baconNumber != packed.BaconNumber(it->first))
+        {
+            cout << "Error: " << it->first << " has different Bacon Numbers" << endl;
+            return false;
+        }
+    }
+
+    for(mIter it = pointers.knownMovies.begin(); it != pointers.knownMovies.end(); it++)
+    {
+        if(it->second->depth != packed.BaconNumber(it->first))
+        {
+            cout << "Error: " << it->first << " has different depths" << endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**************************************************************************//**
+ * @author Chris Kolegraff
+ *
+ * @par Description:
+ * Reads the file into both graphs, then times and outputs the build, memory and
+ * search results, then the search time on each number of threads. Every search has
+ * to reach the same actors at the same Bacon Numbers, or the benchmark fails.
+ *
+ * @param[in]   argc - Number of command line arguments
+ * @param[in]   argv - Contains command line arguments
+ *
+ * @returns  0 Benchmark ran successfully
+ * @returns -1 Error with input arguments
+ * @returns -2 Error opening input file
+ * @returns -3 The starting node is not in the file
+ * @returns -4 The two graphs gave different Bacon Numbers
+ *****************************************************************************/
+int main(int argc, char** argv)
+{
+    if(argc < 2 || argc > 5)
+    {
+        cout << "Usage: Bacon_Bench textFile.txt [Optional] \"Additional Name\" [repetitions] [threads]" << endl;
+        return -1;
+    }
+
+    string fileName = argv[1];
+    string start = (argc > 2) ? argv[2] : "Bacon, Kevin";
+    int reps = (argc > 3) ? max(1, atoi(argv[3])) : 10;
+    int threads = (argc > 4) ? max(1, atoi(argv[4])) :
+                               max(1, int(thread::hardware_concurrency()));
+    ifstream fin;
+
+    // Pointer graph
+    if(!openFile(fileName, fin))
+    {
+        cout << "Could not open file: " << fileName << endl;
+        return -2;
+    }
+
+    benchClock::time_point clock = benchClock::now();
+    pointerGraph pointers;
+    string line;
+    vector<string> names;
+
+    while(getline(fin, line))
+    {
+        tokenNames(line, names);
+        for(size_t i = 0; i < names.size(); i++)
+        {
+            pointers.Insert(names[i], i == 0);
+        }
+        names.clear();
+    }
+    fin.close();
+    double pointerBuild = secondsSince(clock);
+
+    // Packed graph, built the first time it is used
+    if(!openFile(fileName, fin))
+    {
+        cout << "Could not open file: " << fileName << endl;
+        return -2;
+    }
+
+    clock = benchClock::now();
+    movieSet packed;
+    readFile(fin, packed);
+    fin.close();
+    const movieGraph &graph = packed.Graph();
+    double packedBuild = secondsSince(clock);
+
+    if(graph.FindActor(start) < 0 && graph.FindMovie(start) < 0)
+    {
+        cout << start << " is not in " << fileName << endl;
+        return -3;
+    }
+
+    // Search both, and check they agree
+    int pointerReached = pointers.NumberActors(start);
+    packed.ReassignStartNode(start);
+
+    if(!sameNumbers(pointers, packed))
+    {
+        return -4;
+    }
+
+    clock = benchClock::now();
+    for(int i = 0; i < reps; i++)
+    {
+        pointerReached = pointers.NumberActors(start);
+    }
+    double pointerSearch = secondsSince(clock) / reps;
+
+    clock = benchClock::now();
+    for(int i = 0; i < reps; i++)
+    {
+        packed.ReassignStartNode(start);
+    }
+    double packedSearch = secondsSince(clock) / reps;
+
+    cout << fileName << ": " << graph.NumActors() << " actors, " << graph.NumMovies()
+         << " movies, " << pointers.castings << " castings" << endl;
+    cout << pointerReached << " actors reached from " << start << endl << endl;
+    cout << left << setw(24) << "" << right << setw(14) << "pointer" << setw(14) << "packed"
+         << setw(10) << "ratio" << endl;
+    outputRow("Build seconds", pointerBuild, packedBuild);
+    outputRow("Memory MB", pointers.MemoryUsage() / 1e6, packed.MemoryUsage() / 1e6);
+    outputRow("Search ms", 1e3 * pointerSearch, 1e3 * packedSearch);
+
+    // Packed search on each number of threads
+    cout << endl << left << setw(24) << "Threads" << right << setw(14) << "search ms"
+         << setw(10) << "speedup" << "  directions" << endl;
+    double oneThread = 0;
+
+    for(int count = 1; count <= threads; count++)
+    {
+        packed.SetThreads(count);
+        packed.ReassignStartNode(start);
+
+        if(!sameNumbers(pointers, packed))
+        {
+            return -4;
+        }
+
+        clock = benchClock::now();
+        for(int i = 0; i < reps; i++)
+        {
+            packed.ReassignStartNode(start);
+        }
+        double search = secondsSince(clock) / reps;
+        oneThread = (count == 1) ? search : oneThread;
+
+        cout << left << setw(24) << count << right << fixed << setprecision(2)
+             << setw(14) << 1e3 * search << setw(10) << oneThread / search
+             << "  " << packed.Directions() << endl;
+    }
+
+    return 0;
+}
@@ -156,8 +156,23 @@ bool handleInput(movieSet &movSet, char input, bool &quit)
         movSet.OutputVector(movSet.StartNodeName());
         break;
     }
-    // Exit Program
+    // Output a shortest path between any two actors/movies
     case '6':
+    {
+        string toName;
+
+        cout << "Enter the name of the first actor/actress or movie: ";
+        getline(cin, name);
+        cout << "Enter the name of the second actor/actress or movie: ";
+        getline(cin, toName);
+        cout << endl;
+
+        movSet.OutputShortestPath(name, toName);
+        break;
+    }
+
+    // Exit Program
+    case '7':
     {
         quit = true;
         break;
@@ -275,7 +290,8 @@ void outputInstructions()
     cout << "3. Change the starting node\n";
     cout << "4. Output actors with largest Bacon Number\n";
     cout << "5. Output list of start node's actors/movies\n";
-    cout << "6. Exit Program\n";
+    cout << "6. Output shortest path between two actors/movies\n";
+    cout << "7. Exit Program\n";
 }
 
 /**************************************************************************//**
@@ -41,12 +41,15 @@
  * show how closely connected the rest of the actors are to that actor. You can output a list
  * of the actors that are the furthest away from the starting node. you can reassign the starting
  * node to either another actor or a movie.
+ * You can also find a shortest path between any two actors or movies, which searches out
+ * from both names and leaves the starting node as it is.
  *
  * @section compile_section Compiling and Usage
  *
  * @par Compiling Instructions:
  *
- *      To compile, enter "make".
+ *      To compile, enter "make". This also builds Bacon_Bench, which compares the
+ *      packed graph to the original pointer graph, see bench.cpp.
  *
  *      To create Doxygen documentation, enter "doxygen Doxyfile"
  *
@@ -0,0 +1,631 @@
+/*************************************************************************//**
+ * @file
+ * @brief .cpp file holds the definitions of the movieGraph class
+ **************************************************************************/
+
+
+
+#include "movieGraph.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+using namespace std;
+
+/// Unordered map's iterator for name to ID lookups, ID Iterator
+typedef unordered_map<string, int>::const_iterator idIter;
+
+/// Parent and distance of each node one end of a path search has reached
+typedef unordered_map<int, pair<int, int>> reachedMap;
+
+/// Unordered map's iterator for the nodes a path search reached, reached Iterator
+typedef reachedMap::const_iterator rIter;
+
+/**************************************************************************//**
+* @brief pathEnd struct is one end of a bidirectional path search. It only holds
+* the nodes that end has reached, so a search costs about the size of the two
+* neighbourhoods it explores, not the size of the graph.
+*****************************************************************************/
+struct pathEnd
+{
+    /// Movie and half step distance of each actor reached, the start's movie is -1
+    reachedMap actors;
+
+    /// Actor and half step distance of each movie reached, the start's actor is -1
+    reachedMap movies;
+
+    /// Nodes reached on the last half level
+    vector<int> frontier;
+
+    /// Whether the frontier is actors, or movies
+    bool frontierActors = false;
+
+    /// Half step distance of the frontier from this end
+    int depth = 0;
+
+    /// Edges out of the frontier
+    long long frontierEdges = 0;
+};
+
+//##################################################//
+// PUBLIC FUNCTIONS
+//##################################################//
+
+/**************************************************************************//**
+ * @author Chris Kolegraff
+ *
+ * @par Description:
+ * Basic constructor for the movieGraph class. Sets unordered_map variables' max load factor to 0.75.
+ *****************************************************************************/
+movieGraph::movieGraph()
+{
+    actorIds.max_load_factor(0.75f);
+    movieIds.max_load_factor(0.75f);
+
+    selectedMovie = -1;
+    built = false;
+}
+
+/**************************************************************************//**
+ * @author Chris Kolegraff
+ *
+ * @par Description:
+ * Adds a movie to the graph and makes it the selected movie, so the actors added
+ * after it go in its cast. If a movie with the same name was already added, that
+ * movie is selected again, and the new actors are added to its cast.
+ *
+ * @param[in]   name - Name of the movie being added
+ *****************************************************************************/
+void movieGraph::AddMovie(const string &name)
+{
+    if(built)
+    {
+        cout << "Error: " << name << " was added after the graph was built" << endl;
+        return;
+    }
+
+    idIter it = movieIds.find(name);
+
+    if(it != movieIds.end())
+    {
+        selectedMovie = it->second;
+        return;
+    }
+
+    selectedMovie = int(movieNames.size());
+    movieNames.push_back(AddName(name));
+    movieIds.insert(make_pair(name, selectedMovie));
+}
+
+/**************************************************************************//**
+ * @author Chris Kolegraff
+ *
+ * @par Description:
+ * Adds an actor to the cast of the selected movie. A new actor gets the next actor ID,
+ * a known actor keeps the one it has.
+ *
+ * @param[in]   name - Name of the actor being added
+ *****************************************************************************/
+void movieGraph::AddActor(const string &name)
+{
+    if(built || selectedMovie < 0)
+    {
+        cout << "Error: " << name << " was not added to a movie" << endl;
+        return;
+    }
+
+    int act = -1;
+    idIter it = actorIds.find(name);
+
+    if(it != actorIds.end())
+    {
+        act = it->second;
+    }
+    else
+    {
+        act = int(actorNames.size());
+        actorNames.push_back(AddName(name));
+        actorIds.insert(make_pair(name, act));
+    }
+
+    castings.push_back(make_pair(selectedMovie, act));
+}
+
+/**************************************************************************//**
+ * @author Chris Kolegraff
+ *
+ * @par Description:
+ * Packs the castings into the offset and adjacency arrays of both sides, sorts the
+ * IDs by name for lookups, then frees the hash tables and the castings. Each actor's
+ * movies, and each movie's actors, stay in the order they were read in. Calling it
+ * again does nothing.
+ *****************************************************************************/
+void movieGraph::Build()
+{
+    if(built)
+    {
+        return;
+    }
+
+    Pack(castings, true, NumActors(), actorOffsets, actorMovies);
+    Pack(castings, false, NumMovies(), movieOffsets, movieActors);
+
+    SortByName(actorNames, actorsByName);
+    SortByName(movieNames, moviesByName);
+
+    // Swapping with empty containers is what actually gives the memory back
+    unordered_map<string, int>().swap(actorIds);
+    unordered_map<string, int>().swap(movieIds);
+    vector<pair<int, int>>().swap(castings);
+    namePool.shrink_to_fit();
+    actorNames.shrink_to_fit();
+    movieNames.shrink_to_fit();
+
+    built = true;
+}
+
+/**************************************************************************//**
+ * @author Chris Kolegraff
+ *
+ * @par Description:
+ * Returns whether or not the graph has been packed by Build().
+ *
+ * @returns true The graph is packed
+ * @returns false Names can still be added
+ *****************************************************************************/
+bool movieGraph::IsBuilt() const
+{
+    return built;
+}
+
+/**************************************************************************//**
+ * @author Chris Kolegraff
+ *
+ * @par Description:
+ * Finds an actor's ID by name. Before Build() the hash table is used, after it a
+ * binary search of the actor IDs sorted by name.
+ *
+ * @param[in]   name - Name of the actor to find
+ *
+ * @returns int ID of the actor
+ * @returns -1 The actor was not found
+ *****************************************************************************/
+int movieGraph::FindActor(const string &name) const
+{
+    if(!built)
+    {
+        idIter it = actorIds.find(name);
+        return (it == actorIds.end()) ? -1 : it->second;
+    }
+
+    return FindName(name, actorNames, actorsByName);
+}
+
+/**************************************************************************//**
+ * @author Chris Kolegraff
+ *
+ * @par Description:
+ * Finds a movie's ID by name. Before Build() the hash table is used, after it a
+ * binary search of the movie IDs sorted by name.
+ *
+ * @param[in]   name - Name of the movie to find
+ *
+ * @returns int ID of the movie
+ * @returns -1 The movie was not found
+ *****************************************************************************/
+int movieGraph::FindMovie(const string &name) const
+{
+    if(!built)
+    {
+        idIter it = movieIds.find(name);
+        return (it == movieIds.end()) ? -1 : it->second;
+    }
+
+    return FindName(name, movieNames, moviesByName);
+}
+
+/**************************************************************************//**
+ * @author Chris Kolegraff
+ *
+ * @par Description:
+ * Returns the number of actors in the graph.
+ *
+ * @returns int Number of actors
+ *****************************************************************************/
+int movieGraph::NumActors() const
+{
+    return int(actorNames.size());
+}
+
+/**************************************************************************//**
+ * @author Chris Kolegraff
+ *
+ * @par Description:
+ * Returns the number of movies in the graph.
+ *
+ * @returns int Number of movies
+ *****************************************************************************/
+int movieGraph::NumMovies() const
+{
+    return int(movieNames.size());
+}
+
+/**************************************************************************//**
+ * @author Chris Kolegraff
+ *
+ * @par Description:
+ * Returns the name of an actor, from the string pool.
+ *
+ * @param[in]   act - ID of the actor
+ *
+ * @returns const char* Name of the actor
+ *****************************************************************************/
+const char* movieGraph::ActorName(int act) const
+{
+    return &namePool[actorNames[act]];
+}
+
+/**************************************************************************//**
+ * @author Chris Kolegraff
+ *
+ * @par Description:
+ * Returns the name of a movie, from the string pool.
+ *
+ * @param[in]   mov - ID of the movie
+ *
+ * @returns const char* Name of the movie
+ *****************************************************************************/
+const char* movieGraph::MovieName(int mov) const
+{
+    return &namePool[movieNames[mov]];
+}
+
+/**************************************************************************//**
+ * @author Chris Kolegraff
+ *
+ * @par Description:
+ * Returns a pointer to the first of the movies an actor was in. Only valid after Build().
+ *
+ * @param[in]   act - ID of the actor
+ *
+ * @returns const int* First movie ID of the actor
+ *****************************************************************************/
+const int* movieGraph::MoviesBegin(int act) const
+{
+    return actorMovies.data() + actorOffsets[act];
+}
+
+/**************************************************************************//**
+ * @author Chris Kolegraff
+ *
+ * @par Description:
+ * Returns a pointer one past the last of the movies an actor was in. Only valid after Build().
+ *
+ * @param[in]   act - ID of the actor
+ *
+ * @returns const int* End of the actor's movie IDs
+ *****************************************************************************/
+const int* movieGraph::MoviesEnd(int act) const
+{
+    return actorMovies.data() + actorOffsets[act + 1];
+}
+
+/**************************************************************************//**
+ * @author Chris Kolegraff
+ *
+ * @par Description:
+ * Returns a pointer to the first of the actors in a movie. Only valid after Build().
+ *
+ * @param[in]   mov - ID of the movie
+ *
+ * @returns const int* First actor ID of the movie
+ *****************************************************************************/
+const int* movieGraph::ActorsBegin(int mov) const
+{
+    return movieActors.data() + movieOffsets[mov];
+}
+
+/**************************************************************************//**
+ * @author Chris Kolegraff
+ *
+ * @par Description:
+ * Returns a pointer one past the last of the actors in a movie. Only valid after Build().
+ *
+ * @param[in]   mov - ID of the movie
+ *
+ * @returns const int* End of the movie's actor IDs
+ *****************************************************************************/
+const int* movieGraph::ActorsEnd(int mov) const
+{
+    return movieActors.data() + movieOffsets[mov + 1];
+}
+
+/**************************************************************************//**
+ * @author Chris Kolegraff
+ *
+ * @par Description:
+ * Adds up the bytes held by the packed arrays and the string pool. The arrays are
+ * only a handful of allocations, so the allocator's overhead is left out.
+ *
+ * @returns size_t Bytes used by the graph
+ *****************************************************************************/
+size_t movieGraph::MemoryUsage() const
+{
+    return sizeof(*this) + namePool.capacity() +
+           sizeof(int) * (actorNames.capacity() + movieNames.capacity() +
+                          actorsByName.capacity() + moviesByName.capacity() +
+                          actorOffsets.capacity() + actorMovies.capacity() +
+                          movieOffsets.capacity() + movieActors.capacity());
+}
+
+/**************************************************************************//**
+ * @author Chris Kolegraff
+ *
+ * @par Description:
+ * Finds a shortest path between two nodes with a bidirectional breadth first search.
+ * A search runs out from each end, and on each turn the end whose frontier has fewer
+ * edges grows by a half level. Once a node one end reaches has already been reached
+ * by the other, the level is finished and the shortest of the paths met on it is
+ * kept. Only the nodes the two ends reach are ever looked at, and all the state is
+ * local, so any number of threads can search the built graph at once.
+ *
+ * Each end is an actor ID, or -1 and a movie ID. The path alternates between actors
+ * and movies, starting with the from node and ending with the to node, so whether an
+ * entry is an actor or a movie follows from the type of the from node.
+ *
+ * @param[in]   fromActor - ID of the actor the path starts at, -1 if it is a movie
+ * @param[in]   fromMovie - ID of the movie the path starts at, -1 if it is an actor
+ * @param[in]   toActor - ID of the actor the path ends at, -1 if it is a movie
+ * @param[in]   toMovie - ID of the movie the path ends at, -1 if it is an actor
+ * @param[out]  path - IDs along the path, from and to included
+ *
+ * @returns int Number of links in the path
+ * @returns -1 There is no path, or an end is not a valid node
+ *****************************************************************************/
+int movieGraph::ShortestPath(int fromActor, int fromMovie, int toActor, int toMovie,
+                             vector<int> &path) const
+{
+    path.clear();
+
+    bool fromValid = (fromActor >= 0) ? (fromMovie < 0 && fromActor < NumActors()) :
+                                        (fromMovie >= 0 && fromMovie < NumMovies());
+    bool toValid = (toActor >= 0) ? (toMovie < 0 && toActor < NumActors()) :
+                                    (toMovie >= 0 && toMovie < NumMovies());
+
+    if(!built || !fromValid || !toValid)
+    {
+        return -1;
+    }
+
+    if(fromActor == toActor && fromMovie == toMovie)
+    {
+        path.push_back(fromActor >= 0 ? fromActor : fromMovie);
+        return 0;
+    }
+
+    // ends[0] searches out from the from node, ends[1] from the to node
+    pathEnd ends[2];
+    int starts[2][2] = { { fromActor, fromMovie }, { toActor, toMovie } };
+
+    for(int e = 0; e < 2; e++)
+    {
+        int act = starts[e][0];
+        int mov = starts[e][1];
+
+        ends[e].frontierActors = act >= 0;
+        if(act >= 0)
+        {
+            ends[e].actors[act] = make_pair(-1, 0);
+            ends[e].frontier.push_back(act);
+            ends[e].frontierEdges = MoviesEnd(act) - MoviesBegin(act);
+        }
+        else
+        {
+            ends[e].movies[mov] = make_pair(-1, 0);
+            ends[e].frontier.push_back(mov);
+            ends[e].frontierEdges = ActorsEnd(mov) - ActorsBegin(mov);
+        }
+    }
+
+    int best = -1;
+    int meet = -1;
+    bool meetActor = false;
+
+    while(best < 0 && !ends[0].frontier.empty() && !ends[1].frontier.empty())
+    {
+        // Grow the end that has less to look at
+        pathEnd &grow = ends[ends[1].frontierEdges < ends[0].frontierEdges ? 1 : 0];
+        const pathEnd &other = ends[&grow == &ends[0] ? 1 : 0];
+
+        reachedMap &reached = grow.frontierActors ? grow.movies : grow.actors;
+        const reachedMap &otherReached = grow.frontierActors ? other.movies : other.actors;
+        vector<int> next;
+        long long nextEdges = 0;
+
+        for(size_t i = 0; i < grow.frontier.size(); i++)
+        {
+            int node = grow.frontier[i];
+            const int* begin = grow.frontierActors ? MoviesBegin(node) : ActorsBegin(node);
+            const int* end = grow.frontierActors ? MoviesEnd(node) : ActorsEnd(node);
+
+            for(const int* it = begin; it != end; it++)
+            {
+                if(!reached.insert(make_pair(*it, make_pair(node, grow.depth + 1))).second)
+                {
+                    continue;
+                }
+
+                next.push_back(*it);
+                nextEdges += grow.frontierActors ? ActorsEnd(*it) - ActorsBegin(*it) :
+                                                   MoviesEnd(*it) - MoviesBegin(*it);
+
+                rIter met = otherReached.find(*it);
+                if(met != otherReached.end() &&
+                        (best < 0 || grow.depth + 1 + met->second.second < best))
+                {
+                    best = grow.depth + 1 + met->second.second;
+                    meet = *it;
+                    meetActor = !grow.frontierActors;
+                }
+            }
+        }
+
+        grow.frontier.swap(next);
+        grow.frontierEdges = nextEdges;
+        grow.frontierActors = !grow.frontierActors;
+        grow.depth++;
+    }
+
+    if(best < 0)
+    {
+        return -1;
+    }
+
+    // Walk from the meeting node back to the from node, then on to the to node
+    for(int e = 0; e < 2; e++)
+    {
+        vector<int> half;
+        bool isActor = meetActor;
+
+        for(int node = meet; node >= 0; isActor = !isActor)
+        {
+            half.push_back(node);
+            node = (isActor ? ends[e].actors : ends[e].movies).find(node)->second.first;
+        }
+
+        if(e == 0)
+        {
+            path.assign(half.rbegin(), half.rend());
+        }
+        else
+        {
+            path.insert(path.end(), half.begin() + 1, half.end());
+        }
+    }
+
+    return best;
+}
+
+
+//##################################################//
+// PRIVATE FUNCTIONS
+//##################################################//
+
+/**************************************************************************//**
+ * @author Chris Kolegraff
+ *
+ * @par Description:
+ * Copies a name to the end of the string pool, followed by '\0'.
+ *
+ * @param[in]   name - Name to add
+ *
+ * @returns int Where the name starts in the pool
+ *****************************************************************************/
+int movieGraph::AddName(const string &name)
+{
+    int start = int(namePool.size());
+
+    namePool.insert(namePool.end(), name.begin(), name.end());
+    namePool.push_back('\0');
+
+    return start;
+}
+
+/**************************************************************************//**
+ * @author Chris Kolegraff
+ *
+ * @par Description:
+ * Counting sort of the castings by actor or by movie. The first pass counts each
+ * node's neighbours, a running sum turns the counts into offsets, and the second
+ * pass drops every neighbour into its node's run, in the order they were read in.
+ *
+ * @param[in]   castings - Every (movie, actor) pair
+ * @param[in]   byActor - Whether the runs are per actor, or per movie
+ * @param[in]   count - Number of actors or movies
+ * @param[out]  offsets - Where each node's run starts, count + 1 entries
+ * @param[out]  adjacency - Every node's neighbours, back to back
+ *****************************************************************************/
+void movieGraph::Pack(const vector<pair<int, int>> &castings, bool byActor, int count,
+                      vector<int> &offsets, vector<int> &adjacency)
+{
+    offsets.assign(count + 1, 0);
+    adjacency.resize(castings.size());
+
+    for(size_t i = 0; i < castings.size(); i++)
+    {
+        int node = byActor ? castings[i].second : castings[i].first;
+        offsets[node + 1]++;
+    }
+
+    for(int i = 0; i < count; i++)
+    {
+        offsets[i + 1] += offsets[i];
+    }
+
+    // Fill each run from its start, using a copy of the offsets as the next free spot
+    vector<int> next(offsets.begin(), offsets.end() - 1);
+
+    for(size_t i = 0; i < castings.size(); i++)
+    {
+        int node = byActor ? castings[i].second : castings[i].first;
+        adjacency[next[node]++] = byActor ? castings[i].first : castings[i].second;
+    }
+}
+
+/**************************************************************************//**
+ * @author Chris Kolegraff
+ *
+ * @par Description:
+ * Fills sorted with every ID, in order of the names they point to.
+ *
+ * @param[in]   names - Where each ID's name starts in the pool
+ * @param[out]  sorted - IDs sorted by name
+ *****************************************************************************/
+void movieGraph::SortByName(const vector<int> &names, vector<int> &sorted) const
+{
+    const char* pool = namePool.data();
+
+    sorted.resize(names.size());
+    for(size_t i = 0; i < names.size(); i++)
+    {
+        sorted[i] = int(i);
+    }
+
+    sort(sorted.begin(), sorted.end(), [&](int left, int right)
+    {
+        return strcmp(pool + names[left], pool + names[right]) < 0;
+    });
+}
+
+/**************************************************************************//**
+ * @author Chris Kolegraff
+ *
+ * @par Description:
+ * Binary searches IDs sorted by name for a name.
+ *
+ * @param[in]   name - Name to find
+ * @param[in]   names - Where each ID's name starts in the pool
+ * @param[in]   sorted - IDs sorted by name
+ *
+ * @returns int ID with that name
+ * @returns -1 No ID has that name
+ *****************************************************************************/
+int movieGraph::FindName(const string &name, const vector<int> &names,
+                         const vector<int> &sorted) const
+{
+    const char* pool = namePool.data();
+
+    vector<int>::const_iterator it = lower_bound(sorted.begin(), sorted.end(), name,
+                                                 [&](int id, const string &key)
+    {
+        return strcmp(pool + names[id], key.c_str()) < 0;
+    });
+
+    if(it == sorted.end() || strcmp(pool + names[*it], name.c_str()) != 0)
+    {
+        return -1;
+    }
+
+    return *it;
+}
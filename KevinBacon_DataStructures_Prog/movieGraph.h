@@ -0,0 +1,149 @@
+/*************************************************************************//**
+ * @file
+ * @brief .h file holds the declaration of the movieGraph class, the packed actor/movie graph
+ **************************************************************************/
+
+#pragma once
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**************************************************************************//**
+* @class movieGraph
+*
+* @brief movieGraph class holds the actor/movie graph in compressed sparse row form
+*
+* @brief Every actor and every movie gets a dense integer ID, in the order they were
+* first read in. Once Build() is called the graph is packed into a few flat arrays:
+* for actor a, the IDs of the movies it was in are actorMovies[actorOffsets[a]] up
+* to actorMovies[actorOffsets[a + 1]], and the same goes for the cast of a movie.
+* Names are kept back to back in one string pool, and looked up through arrays of
+* IDs sorted by name. A traversal then walks through contiguous integers instead of
+* chasing a pointer to every node.
+*
+* While names are being added, hash tables map each name to its ID, and the castings
+* are kept as a list of (movie, actor) pairs. Build() replaces both with the packed
+* arrays, so names can not be added after it.
+*
+* Once built, the graph is never changed, so its const functions, ShortestPath()
+* included, can be called from several threads at once.
+*****************************************************************************/
+class movieGraph
+{
+public:
+    /// movieGraph constructor
+    movieGraph();
+
+    /// Adds a movie, the actors added after it are its cast
+    void AddMovie(const std::string &name);
+
+    /// Adds an actor to the cast of the last movie added
+    void AddActor(const std::string &name);
+
+    /// Packs the graph into its arrays
+    void Build();
+
+    /// Whether or not Build() has been called
+    bool IsBuilt() const;
+
+    /// Finds an actor's ID, -1 if there is no such actor
+    int FindActor(const std::string &name) const;
+
+    /// Finds a movie's ID, -1 if there is no such movie
+    int FindMovie(const std::string &name) const;
+
+    /// Number of actors
+    int NumActors() const;
+
+    /// Number of movies
+    int NumMovies() const;
+
+    /// Name of an actor
+    const char* ActorName(int act) const;
+
+    /// Name of a movie
+    const char* MovieName(int mov) const;
+
+    /// First of the movies an actor was in
+    const int* MoviesBegin(int act) const;
+
+    /// One past the last of the movies an actor was in
+    const int* MoviesEnd(int act) const;
+
+    /// First of the actors in a movie
+    const int* ActorsBegin(int mov) const;
+
+    /// One past the last of the actors in a movie
+    const int* ActorsEnd(int mov) const;
+
+    /// Bytes held by the packed graph
+    std::size_t MemoryUsage() const;
+
+    /// Shortest path between two actors/movies by bidirectional search, -1 if there is none
+    int ShortestPath(int fromActor, int fromMovie, int toActor, int toMovie,
+                     std::vector<int> &path) const;
+
+private:
+
+    /// Adds a name to the pool, returns where it starts
+    int AddName(const std::string &name);
+
+    /// Packs one side of the castings into offset and adjacency arrays
+    static void Pack(const std::vector<std::pair<int, int>> &castings, bool byActor,
+                     int count, std::vector<int> &offsets, std::vector<int> &adjacency);
+
+    /// Sorts IDs by the names they point to in the pool
+    void SortByName(const std::vector<int> &names, std::vector<int> &sorted) const;
+
+    /// Binary searches IDs sorted by name
+    int FindName(const std::string &name, const std::vector<int> &names,
+                 const std::vector<int> &sorted) const;
+
+
+    //##################################################//
+    // PRIVATE VARIABLES
+    //##################################################//
+
+    /// Every name, each one ending in '\0'
+    std::vector<char> namePool;
+
+    /// Where each actor's name starts in the pool
+    std::vector<int> actorNames;
+
+    /// Where each movie's name starts in the pool
+    std::vector<int> movieNames;
+
+    /// Actor IDs sorted by name
+    std::vector<int> actorsByName;
+
+    /// Movie IDs sorted by name
+    std::vector<int> moviesByName;
+
+    /// Where each actor's movies start in actorMovies, one more entry than actors
+    std::vector<int> actorOffsets;
+
+    /// The movies of every actor, back to back
+    std::vector<int> actorMovies;
+
+    /// Where each movie's actors start in movieActors, one more entry than movies
+    std::vector<int> movieOffsets;
+
+    /// The actors of every movie, back to back
+    std::vector<int> movieActors;
+
+    /// Actor IDs by name, only until Build()
+    std::unordered_map<std::string, int> actorIds;
+
+    /// Movie IDs by name, only until Build()
+    std::unordered_map<std::string, int> movieIds;
+
+    /// Every (movie, actor) pair read in, only until Build()
+    std::vector<std::pair<int, int>> castings;
+
+    /// ID of the movie actors are being added to, -1 before the first movie
+    int selectedMovie;
+
+    /// Whether or not the graph has been packed
+    bool built;
+};
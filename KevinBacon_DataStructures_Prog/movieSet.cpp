@@ -11,17 +11,8 @@
 
 using namespace std;
 
-/// Unordered map's iterator for actor nodes, actor Iterator
-typedef unordered_map<string, actor*>::iterator aIter;
-
-/// Unordered map's iterator for movie nodes, movie Iterator
-typedef unordered_map<string, movie*>::iterator mIter;
-
-/// Vector's iterator for actor nodes, actor vector Iterator
-typedef vector<actor*>::iterator avIter;
-
-/// Vector's iterator for movie nodes, movie vector Iterator
-typedef vector<movie*>::iterator mvIter;
+/// Pointer into the graph's actor/movie ID arrays, ID Iterator
+typedef const int* idIter;
 
 //##################################################//
 // PUBLIC FUNCTIONS
@@ -31,38 +22,22 @@ typedef vector<movie*>::iterator mvIter;
  * @author Chris Kolegraff
  *
  * @par Description:
- * Basic constructor for the movieSet class. Sets unordered_map variables' max load factor to 0.75.
+ * Basic constructor for the movieSet class. There is no starting node yet.
  *****************************************************************************/
 movieSet::movieSet()
 {
-    knownActors.max_load_factor(0.75f);
-    knownMovies.max_load_factor(0.75f);
-
-    targetMovie = selectedMovie = startingMovie = nullptr;
-    targetActor = startingActor = nullptr;
-
-    updated = false;
-}
-
-/**************************************************************************//**
- * @author Chris Kolegraff
- *
- * @par Description:
- * Basic destructor for the movieSet class. Calls a delete function which will
- * delete all dynamically allocated nodes.
- *****************************************************************************/
-movieSet::~movieSet()
-{
-    DeleteGraph();
+    startingMovie = -1;
+    startingActor = -1;
 }
 
 /**************************************************************************//**
  * @author Chris Kolegraff
  *
  * @par Description:
- * Inserts either a new movie or a new actor node into their respective unordered_maps, or hash tables.
- * After an insertion, the function will make the movie node and actor node point to each other, creating a graph.
- * The function will check if an actor is already in the actor hash table, and if it is it will set the pointers.
+ * Inserts either a new movie or a new actor into the graph. A movie becomes the selected
+ * movie, and each actor inserted after it is linked to it. The graph gives a new actor
+ * the next ID, and links a known actor by the ID it already has. Inserts only work
+ * until the graph is built, the first time it is used.
  *
  * @param[in]   name - Name of the actor/movie being inserted
  * @param[in]   isMovie - Whether or not the incoming name is a movie
@@ -71,48 +46,11 @@ void movieSet::Insert(string &name, bool isMovie)
 {
     if(isMovie)
     {
-        // Add a new movie with no actors in its vector. Set it as the selected movie
-        movie* tempMovie = new movie;
-        tempMovie->name = name;
-        selectedMovie = tempMovie;
-        knownMovies.insert(make_pair<string, movie*>(move(name), move(tempMovie)));
-        tempMovie = nullptr;
+        graph.AddMovie(name);
     }
     else
     {
-        // If the actor is known, push the selected movie onto that actor's movie vector
-        if(KnownActor(name))
-        {
-            // Find the actor, get the list of movies the actor's been in, and add the selected movie
-            actor* tempActor = FindActor(name);
-            tempActor->movies.push_back(selectedMovie);
-            tempActor->numMovies++;
-
-            // Take the selected movie, and add the actor to the list of that movie's actors
-            selectedMovie->actors.push_back(tempActor);
-            selectedMovie->numActors++;
-        }
-        // If the actor isn't known, create a new actor
-        else
-        {
-            // Create a new actor
-            actor* temp = new actor;
-
-            // Set the name of the actor
-            temp->name = name;
-            temp->numMovies++;
-
-            // Add the current movie to the list of movies the actor's been in
-            temp->movies.push_back(selectedMovie);
-
-            // Add the actor to the list of actors that are in the selected movie
-            selectedMovie->actors.push_back(temp);
-            selectedMovie->numActors++;
-
-            // Make the actor known
-            knownActors.insert(make_pair<string, actor*>(move(name), move(temp)));
-            temp = nullptr;
-        }
+        graph.AddActor(name);
     }
     name.clear();
 }
@@ -121,7 +59,7 @@ void movieSet::Insert(string &name, bool isMovie)
  * @author Chris Kolegraff
  *
  * @par Description:
- * This function will return whether or not an actor is in the knownActors hash table.
+ * This function will return whether or not an actor is in the graph.
  *
  * @param[in]   name - Name of the actor to find
  *
@@ -130,7 +68,7 @@ void movieSet::Insert(string &name, bool isMovie)
  *****************************************************************************/
 bool movieSet::KnownActor(string &name)
 {
-    if(knownActors.find(name) == knownActors.end())
+    if(graph.FindActor(name) < 0)
     {
         return false;
     }
@@ -142,7 +80,7 @@ bool movieSet::KnownActor(string &name)
  * @author Chris Kolegraff
  *
  * @par Description:
- * This function will return whether or not a movie is in the knownMovies hash table.
+ * This function will return whether or not a movie is in the graph.
  *
  * @param[in]   name - Name of the movie to find
  *
@@ -150,7 +88,7 @@ bool movieSet::KnownActor(string &name)
  *****************************************************************************/
 bool movieSet::KnownMovie(string &name)
 {
-    if(knownMovies.find(name) == knownMovies.end())
+    if(graph.FindMovie(name) < 0)
     {
         return false;
     }
@@ -173,10 +111,12 @@ bool movieSet::KnownMovie(string &name)
  *****************************************************************************/
 bool movieSet::MakeStartNode(string name)
 {
+    BuildGraph();
+
     if(KnownActor(name) || KnownMovie(name))
     {
-        startingActor = FindActor(name);
-        startingMovie = FindMovie(name);
+        startingActor = graph.FindActor(name);
+        startingMovie = graph.FindMovie(name);
         return true;
     }
 
@@ -189,57 +129,41 @@ bool movieSet::MakeStartNode(string name)
  * @par Description:
  * Assigns Bacon Numbers to movies and actors. This is an interface function that will
  * first set up the algorithm by varifying there is a valid starting node, as well as
- * making sure that actor/movie has at least one movie/actor. It will then call a
- * recursive function that will do the assignments.
+ * making sure that actor/movie has at least one movie/actor. It will then run a
+ * level by level breadth first search out from the starting node.
+ *
+ * The search is a parallelBfs, run on the number of threads set by SetThreads(). Each
+ * level takes the actors found on the last level to their movies, then those movies
+ * to their actors, going top-down or bottom-up, whichever looks at fewer links. A
+ * movie's depth is the Bacon Number of the actors that reach it, plus one if the
+ * starting node is a movie, and a movie's unnumbered actors get one more than that.
  *
  * @returns true The assignments worked
  * @return false The assignments did not work
  *****************************************************************************/
 bool movieSet::NumberActors()
 {
+    BuildGraph();
+    search.Run(graph, startingActor, startingMovie, baconNumbers, depths,
+               actorParents, movieParents);
+
     // If the start node is an actor
-    if(startingActor != nullptr && startingMovie == nullptr)
+    if(startingActor >= 0 && startingMovie < 0)
     {
-        startingActor->baconNumber = 0;
-
-        if(startingActor->movies.empty())
+        if(graph.MoviesBegin(startingActor) == graph.MoviesEnd(startingActor))
         {
-            cout << startingActor->name << " was not in any movies" << endl;
+            cout << graph.ActorName(startingActor) << " was not in any movies" << endl;
             return false;
         }
-
-        // Continue to run until all nodes have the shortest possible path
-        do
-        {
-            // Reset all visted values to false
-            ResetVisited();
-
-            updated = false;
-            NumberActors(startingActor, 0);
-        }
-        while(updated);
     }
     // If the start node is a movie
-    else if(startingActor == nullptr && startingMovie != nullptr)
+    else if(startingActor < 0 && startingMovie >= 0)
     {
-        startingMovie->depth = 0;
-
-        if(startingMovie->actors.empty())
+        if(graph.ActorsBegin(startingMovie) == graph.ActorsEnd(startingMovie))
         {
-            cout << startingMovie->name << " does not have any actors" << endl;
+            cout << graph.MovieName(startingMovie) << " does not have any actors" << endl;
             return false;
         }
-
-        // Continue to run until all nodes have the shortest possible path
-        do
-        {
-            // Reset all visted values to false
-            ResetVisited();
-
-            updated = false;
-            NumberActors(startingMovie, 1);
-        }
-        while(updated);
     }
     else
     {
@@ -260,6 +184,8 @@ bool movieSet::NumberActors()
  *****************************************************************************/
 void movieSet::OutputHist()
 {
+    BuildGraph();
+
     int freq = FindMaxFreq();
     int sum = 0;
     int count = 0;
@@ -275,12 +201,12 @@ void movieSet::OutputHist()
     }
 
     // Count frequencies
-    for(aIter it = knownActors.begin(); it != knownActors.end(); it++)
+    for(int act = 0; act < graph.NumActors(); act++)
     {
-        if(it->second->baconNumber != INF)
+        if(baconNumbers[act] != INF)
         {
-            buckets[it->second->baconNumber]++;
-            sum += it->second->baconNumber;
+            buckets[baconNumbers[act]]++;
+            sum += baconNumbers[act];
             count++;
         }
     }
@@ -308,15 +234,79 @@ void movieSet::OutputHist()
  *****************************************************************************/
 void movieSet::OutputLongestPaths()
 {
+    BuildGraph();
+
     int freq = FindMaxFreq();
 
     cout << "Actors with Bacon Number of: " << freq << endl << endl;
 
-    for(aIter it = knownActors.begin(); it != knownActors.end(); it++)
+    for(int act = 0; act < graph.NumActors(); act++)
+    {
+        if(baconNumbers[act] == freq)
+        {
+            cout << graph.ActorName(act) << endl;
+        }
+    }
+}
+
+/**************************************************************************//**
+ * @author Chris Kolegraff
+ *
+ * @par Description:
+ * Outputs a shortest path between any two actors/movies, in the same layout as the
+ * Six Degrees game, with each actor numbered by its distance from toName. The path
+ * comes from movieGraph::ShortestPath(), which only searches out from the two names,
+ * so the starting node and every Bacon Number are left as they are.
+ *
+ * @param[in]   fromName - Name of the actor/movie the path starts at
+ * @param[in]   toName - Name of the actor/movie the path ends at
+ *****************************************************************************/
+void movieSet::OutputShortestPath(string fromName, string toName)
+{
+    BuildGraph();
+
+    int fromActor = graph.FindActor(fromName);
+    int fromMovie = (fromActor < 0) ? graph.FindMovie(fromName) : -1;
+    int toActor = graph.FindActor(toName);
+    int toMovie = (toActor < 0) ? graph.FindMovie(toName) : -1;
+
+    if(fromActor < 0 && fromMovie < 0)
+    {
+        cout << fromName << " is an invalid actor/actress/movie" << endl;
+        return;
+    }
+
+    if(toActor < 0 && toMovie < 0)
+    {
+        cout << toName << " is an invalid actor/actress/movie" << endl;
+        return;
+    }
+
+    vector<int> path;
+    int links = graph.ShortestPath(fromActor, fromMovie, toActor, toMovie, path);
+
+    if(links < 0)
+    {
+        cout << fromName << " is not related to " << toName << endl;
+        return;
+    }
+
+    bool isActor = fromActor >= 0;
+
+    for(int i = 0; i <= links; i++, isActor = !isActor)
     {
-        if(it->second->baconNumber == freq)
+        // Output arrow to all the names beneath the first one
+        if(i > 0)
+            cout << "     V" << endl;
+
+        if(isActor)
+        {
+            // Links left to toName, an actor in a starting movie is 1
+            cout << (links - i + 1) / 2 << ". " << graph.ActorName(path[i]) << endl;
+        }
+        else
         {
-            cout << it->second->name << endl;
+            cout << graph.MovieName(path[i]) << endl;
         }
     }
 }
@@ -332,29 +322,29 @@ void movieSet::OutputLongestPaths()
  *****************************************************************************/
 void movieSet::OutputVector(std::string name)
 {
-    actor* act = nullptr;
-    movie* mov = nullptr;
+    BuildGraph();
 
-    if(KnownActor(name))
-    {
-        act = FindActor(name);
+    int act = graph.FindActor(name);
+    int mov = graph.FindMovie(name);
 
-        cout << act->numMovies << " " << act->name << " movies: " << endl;
+    if(act >= 0)
+    {
+        cout << graph.MoviesEnd(act) - graph.MoviesBegin(act) << " " << graph.ActorName(act)
+             << " movies: " << endl;
 
-        for(mvIter it = act->movies.begin(); it != act->movies.end(); it++)
+        for(idIter it = graph.MoviesBegin(act); it != graph.MoviesEnd(act); it++)
         {
-            cout << "\t" << (*it)->name << endl;
+            cout << "\t" << graph.MovieName(*it) << endl;
         }
     }
-    else if(KnownMovie(name))
+    else if(mov >= 0)
     {
-        mov = FindMovie(name);
-
-        cout << mov->numActors << " " << mov->name << " performers" << endl;
+        cout << graph.ActorsEnd(mov) - graph.ActorsBegin(mov) << " " << graph.MovieName(mov)
+             << " performers" << endl;
 
-        for(avIter it = mov->actors.begin(); it != mov->actors.end(); it++)
+        for(idIter it = graph.ActorsBegin(mov); it != graph.ActorsEnd(mov); it++)
         {
-            cout << "\t" << (*it)->name << endl;
+            cout << "\t" << graph.ActorName(*it) << endl;
         }
     }
 }
@@ -365,33 +355,36 @@ void movieSet::OutputVector(std::string name)
  * @par Description:
  * Interface function that will initialize the Six Degrees
  * of Kevin Bacon game. It will find the node where the user wishes to start, and checks
- * for validity. If the startName is valid, it will reset every node's visited value to false,
- * and then call the recursive function that will navigate to the starting node.
+ * for validity. If the startName is valid, it will follow each node's parent, the node
+ * it was reached from when the Bacon Numbers were generated, back to the starting node.
+ * The walk is as long as the path, no other nodes are looked at.
  *
  * @param[in]   startName - Name of the node the user wishes to start
  *****************************************************************************/
 void movieSet::PlayBaconGame(string startName)
 {
+    BuildGraph();
+
     // Make sure that the actor/actress or movie is related to the start node
-    movie* mTemp = FindMovie(startName);
-    actor* aTemp = FindActor(startName);
+    int mTemp = graph.FindMovie(startName);
+    int aTemp = graph.FindActor(startName);
 
     // Check to make sure startName's node is related to starting actor/movie
-    if(startingActor != nullptr)
+    if(startingActor >= 0)
     {
-        if((aTemp != nullptr && aTemp->baconNumber == INF) ||
-                (mTemp != nullptr && mTemp->depth == INF))
+        if((aTemp >= 0 && baconNumbers[aTemp] == INF) ||
+                (mTemp >= 0 && depths[mTemp] == INF))
         {
-            cout << startName << " is not related to " << startingActor->name << endl;
+            cout << startName << " is not related to " << graph.ActorName(startingActor) << endl;
             return;
         }
     }
-    else if(startingMovie != nullptr)
+    else if(startingMovie >= 0)
     {
-        if((aTemp != nullptr && aTemp->baconNumber == INF) ||
-                (mTemp != nullptr && mTemp->depth == INF))
+        if((aTemp >= 0 && baconNumbers[aTemp] == INF) ||
+                (mTemp >= 0 && depths[mTemp] == INF))
         {
-            cout << startName << " is not related to " << startingMovie->name << endl;
+            cout << startName << " is not related to " << graph.MovieName(startingMovie) << endl;
             return;
         }
     }
@@ -401,11 +394,32 @@ void movieSet::PlayBaconGame(string startName)
         return;
     }
 
-    // Reset all visted values to false, then play the game
-    ResetVisited();
-    targetActor = aTemp;
-    targetMovie = mTemp;
-    FindTheBacon(aTemp, mTemp);
+    if((aTemp >= 0) == (mTemp >= 0))
+    {
+        cout << "Error finding node" << endl;
+        return;
+    }
+
+    // Walk up the parents, one actor or movie at a time, until the starting node
+    for(int act = aTemp, mov = mTemp; act >= 0 || mov >= 0; )
+    {
+        // Output arrow to all the names beneath the target node
+        if(act != aTemp || mov != mTemp)
+            cout << "     V" << endl;
+
+        if(act >= 0)
+        {
+            cout << baconNumbers[act] << ". " << graph.ActorName(act) << endl;
+            mov = actorParents[act];
+            act = -1;
+        }
+        else
+        {
+            cout << graph.MovieName(mov) << endl;
+            act = movieParents[mov];
+            mov = -1;
+        }
+    }
 }
 
 /**************************************************************************//**
@@ -428,8 +442,6 @@ bool movieSet::ReassignStartNode(string name)
         return false;
     }
 
-    updated = true;
-    ResetBaconNumbers();
     NumberActors();
 
     return true;
@@ -447,13 +459,13 @@ bool movieSet::ReassignStartNode(string name)
  *****************************************************************************/
 string movieSet::StartNodeName()
 {
-    if(startingMovie != nullptr)
+    if(startingMovie >= 0)
     {
-        return startingMovie->name;
+        return graph.MovieName(startingMovie);
     }
-    else if(startingActor != nullptr)
+    else if(startingActor >= 0)
     {
-        return startingActor->name;
+        return graph.ActorName(startingActor);
     }
     else
     {
@@ -461,348 +473,179 @@ string movieSet::StartNodeName()
     }
 }
 
-
-//##################################################//
-// PRIVATE FUNCTIONS
-//##################################################//
-
 /**************************************************************************//**
  * @author Chris Kolegraff
  *
  * @par Description:
- * Counts the number of actors that are not related to the starting node.
+ * Returns the Bacon Number of an actor, or the depth of a movie, from the last time
+ * the numbers were generated.
  *
- * @returns int Number of actors not related to the starting node
+ * @param[in]   name - Name of the actor/movie
+ *
+ * @returns int Bacon Number or depth, 999999 if it is not related to the starting node
+ * @returns -1 There is no actor/movie with that name
  *****************************************************************************/
-int movieSet::CountInfinites()
+int movieSet::BaconNumber(string name)
 {
-    int count = 0;
-    for(aIter it = knownActors.begin(); it != knownActors.end(); it++)
-    {
-        if(it->second->baconNumber == INF)
-        {
-            count++;
-        }
-    }
+    BuildGraph();
 
-    return count;
-}
+    int act = graph.FindActor(name);
+    int mov = graph.FindMovie(name);
 
-/**************************************************************************//**
- * @author Chris Kolegraff
- *
- * @par Description:
- * Deletes the dynamically allocated actor and movie structs in their hashtables.
- *****************************************************************************/
-void movieSet::DeleteGraph()
-{
-    for(aIter it = knownActors.begin(); it != knownActors.end(); it++)
+    if(act >= 0)
     {
-        delete it->second;
-        it->second = nullptr;
+        return baconNumbers[act];
     }
-
-    for(mIter it = knownMovies.begin(); it != knownMovies.end(); it++)
+    else if(mov >= 0)
     {
-        delete it->second;
-        it->second = nullptr;
+        return depths[mov];
     }
 
-    knownActors.clear();
-    knownMovies.clear();
+    return -1;
 }
 
 /**************************************************************************//**
  * @author Chris Kolegraff
  *
  * @par Description:
- * Finds the highest Bacon Number in the list of actors
+ * Sets the number of threads NumberActors() runs its search on. 0 uses one thread
+ * per hardware thread, which is what a movieSet starts with.
  *
- * @returns int Max frequency found
+ * @param[in]   count - Number of threads
  *****************************************************************************/
-int movieSet::FindMaxFreq()
+void movieSet::SetThreads(int count)
 {
-    int max = -1;
-
-    for(aIter it = knownActors.begin(); it != knownActors.end(); it++)
-    {
-        if(it->second->baconNumber != INF && it->second->baconNumber > max)
-        {
-            max = it->second->baconNumber;
-        }
-    }
-
-    return max;
+    search.SetThreads(count);
 }
 
 /**************************************************************************//**
  * @author Chris Kolegraff
  *
  * @par Description:
- * Recursive function that will find its way back to the starting node.
- * It will search the surrounding nodes, and it will pick the node with the
- * smallest depth or Bacon Number.
+ * Returns the number of threads NumberActors() runs its search on.
  *
- * @param[in]   act Points to the most current actor
- * @param[in]   mov Points to the most current movie
+ * @returns int Number of threads
  *****************************************************************************/
-void movieSet::FindTheBacon(actor *act, movie *mov)
+int movieSet::Threads()
 {
-    // Output arrow to all the names beneath the target node
-    if(act != targetActor || mov != targetMovie)
-        cout << "     V" << endl;
-
-    if(act != nullptr)
-    {
-        cout << act->baconNumber << ". " << act->name << endl;
-    }
-    else if(mov != nullptr)
-    {
-        cout << mov->name << endl;
-    }
-
-
-    movie* chosenMovie = nullptr;
-    actor* chosenActor = nullptr;
-
-    int minNum = 1000000;
-
-    // If a movie is chosen
-    if(act == nullptr && mov != nullptr)
-    {
-        // Check if we've found the target
-        if(mov == startingMovie)
-        {
-            return;
-        }
-
-        // Find the minimum Bacon Number and that actor
-        for(avIter i = mov->actors.begin(); i != mov->actors.end(); i++)
-        {
-            if(!(*i)->visited && (*i)->baconNumber < minNum)
-            {
-                minNum = (*i)->baconNumber;
-                chosenActor = *i;
-            }
-        }
-
-        chosenActor->visited = true;
-        // Recurse using that actor
-        FindTheBacon(chosenActor, nullptr);
-    }
-    // If an actor is chosen
-    else if(act != nullptr && mov == nullptr)
-    {
-        // Check if we've found the target
-        if(act == startingActor)
-        {
-            return;
-        }
-
-        // Find the minimum depth and that movie
-        for(mvIter i = act->movies.begin(); i != act->movies.end(); i++)
-        {
-            if(!(*i)->visited && (*i)->depth < minNum)
-            {
-                minNum = (*i)->depth;
-                chosenMovie = *i;
-            }
-        }
-
-        chosenMovie->visited = true;
-        // Recurse using that movie
-        FindTheBacon(nullptr, chosenMovie);
-    }
-    else
-    {
-        cout << "Error finding node" << endl;
-        return;
-    }
+    return search.Threads();
 }
 
 /**************************************************************************//**
  * @author Chris Kolegraff
  *
  * @par Description:
- * This function will try and find an actor in the actor hash table. If it is
- * there, it will return a pointer to that actor.
- *
- * @param[in]   name - Name of the actor to find
+ * Returns the direction each half level of the last NumberActors() search took, in
+ * order, 'T' for top-down and 'B' for bottom-up.
  *
- * @returns actor* The function found the actor
- * @returns nullptr The function did not find the actor
+ * @returns string Directions of the last search
  *****************************************************************************/
-actor* movieSet::FindActor(string &name)
+string movieSet::Directions()
 {
-    aIter it = knownActors.find(name);
-
-    if(it == knownActors.end())
-    {
-        return nullptr;
-    }
-    else
-    {
-        return it->second;
-    }
+    return search.Directions();
 }
 
 /**************************************************************************//**
  * @author Chris Kolegraff
  *
  * @par Description:
- * This function will try and find a movie in the movie hash table. If it is
- * there, it will return a pointer to that movie.
+ * Returns the packed actor/movie graph, building it first if it has not been built.
  *
- * @param[in]   name - Name of the movie to find
- *
- * @returns movie* The function found the movie
- * @returns nullptr The function did not find the movie
+ * @returns movieGraph The actor/movie graph
  *****************************************************************************/
-movie* movieSet::FindMovie(string &name)
+const movieGraph& movieSet::Graph()
 {
-    mIter it = knownMovies.find(name);
-
-    if(it == knownMovies.end())
-    {
-        return nullptr;
-    }
-    else
-    {
-        return it->second;
-    }
+    BuildGraph();
+    return graph;
 }
 
 /**************************************************************************//**
  * @author Chris Kolegraff
  *
  * @par Description:
- * One of 2 recursive functions for generating the Bacon Numbers for actors. It
- * will validate the actor, then update the neighbours, then recurse to all
- * surrounding movie nodes, if it hasn't already been visited.
+ * Adds up the bytes held by the graph and by the per node Bacon Number, depth
+ * and parent arrays.
  *
- * @param[in]   act - Pointer to the current actor node
- * @param[in]   distance - Current Bacon Number
+ * @returns size_t Bytes used by the movieSet
  *****************************************************************************/
-void movieSet::NumberActors(actor *act, int distance)
+size_t movieSet::MemoryUsage()
 {
-    if(act == nullptr)
-    {
-        return;
-    }
+    BuildGraph();
 
-    act->visited = true;
+    return graph.MemoryUsage() + sizeof(*this) - sizeof(graph) +
+           sizeof(int) * (baconNumbers.capacity() + depths.capacity() +
+                          actorParents.capacity() + movieParents.capacity());
+}
 
-    // Update the neighbours if they need to be updated
-    for(mvIter mov = act->movies.begin(); mov != act->movies.end(); mov++)
-    {
-        if(distance < (*mov)->depth)
-        {
-            (*mov)->depth = distance;
-            updated = true;
-        }
-    }
 
-    // Go to all of the actors' movies
-    for(mvIter mov = act->movies.begin(); mov != act->movies.end(); mov++)
-    {
-        if(!(*mov)->visited)
-        {
-            if(startingMovie != nullptr)
-            {
-                NumberActors(*mov, (*mov)->depth);
-            }
-            else
-            {
-                NumberActors(*mov, (*mov)->depth + 1);
-            }
-        }
-    }
-}
+//##################################################//
+// PRIVATE FUNCTIONS
+//##################################################//
 
 /**************************************************************************//**
  * @author Chris Kolegraff
  *
  * @par Description:
- * One of 2 recursive functions for generating the Bacon Numbers for actors. It
- * will validate the movie, then update the neighbours, then recurse to all
- * surrounding actor nodes, if it hasn't already been visited.
- *
- * @param[in]   mov - Pointer to the current movie node
- * @param[in]   distance - Current Bacon Number
+ * Packs the graph once every name has been inserted, then sizes the Bacon Number,
+ * depth and parent arrays to match, with every node at an infinite distance.
+ * Does nothing once the graph is built.
  *****************************************************************************/
-void movieSet::NumberActors(movie *mov, int distance)
+void movieSet::BuildGraph()
 {
-    if(mov == nullptr)
+    if(graph.IsBuilt())
     {
         return;
     }
 
-    mov->visited = true;
-
-    // Update the neighbours if they need to be updated
-    for(avIter act = mov->actors.begin(); act != mov->actors.end(); act++)
-    {
-        if(distance < (*act)->baconNumber)
-        {
-            (*act)->baconNumber = distance;
-            updated = true;
-        }
-    }
-
-    // Go to all other actors
-    for(avIter act = mov->actors.begin(); act != mov->actors.end(); act++)
-    {
-        if(!(*act)->visited)
-        {
-            if(startingMovie != nullptr)
-            {
-                NumberActors(*act, (*act)->baconNumber + 1);
-            }
-            else
-            {
-                NumberActors(*act, (*act)->baconNumber);
-            }
-        }
-    }
+    graph.Build();
+    baconNumbers.assign(graph.NumActors(), INF);
+    depths.assign(graph.NumMovies(), INF);
+    actorParents.assign(graph.NumActors(), -1);
+    movieParents.assign(graph.NumMovies(), -1);
 }
 
 /**************************************************************************//**
  * @author Chris Kolegraff
  *
  * @par Description:
- * Resets the Bacon Number and depth of all actor and movie nodes to INF,
- * which basically represents infinite length.
+ * Counts the number of actors that are not related to the starting node.
+ *
+ * @returns int Number of actors not related to the starting node
  *****************************************************************************/
-void movieSet::ResetBaconNumbers()
+int movieSet::CountInfinites()
 {
-    for(aIter it = knownActors.begin(); it != knownActors.end(); it++)
+    int count = 0;
+    for(int act = 0; act < graph.NumActors(); act++)
     {
-        it->second->visited = false;
-        it->second->baconNumber = INF;
+        if(baconNumbers[act] == INF)
+        {
+            count++;
+        }
     }
 
-    for(mIter it = knownMovies.begin(); it != knownMovies.end(); it++)
-    {
-        it->second->visited = false;
-        it->second->depth = INF;
-    }
+    return count;
 }
 
 /**************************************************************************//**
  * @author Chris Kolegraff
  *
  * @par Description:
- * Resets the visited variable for all of the actors and movies to false.
+ * Finds the highest Bacon Number in the list of actors
+ *
+ * @returns int Max frequency found
  *****************************************************************************/
-void movieSet::ResetVisited()
+int movieSet::FindMaxFreq()
 {
-    for(aIter it = knownActors.begin(); it != knownActors.end(); it++)
-    {
-        it->second->visited = false;
-    }
+    int max = -1;
 
-    for(mIter it = knownMovies.begin(); it != knownMovies.end(); it++)
+    for(int act = 0; act < graph.NumActors(); act++)
     {
-        it->second->visited = false;
+        if(baconNumbers[act] != INF && baconNumbers[act] > max)
+        {
+            max = baconNumbers[act];
+        }
     }
+
+    return max;
 }
+
@@ -1,71 +1,27 @@
 /*************************************************************************//**
  * @file
- * @brief .h file holds the declarations of the movieSet class, and movie/actor structs
+ * @brief .h file holds the declaration of the movieSet class
  **************************************************************************/
 
 #pragma once
-#include <unordered_map>
 #include "functions.h"
-
-// Forward declaration so actor struct knows the movie struct exists
-struct movie;
-
-/// Actor struct. Points to movies
-/**************************************************************************//**
-* @brief Actor struct will point to its surrounding movies. It has a bacon number,
-* a visited value, and a name.
-*****************************************************************************/
-struct actor
-{
-    /// Name of the actor
-    std::string name = "";
-
-    /// Array of pointers to surrounding movies
-    std::vector<movie*> movies;
-
-    /// Distance from starting node
-    int baconNumber = 999999;
-
-    /// Whether or not the node has been visited
-    bool visited = false;
-
-    /// Tracks how many movies the actor is in
-    int numMovies = 0;
-};
-
-/// Movie struct. Points to actors
-/**************************************************************************//**
-* @brief Movie struct will point to its surrounding actors. It has a depth,
-* a visited value, and a name.
-*****************************************************************************/
-struct movie
-{
-    /// Name of the movie
-    std::string name = "";
-
-    /// Array of pointers to surrounding actors
-    std::vector<actor*> actors;
-
-    /// Distance from starting node
-    int depth = 999999;
-
-    /// Whether or not the node has been visited
-    bool visited = false;
-
-    /// Tracks how many actors the movie has
-    int numActors = 0;
-};
+#include "movieGraph.h"
+#include "parallelBfs.h"
 
 /**************************************************************************//**
 * @class movieSet
 *
 * @brief movieSet class holds movies and actors
 *
-* @brief movieSet class uses unordered_maps to hold a list of actors and a list
-* of movies. Each actor will point to a movie that that actor was in, and each
-* movie will point to an actor that had cast that actor. This creates a graph
+* @brief movieSet class uses a movieGraph to hold a list of actors and a list
+* of movies. Each actor is linked to the movies that actor was in, and each
+* movie is linked to the actors in its cast. This creates a graph
 * that can be used to play the Six Degrees of Kevin Bacon game. Other operations are
 * also available that can be used to get more information about the created graph.
+*
+* Actors and movies are dense integer IDs into the graph, and the Bacon Numbers,
+* depths and parents are arrays indexed by those IDs. The graph is built the
+* first time it is used after the last Insert().
 *****************************************************************************/
 class movieSet
 {
@@ -73,9 +29,6 @@ public:
     /// movieSet constructor
     movieSet();
 
-    /// movieSet destructor
-    ~movieSet();
-
     /// Insert a movie or actor/actress into hash tables, creates actor/movie graph
     void Insert(std::string &name, bool isMovie = false);
 
@@ -97,6 +50,9 @@ public:
     /// Outputs the actors who have the highest bacon numbers
     void OutputLongestPaths();
 
+    /// Outputs a shortest path between two actors/movies, without changing the starting node
+    void OutputShortestPath(std::string fromName, std::string toName);
+
     /// Outputs a list of movies that that actor has been in
     void OutputVector(std::string name);
 
@@ -109,37 +65,34 @@ public:
     /// Gets the starting node's name
     std::string StartNodeName();
 
-private:
-
-    /// Count the number of actors that are not related to the starting node
-    int CountInfinites();
+    /// Gets the Bacon Number of an actor, or the depth of a movie
+    int BaconNumber(std::string name);
 
-    /// Delete all the allocated memory
-    void DeleteGraph();
+    /// Sets the number of threads generating bacon numbers, 0 for one per hardware thread
+    void SetThreads(int count);
 
-    /// Finds the max frequency of the actors
-    int FindMaxFreq();
+    /// Gets the number of threads generating bacon numbers
+    int Threads();
 
-    /// Recursively finds the starting node, given a start position
-    void FindTheBacon(actor* act, movie* mov);
+    /// Gets the direction of each half level of the last search, 'T' top-down or 'B' bottom-up
+    std::string Directions();
 
-    /// Finds an actor in the hash table
-    actor* FindActor(std::string &name);
+    /// Gets the packed actor/movie graph
+    const movieGraph& Graph();
 
-    /// Finds a movie in the hash table
-    movie* FindMovie(std::string &name);
+    /// Bytes held by the graph and the per node arrays
+    std::size_t MemoryUsage();
 
-    /// Recursively generate bacon numbers for surrounding movies
-    void NumberActors(actor *act, int distance);
+private:
 
-    /// Recursively generate bacon numbers for surrounding actors
-    void NumberActors(movie *mov, int distance);
+    /// Packs the graph and sizes the per node arrays, if it has not been done
+    void BuildGraph();
 
-    /// Reset the bacon numbers for actors/movies
-    void ResetBaconNumbers();
+    /// Count the number of actors that are not related to the starting node
+    int CountInfinites();
 
-    /// Reset the visited bools for actors/movies
-    void ResetVisited();
+    /// Finds the max frequency of the actors
+    int FindMaxFreq();
 
 
     //##################################################//
@@ -149,29 +102,29 @@ private:
     /// Holds the output file's name
     std::string fileName;
 
-    /// Holds the actors that have been read in
-    std::unordered_map<std::string, actor*> knownActors;
+    /// Holds the actors and movies that have been read in, and their links
+    movieGraph graph;
 
-    /// Holds the movies that have been read in
-    std::unordered_map<std::string, movie*> knownMovies;
+    /// Distance of each actor from the starting node
+    std::vector<int> baconNumbers;
 
-    /// Holds the current in-use movie for inserting
-    movie* selectedMovie;
+    /// Distance of each movie from the starting node
+    std::vector<int> depths;
 
-    /// Holds the starting actor for generating bacon numbers
-    actor* startingActor;
+    /// Movie each actor was reached from, one step closer to the starting node
+    std::vector<int> actorParents;
 
-    /// Holds the starting movie for generating bacon numbers
-    movie* startingMovie;
+    /// Actor each movie was reached from, one step closer to the starting node
+    std::vector<int> movieParents;
 
-    /// Holds the target movie, used for outputting Six Degrees arrows
-    movie* targetMovie;
+    /// Holds the starting actor for generating bacon numbers, -1 if none
+    int startingActor;
 
-    /// Holds the target actor, used for outputting Six Degrees arrows
-    actor* targetActor;
+    /// Holds the starting movie for generating bacon numbers, -1 if none
+    int startingMovie;
 
-    /// Tracks if there were updates while generating bacon numbers
-    bool updated;
+    /// Multithreaded search that generates the bacon numbers
+    parallelBfs search;
 
     /// Represents a node with an infinite distance from the start node
     const int INF = 999999;
@@ -0,0 +1,533 @@
+/*************************************************************************//**
+ * @file
+ * @brief .cpp file holds the definitions of the parallelBfs class
+ **************************************************************************/
+
+
+
+#include "parallelBfs.h"
+
+#include <algorithm>
+
+using namespace std;
+
+/// Bits in one word of a bitmap
+const int WORD_BITS = 64;
+
+/// Represents a node with an infinite distance from the start node
+const int INF = 999999;
+
+//##################################################//
+// PUBLIC FUNCTIONS
+//##################################################//
+
+/**************************************************************************//**
+ * @author Chris Kolegraff
+ *
+ * @par Description:
+ * Basic constructor for the parallelBfs class. Uses one thread per hardware thread.
+ *****************************************************************************/
+parallelBfs::parallelBfs() : nextChunk(0)
+{
+    graph = nullptr;
+    baconNumbers = depths = actorParents = movieParents = nullptr;
+    bottomUp = false;
+    frontierEdges = unvisitedActorEdges = unvisitedMovieEdges = 0;
+    stepFromActors = true;
+    stepDistance = 0;
+    stepCount = running = 0;
+    stopping = false;
+
+    SetThreads(0);
+}
+
+/**************************************************************************//**
+ * @author Chris Kolegraff
+ *
+ * @par Description:
+ * Sets the number of threads the search runs on. 0, or a negative count, uses one
+ * thread per hardware thread, or 1 if that is not known.
+ *
+ * @param[in]   count - Number of threads
+ *****************************************************************************/
+void parallelBfs::SetThreads(int count)
+{
+    if(count <= 0)
+    {
+        count = max(1, int(thread::hardware_concurrency()));
+    }
+
+    threads = count;
+    buffers.resize(threads);
+    bufferEdges.resize(threads);
+}
+
+/**************************************************************************//**
+ * @author Chris Kolegraff
+ *
+ * @par Description:
+ * Returns the number of threads the search runs on.
+ *
+ * @returns int Number of threads
+ *****************************************************************************/
+int parallelBfs::Threads() const
+{
+    return threads;
+}
+
+/**************************************************************************//**
+ * @author Chris Kolegraff
+ *
+ * @par Description:
+ * Numbers every actor and movie out from the starting actor, or the starting movie if
+ * startActor is -1. Nodes that can not be reached are left at 999999. The numbers
+ * are the ones movieSet gives: a movie's depth is the Bacon Number of the actors that
+ * reach it, plus one if the starting node is a movie, and an actor is one more than
+ * the movie that reaches it. Each node's parent is the neighbour it was found from,
+ * -1 for the starting node and for nodes that can not be reached.
+ *
+ * @param[in]   graph - Packed actor/movie graph
+ * @param[in]   startActor - ID of the starting actor, -1 if the start is a movie
+ * @param[in]   startMovie - ID of the starting movie, only used if startActor is -1
+ * @param[out]  baconNumbers - Bacon Number of every actor
+ * @param[out]  depths - Depth of every movie
+ * @param[out]  actorParents - Movie each actor was found from
+ * @param[out]  movieParents - Actor each movie was found from
+ *****************************************************************************/
+void parallelBfs::Run(const movieGraph &graph, int startActor, int startMovie,
+                      vector<int> &baconNumbers, vector<int> &depths,
+                      vector<int> &actorParents, vector<int> &movieParents)
+{
+    this->graph = &graph;
+    baconNumbers.assign(graph.NumActors(), INF);
+    depths.assign(graph.NumMovies(), INF);
+    actorParents.assign(graph.NumActors(), -1);
+    movieParents.assign(graph.NumMovies(), -1);
+    this->baconNumbers = baconNumbers.data();
+    this->depths = depths.data();
+    this->actorParents = actorParents.data();
+    this->movieParents = movieParents.data();
+
+    ClearBits(actorVisited, graph.NumActors());
+    ClearBits(movieVisited, graph.NumMovies());
+    ClearBits(frontierBits, max(graph.NumActors(), graph.NumMovies()));
+
+    // Every casting is one edge on each side
+    unvisitedActorEdges = unvisitedMovieEdges = 0;
+    if(graph.NumActors() > 0)
+    {
+        unvisitedActorEdges = unvisitedMovieEdges = graph.MoviesEnd(graph.NumActors() - 1) -
+                                                    graph.MoviesBegin(0);
+    }
+    bottomUp = false;
+    directions.clear();
+    frontier.clear();
+
+    bool fromActors = startActor >= 0;
+    int shift = fromActors ? 0 : 1;
+
+    if(fromActors)
+    {
+        SetBit(actorVisited, startActor);
+        baconNumbers[startActor] = 0;
+        frontier.push_back(startActor);
+        frontierEdges = graph.MoviesEnd(startActor) - graph.MoviesBegin(startActor);
+        unvisitedActorEdges -= frontierEdges;
+    }
+    else if(startMovie >= 0)
+    {
+        SetBit(movieVisited, startMovie);
+        depths[startMovie] = 0;
+        frontier.push_back(startMovie);
+        frontierEdges = graph.ActorsEnd(startMovie) - graph.ActorsBegin(startMovie);
+        unvisitedMovieEdges -= frontierEdges;
+    }
+
+    StartPool();
+
+    // distance is the Bacon Number of the actors in, or reached from, the frontier
+    for(int distance = 0; !frontier.empty(); fromActors = !fromActors)
+    {
+        if(fromActors)
+        {
+            Step(true, distance + shift);
+        }
+        else
+        {
+            distance++;
+            Step(false, distance);
+        }
+    }
+
+    StopPool();
+}
+
+/**************************************************************************//**
+ * @author Chris Kolegraff
+ *
+ * @par Description:
+ * Returns the direction each half level of the last search took, 'T' for top-down
+ * and 'B' for bottom-up, in order.
+ *
+ * @returns string Directions of the last search
+ *****************************************************************************/
+const string& parallelBfs::Directions() const
+{
+    return directions;
+}
+
+
+//##################################################//
+// PRIVATE FUNCTIONS
+//##################################################//
+
+/**************************************************************************//**
+ * @author Chris Kolegraff
+ *
+ * @par Description:
+ * Picks the direction of the half level, numbers the frontier's unvisited neighbours
+ * with every thread, or only the calling thread if the frontier is small, then joins
+ * the threads' buffers into the next frontier.
+ *
+ * @param[in]   fromActors - Whether the frontier is actors, or movies
+ * @param[in]   distance - Number given to the nodes found
+ *****************************************************************************/
+void parallelBfs::Step(bool fromActors, int distance)
+{
+    long long unvisitedEdges = fromActors ? unvisitedMovieEdges : unvisitedActorEdges;
+    int sideCount = fromActors ? graph->NumActors() : graph->NumMovies();
+
+    if(!bottomUp && frontierEdges * ALPHA > unvisitedEdges)
+    {
+        bottomUp = true;
+    }
+    else if(bottomUp && (long long)frontier.size() * BETA < sideCount)
+    {
+        bottomUp = false;
+    }
+
+    directions.push_back(bottomUp ? 'B' : 'T');
+    nextChunk = 0;
+    stepFromActors = fromActors;
+    stepDistance = distance;
+
+    if(bottomUp)
+    {
+        for(size_t i = 0; i < frontier.size(); i++)
+        {
+            SetBit(frontierBits, frontier[i]);
+        }
+
+        Parallel();
+
+        for(size_t i = 0; i < frontier.size(); i++)
+        {
+            frontierBits[frontier[i] / WORD_BITS].store(0, memory_order_relaxed);
+        }
+    }
+    else if(frontierEdges < SERIAL_EDGES)
+    {
+        TopDown(0, fromActors, distance);
+    }
+    else
+    {
+        Parallel();
+    }
+
+    // Join the buffers into the next frontier
+    frontier.clear();
+    frontierEdges = 0;
+
+    for(int id = 0; id < threads; id++)
+    {
+        frontier.insert(frontier.end(), buffers[id].begin(), buffers[id].end());
+        frontierEdges += bufferEdges[id];
+        buffers[id].clear();
+        bufferEdges[id] = 0;
+    }
+
+    if(fromActors)
+    {
+        unvisitedMovieEdges -= frontierEdges;
+    }
+    else
+    {
+        unvisitedActorEdges -= frontierEdges;
+    }
+}
+
+/**************************************************************************//**
+ * @author Chris Kolegraff
+ *
+ * @par Description:
+ * One thread's share of a top-down half level. The thread takes chunks of the
+ * frontier until there are none left, and claims each unvisited neighbour with an
+ * atomic fetch_or, so a node two frontier nodes share is only numbered once, and its
+ * parent is the frontier node that claimed it.
+ *
+ * @param[in]   id - Which thread this is
+ * @param[in]   fromActors - Whether the frontier is actors, or movies
+ * @param[in]   distance - Number given to the nodes found
+ *****************************************************************************/
+void parallelBfs::TopDown(int id, bool fromActors, int distance)
+{
+    vector<int> &buffer = buffers[id];
+    bitmap &visited = fromActors ? movieVisited : actorVisited;
+    int* numbers = fromActors ? depths : baconNumbers;
+    int* parents = fromActors ? movieParents : actorParents;
+    long long edges = 0;
+    int size = int(frontier.size());
+
+    for(int start = nextChunk.fetch_add(CHUNK); start < size; start = nextChunk.fetch_add(CHUNK))
+    {
+        for(int i = start; i < min(size, start + CHUNK); i++)
+        {
+            int node = frontier[i];
+            const int* begin = fromActors ? graph->MoviesBegin(node) : graph->ActorsBegin(node);
+            const int* end = fromActors ? graph->MoviesEnd(node) : graph->ActorsEnd(node);
+
+            for(const int* next = begin; next != end; next++)
+            {
+                if(!TestBit(visited, *next) && !SetBit(visited, *next))
+                {
+                    numbers[*next] = distance;
+                    parents[*next] = node;
+                    buffer.push_back(*next);
+                    edges += fromActors ? graph->ActorsEnd(*next) - graph->ActorsBegin(*next) :
+                                          graph->MoviesEnd(*next) - graph->MoviesBegin(*next);
+                }
+            }
+        }
+    }
+
+    bufferEdges[id] = edges;
+}
+
+/**************************************************************************//**
+ * @author Chris Kolegraff
+ *
+ * @par Description:
+ * One thread's share of a bottom-up half level. The thread takes chunks of the node
+ * IDs on the other side until there are none left. Each unvisited node looks through
+ * its neighbours and is numbered at the first one in the frontier bitmap, which
+ * becomes its parent.
+ *
+ * @param[in]   id - Which thread this is
+ * @param[in]   fromActors - Whether the frontier is actors, or movies
+ * @param[in]   distance - Number given to the nodes found
+ *****************************************************************************/
+void parallelBfs::BottomUp(int id, bool fromActors, int distance)
+{
+    vector<int> &buffer = buffers[id];
+    bitmap &visited = fromActors ? movieVisited : actorVisited;
+    int* numbers = fromActors ? depths : baconNumbers;
+    int* parents = fromActors ? movieParents : actorParents;
+    long long edges = 0;
+    int size = fromActors ? graph->NumMovies() : graph->NumActors();
+
+    for(int start = nextChunk.fetch_add(CHUNK); start < size; start = nextChunk.fetch_add(CHUNK))
+    {
+        for(int node = start; node < min(size, start + CHUNK); node++)
+        {
+            if(TestBit(visited, node))
+            {
+                continue;
+            }
+
+            const int* begin = fromActors ? graph->ActorsBegin(node) : graph->MoviesBegin(node);
+            const int* end = fromActors ? graph->ActorsEnd(node) : graph->MoviesEnd(node);
+
+            for(const int* next = begin; next != end; next++)
+            {
+                if(TestBit(frontierBits, *next))
+                {
+                    SetBit(visited, node);
+                    numbers[node] = distance;
+                    parents[node] = *next;
+                    buffer.push_back(node);
+                    edges += end - begin;
+                    break;
+                }
+            }
+        }
+    }
+
+    bufferEdges[id] = edges;
+}
+
+/**************************************************************************//**
+ * @author Chris Kolegraff
+ *
+ * @par Description:
+ * Runs thread id's share of the current half level, in the direction Step picked.
+ *
+ * @param[in]   id - Which thread this is
+ *****************************************************************************/
+void parallelBfs::Work(int id)
+{
+    if(bottomUp)
+    {
+        BottomUp(id, stepFromActors, stepDistance);
+    }
+    else
+    {
+        TopDown(id, stepFromActors, stepDistance);
+    }
+}
+
+/**************************************************************************//**
+ * @author Chris Kolegraff
+ *
+ * @par Description:
+ * Hands the current half level to every thread in the pool, runs it on the calling
+ * thread as thread 0, then waits for every thread to finish. Taking the mutex on both
+ * sides also makes the threads' buffers visible to the calling thread.
+ *****************************************************************************/
+void parallelBfs::Parallel()
+{
+    {
+        lock_guard<mutex> lock(poolMutex);
+        running = int(pool.size());
+        stepCount++;
+    }
+    stepStart.notify_all();
+
+    Work(0);
+
+    unique_lock<mutex> lock(poolMutex);
+    stepDone.wait(lock, [this] { return running == 0; });
+}
+
+/**************************************************************************//**
+ * @author Chris Kolegraff
+ *
+ * @par Description:
+ * Starts threads - 1 threads, which wait for Parallel to hand them a half level.
+ *****************************************************************************/
+void parallelBfs::StartPool()
+{
+    stopping = false;
+    stepCount = running = 0;
+
+    for(int id = 1; id < threads; id++)
+    {
+        pool.push_back(thread(&parallelBfs::Worker, this, id));
+    }
+}
+
+/**************************************************************************//**
+ * @author Chris Kolegraff
+ *
+ * @par Description:
+ * Tells every thread in the pool to exit, and joins them.
+ *****************************************************************************/
+void parallelBfs::StopPool()
+{
+    {
+        lock_guard<mutex> lock(poolMutex);
+        stopping = true;
+    }
+    stepStart.notify_all();
+
+    for(size_t i = 0; i < pool.size(); i++)
+    {
+        pool[i].join();
+    }
+    pool.clear();
+}
+
+/**************************************************************************//**
+ * @author Chris Kolegraff
+ *
+ * @par Description:
+ * Waits for each new half level, runs this thread's share of it, and tells the
+ * calling thread once the last thread is done. Returns when the pool stops.
+ *
+ * @param[in]   id - Which thread this is
+ *****************************************************************************/
+void parallelBfs::Worker(int id)
+{
+    int seen = 0;
+    unique_lock<mutex> lock(poolMutex);
+
+    while(true)
+    {
+        stepStart.wait(lock, [&] { return stopping || stepCount != seen; });
+        if(stopping)
+        {
+            return;
+        }
+
+        seen = stepCount;
+        lock.unlock();
+        Work(id);
+        lock.lock();
+
+        if(--running == 0)
+        {
+            stepDone.notify_one();
+        }
+    }
+}
+
+/**************************************************************************//**
+ * @author Chris Kolegraff
+ *
+ * @par Description:
+ * Sizes a bitmap for count bits and clears every bit. Atomics can not be copied or
+ * moved, so a bitmap of the wrong size is replaced by a new one.
+ *
+ * @param[in,out]   bits - Bitmap to clear
+ * @param[in]       count - Number of bits
+ *****************************************************************************/
+void parallelBfs::ClearBits(bitmap &bits, int count)
+{
+    size_t words = (count + WORD_BITS - 1) / WORD_BITS;
+
+    if(bits.size() != words)
+    {
+        bitmap(words).swap(bits);
+    }
+
+    for(size_t i = 0; i < words; i++)
+    {
+        bits[i].store(0, memory_order_relaxed);
+    }
+}
+
+/**************************************************************************//**
+ * @author Chris Kolegraff
+ *
+ * @par Description:
+ * Atomically sets a bit. When two threads set the same bit at once, exactly one of
+ * them sees that it was not set before.
+ *
+ * @param[in,out]   bits - Bitmap to set the bit in
+ * @param[in]       bit - Which bit to set
+ *
+ * @returns true The bit was already set
+ * @returns false This call set the bit
+ *****************************************************************************/
+bool parallelBfs::SetBit(bitmap &bits, int bit)
+{
+    unsigned long long mask = 1ULL << (bit % WORD_BITS);
+    return (bits[bit / WORD_BITS].fetch_or(mask, memory_order_relaxed) & mask) != 0;
+}
+
+/**************************************************************************//**
+ * @author Chris Kolegraff
+ *
+ * @par Description:
+ * Checks a bit, without the cost of an atomic read-modify-write.
+ *
+ * @param[in]   bits - Bitmap to check
+ * @param[in]   bit - Which bit to check
+ *
+ * @returns true The bit is set
+ * @returns false The bit is not set
+ *****************************************************************************/
+bool parallelBfs::TestBit(const bitmap &bits, int bit)
+{
+    unsigned long long mask = 1ULL << (bit % WORD_BITS);
+    return (bits[bit / WORD_BITS].load(memory_order_relaxed) & mask) != 0;
+}
@@ -0,0 +1,207 @@
+/*************************************************************************//**
+ * @file
+ * @brief .h file holds the declaration of the parallelBfs class, the multithreaded Bacon Number search
+ **************************************************************************/
+
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "movieGraph.h"
+
+/**************************************************************************//**
+* @class parallelBfs
+*
+* @brief parallelBfs class numbers every actor and movie out from a starting node,
+* using several threads
+*
+* @brief The search runs one half level at a time, from the actor frontier to its
+* movies, or from the movie frontier to its actors, and picks a direction for each one:
+*
+*   Top-down: each frontier node claims its unvisited neighbours. Threads take chunks
+*   of the frontier, and a neighbour is claimed by an atomic fetch_or on the visited
+*   bitmap, so only one thread numbers it.
+*
+*   Bottom-up: each unvisited node on the other side looks through its neighbours for
+*   one in the frontier, and stops at the first. Threads take chunks of node IDs, so
+*   no two threads ever look at the same node.
+*
+* Top-down costs about the edges out of the frontier, bottom-up about the edges into
+* the unvisited nodes, less the early stops. Following Beamer, the search goes bottom-up
+* once the frontier's edges are more than 1 / ALPHA of the unvisited side's edges,
+* and back to top-down once the frontier is under 1 / BETA of its side.
+*
+* Each thread adds the nodes it numbers to its own buffer, and the buffers are joined
+* into the next frontier. With one thread everything runs on the calling thread.
+*
+* The other threads are started once per search, and wait for each half level on a
+* condition variable, so a level costs a wake up and a barrier rather than starting
+* and joining threads. A top-down half level with fewer than SERIAL_EDGES edges out
+* of the frontier runs on the calling thread alone, since waking the threads would
+* cost more than the level itself.
+*
+* Every node also gets a parent, the neighbour one step closer to the start that it
+* was found from, so a shortest path back to the start is a walk up the parents.
+* With several threads, which of a node's closer neighbours becomes its parent
+* depends on which thread gets to it first.
+*****************************************************************************/
+class parallelBfs
+{
+public:
+    /// parallelBfs constructor, one thread per hardware thread
+    parallelBfs();
+
+    /// Sets the number of threads, 0 for one per hardware thread
+    void SetThreads(int count);
+
+    /// Gets the number of threads
+    int Threads() const;
+
+    /// Numbers every actor and movie from one starting actor or movie, and finds their parents
+    void Run(const movieGraph &graph, int startActor, int startMovie,
+             std::vector<int> &baconNumbers, std::vector<int> &depths,
+             std::vector<int> &actorParents, std::vector<int> &movieParents);
+
+    /// Direction of each half level of the last search, 'T' top-down or 'B' bottom-up
+    const std::string& Directions() const;
+
+private:
+
+    /// Bitmap that threads can set bits in at the same time
+    typedef std::vector<std::atomic<unsigned long long>> bitmap;
+
+    /// Numbers the unvisited neighbours of the frontier, one half level
+    void Step(bool fromActors, int distance);
+
+    /// Top-down half level, the frontier claims its neighbours
+    void TopDown(int id, bool fromActors, int distance);
+
+    /// Bottom-up half level, unvisited nodes look for a frontier neighbour
+    void BottomUp(int id, bool fromActors, int distance);
+
+    /// Runs the current half level on thread id
+    void Work(int id);
+
+    /// Runs Work(id) on every thread, id 0 on the calling thread, and waits for all of them
+    void Parallel();
+
+    /// Starts the threads other than the calling thread
+    void StartPool();
+
+    /// Stops and joins the threads
+    void StopPool();
+
+    /// Loop of one thread, runs Work(id) for every half level until the pool stops
+    void Worker(int id);
+
+    /// Clears a bitmap, and sizes it for count bits
+    static void ClearBits(bitmap &bits, int count);
+
+    /// Sets a bit, returns whether it was already set
+    static bool SetBit(bitmap &bits, int bit);
+
+    /// Checks a bit
+    static bool TestBit(const bitmap &bits, int bit);
+
+
+    //##################################################//
+    // PRIVATE VARIABLES
+    //##################################################//
+
+    /// Turn to bottom-up once the frontier has more than 1 / ALPHA of the unvisited edges
+    static const int ALPHA = 14;
+
+    /// Turn back to top-down once the frontier has fewer than 1 / BETA of its side's nodes
+    static const int BETA = 24;
+
+    /// IDs of each chunk of work a thread takes at once
+    static const int CHUNK = 256;
+
+    /// Top-down half levels with fewer frontier edges than this run on one thread
+    static const int SERIAL_EDGES = 4096;
+
+    /// Number of threads
+    int threads;
+
+    /// Graph being searched
+    const movieGraph* graph;
+
+    /// Bacon Number of every actor
+    int* baconNumbers;
+
+    /// Depth of every movie
+    int* depths;
+
+    /// Movie each actor was found from
+    int* actorParents;
+
+    /// Actor each movie was found from
+    int* movieParents;
+
+    /// Actors that have been numbered
+    bitmap actorVisited;
+
+    /// Movies that have been numbered
+    bitmap movieVisited;
+
+    /// Frontier as a bitmap, only filled for a bottom-up half level
+    bitmap frontierBits;
+
+    /// Nodes numbered on the last half level
+    std::vector<int> frontier;
+
+    /// Each thread's newly numbered nodes
+    std::vector<std::vector<int>> buffers;
+
+    /// Each thread's sum of the degrees of its newly numbered nodes
+    std::vector<long long> bufferEdges;
+
+    /// Next chunk of the frontier or of the node IDs to hand out
+    std::atomic<int> nextChunk;
+
+    /// Whether the last half level went bottom-up
+    bool bottomUp;
+
+    /// Edges out of the frontier
+    long long frontierEdges;
+
+    /// Edges of the actors that have not been numbered
+    long long unvisitedActorEdges;
+
+    /// Edges of the movies that have not been numbered
+    long long unvisitedMovieEdges;
+
+    /// Direction of each half level of the last search
+    std::string directions;
+
+    /// Whether the current half level's frontier is actors
+    bool stepFromActors;
+
+    /// Number given to the nodes found on the current half level
+    int stepDistance;
+
+    /// Threads other than the calling thread, only running during a search
+    std::vector<std::thread> pool;
+
+    /// Guards the pool's step count, running count and stop flag
+    std::mutex poolMutex;
+
+    /// Wakes the threads when a half level starts, or the pool stops
+    std::condition_variable stepStart;
+
+    /// Wakes the calling thread when the last thread finishes a half level
+    std::condition_variable stepDone;
+
+    /// Half levels handed to the pool so far
+    int stepCount;
+
+    /// Threads still working on the current half level
+    int running;
+
+    /// Whether the threads should exit
+    bool stopping;
+};